@@ -328,6 +328,23 @@ Status BinaryPlainBlockDecoder::CopyNextAndEval(size_t* n,
   });
 }
 
+Status BinaryPlainBlockDecoder::CopySelectedValues(size_t* n,
+                                                   const SelectionVectorView& sel,
+                                                   ColumnDataView* dst,
+                                                   size_t* n_decoded) {
+  // Every string is directly addressable, so there's no need to seek: just
+  // avoid copying the unselected ones into the arena.
+  size_t decoded = 0;
+  RETURN_NOT_OK(HandleBatch(n, dst, [&](size_t i, Slice elem, Slice* out, Arena* out_arena) {
+    if (sel.TestBit(i)) {
+      CHECK(out_arena->RelocateSlice(elem, out));
+      decoded++;
+    }
+  }));
+  *n_decoded = decoded;
+  return Status::OK();
+}
+
 
 } // namespace cfile
 } // namespace kudu
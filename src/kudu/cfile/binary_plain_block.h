@@ -117,6 +117,10 @@ class BinaryPlainBlockDecoder final : public BlockDecoder {
                          ColumnMaterializationContext* ctx,
                          SelectionVectorView* sel,
                          ColumnDataView* dst) override;
+  Status CopySelectedValues(size_t* n,
+                            const SelectionVectorView& sel,
+                            ColumnDataView* dst,
+                            size_t* n_decoded) override;
 
   virtual bool HasNext() const OVERRIDE {
     DCHECK(parsed_);
@@ -23,6 +23,7 @@
 #include <glog/logging.h>
 
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/columnblock.h"
 #include "kudu/common/rowid.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/cfile/cfile.pb.h"
@@ -32,8 +33,6 @@
 #include "kudu/util/status.h"
 
 namespace kudu {
-class ColumnDataView;
-
 namespace cfile {
 class CFileWriter;
 
@@ -171,6 +170,42 @@ class BlockDecoder {
     return Status::OK();
   }
 
+  // Fetch the next '*n' values from the block into 'dst', like
+  // CopyNextValues(), except that only the rows selected in 'sel' need to be
+  // materialized. The cells of unselected rows are left undefined. 'sel' is
+  // relative to the same starting row as 'dst'.
+  //
+  // Modifies *n to contain the number of values consumed from the block, and
+  // sets *n_decoded to the number of values actually materialized.
+  //
+  // The default implementation copies runs of selected rows and seeks past
+  // runs of unselected ones.
+  virtual Status CopySelectedValues(size_t* n,
+                                    const SelectionVectorView& sel,
+                                    ColumnDataView* dst,
+                                    size_t* n_decoded) {
+    size_t to_copy = std::min(*n, Count() - GetCurrentIndex());
+    ColumnDataView run_dst(*dst);
+    size_t done = 0;
+    *n_decoded = 0;
+    while (done < to_copy) {
+      bool selected;
+      size_t run = sel.NextRun(done, to_copy - done, &selected);
+      if (selected) {
+        size_t copied = run;
+        RETURN_NOT_OK(CopyNextValues(&copied, &run_dst));
+        DCHECK_EQ(run, copied);
+        *n_decoded += run;
+      } else {
+        SeekToPositionInBlock(GetCurrentIndex() + run);
+      }
+      run_dst.Advance(run);
+      done += run;
+    }
+    *n = to_copy;
+    return Status::OK();
+  }
+
   // Return true if there are more values remaining to be iterated.
   // (i.e that the next call to CopyNextValues will return at least 1
   // element)
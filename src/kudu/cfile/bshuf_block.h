@@ -330,6 +330,17 @@ class BShufBlockDecoder final : public BlockDecoder {
     return CopyNextValuesToArray(n, dst->data());
   }
 
+  // The whole block was already unshuffled by ParseHeader(), so copying the
+  // range in one go is cheaper than consulting 'sel'.
+  Status CopySelectedValues(size_t* n,
+                            const SelectionVectorView& /*sel*/,
+                            ColumnDataView* dst,
+                            size_t* n_decoded) OVERRIDE {
+    RETURN_NOT_OK(CopyNextValues(n, dst));
+    *n_decoded = *n;
+    return Status::OK();
+  }
+
   // Copy the codewords to a temporary buffer.
   // This API provides a more convenient way for the dictionary decoder to copy out
   // integer codewords and then look up the strings. If we use the CopyNextValuesToArray()
@@ -251,6 +251,60 @@ class TestCFile : public CFileTestBase {
     TimeSeekAndReadFileWithNulls(generator, block_id, n);
   }
 
+  // Scan the file with only every 'stride'-th row selected, first decoding
+  // whole blocks and then letting the iterator skip the unselected rows, and
+  // verify the values of the selected rows in both cases.
+  template <class DataGeneratorType>
+  void TestSparseSelectionScan(DataGeneratorType* generator, EncodingType encoding,
+                               int num_entries, int stride) {
+    BlockId block_id;
+    WriteTestFile(generator, encoding, NO_COMPRESSION, num_entries, SMALL_BLOCKSIZE, &block_id);
+
+    unique_ptr<ReadableBlock> block;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+
+    const size_t kBatchSize = 1000;
+    ScopedColumnBlock<DataGeneratorType::kDataType> cb(kBatchSize);
+    SelectionVector sel(kBatchSize);
+    sel.SetAllFalse();
+    for (size_t i = 0; i < kBatchSize; i += stride) {
+      sel.SetRowSelected(i);
+    }
+
+    for (bool sparse : { false, true }) {
+      gscoped_ptr<CFileIterator> iter;
+      ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK));
+      ASSERT_OK(iter->SeekToOrdinal(0));
+      ColumnMaterializationContext ctx = CreateNonDecoderEvalContext(&cb, &sel);
+      ctx.SetDecoderEvalNotSupported();
+      if (sparse) {
+        ctx.SetSparseSelection();
+      }
+
+      size_t read_offset = 0;
+      LOG_TIMING(INFO, Substitute("scanning $0 rows with 1 in $1 selected ($2)",
+                                  num_entries, stride, sparse ? "sparse" : "dense")) {
+        while (iter->HasNext()) {
+          size_t n = kBatchSize;
+          ASSERT_OK_FAST(iter->CopyNextValues(&n, &ctx));
+          generator->Build(read_offset, n);
+          for (size_t j = 0; j < n; j += stride) {
+            bool expected_null = generator->TestValueShouldBeNull(read_offset + j);
+            ASSERT_EQ(expected_null, cb.is_null(j));
+            if (!expected_null) {
+              ASSERT_EQ((*generator)[j], cb[j]);
+            }
+          }
+          cb.arena()->Reset();
+          read_offset += n;
+        }
+      }
+      ASSERT_EQ(num_entries, read_offset);
+    }
+  }
+
   void TestReadWriteRawBlocks(CompressionType compression, int num_entries) {
     // Test Write
     unique_ptr<WritableBlock> sink;
@@ -915,6 +969,19 @@ TEST_P(TestCFileBothCacheTypes, TestNullDictStrings) {
   TestNullTypes(&generator, DICT_ENCODING, LZ4);
 }
 
+// Test scanning with a selective predicate, where only a few rows of each
+// batch need to be materialized.
+TEST_P(TestCFileBothCacheTypes, TestSparseSelectionScan) {
+  UInt32DataGenerator<false> ints;
+  TestSparseSelectionScan(&ints, BIT_SHUFFLE, 100000, 97);
+  UInt32DataGenerator<true> nullable_ints;
+  TestSparseSelectionScan(&nullable_ints, RLE, 100000, 97);
+  StringDataGenerator<true> prefix_strings("hello %zu");
+  TestSparseSelectionScan(&prefix_strings, PREFIX_ENCODING, 100000, 97);
+  StringDataGenerator<false> dict_strings("hello %zu");
+  TestSparseSelectionScan(&dict_strings, DICT_ENCODING, 100000, 5);
+}
+
 TEST_P(TestCFileBothCacheTypes, TestReleaseBlock) {
   unique_ptr<WritableBlock> sink;
   ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
@@ -1089,15 +1089,22 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
         }
         size_t this_batch = nblock;
         if (not_null) {
+          size_t n_decoded;
           if (ctx->DecoderEvalNotDisabled()) {
             RETURN_NOT_OK(pb->dblk_->CopyNextAndEval(&this_batch,
                                                      ctx,
                                                      &remaining_sel,
                                                      &remaining_dst));
+            n_decoded = this_batch;
+          } else if (ctx->sparse_selection()) {
+            RETURN_NOT_OK(pb->dblk_->CopySelectedValues(&this_batch, remaining_sel,
+                                                        &remaining_dst, &n_decoded));
           } else {
             RETURN_NOT_OK(pb->dblk_->CopyNextValues(&this_batch, &remaining_dst));
+            n_decoded = this_batch;
           }
           DCHECK_EQ(nblock, this_batch);
+          io_stats_.cells_decoded += n_decoded;
           pb->needs_rewind_ = true;
         } else {
 #ifndef NDEBUG
@@ -1123,11 +1130,18 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
       // Fetch as many as we can from the current datablock.
       size_t this_batch = rem;
 
+      size_t n_decoded;
       if (ctx->DecoderEvalNotDisabled()) {
         RETURN_NOT_OK(pb->dblk_->CopyNextAndEval(&this_batch, ctx, &remaining_sel, &remaining_dst));
+        n_decoded = this_batch;
+      } else if (ctx->sparse_selection()) {
+        RETURN_NOT_OK(pb->dblk_->CopySelectedValues(&this_batch, remaining_sel,
+                                                    &remaining_dst, &n_decoded));
       } else {
         RETURN_NOT_OK(pb->dblk_->CopyNextValues(&this_batch, &remaining_dst));
+        n_decoded = this_batch;
       }
+      io_stats_.cells_decoded += n_decoded;
       pb->needs_rewind_ = true;
       DCHECK_LE(this_batch, rem);
 
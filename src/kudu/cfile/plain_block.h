@@ -208,6 +208,16 @@ class PlainBlockDecoder final : public BlockDecoder {
     return Status::OK();
   }
 
+  // A single memcpy of the whole range is cheaper than consulting 'sel'.
+  virtual Status CopySelectedValues(size_t* n,
+                                    const SelectionVectorView& /*sel*/,
+                                    ColumnDataView* dst,
+                                    size_t* n_decoded) OVERRIDE {
+    RETURN_NOT_OK(CopyNextValues(n, dst));
+    *n_decoded = *n;
+    return Status::OK();
+  }
+
   virtual bool HasNext() const OVERRIDE {
     return cur_idx_ < num_elems_;
   }
@@ -359,7 +359,8 @@ KuduClient::Data::~Data() {
 RemoteTabletServer* KuduClient::Data::SelectTServer(const scoped_refptr<RemoteTablet>& rt,
                                                     const ReplicaSelection selection,
                                                     const set<string>& blacklist,
-                                                    vector<RemoteTabletServer*>* candidates) const {
+                                                    vector<RemoteTabletServer*>* candidates,
+                                                    const MonoDelta& max_staleness) const {
   RemoteTabletServer* ret = nullptr;
   candidates->clear();
   switch (selection) {
@@ -385,6 +386,22 @@ RemoteTabletServer* KuduClient::Data::SelectTServer(const scoped_refptr<RemoteTa
           VLOG(1) << "Excluding blacklisted tserver " << rts->permanent_uuid();
         }
       }
+      // Prefer replicas which aren't known to be too stale. If they all are,
+      // their lag may have been reported a while ago: try them anyway.
+      if (max_staleness.Initialized()) {
+        vector<RemoteTabletServer*> fresh;
+        for (RemoteTabletServer* rts : filtered) {
+          if (!rt->IsReplicaKnownTooStale(rts, max_staleness)) {
+            fresh.push_back(rts);
+          } else {
+            VLOG(1) << "Avoiding tserver " << rts->permanent_uuid()
+                    << " lagging behind by more than " << max_staleness.ToString();
+          }
+        }
+        if (!fresh.empty()) {
+          filtered.swap(fresh);
+        }
+      }
       if (selection == FIRST_REPLICA) {
         if (!filtered.empty()) {
           ret = filtered[0];
@@ -418,9 +435,10 @@ Status KuduClient::Data::GetTabletServer(KuduClient* client,
                                          ReplicaSelection selection,
                                          const set<string>& blacklist,
                                          vector<RemoteTabletServer*>* candidates,
-                                         RemoteTabletServer** ts) {
+                                         RemoteTabletServer** ts,
+                                         const MonoDelta& max_staleness) {
   // TODO: write a proper async version of this for async client.
-  RemoteTabletServer* ret = SelectTServer(rt, selection, blacklist, candidates);
+  RemoteTabletServer* ret = SelectTServer(rt, selection, blacklist, candidates, max_staleness);
   if (PREDICT_FALSE(ret == nullptr)) {
     // Construct a blacklist string if applicable.
     string blacklist_string = "";
@@ -90,12 +90,16 @@ class KuduClient::Data {
   // The 'candidates' return parameter indicates tservers that are live and meet the selection
   // criteria, but are possibly filtered by the blacklist. This is useful for implementing
   // retry logic.
+  //
+  // If 'max_staleness' is initialized, replicas known to lag further behind are
+  // avoided when the selection criteria allow for followers.
   Status GetTabletServer(KuduClient* client,
                          const scoped_refptr<internal::RemoteTablet>& rt,
                          ReplicaSelection selection,
                          const std::set<std::string>& blacklist,
                          std::vector<internal::RemoteTabletServer*>* candidates,
-                         internal::RemoteTabletServer** ts);
+                         internal::RemoteTabletServer** ts,
+                         const MonoDelta& max_staleness = MonoDelta());
 
   Status CreateTable(KuduClient* client,
                      const master::CreateTableRequestPB& req,
@@ -146,14 +150,15 @@ class KuduClient::Data {
   bool IsTabletServerLocal(const internal::RemoteTabletServer& rts) const;
 
   // Returns a non-failed replica of the specified tablet based on the provided selection criteria
-  // and tablet server blacklist.
+  // and tablet server blacklist. See GetTabletServer() for 'max_staleness'.
   //
   // Returns NULL if there are no valid tablet servers.
   internal::RemoteTabletServer* SelectTServer(
       const scoped_refptr<internal::RemoteTablet>& rt,
       const ReplicaSelection selection,
       const std::set<std::string>& blacklist,
-      std::vector<internal::RemoteTabletServer*>* candidates) const;
+      std::vector<internal::RemoteTabletServer*>* candidates,
+      const MonoDelta& max_staleness = MonoDelta()) const;
 
   // Sets 'master_proxy_' from the address specified by 'leader_addr'.
   // Called by ConnectToClusterRpc::SendRpcCb() upon successful completion.
@@ -136,7 +136,7 @@ MAKE_ENUM_LIMITS(kudu::client::KuduSession::ExternalConsistencyMode,
 
 MAKE_ENUM_LIMITS(kudu::client::KuduScanner::ReadMode,
                  kudu::client::KuduScanner::READ_LATEST,
-                 kudu::client::KuduScanner::READ_AT_SNAPSHOT);
+                 kudu::client::KuduScanner::READ_AT_BOUNDED_STALENESS);
 
 MAKE_ENUM_LIMITS(kudu::client::KuduScanner::OrderMode,
                  kudu::client::KuduScanner::UNORDERED,
@@ -1260,6 +1260,17 @@ Status KuduScanner::SetTimeoutMillis(int millis) {
   return Status::OK();
 }
 
+Status KuduScanner::SetMaxStalenessMillis(int millis) {
+  if (data_->open_) {
+    return Status::IllegalState("Maximum staleness must be set before Open()");
+  }
+  if (millis < 0) {
+    return Status::InvalidArgument("Maximum staleness must not be negative");
+  }
+  data_->mutable_configuration()->SetMaxStalenessMillis(millis);
+  return Status::OK();
+}
+
 Status KuduScanner::AddConjunctPredicate(KuduPredicate* pred) {
   if (data_->open_) {
     // Take ownership even if we return a bad status.
@@ -1619,6 +1630,14 @@ Status KuduScanTokenBuilder::SetTimeoutMillis(int millis) {
   return Status::OK();
 }
 
+Status KuduScanTokenBuilder::SetMaxStalenessMillis(int millis) {
+  if (millis < 0) {
+    return Status::InvalidArgument("Maximum staleness must not be negative");
+  }
+  data_->mutable_configuration()->SetMaxStalenessMillis(millis);
+  return Status::OK();
+}
+
 Status KuduScanTokenBuilder::AddConjunctPredicate(KuduPredicate* pred) {
   return data_->mutable_configuration()->AddConjunctPredicate(pred);
 }
@@ -1734,7 +1734,23 @@ class KUDU_EXPORT KuduScanner {
     ///   by which writes are sometimes not externally consistent even when
     ///   action was taken to make them so. In these cases Isolation may
     ///   degenerate to mode "Read Committed". See KUDU-430.
-    READ_AT_SNAPSHOT
+    READ_AT_SNAPSHOT,
+
+    /// When @c READ_AT_BOUNDED_STALENESS is specified any replica, including
+    /// a follower, may serve the read at its current safe time without
+    /// waiting, provided that safe time is no staler than the bound set with
+    /// KuduScanner::SetMaxStalenessMillis(). Replicas lagging further behind
+    /// reject the scan, which is then retried at another replica; the client
+    /// remembers their lag and avoids them for a while. Combine it with the
+    /// @c CLOSEST_REPLICA selection to offload reads from tablet leaders.
+    ///
+    /// Each tablet is read at a consistent snapshot, whose timestamp is
+    /// returned as with @c READ_AT_SNAPSHOT. Fault-tolerant scans use the
+    /// first tablet's snapshot for the rest of the scan.
+    ///
+    /// @note This mode is experimental and requires tablet servers which
+    ///   support it.
+    READ_AT_BOUNDED_STALENESS
   };
 
   /// Whether the rows should be returned in order.
@@ -2031,6 +2047,14 @@ class KUDU_EXPORT KuduScanner {
   /// @return Operation result status.
   Status SetTimeoutMillis(int millis);
 
+  /// Set the maximum staleness for scans in @c READ_AT_BOUNDED_STALENESS mode.
+  ///
+  /// @param [in] millis
+  ///   How far behind the scanned replica's clock (in milliseconds) its
+  ///   snapshot may be. Must not be negative.
+  /// @return Operation result status.
+  Status SetMaxStalenessMillis(int millis) WARN_UNUSED_RESULT;
+
   /// @return Schema of the projection being scanned.
   KuduSchema GetProjectionSchema() const;
 
@@ -2261,6 +2285,9 @@ class KUDU_EXPORT KuduScanTokenBuilder {
   /// @copydoc KuduScanner::SetTimeoutMillis
   Status SetTimeoutMillis(int millis) WARN_UNUSED_RESULT;
 
+  /// @copydoc KuduScanner::SetMaxStalenessMillis
+  Status SetMaxStalenessMillis(int millis) WARN_UNUSED_RESULT;
+
   /// Build the set of scan tokens.
   ///
   /// The builder may be reused after this call.
@@ -189,12 +189,21 @@ void RemoteTablet::Refresh(const TabletServerMap& tservers,
                              <TabletLocationsPB_ReplicaPB>& replicas) {
   // Adopt the data from the successful response.
   std::lock_guard<simple_spinlock> l(lock_);
-  replicas_.clear();
+  vector<RemoteReplica> old_replicas;
+  old_replicas.swap(replicas_);
   for (const TabletLocationsPB_ReplicaPB& r : replicas) {
     RemoteReplica rep;
     rep.ts = FindOrDie(tservers, r.ts_info().permanent_uuid());
     rep.role = r.role();
     rep.failed = false;
+    // Carry over the lag, which the master knows nothing about.
+    for (const RemoteReplica& old : old_replicas) {
+      if (old.ts == rep.ts) {
+        rep.lag = old.lag;
+        rep.lag_time = old.lag_time;
+        break;
+      }
+    }
     replicas_.push_back(rep);
   }
   stale_ = false;
@@ -235,6 +244,33 @@ int RemoteTablet::GetNumFailedReplicas() const {
   return failed;
 }
 
+void RemoteTablet::UpdateReplicaLag(const RemoteTabletServer* ts, const MonoDelta& lag) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  for (RemoteReplica& rep : replicas_) {
+    if (rep.ts == ts) {
+      rep.lag = lag;
+      rep.lag_time = MonoTime::Now();
+    }
+  }
+}
+
+bool RemoteTablet::IsReplicaKnownTooStale(const RemoteTabletServer* ts,
+                                          const MonoDelta& max_staleness) const {
+  // How long a reported lag is trusted for.
+  static const MonoDelta kReplicaLagTtl = MonoDelta::FromSeconds(10);
+
+  const MonoTime now = MonoTime::Now();
+  std::lock_guard<simple_spinlock> l(lock_);
+  for (const RemoteReplica& rep : replicas_) {
+    if (rep.ts == ts) {
+      return rep.lag_time.Initialized() &&
+          now < rep.lag_time + kReplicaLagTtl &&
+          rep.lag > max_staleness;
+    }
+  }
+  return false;
+}
+
 RemoteTabletServer* RemoteTablet::LeaderTServer() const {
   std::lock_guard<simple_spinlock> l(lock_);
   for (const RemoteReplica& replica : replicas_) {
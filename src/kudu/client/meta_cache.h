@@ -126,6 +126,12 @@ struct RemoteReplica {
   RemoteTabletServer* ts;
   consensus::RaftPeerPB::Role role;
   bool failed;
+
+  // How far the replica's safe time lagged behind its clock, as last reported
+  // in response to a bounded staleness scan, and when that was. 'lag_time' is
+  // uninitialized if the replica never reported its lag.
+  MonoDelta lag;
+  MonoTime lag_time;
 };
 
 typedef std::unordered_map<std::string, RemoteTabletServer*> TabletServerMap;
@@ -216,6 +222,15 @@ class RemoteTablet : public RefCountedThreadSafe<RemoteTablet> {
   // Return the number of failed replicas for this tablet.
   int GetNumFailedReplicas() const;
 
+  // Record the safe time lag reported by the replica hosted by 'ts'.
+  void UpdateReplicaLag(const RemoteTabletServer* ts, const MonoDelta& lag);
+
+  // Return true if the replica hosted by 'ts' recently reported a safe time
+  // lag larger than 'max_staleness'. Lags reported long ago are not trusted,
+  // since the replica has likely caught up in the meantime.
+  bool IsReplicaKnownTooStale(const RemoteTabletServer* ts,
+                              const MonoDelta& max_staleness) const;
+
   // Return the tablet server which is acting as the current LEADER for
   // this tablet, provided it hasn't failed.
   //
@@ -184,6 +184,10 @@ void ScanConfiguration::SetTimeoutMillis(int millis) {
   timeout_ = MonoDelta::FromMilliseconds(millis);
 }
 
+void ScanConfiguration::SetMaxStalenessMillis(int millis) {
+  max_staleness_ = MonoDelta::FromMilliseconds(millis);
+}
+
 Status ScanConfiguration::SetRowFormatFlags(uint64_t flags) {
   row_format_flags_ = flags;
   return Status::OK();
@@ -88,6 +88,8 @@ class ScanConfiguration {
 
   void SetTimeoutMillis(int millis);
 
+  void SetMaxStalenessMillis(int millis);
+
   Status SetRowFormatFlags(uint64_t flags);
 
   void OptimizeScanSpec();
@@ -148,6 +150,11 @@ class ScanConfiguration {
     return timeout_;
   }
 
+  // Uninitialized unless SetMaxStalenessMillis() was called.
+  const MonoDelta& max_staleness() const {
+    return max_staleness_;
+  }
+
   uint64_t row_format_flags() const {
     return row_format_flags_;
   }
@@ -186,6 +193,8 @@ class ScanConfiguration {
 
   MonoDelta timeout_;
 
+  MonoDelta max_staleness_;
+
   // Manages interior allocations for the scan spec and copied bounds.
   Arena arena_;
 
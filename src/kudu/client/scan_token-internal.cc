@@ -164,6 +164,9 @@ Status KuduScanToken::Data::PBIntoScanner(KuduClient* client,
       case ReadMode::READ_AT_SNAPSHOT:
         RETURN_NOT_OK(scan_builder->SetReadMode(KuduScanner::READ_AT_SNAPSHOT));
         break;
+      case ReadMode::READ_AT_BOUNDED_STALENESS:
+        RETURN_NOT_OK(scan_builder->SetReadMode(KuduScanner::READ_AT_BOUNDED_STALENESS));
+        break;
       default:
         return Status::InvalidArgument("scan token has unrecognized read mode");
     }
@@ -177,6 +180,10 @@ Status KuduScanToken::Data::PBIntoScanner(KuduClient* client,
     RETURN_NOT_OK(scan_builder->SetSnapshotRaw(message.snap_timestamp()));
   }
 
+  if (message.has_max_staleness_ms()) {
+    RETURN_NOT_OK(scan_builder->SetMaxStalenessMillis(message.max_staleness_ms()));
+  }
+
   RETURN_NOT_OK(scan_builder->SetCacheBlocks(message.cache_blocks()));
 
   if (message.has_propagated_timestamp()) {
@@ -244,6 +251,12 @@ Status KuduScanTokenBuilder::Data::Build(vector<KuduScanToken*>* tokens) {
         pb.set_snap_timestamp(configuration_.snapshot_timestamp());
       }
       break;
+    case KuduScanner::READ_AT_BOUNDED_STALENESS:
+      pb.set_read_mode(kudu::READ_AT_BOUNDED_STALENESS);
+      if (configuration_.max_staleness().Initialized()) {
+        pb.set_max_staleness_ms(configuration_.max_staleness().ToMilliseconds());
+      }
+      break;
     default:
       LOG(FATAL) << Substitute("$0: unexpected read mode", read_mode);
   }
@@ -115,6 +115,7 @@ Status KuduScanner::Data::HandleError(const ScanRpcStatus& err,
       reacquire_authn_token = true;
       break;
     case ScanRpcStatus::TABLET_NOT_RUNNING:
+    case ScanRpcStatus::REPLICA_TOO_STALE:
       blacklist_location = true;
       break;
     case ScanRpcStatus::TABLET_NOT_FOUND:
@@ -246,6 +247,8 @@ ScanRpcStatus KuduScanner::Data::AnalyzeResponse(const Status& rpc_status,
       return ScanRpcStatus{ScanRpcStatus::SCANNER_EXPIRED, server_status};
     case tserver::TabletServerErrorPB::TABLET_NOT_RUNNING:
       return ScanRpcStatus{ScanRpcStatus::TABLET_NOT_RUNNING, server_status};
+    case tserver::TabletServerErrorPB::REPLICA_TOO_STALE:
+      return ScanRpcStatus{ScanRpcStatus::REPLICA_TOO_STALE, server_status};
     case tserver::TabletServerErrorPB::TABLET_FAILED: // fall-through
     case tserver::TabletServerErrorPB::TABLET_NOT_FOUND:
       return ScanRpcStatus{ScanRpcStatus::TABLET_NOT_FOUND, server_status};
@@ -291,6 +294,10 @@ ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
   if (configuration().row_format_flags() & KuduScanner::PAD_UNIXTIME_MICROS_TO_16_BYTES) {
     controller_.RequireServerFeature(TabletServerFeatures::PAD_UNIXTIME_MICROS_TO_16_BYTES);
   }
+  if (next_req_.has_new_scan_request() &&
+      next_req_.new_scan_request().read_mode() == kudu::READ_AT_BOUNDED_STALENESS) {
+    controller_.RequireServerFeature(TabletServerFeatures::BOUNDED_STALENESS_READS);
+  }
   ScanRpcStatus scan_status = AnalyzeResponse(
       proxy_->Scan(next_req_,
                    &last_response_,
@@ -325,6 +332,21 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
         scan->set_snap_timestamp(configuration_.snapshot_timestamp());
       }
       break;
+    case KuduScanner::READ_AT_BOUNDED_STALENESS:
+      if (!configuration_.max_staleness().Initialized()) {
+        return Status::InvalidArgument(
+            "a maximum staleness must be set for READ_AT_BOUNDED_STALENESS scans");
+      }
+      // A fault-tolerant scan which already picked its snapshot must stick
+      // to it, wherever it's resumed.
+      if (configuration_.has_snapshot_timestamp()) {
+        scan->set_read_mode(kudu::READ_AT_SNAPSHOT);
+        scan->set_snap_timestamp(configuration_.snapshot_timestamp());
+      } else {
+        scan->set_read_mode(kudu::READ_AT_BOUNDED_STALENESS);
+        scan->set_max_staleness_usec(configuration_.max_staleness().ToMicroseconds());
+      }
+      break;
     default:
       LOG(FATAL) << Substitute("$0: unexpected read mode", read_mode);
   }
@@ -407,7 +429,9 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
         configuration_.selection(),
         *blacklist,
         &candidates,
-        &ts);
+        &ts,
+        configuration_.read_mode() == KuduScanner::READ_AT_BOUNDED_STALENESS ?
+            configuration_.max_staleness() : MonoDelta());
     // If we get ServiceUnavailable, this indicates that the tablet doesn't
     // currently have any known leader. We should sleep and retry, since
     // it's likely that the tablet is undergoing a leader election and will
@@ -432,6 +456,12 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
 
     bool allow_time_for_failover = static_cast<int>(candidates.size()) - blacklist->size() > 1;
     ScanRpcStatus scan_status = SendScanRpc(deadline, allow_time_for_failover);
+    if ((scan_status.result == ScanRpcStatus::OK ||
+         scan_status.result == ScanRpcStatus::REPLICA_TOO_STALE) &&
+        last_response_.has_replica_lag_usec()) {
+      remote_->UpdateReplicaLag(
+          ts_, MonoDelta::FromMicroseconds(last_response_.replica_lag_usec()));
+    }
     if (scan_status.result == ScanRpcStatus::OK) {
       last_error_ = Status::OK();
       scan_attempts_ = 0;
@@ -473,6 +503,15 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
     configuration_.SetSnapshotRaw(last_response_.snap_timestamp());
   }
 
+  // Pin the snapshot of fault-tolerant bounded staleness scans so that they
+  // can be resumed at another replica.
+  if (configuration_.read_mode() == KuduScanner::READ_AT_BOUNDED_STALENESS &&
+      configuration_.is_fault_tolerant() &&
+      !configuration_.has_snapshot_timestamp() &&
+      last_response_.has_snap_timestamp()) {
+    configuration_.SetSnapshotRaw(last_response_.snap_timestamp());
+  }
+
   if (last_response_.has_propagated_timestamp()) {
     table_->client()->data_->UpdateLatestObservedTimestamp(
         last_response_.propagated_timestamp());
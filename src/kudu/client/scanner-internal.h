@@ -103,6 +103,10 @@ struct ScanRpcStatus {
     // The destination tablet does not exist (e.g. because the replica was deleted).
     TABLET_NOT_FOUND,
 
+    // The destination replica lags behind by more than the maximum staleness
+    // of a READ_AT_BOUNDED_STALENESS scan.
+    REPLICA_TOO_STALE,
+
     // Some other unknown tablet server error. This indicates that the TS was running
     // but some problem occurred other than the ones enumerated above.
     OTHER_TS_ERROR
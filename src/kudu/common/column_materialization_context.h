@@ -38,7 +38,8 @@ class ColumnMaterializationContext {
       pred_(pred),
       block_(block),
       sel_(sel),
-      decoder_eval_status_(kNotSet) {
+      decoder_eval_status_(kNotSet),
+      sparse_selection_(false) {
       if (!pred_ || !sel || !block) {
         decoder_eval_status_ = kDecoderEvalNotSupported;
       }
@@ -110,6 +111,22 @@ class ColumnMaterializationContext {
     decoder_eval_status_ = kDecoderEvalNotSupported;
   }
 
+  // Set by the caller when only a small fraction of the rows in sel() remain
+  // selected. Iterators may then materialize only the selected rows, leaving
+  // the cells of unselected rows in the block undefined.
+  //
+  // Only takes effect when decoder-level evaluation is not supported.
+  void SetSparseSelection() {
+    DCHECK(sel_ != nullptr);
+    sparse_selection_ = true;
+  }
+
+  // Checked by CFileIterator::Scan() to determine whether the decoder may skip
+  // over unselected rows (on true).
+  bool sparse_selection() const {
+    return sparse_selection_;
+  }
+
  private:
   enum DecoderEvalStatus {
     // During scan, will try to evaluate with the decoder, after which the
@@ -119,8 +136,9 @@ class ColumnMaterializationContext {
     // May be set before scanning if the decoder eval flag is set to false or
     // if iterator has deltas associated with it.
     // May be set by decoder during scan if decoder eval is not supported.
-    // Once set, scanning will materialize the entire column into the block,
-    // leaving evaluation for after the scan.
+    // Once set, scanning will materialize the entire column (or, with a
+    // sparse selection, only its selected rows) into the block, leaving
+    // evaluation for after the scan.
     kDecoderEvalNotSupported,
 
     // Is set by a decoder during scan if decoder eval is supported.
@@ -138,6 +156,8 @@ class ColumnMaterializationContext {
   SelectionVector* const sel_;
 
   DecoderEvalStatus decoder_eval_status_;
+
+  bool sparse_selection_;
 };
 
 } // namespace kudu
@@ -19,6 +19,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -26,7 +27,9 @@
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
+#include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -1092,6 +1095,59 @@ TEST_F(TestColumnPredicate, TestSelectivity) {
             0);
 }
 
+// Test that evaluating a predicate on a list of selected rows has the same
+// result as evaluating it on the whole block.
+TEST_F(TestColumnPredicate, TestEvaluateSelected) {
+  const int kNumRows = 1000;
+  ColumnSchema column("a", INT32, true);
+  ScopedColumnBlock<INT32> block(kNumRows);
+  for (int i = 0; i < kNumRows; i++) {
+    block[i] = i;
+    block.SetCellIsNull(i, i % 7 == 0);
+  }
+
+  int32_t lower = 100;
+  int32_t upper = 800;
+  int32_t values[] = { 5, 21, 100, 101, 555, 999 };
+  vector<const void*> in_list;
+  for (const int32_t& v : values) {
+    in_list.push_back(&v);
+  }
+  vector<ColumnPredicate> predicates = {
+    ColumnPredicate::Range(column, &lower, &upper),
+    ColumnPredicate::Range(column, &lower, nullptr),
+    ColumnPredicate::Equality(column, &lower),
+    ColumnPredicate::IsNotNull(column),
+    ColumnPredicate::IsNull(column),
+    ColumnPredicate::InList(column, &in_list),
+  };
+
+  for (const auto& pred : predicates) {
+    SCOPED_TRACE(pred.ToString());
+    // Start from a selection with most rows already filtered out.
+    SelectionVector expected(kNumRows);
+    expected.SetAllFalse();
+    for (int i = 0; i < kNumRows; i += 3) {
+      expected.SetRowSelected(i);
+    }
+    SelectionVector actual(kNumRows);
+    memcpy(actual.mutable_bitmap(), expected.bitmap(), BitmapSize(kNumRows));
+
+    vector<uint32_t> rows;
+    actual.GetSelectedRows(&rows);
+    ASSERT_EQ(expected.CountSelected(), rows.size());
+
+    pred.Evaluate(block, &expected);
+    pred.EvaluateSelected(block, &rows, &actual);
+
+    ASSERT_EQ(expected.CountSelected(), rows.size());
+    for (uint32_t row : rows) {
+      ASSERT_TRUE(expected.IsRowSelected(row)) << row;
+    }
+    ASSERT_EQ(0, memcmp(expected.bitmap(), actual.bitmap(), BitmapSize(kNumRows)));
+  }
+}
+
 TEST_F(TestColumnPredicate, TestRedaction) {
   ASSERT_NE("", gflags::SetCommandLineOption("redact", "log"));
   ColumnSchema column_i32("a", INT32, true);
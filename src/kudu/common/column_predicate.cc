@@ -625,6 +625,49 @@ void ColumnPredicate::Evaluate(const ColumnBlock& block, SelectionVector* sel) c
   }
 }
 
+template <DataType PhysicalType>
+void ColumnPredicate::EvaluateSelectedForPhysicalType(const ColumnBlock& block,
+                                                      vector<uint32_t>* rows,
+                                                      SelectionVector* sel) const {
+  auto out = rows->begin();
+  for (uint32_t row : *rows) {
+    DCHECK(sel->IsRowSelected(row));
+    bool passes;
+    if (block.is_nullable() && block.is_null(row)) {
+      passes = predicate_type() == PredicateType::IsNull;
+    } else {
+      passes = EvaluateCell<PhysicalType>(block.cell_ptr(row));
+    }
+    if (passes) {
+      *out++ = row;
+    } else {
+      sel->SetRowUnselected(row);
+    }
+  }
+  rows->erase(out, rows->end());
+}
+
+void ColumnPredicate::EvaluateSelected(const ColumnBlock& block,
+                                       vector<uint32_t>* rows,
+                                       SelectionVector* sel) const {
+  DCHECK(sel);
+  switch (block.type_info()->physical_type()) {
+    case BOOL: return EvaluateSelectedForPhysicalType<BOOL>(block, rows, sel);
+    case INT8: return EvaluateSelectedForPhysicalType<INT8>(block, rows, sel);
+    case INT16: return EvaluateSelectedForPhysicalType<INT16>(block, rows, sel);
+    case INT32: return EvaluateSelectedForPhysicalType<INT32>(block, rows, sel);
+    case INT64: return EvaluateSelectedForPhysicalType<INT64>(block, rows, sel);
+    case UINT8: return EvaluateSelectedForPhysicalType<UINT8>(block, rows, sel);
+    case UINT16: return EvaluateSelectedForPhysicalType<UINT16>(block, rows, sel);
+    case UINT32: return EvaluateSelectedForPhysicalType<UINT32>(block, rows, sel);
+    case UINT64: return EvaluateSelectedForPhysicalType<UINT64>(block, rows, sel);
+    case FLOAT: return EvaluateSelectedForPhysicalType<FLOAT>(block, rows, sel);
+    case DOUBLE: return EvaluateSelectedForPhysicalType<DOUBLE>(block, rows, sel);
+    case BINARY: return EvaluateSelectedForPhysicalType<BINARY>(block, rows, sel);
+    default: LOG(FATAL) << "unknown physical type: " << block.type_info()->name();
+  }
+}
+
 string ColumnPredicate::ToString() const {
   switch (predicate_type()) {
     case PredicateType::None: return strings::Substitute("`$0` NONE", column_.name());
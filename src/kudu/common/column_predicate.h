@@ -164,6 +164,17 @@ class ColumnPredicate {
   // same vector as block->selection_vector().
   void Evaluate(const ColumnBlock& block, SelectionVector* sel) const;
 
+  // Evaluate the predicate only on the rows listed in 'rows', all of which
+  // must be selected in '*sel'. Rows which do not pass the predicate are
+  // cleared in '*sel' and removed from 'rows', preserving the order of the
+  // remaining entries.
+  //
+  // This is preferable to Evaluate() once only a small fraction of the rows
+  // in the block remain selected (see SelectionVector::GetSelectedRows()).
+  void EvaluateSelected(const ColumnBlock& block,
+                        std::vector<uint32_t>* rows,
+                        SelectionVector* sel) const;
+
   // Evaluate the predicate on a single cell.
   template <DataType PhysicalType>
   bool EvaluateCell(const void* cell) const {
@@ -269,6 +280,11 @@ class ColumnPredicate {
 
   // Templated evaluation to inline the dispatch of comparator. Templating this
   // allows dispatch to occur only once per batch.
+  template <DataType PhysicalType>
+  void EvaluateSelectedForPhysicalType(const ColumnBlock& block,
+                                       std::vector<uint32_t>* rows,
+                                       SelectionVector* sel) const;
+
   template <DataType PhysicalType>
   void EvaluateForPhysicalType(const ColumnBlock& block,
                                SelectionVector* sel) const;
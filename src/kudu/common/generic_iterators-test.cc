@@ -33,6 +33,7 @@
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/iterator.h"
+#include "kudu/common/iterator_stats.h"
 #include "kudu/common/generic_iterators.h"
 #include "kudu/common/column_materialization_context.h"
 #include "kudu/common/rowblock.h"
@@ -57,8 +58,6 @@ using std::vector;
 
 namespace kudu {
 
-struct IteratorStats;
-
 static const Schema kIntSchema({ ColumnSchema("val", UINT32) }, 1);
 
 // Test iterator which just yields integer rows from a provided
@@ -275,6 +274,73 @@ TEST(TestMaterializingIterator, TestMaterializingPredicatePushdown) {
   ASSERT_TRUE(dst.selection_vector()->IsRowSelected(20));
   ASSERT_TRUE(dst.selection_vector()->IsRowSelected(29));
   ASSERT_FALSE(dst.selection_vector()->IsRowSelected(30));
+
+  // Only the selected rows are counted as returned.
+  vector<IteratorStats> stats;
+  materializing.GetIteratorStats(&stats);
+  ASSERT_EQ(1, stats.size());
+  ASSERT_EQ(10, stats[0].cells_returned);
+}
+
+// Test that the MaterializingIterator reorders its predicates based on their
+// observed selectivity and cost.
+TEST(TestMaterializingIterator, TestAdaptivePredicateOrder) {
+  ScanSpec spec;
+  TestIntRangePredicate wide(0, 90);
+  TestIntRangePredicate narrow(20, 30);
+  spec.AddPredicate(wide.pred_);
+
+  shared_ptr<VectorIterator> colwise(new VectorIterator({}));
+  MaterializingIterator materializing(colwise);
+  ASSERT_OK(materializing.Init(&spec));
+  ASSERT_EQ(1, materializing.col_idx_predicates_.size());
+
+  // Both predicates are on the same column, which doesn't matter since no
+  // rows are materialized.
+  materializing.col_idx_predicates_.emplace_back(0, narrow.pred_);
+  materializing.predicate_stats_.resize(2);
+  auto first_pred = [&]() {
+    return std::get<1>(materializing.col_idx_predicates_[0]);
+  };
+  auto set_stats = [&](int idx, int64_t rows_in, int64_t rows_out, int64_t cycles) {
+    auto* stats = &materializing.predicate_stats_[idx];
+    stats->block_rows = 1000;
+    stats->rows_in = rows_in;
+    stats->rows_out = rows_out;
+    stats->cycles = cycles;
+  };
+
+  // At equal cost, the more selective predicate should go first.
+  set_stats(0, 1000, 900, 10000);
+  set_stats(1, 900, 100, 10000);
+  materializing.ReorderPredicates();
+  ASSERT_EQ(narrow.pred_, first_pred());
+
+  // The statistics are decayed after reordering.
+  ASSERT_EQ(500, materializing.predicate_stats_[0].block_rows);
+  ASSERT_EQ(450, materializing.predicate_stats_[0].rows_in);
+
+  // A cheap predicate should go before an expensive but more selective one.
+  set_stats(0, 1000, 100, 1000000);
+  set_stats(1, 100, 50, 1000);
+  materializing.ReorderPredicates();
+  ASSERT_EQ(wide.pred_, first_pred());
+
+  // A predicate which was never evaluated goes last.
+  set_stats(0, 1000, 1000, 10000);
+  set_stats(1, 0, 0, 0);
+  materializing.ReorderPredicates();
+  ASSERT_EQ(wide.pred_, first_pred());
+
+  // Predicates aren't reordered until enough blocks have been materialized.
+  set_stats(0, 1000, 1000, 10000);
+  set_stats(1, 1000, 10, 10000);
+  materializing.MaybeReorderPredicates();
+  ASSERT_EQ(wide.pred_, first_pred());
+  for (int i = 0; i < 16; i++) {
+    materializing.MaybeReorderPredicates();
+  }
+  ASSERT_EQ(narrow.pred_, first_pred());
 }
 
 // Test that PredicateEvaluatingIterator will properly evaluate predicates on its
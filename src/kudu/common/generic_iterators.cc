@@ -20,8 +20,10 @@
 #include <algorithm>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -37,12 +39,14 @@
 #include "kudu/common/iterator_stats.h"
 #include "kudu/common/row.h"
 #include "kudu/common/rowblock.h"
+#include "kudu/gutil/cycleclock-inl.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/memory/arena.h"
+#include "kudu/util/trace.h"
 
 using std::all_of;
 using std::get;
@@ -62,6 +66,18 @@ DEFINE_bool(materializing_iterator_decoder_eval, true,
             "Should MaterializingIterator do decoder-level evaluation");
 TAG_FLAG(materializing_iterator_decoder_eval, hidden);
 TAG_FLAG(materializing_iterator_decoder_eval, runtime);
+DEFINE_double(materializing_iterator_sparse_selectivity, 0.05,
+              "Once the fraction of rows in a block which pass the predicates "
+              "evaluated so far drops below this value, MaterializingIterator "
+              "materializes and evaluates the remaining columns only for the "
+              "selected rows. Set to 0 to always materialize whole blocks.");
+TAG_FLAG(materializing_iterator_sparse_selectivity, advanced);
+TAG_FLAG(materializing_iterator_sparse_selectivity, runtime);
+DEFINE_bool(materializing_iterator_adaptive_predicate_order, true,
+            "Whether MaterializingIterator should periodically reorder the predicates "
+            "it evaluates based on their observed selectivity and cost");
+TAG_FLAG(materializing_iterator_adaptive_predicate_order, advanced);
+TAG_FLAG(materializing_iterator_adaptive_predicate_order, runtime);
 
 namespace kudu {
 namespace {
@@ -450,6 +466,8 @@ void UnionIterator::GetIteratorStats(std::vector<IteratorStats>* stats) const {
 
 MaterializingIterator::MaterializingIterator(shared_ptr<ColumnwiseIterator> iter)
     : iter_(move(iter)),
+      blocks_since_reorder_(0),
+      rows_returned_(0),
       disallow_pushdown_for_tests_(!FLAGS_materializing_iterator_do_pushdown),
       disallow_decoder_eval_(!FLAGS_materializing_iterator_decoder_eval) {
 }
@@ -497,6 +515,8 @@ Status MaterializingIterator::Init(ScanSpec *spec) {
            const tuple<int32_t, ColumnPredicate>& right) {
          return SelectivityComparator(get<1>(left), get<1>(right));
        });
+  predicate_stats_.assign(col_idx_predicates_.size(), PredicateStats());
+  blocks_since_reorder_ = 0;
 
   return Status::OK();
 }
@@ -515,6 +535,7 @@ Status MaterializingIterator::NextBlock(RowBlock* dst) {
   dst->Resize(n);
   RETURN_NOT_OK(MaterializeBlock(dst));
   RETURN_NOT_OK(iter_->FinishBatch());
+  MaybeReorderPredicates();
 
   return Status::OK();
 }
@@ -522,48 +543,169 @@ Status MaterializingIterator::NextBlock(RowBlock* dst) {
 Status MaterializingIterator::MaterializeBlock(RowBlock *dst) {
   // Initialize the selection vector indicating which rows have been
   // been deleted.
-  RETURN_NOT_OK(iter_->InitializeSelectionVector(dst->selection_vector()));
+  SelectionVector* sel = dst->selection_vector();
+  RETURN_NOT_OK(iter_->InitializeSelectionVector(sel));
+
+  // Once the selection becomes sparse, the selected rows are tracked as an
+  // index list: the remaining predicates are evaluated on those rows only,
+  // and the underlying iterator is allowed to skip decoding the others.
+  const size_t sparse_threshold =
+      dst->nrows() * FLAGS_materializing_iterator_sparse_selectivity;
+  bool sparse = false;
+  size_t num_selected = sel->CountSelected();
+
+  for (size_t i = 0; i < col_idx_predicates_.size(); i++) {
+    const auto& col_pred = col_idx_predicates_[i];
+    const int64_t start_cycles = CycleClock::Now();
+    const size_t rows_in = num_selected;
 
-  for (const auto& col_pred : col_idx_predicates_) {
     // Materialize the column itself into the row block.
     ColumnBlock dst_col(dst->column_block(get<0>(col_pred)));
     ColumnMaterializationContext ctx(get<0>(col_pred),
                                      &get<1>(col_pred),
                                      &dst_col,
-                                     dst->selection_vector());
+                                     sel);
     // None predicates should be short-circuited in scan spec.
     DCHECK(ctx.pred()->predicate_type() != PredicateType::None);
-    if (disallow_decoder_eval_) {
+    if (disallow_decoder_eval_ || sparse) {
       ctx.SetDecoderEvalNotSupported();
     }
+    if (sparse) {
+      ctx.SetSparseSelection();
+    }
     RETURN_NOT_OK(iter_->MaterializeColumn(&ctx));
-    if (ctx.DecoderEvalNotSupported()) {
-      get<1>(col_pred).Evaluate(dst_col, dst->selection_vector());
+    if (sparse) {
+      get<1>(col_pred).EvaluateSelected(dst_col, &selected_rows_, sel);
+      num_selected = selected_rows_.size();
+    } else {
+      if (ctx.DecoderEvalNotSupported()) {
+        get<1>(col_pred).Evaluate(dst_col, sel);
+      }
+      num_selected = sel->CountSelected();
     }
 
+    PredicateStats* stats = &predicate_stats_[i];
+    stats->block_rows += dst->nrows();
+    stats->rows_in += rows_in;
+    stats->rows_out += num_selected;
+    stats->cycles += CycleClock::Now() - start_cycles;
+
     // If after evaluating this predicate the entire row block has been filtered
     // out, we don't need to materialize other columns at all.
-    if (!dst->selection_vector()->AnySelected()) {
+    if (num_selected == 0) {
       DVLOG(1) << "0/" << dst->nrows() << " passed predicate";
       return Status::OK();
     }
+    if (!sparse && num_selected < sparse_threshold) {
+      sel->GetSelectedRows(&selected_rows_);
+      sparse = true;
+    }
   }
 
+  // Late materialization: the remaining columns only need to be decoded for
+  // the rows which passed the predicates.
+  const bool late_materialize = num_selected < dst->nrows();
   for (size_t col_idx : non_predicate_column_indexes_) {
     // Materialize the column itself into the row block.
     ColumnBlock dst_col(dst->column_block(col_idx));
     ColumnMaterializationContext ctx(col_idx,
                                      nullptr,
                                      &dst_col,
-                                     dst->selection_vector());
+                                     sel);
+    if (late_materialize) {
+      ctx.SetSparseSelection();
+    }
     RETURN_NOT_OK(iter_->MaterializeColumn(&ctx));
   }
 
-  DVLOG(1) << dst->selection_vector()->CountSelected() << "/"
-           << dst->nrows() << " passed predicate";
+  rows_returned_ += num_selected;
+  DVLOG(1) << num_selected << "/" << dst->nrows() << " passed predicate";
   return Status::OK();
 }
 
+double MaterializingIterator::PredicateStats::Rank() const {
+  if (block_rows == 0 || rows_in == 0) {
+    // Never evaluated, or only on blocks which were already filtered out:
+    // nothing is known about the predicate, so keep it last.
+    return std::numeric_limits<double>::max();
+  }
+  // Most of the cost of a predicate is materializing its column, which is
+  // proportional to the size of the block rather than to the number of rows
+  // still selected.
+  double cost_per_row = static_cast<double>(cycles) / block_rows;
+  double fraction_eliminated = 1.0 - static_cast<double>(rows_out) / rows_in;
+  return cost_per_row / std::max(fraction_eliminated, 1e-6);
+}
+
+string MaterializingIterator::PredicateStats::ToString() const {
+  return strings::Substitute("rows_in=$0 rows_out=$1 cycles_per_row=$2",
+                             rows_in, rows_out, block_rows == 0 ? 0 : cycles / block_rows);
+}
+
+void MaterializingIterator::MaybeReorderPredicates() {
+  // Reorder every this many blocks.
+  static const int kReorderIntervalBlocks = 16;
+  if (col_idx_predicates_.size() < 2 ||
+      !FLAGS_materializing_iterator_adaptive_predicate_order ||
+      ++blocks_since_reorder_ < kReorderIntervalBlocks) {
+    return;
+  }
+  blocks_since_reorder_ = 0;
+  ReorderPredicates();
+}
+
+void MaterializingIterator::ReorderPredicates() {
+  vector<double> ranks;
+  ranks.reserve(predicate_stats_.size());
+  for (const auto& stats : predicate_stats_) {
+    ranks.push_back(stats.Rank());
+  }
+  vector<size_t> order(col_idx_predicates_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return ranks[a] < ranks[b];
+  });
+
+  if (!std::is_sorted(order.begin(), order.end())) {
+    vector<tuple<int32_t, ColumnPredicate>> predicates;
+    vector<PredicateStats> stats;
+    predicates.reserve(order.size());
+    stats.reserve(order.size());
+    for (size_t idx : order) {
+      predicates.emplace_back(move(col_idx_predicates_[idx]));
+      stats.emplace_back(predicate_stats_[idx]);
+    }
+    col_idx_predicates_ = move(predicates);
+    predicate_stats_ = move(stats);
+
+    string order_str;
+    for (size_t i = 0; i < col_idx_predicates_.size(); i++) {
+      if (i > 0) order_str.append(", ");
+      order_str.append(strings::Substitute("$0 ($1)",
+                                           get<1>(col_idx_predicates_[i]).ToString(),
+                                           predicate_stats_[i].ToString()));
+    }
+    TRACE("Reordered predicates: $0", order_str);
+    VLOG(1) << "Reordered predicates: " << order_str;
+  }
+
+  // Halve the statistics, so that the order keeps adapting if the data
+  // changes over the course of the scan.
+  for (auto& stats : predicate_stats_) {
+    stats.block_rows /= 2;
+    stats.rows_in /= 2;
+    stats.rows_out /= 2;
+    stats.cycles /= 2;
+  }
+}
+
+void MaterializingIterator::GetIteratorStats(vector<IteratorStats>* stats) const {
+  iter_->GetIteratorStats(stats);
+  for (IteratorStats& col_stats : *stats) {
+    col_stats.cells_returned += rows_returned_;
+  }
+}
+
 string MaterializingIterator::ToString() const {
   string s;
   s.append("Materializing(").append(iter_->ToString()).append(")");
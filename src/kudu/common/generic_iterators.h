@@ -174,6 +174,11 @@ class UnionIterator : public RowwiseIterator {
 // block, columns with associated predicates are materialized first, and the
 // predicates evaluated. If the predicates succeed in filtering out an entire
 // batch, then other columns may avoid doing any IO.
+//
+// The predicates are initially ordered by their estimated selectivity. As the
+// scan progresses, the observed selectivity and cost of each predicate is used
+// to periodically reorder them, so that cheap and selective predicates are
+// evaluated first.
 class MaterializingIterator : public RowwiseIterator {
  public:
   explicit MaterializingIterator(std::shared_ptr<ColumnwiseIterator> iter);
@@ -189,26 +194,76 @@ class MaterializingIterator : public RowwiseIterator {
     return iter_->schema();
   }
 
-  virtual void GetIteratorStats(std::vector<IteratorStats>* stats) const OVERRIDE {
-    iter_->GetIteratorStats(stats);
-  }
+  virtual void GetIteratorStats(std::vector<IteratorStats>* stats) const OVERRIDE;
 
   virtual Status NextBlock(RowBlock* dst) OVERRIDE;
 
  private:
   FRIEND_TEST(TestMaterializingIterator, TestPredicatePushdown);
   FRIEND_TEST(TestPredicateEvaluatingIterator, TestPredicateEvaluation);
+  FRIEND_TEST(TestMaterializingIterator, TestAdaptivePredicateOrder);
+
+  // Statistics about the evaluation of a single predicate, accumulated since
+  // the predicates were last reordered.
+  struct PredicateStats {
+    PredicateStats()
+        : block_rows(0),
+          rows_in(0),
+          rows_out(0),
+          cycles(0) {
+    }
+
+    // Returns the expected cost of evaluating the predicate per row it
+    // eliminates. Predicates with lower ranks should be evaluated first.
+    double Rank() const;
+
+    std::string ToString() const;
+
+    // Total number of rows in the blocks on which the predicate was evaluated.
+    int64_t block_rows;
+
+    // Number of rows which were selected before and after the predicate was
+    // evaluated.
+    int64_t rows_in;
+    int64_t rows_out;
+
+    // CPU cycles spent materializing the predicate's column and evaluating it.
+    int64_t cycles;
+  };
 
   Status MaterializeBlock(RowBlock *dst);
 
+  // Reorders the predicates by the rank of their statistics, if enough blocks
+  // have been materialized since they were last reordered.
+  void MaybeReorderPredicates();
+
+  // Reorders 'col_idx_predicates_' and 'predicate_stats_' by rank, and decays
+  // the statistics so that recent blocks carry more weight.
+  void ReorderPredicates();
+
   std::shared_ptr<ColumnwiseIterator> iter_;
 
-  // List of (column index, predicate) in order of most to least selective.
+  // List of (column index, predicate) in the order of evaluation.
   std::vector<std::tuple<int32_t, ColumnPredicate>> col_idx_predicates_;
 
+  // Statistics for each entry of 'col_idx_predicates_', at the same index.
+  std::vector<PredicateStats> predicate_stats_;
+
+  // Number of blocks materialized since the predicates were last reordered.
+  int blocks_since_reorder_;
+
   // List of column indexes without predicates to materialize.
   std::vector<int32_t> non_predicate_column_indexes_;
 
+  // Indexes of the rows still selected in the block being materialized. Only
+  // populated once the block's selectivity drops below
+  // --materializing_iterator_sparse_selectivity; kept across blocks to reuse
+  // its allocation.
+  std::vector<uint32_t> selected_rows_;
+
+  // The number of rows which passed all predicates so far.
+  int64_t rows_returned_;
+
   // Set only by test code to disallow pushdown.
   bool disallow_pushdown_for_tests_;
   bool disallow_decoder_eval_;
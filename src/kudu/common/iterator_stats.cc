@@ -29,22 +29,34 @@ using strings::Substitute;
 IteratorStats::IteratorStats()
     : data_blocks_read_from_disk(0),
       bytes_read_from_disk(0),
-      cells_read_from_disk(0) {
+      cells_read_from_disk(0),
+      cells_decoded(0),
+      cells_returned(0),
+      delta_stores_skipped(0) {
 }
 
 string IteratorStats::ToString() const {
   return Substitute("data_blocks_read_from_disk=$0 "
                     "bytes_read_from_disk=$1 "
-                    "cells_read_from_disk=$2",
+                    "cells_read_from_disk=$2 "
+                    "cells_decoded=$3 "
+                    "cells_returned=$4 "
+                    "delta_stores_skipped=$5",
                     data_blocks_read_from_disk,
                     bytes_read_from_disk,
-                    cells_read_from_disk);
+                    cells_read_from_disk,
+                    cells_decoded,
+                    cells_returned,
+                    delta_stores_skipped);
 }
 
 void IteratorStats::AddStats(const IteratorStats& other) {
   data_blocks_read_from_disk += other.data_blocks_read_from_disk;
   bytes_read_from_disk += other.bytes_read_from_disk;
   cells_read_from_disk += other.cells_read_from_disk;
+  cells_decoded += other.cells_decoded;
+  cells_returned += other.cells_returned;
+  delta_stores_skipped += other.delta_stores_skipped;
   DCheckNonNegative();
 }
 
@@ -52,6 +64,9 @@ void IteratorStats::SubtractStats(const IteratorStats& other) {
   data_blocks_read_from_disk -= other.data_blocks_read_from_disk;
   bytes_read_from_disk -= other.bytes_read_from_disk;
   cells_read_from_disk -= other.cells_read_from_disk;
+  cells_decoded -= other.cells_decoded;
+  cells_returned -= other.cells_returned;
+  delta_stores_skipped -= other.delta_stores_skipped;
   DCheckNonNegative();
 }
 
@@ -59,6 +74,9 @@ void IteratorStats::DCheckNonNegative() const {
   DCHECK_GE(data_blocks_read_from_disk, 0);
   DCHECK_GE(bytes_read_from_disk, 0);
   DCHECK_GE(cells_read_from_disk, 0);
+  DCHECK_GE(cells_decoded, 0);
+  DCHECK_GE(cells_returned, 0);
+  DCHECK_GE(delta_stores_skipped, 0);
 }
 
 
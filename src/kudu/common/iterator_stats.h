@@ -37,6 +37,19 @@ struct IteratorStats {
   // they were decoded/materialized.
   int64_t cells_read_from_disk;
 
+  // The number of cells which were decoded into row blocks. With late
+  // materialization, the cells of rows which were already filtered out by
+  // a predicate are not decoded.
+  int64_t cells_decoded;
+
+  // The number of cells which passed the predicates evaluated by the
+  // iterator and were returned to its caller.
+  int64_t cells_returned;
+
+  // The number of delta stores which were skipped entirely because their
+  // stats showed they could not affect the scanned columns or rows.
+  int64_t delta_stores_skipped;
+
   // Add statistics contained 'other' to this object (for each field
   // in this object, increment it by the value of the equivalent field
   // in 'other').
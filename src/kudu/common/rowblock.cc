@@ -16,11 +16,16 @@
 // under the License.
 #include "kudu/common/rowblock.h"
 
+#include <vector>
+
 #include <glog/logging.h>
 
 #include "kudu/gutil/bits.h"
+#include "kudu/gutil/port.h"
 #include "kudu/util/bitmap.h"
 
+using std::vector;
+
 namespace kudu {
 
 SelectionVector::SelectionVector(size_t row_capacity)
@@ -72,6 +77,28 @@ bool SelectionVector::AnySelected() const {
   return false;
 }
 
+void SelectionVector::GetSelectedRows(vector<uint32_t>* rows) const {
+  rows->clear();
+  // Scan a word at a time, so that runs of unselected rows are skipped
+  // cheaply. Resize() guarantees that the bits past n_rows_ in the last byte
+  // are zero.
+  size_t byte_idx = 0;
+  for (; byte_idx + 8 <= n_bytes_; byte_idx += 8) {
+    uint64_t word = UNALIGNED_LOAD64(&bitmap_[byte_idx]);
+    while (word != 0) {
+      rows->push_back(byte_idx * 8 + Bits::FindLSBSetNonZero64(word));
+      word &= word - 1;
+    }
+  }
+  for (; byte_idx < n_bytes_; byte_idx++) {
+    uint32_t byte = bitmap_[byte_idx];
+    while (byte != 0) {
+      rows->push_back(byte_idx * 8 + Bits::FindLSBSetNonZero(byte));
+      byte &= byte - 1;
+    }
+  }
+}
+
 //////////////////////////////
 // RowBlock
 //////////////////////////////
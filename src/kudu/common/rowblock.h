@@ -70,6 +70,13 @@ class SelectionVector {
   // This is equivalent to (CountSelected() > 0), but faster.
   bool AnySelected() const;
 
+  // Replace the contents of 'rows' with the indexes of the selected rows,
+  // in ascending order.
+  //
+  // Once few rows remain selected, iterating this list is much cheaper than
+  // testing every bit of the vector.
+  void GetSelectedRows(std::vector<uint32_t>* rows) const;
+
   bool IsRowSelected(size_t row) const {
     DCHECK_LT(row, n_rows_);
     return BitmapTest(&bitmap_[0], row);
@@ -146,7 +153,7 @@ class SelectionVectorView {
     DCHECK_LE(row_idx, sel_vec_->nrows() - row_offset_);
     BitmapClear(sel_vec_->mutable_bitmap(), row_offset_ + row_idx);
   }
-  bool TestBit(size_t row_idx) {
+  bool TestBit(size_t row_idx) const {
     DCHECK_LE(row_idx, sel_vec_->nrows() - row_offset_);
     return BitmapTest(sel_vec_->bitmap(), row_offset_ + row_idx);
   }
@@ -154,6 +161,21 @@ class SelectionVectorView {
     DCHECK_LE(nrows, sel_vec_->nrows() - row_offset_);
     BitmapChangeBits(sel_vec_->mutable_bitmap(), row_offset_, nrows, false);
   }
+  // Return the number of consecutive rows, starting at 'row_idx' and spanning
+  // at most 'max_rows', which share the selection state of 'row_idx'. That
+  // state is returned in 'selected'.
+  size_t NextRun(size_t row_idx, size_t max_rows, bool* selected) const {
+    DCHECK_GT(max_rows, 0);
+    DCHECK_LE(row_idx + max_rows, sel_vec_->nrows() - row_offset_);
+    size_t start = row_offset_ + row_idx;
+    size_t end = start + max_rows;
+    *selected = BitmapTest(sel_vec_->bitmap(), start);
+    size_t run_end;
+    if (!BitmapFindFirst(sel_vec_->bitmap(), start, end, !*selected, &run_end)) {
+      run_end = end;
+    }
+    return run_end - start;
+  }
  private:
   SelectionVector* sel_vec_;
   size_t row_offset_;
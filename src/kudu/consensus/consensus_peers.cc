@@ -37,7 +37,9 @@
 #include "kudu/consensus/consensus.proxy.h"
 #include "kudu/consensus/consensus_queue.h"
 #include "kudu/consensus/metadata.pb.h"
+#include "kudu/consensus/multi_raft_batcher.h"
 #include "kudu/consensus/opid_util.h"
+#include "kudu/consensus/replicate_sidecars.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/move.h"
@@ -46,6 +48,7 @@
 #include "kudu/rpc/periodic.h"
 #include "kudu/rpc/response_callback.h"
 #include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
@@ -54,6 +57,7 @@
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/pb_util.h"
+#include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/status.h"
 #include "kudu/util/threadpool.h"
 
@@ -65,6 +69,15 @@ DEFINE_int32(raft_get_node_instance_timeout_ms, 30000,
              "Timeout for retrieving node instance data over RPC.");
 TAG_FLAG(raft_get_node_instance_timeout_ms, hidden);
 
+DEFINE_int32(consensus_max_inflight_requests_per_peer, 1,
+             "Maximum number of UpdateConsensus requests with operations that a "
+             "leader may have in flight to each of its peers. Values above one "
+             "pipeline the replication of operations to followers, which helps "
+             "when the round-trip time to them is high.");
+TAG_FLAG(consensus_max_inflight_requests_per_peer, advanced);
+TAG_FLAG(consensus_max_inflight_requests_per_peer, experimental);
+TAG_FLAG(consensus_max_inflight_requests_per_peer, runtime);
+
 DEFINE_double(fault_crash_on_leader_request_fraction, 0.0,
               "Fraction of the time when the leader will crash just before sending an "
               "UpdateConsensus RPC. (For testing only!)");
@@ -84,6 +97,7 @@ DEFINE_bool(enable_tablet_copy, true,
             "replica. For testing purposes only.");
 TAG_FLAG(enable_tablet_copy, unsafe);
 
+DECLARE_bool(enable_multi_raft_heartbeat_batcher);
 DECLARE_int32(raft_heartbeat_interval_ms);
 
 using kudu::pb_util::SecureShortDebugString;
@@ -93,6 +107,7 @@ using kudu::rpc::RpcController;
 using kudu::tserver::TabletServerErrorPB;
 using std::shared_ptr;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 using std::weak_ptr;
 using strings::Substitute;
@@ -135,6 +150,7 @@ Peer::Peer(RaftPeerPB peer_pb,
       proxy_(std::move(proxy)),
       queue_(queue),
       failed_attempts_(0),
+      last_sent_committed_index_(kMinimumOpIdIndex),
       messenger_(std::move(messenger)),
       raft_pool_token_(raft_pool_token) {
 }
@@ -184,19 +200,13 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
     return;
   }
 
-  // Only allow one request at a time.
-  if (request_pending_) {
+  // Don't send anything while a tablet copy is being initiated, and only
+  // allow as many requests in flight as the window permits.
+  size_t max_in_flight = std::max(FLAGS_consensus_max_inflight_requests_per_peer, 1);
+  if (tablet_copy_pending_ || in_flight_.size() >= max_in_flight) {
     return;
   }
 
-  // For the first request sent by the peer, we send it even if the queue is empty,
-  // which it will always appear to be for the first request, since this is the
-  // negotiation round.
-  if (!has_sent_first_request_) {
-    even_if_queue_empty = true;
-    has_sent_first_request_ = true;
-  }
-
   // If our last request generated an error, and this is not a normal
   // heartbeat request, then don't send the "per-op" request. Instead,
   // we'll wait for the heartbeat.
@@ -207,19 +217,38 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
   // exponential backoff after an error. As it is implemented today, any
   // transient error will result in a latency blip as long as the heartbeat
   // period.
-  if (failed_attempts_ > 0 && !even_if_queue_empty) {
+  //
+  // For the same reason, don't pipeline requests behind ones which may fail.
+  bool pipelined = !in_flight_.empty();
+  if (failed_attempts_ > 0 && (pipelined || !even_if_queue_empty)) {
     return;
   }
 
-  // The peer has no pending request nor is sending: send the request.
-  bool needs_tablet_copy = false;
-  int64_t commit_index_before = request_.has_committed_index() ?
-      request_.committed_index() : kMinimumOpIdIndex;
-  Status s = queue_->RequestForPeer(peer_pb_.permanent_uuid(), &request_,
-                                    &replicate_msg_refs_, &needs_tablet_copy);
-  int64_t commit_index_after = request_.has_committed_index() ?
-      request_.committed_index() : kMinimumOpIdIndex;
+  // For the first request sent by the peer, we send it even if the queue is empty,
+  // which it will always appear to be for the first request, since this is the
+  // negotiation round.
+  bool first_request = !has_sent_first_request_;
+  if (first_request) {
+    even_if_queue_empty = true;
+    has_sent_first_request_ = true;
+  }
+
+  unique_ptr<PendingRequest> req;
+  if (free_requests_.empty()) {
+    req.reset(new PendingRequest);
+  } else {
+    req = std::move(free_requests_.back());
+    free_requests_.pop_back();
+  }
+  // Return the request for reuse if it turns out there's nothing to send.
+  auto release_req = MakeScopedCleanup([&]() {
+    free_requests_.emplace_back(std::move(req));
+  });
 
+  bool needs_tablet_copy = false;
+  Status s = queue_->RequestForPeer(peer_pb_.permanent_uuid(), &req->request,
+                                    &req->replicate_msg_refs, &needs_tablet_copy,
+                                    pipelined, &req->seqno);
   if (PREDICT_FALSE(!s.ok())) {
     LOG_WITH_PREFIX_UNLOCKED(INFO) << "Could not obtain request from queue for peer: "
         << peer_pb_.permanent_uuid() << ". Status: " << s.ToString();
@@ -227,10 +256,14 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
   }
 
   if (PREDICT_FALSE(needs_tablet_copy)) {
+    // Wait for the requests in flight to complete before initiating tablet copy.
+    if (pipelined) {
+      return;
+    }
     Status s = PrepareTabletCopyRequest();
     if (s.ok()) {
       controller_.Reset();
-      request_pending_ = true;
+      tablet_copy_pending_ = true;
       l.unlock();
       // Capture a shared_ptr reference into the RPC callback so that we're guaranteed
       // that this object outlives the RPC.
@@ -246,14 +279,20 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
     return;
   }
 
-  request_.set_tablet_id(tablet_id_);
-  request_.set_caller_uuid(leader_uuid_);
-  request_.set_dest_uuid(peer_pb_.permanent_uuid());
+  ConsensusRequestPB* request = &req->request;
+  request->set_tablet_id(tablet_id_);
+  request->set_caller_uuid(leader_uuid_);
+  request->set_dest_uuid(peer_pb_.permanent_uuid());
 
-  bool req_has_ops = request_.ops_size() > 0 || (commit_index_after > commit_index_before);
+  int64_t commit_index = request->has_committed_index() ?
+      request->committed_index() : kMinimumOpIdIndex;
+  bool req_has_ops = request->ops_size() > 0 ||
+      (commit_index > last_sent_committed_index_);
   // If the queue is empty, check if we were told to send a status-only
-  // message, if not just return.
-  if (PREDICT_FALSE(!req_has_ops && !even_if_queue_empty)) {
+  // message, if not just return. Pipelined requests are only worth sending
+  // if they carry operations.
+  if (PREDICT_FALSE(pipelined ? request->ops_size() == 0
+                              : !req_has_ops && !even_if_queue_empty)) {
     return;
   }
 
@@ -266,65 +305,94 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
 
 
   VLOG_WITH_PREFIX_UNLOCKED(2) << "Sending to peer " << peer_pb().permanent_uuid() << ": "
-      << SecureShortDebugString(request_);
-  controller_.Reset();
+      << SecureShortDebugString(*request);
+  req->controller.Reset();
+
+  // Send the operations' serialized form, shared with the other peers, rather
+  // than serializing them into the request.
+  if (request->ops_size() > 0 && replicate_sidecars_supported_ &&
+      proxy_->SupportsReplicateSidecars() &&
+      MoveOpsToSidecars(req->replicate_msg_refs, request, &req->controller)) {
+    req->controller.RequireServerFeature(ConsensusFeatures::REPLICATE_SIDECARS);
+  }
 
-  request_pending_ = true;
+  last_sent_committed_index_ = commit_index;
+  release_req.cancel();
+  req->send_time = MonoTime::Now();
+  PendingRequest* raw_req = req.get();
+  in_flight_.emplace_back(std::move(req));
   l.unlock();
   // Capture a shared_ptr reference into the RPC callback so that we're guaranteed
   // that this object outlives the RPC.
   shared_ptr<Peer> s_this = shared_from_this();
-  proxy_->UpdateAsync(&request_, &response_, &controller_,
-                      [s_this]() {
-                        s_this->ProcessResponse();
-                      });
+  auto cb = [s_this, raw_req]() {
+    s_this->ProcessResponse(raw_req);
+  };
+  // Plain heartbeats may be batched with those of other tablets. The
+  // negotiation round and retries after errors are sent on their own so that
+  // their failures are reported promptly.
+  if (!req_has_ops && !first_request && failed_attempts_ == 0) {
+    proxy_->UpdateHeartbeatAsync(&raw_req->request, &raw_req->response, &raw_req->controller,
+                                 cb);
+  } else {
+    proxy_->UpdateAsync(&raw_req->request, &raw_req->response, &raw_req->controller, cb);
+  }
 }
 
-void Peer::ProcessResponse() {
+void Peer::ProcessResponse(PendingRequest* req) {
   // Note: This method runs on the reactor thread.
   std::unique_lock<simple_spinlock> lock(peer_lock_);
   if (closed_) {
     return;
   }
-  CHECK(request_pending_);
 
   MAYBE_FAULT(FLAGS_fault_crash_after_leader_request_fraction);
 
+  const RpcController& controller = req->controller;
+  const ConsensusResponsePB& response = req->response;
+
   // Process RpcController errors.
-  if (!controller_.status().ok()) {
-    auto ps = controller_.status().IsRemoteError() ?
+  if (!controller.status().ok()) {
+    if (controller.status().IsRemoteError() && req->request.ops_sidecars_size() > 0 &&
+        controller.error_response() &&
+        controller.error_response()->unsupported_feature_flags_size() > 0) {
+      LOG_WITH_PREFIX_UNLOCKED(INFO) << "Peer does not support receiving operations in "
+                                     << "RPC sidecars; sending them in requests instead";
+      replicate_sidecars_supported_ = false;
+    }
+    auto ps = controller.status().IsRemoteError() ?
         PeerStatus::REMOTE_ERROR : PeerStatus::RPC_LAYER_ERROR;
-    queue_->UpdatePeerStatus(peer_pb_.permanent_uuid(), ps, controller_.status());
-    ProcessResponseError(controller_.status());
+    queue_->UpdatePeerStatus(peer_pb_.permanent_uuid(), ps, controller.status());
+    ProcessResponseError(controller.status(), req);
     return;
   }
 
   // Process CANNOT_PREPARE.
   // TODO(todd): there is no integration test coverage of this code path. Likely a bug in
   // this path is responsible for KUDU-1779.
-  if (response_.status().has_error() &&
-      response_.status().error().code() == consensus::ConsensusErrorPB::CANNOT_PREPARE) {
-    Status response_status = StatusFromPB(response_.status().error().status());
+  if (response.status().has_error() &&
+      response.status().error().code() == consensus::ConsensusErrorPB::CANNOT_PREPARE) {
+    Status response_status = StatusFromPB(response.status().error().status());
     queue_->UpdatePeerStatus(peer_pb_.permanent_uuid(), PeerStatus::CANNOT_PREPARE,
                              response_status);
-    ProcessResponseError(response_status);
+    ProcessResponseError(response_status, req);
     return;
   }
 
   // Process tserver-level errors.
-  if (response_.has_error()) {
-    Status response_status = StatusFromPB(response_.error().status());
+  if (response.has_error()) {
+    Status response_status = StatusFromPB(response.error().status());
     PeerStatus ps;
-    if (response_.error().code() == TabletServerErrorPB::TABLET_FAILED) {
+    if (response.error().code() == TabletServerErrorPB::TABLET_FAILED) {
       ps = PeerStatus::TABLET_FAILED;
-    } else if (response_.error().code() == TabletServerErrorPB::TABLET_NOT_FOUND) {
+    } else if (response.error().code() == TabletServerErrorPB::TABLET_NOT_FOUND) {
       ps = PeerStatus::TABLET_NOT_FOUND;
     } else {
       // Unknown kind of error.
       ps = PeerStatus::REMOTE_ERROR;
     }
     queue_->UpdatePeerStatus(peer_pb_.permanent_uuid(), ps, response_status);
-    ProcessResponseError(response_status);
+    ProcessResponseError(response_status, req);
     return;
   }
 
@@ -334,34 +402,34 @@ void Peer::ProcessResponse() {
   // thread.
   //
   // Capture a weak_ptr reference into the submitted functor so that we can
-  // safely handle the functor outliving its peer.
+  // safely handle the functor outliving its peer. 'req' remains in flight,
+  // and thus valid, until the functor releases it.
   weak_ptr<Peer> w_this = shared_from_this();
-  Status s = raft_pool_token_->SubmitFunc([w_this]() {
+  Status s = raft_pool_token_->SubmitFunc([w_this, req]() {
     if (auto p = w_this.lock()) {
-      p->DoProcessResponse();
-
+      p->DoProcessResponse(req);
     }
   });
   if (PREDICT_FALSE(!s.ok())) {
     LOG_WITH_PREFIX_UNLOCKED(WARNING) << "Unable to process peer response: " << s.ToString()
-        << ": " << SecureShortDebugString(response_);
-    request_pending_ = false;
+        << ": " << SecureShortDebugString(response);
+    ReleaseRequestUnlocked(req);
   }
 }
 
-void Peer::DoProcessResponse() {
+void Peer::DoProcessResponse(PendingRequest* req) {
 
   VLOG_WITH_PREFIX_UNLOCKED(2) << "Response from peer " << peer_pb().permanent_uuid() << ": "
-      << SecureShortDebugString(response_);
+      << SecureShortDebugString(req->response);
 
   bool more_pending;
-  queue_->ResponseFromPeer(peer_pb_.permanent_uuid(), response_, &more_pending);
+  queue_->ResponseFromPeer(peer_pb_.permanent_uuid(), req->response, &more_pending,
+                           req->send_time, req->seqno);
 
   {
     std::unique_lock<simple_spinlock> lock(peer_lock_);
-    CHECK(request_pending_);
     failed_attempts_ = 0;
-    request_pending_ = false;
+    ReleaseRequestUnlocked(req);
   }
   // We're OK to read the state_ without a lock here -- if we get a race,
   // the worst thing that could happen is that we'll make one more request before
@@ -371,6 +439,17 @@ void Peer::DoProcessResponse() {
   }
 }
 
+void Peer::ReleaseRequestUnlocked(PendingRequest* req) {
+  DCHECK(peer_lock_.is_locked());
+  auto it = std::find_if(in_flight_.begin(), in_flight_.end(),
+                         [req](const unique_ptr<PendingRequest>& r) {
+                           return r.get() == req;
+                         });
+  CHECK(it != in_flight_.end());
+  free_requests_.emplace_back(std::move(*it));
+  in_flight_.erase(it);
+}
+
 Status Peer::PrepareTabletCopyRequest() {
   if (!FLAGS_enable_tablet_copy) {
     failed_attempts_++;
@@ -388,8 +467,8 @@ void Peer::ProcessTabletCopyResponse() {
   if (closed_) {
     return;
   }
-  CHECK(request_pending_);
-  request_pending_ = false;
+  CHECK(tablet_copy_pending_);
+  tablet_copy_pending_ = false;
 
   // If the response is OK, or ALREADY_INPROGRESS, then consider the RPC successful.
   bool success =
@@ -411,13 +490,13 @@ void Peer::ProcessTabletCopyResponse() {
   }
 }
 
-void Peer::ProcessResponseError(const Status& status) {
+void Peer::ProcessResponseError(const Status& status, PendingRequest* req) {
   failed_attempts_++;
   string resp_err_info;
-  if (response_.has_error()) {
+  if (req->response.has_error()) {
     resp_err_info = Substitute(" Error code: $0 ($1).",
-                               TabletServerErrorPB::Code_Name(response_.error().code()),
-                               response_.error().code());
+                               TabletServerErrorPB::Code_Name(req->response.error().code()),
+                               req->response.error().code());
   }
   LOG_WITH_PREFIX_UNLOCKED(WARNING) << "Couldn't send request to peer " << peer_pb_.permanent_uuid()
       << " for tablet " << tablet_id_ << "."
@@ -425,7 +504,7 @@ void Peer::ProcessResponseError(const Status& status) {
       << " Status: " << status.ToString() << "."
       << " Retrying in the next heartbeat period."
       << " Already tried " << failed_attempts_ << " times.";
-  request_pending_ = false;
+  ReleaseRequestUnlocked(req);
 }
 
 string Peer::LogPrefixUnlocked() const {
@@ -453,13 +532,19 @@ Peer::~Peer() {
   }
 
   // We don't own the ops (the queue does).
-  request_.mutable_ops()->ExtractSubrange(0, request_.ops_size(), nullptr);
+  auto release_ops = [](const unique_ptr<PendingRequest>& req) {
+    req->request.mutable_ops()->ExtractSubrange(0, req->request.ops_size(), nullptr);
+  };
+  std::for_each(in_flight_.begin(), in_flight_.end(), release_ops);
+  std::for_each(free_requests_.begin(), free_requests_.end(), release_ops);
 }
 
 RpcPeerProxy::RpcPeerProxy(gscoped_ptr<HostPort> hostport,
-                           gscoped_ptr<ConsensusServiceProxy> consensus_proxy)
+                           gscoped_ptr<ConsensusServiceProxy> consensus_proxy,
+                           shared_ptr<MultiRaftHeartbeatBatcher> heartbeat_batcher)
     : hostport_(std::move(hostport)),
-      consensus_proxy_(std::move(consensus_proxy)) {
+      consensus_proxy_(std::move(consensus_proxy)),
+      heartbeat_batcher_(std::move(heartbeat_batcher)) {
 }
 
 void RpcPeerProxy::UpdateAsync(const ConsensusRequestPB* request,
@@ -470,6 +555,17 @@ void RpcPeerProxy::UpdateAsync(const ConsensusRequestPB* request,
   consensus_proxy_->UpdateConsensusAsync(*request, response, controller, callback);
 }
 
+void RpcPeerProxy::UpdateHeartbeatAsync(const ConsensusRequestPB* request,
+                                        ConsensusResponsePB* response,
+                                        rpc::RpcController* controller,
+                                        const rpc::ResponseCallback& callback) {
+  if (!heartbeat_batcher_) {
+    UpdateAsync(request, response, controller, callback);
+    return;
+  }
+  heartbeat_batcher_->AddRequestToBatch(request, response, controller, callback);
+}
+
 void RpcPeerProxy::RequestConsensusVoteAsync(const VoteRequestPB* request,
                                              VoteResponsePB* response,
                                              rpc::RpcController* controller,
@@ -504,8 +600,10 @@ Status CreateConsensusServiceProxyForHost(const shared_ptr<Messenger>& messenger
 
 } // anonymous namespace
 
-RpcPeerProxyFactory::RpcPeerProxyFactory(shared_ptr<Messenger> messenger)
-    : messenger_(std::move(messenger)) {}
+RpcPeerProxyFactory::RpcPeerProxyFactory(shared_ptr<Messenger> messenger,
+                                         MultiRaftManager* multi_raft_manager)
+    : messenger_(std::move(messenger)),
+      multi_raft_manager_(multi_raft_manager) {}
 
 Status RpcPeerProxyFactory::NewProxy(const RaftPeerPB& peer_pb,
                                      gscoped_ptr<PeerProxy>* proxy) {
@@ -513,7 +611,11 @@ Status RpcPeerProxyFactory::NewProxy(const RaftPeerPB& peer_pb,
   RETURN_NOT_OK(HostPortFromPB(peer_pb.last_known_addr(), hostport.get()));
   gscoped_ptr<ConsensusServiceProxy> new_proxy;
   RETURN_NOT_OK(CreateConsensusServiceProxyForHost(messenger_, *hostport, &new_proxy));
-  proxy->reset(new RpcPeerProxy(std::move(hostport), std::move(new_proxy)));
+  shared_ptr<MultiRaftHeartbeatBatcher> batcher;
+  if (multi_raft_manager_ && FLAGS_enable_multi_raft_heartbeat_batcher) {
+    RETURN_NOT_OK(multi_raft_manager_->GetOrCreateBatcher(*hostport, &batcher));
+  }
+  proxy->reset(new RpcPeerProxy(std::move(hostport), std::move(new_proxy), std::move(batcher)));
   return Status::OK();
 }
 
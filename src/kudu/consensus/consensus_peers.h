@@ -34,6 +34,7 @@
 #include "kudu/rpc/response_callback.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -47,6 +48,8 @@ class PeriodicTimer;
 
 namespace consensus {
 class ConsensusServiceProxy;
+class MultiRaftHeartbeatBatcher;
+class MultiRaftManager;
 class PeerProxy;
 class PeerMessageQueue;
 
@@ -58,7 +61,14 @@ class PeerMessageQueue;
 // the request will be generated once the outstanding one finishes.
 //
 // Peers are owned by the consensus implementation and do not keep
-// state aside from the most recent request and response.
+// state aside from the requests in flight and their responses.
+//
+// Ordinarily a peer has at most one request in flight. With
+// --consensus_max_inflight_requests_per_peer above one, requests carrying
+// operations are pipelined: while earlier requests await their responses,
+// further ones pick up after the operations those carry. This hides the
+// round-trip time to distant followers when replicating a steady stream of
+// operations. Pipelining stops as soon as an exchange with the peer fails.
 //
 // Peers are also responsible for sending periodic heartbeats
 // to assert liveness of the leader. The peer constructs a heartbeater
@@ -118,17 +128,43 @@ class Peer : public std::enable_shared_from_this<Peer> {
        gscoped_ptr<PeerProxy> proxy,
        std::shared_ptr<rpc::Messenger> messenger);
 
+  // A consensus update request to the peer, its response, and the state
+  // needed to send it. Recycled once the response has been handled.
+  struct PendingRequest {
+    ConsensusRequestPB request;
+    ConsensusResponsePB response;
+
+    // Reference-counted pointers to the ReplicateMsgs in 'request'. We may
+    // have loaded these messages from the LogCache, in which case we are
+    // potentially sharing the same object as other peers. Since the PB
+    // request itself can't hold reference counts, this holds them.
+    std::vector<ReplicateRefPtr> replicate_msg_refs;
+
+    rpc::RpcController controller;
+
+    // When 'request' was sent.
+    MonoTime send_time;
+
+    // The sequence number the queue assigned to 'request', used to recognize
+    // responses that arrive out of order.
+    int64_t seqno = -1;
+  };
+
   void SendNextRequest(bool even_if_queue_empty);
 
-  // Signals that a response was received from the peer.
+  // Signals that a response to 'req' was received from the peer.
   //
   // This method is called from the reactor thread and calls
   // DoProcessResponse() on raft_pool_token_ to do any work that requires IO or
   // lock-taking.
-  void ProcessResponse();
+  void ProcessResponse(PendingRequest* req);
 
   // Run on 'raft_pool_token'. Does response handling that requires IO or may block.
-  void DoProcessResponse();
+  void DoProcessResponse(PendingRequest* req);
+
+  // Removes 'req' from the requests in flight so that it may be reused.
+  // Requires that 'peer_lock_' is held.
+  void ReleaseRequestUnlocked(PendingRequest* req);
 
   // Fetch the desired tablet copy request from the queue and set up
   // tc_request_ appropriately.
@@ -140,8 +176,8 @@ class Peer : public std::enable_shared_from_this<Peer> {
   // Handle RPC callback from initiating tablet copy.
   void ProcessTabletCopyResponse();
 
-  // Signals there was an error sending the request to the peer.
-  void ProcessResponseError(const Status& status);
+  // Signals there was an error sending 'req' to the peer.
+  void ProcessResponseError(const Status& status, PendingRequest* req);
 
   std::string LogPrefixUnlocked() const;
 
@@ -157,20 +193,17 @@ class Peer : public std::enable_shared_from_this<Peer> {
   PeerMessageQueue* queue_;
   uint64_t failed_attempts_;
 
-  // The latest consensus update request and response.
-  ConsensusRequestPB request_;
-  ConsensusResponsePB response_;
+  // The consensus update requests in flight to the peer, in the order they
+  // were sent, and those which completed and may be reused.
+  std::vector<std::unique_ptr<PendingRequest>> in_flight_;
+  std::vector<std::unique_ptr<PendingRequest>> free_requests_;
+
+  // The committed index carried by the latest request sent to the peer.
+  int64_t last_sent_committed_index_;
 
   // The latest tablet copy request and response.
   StartTabletCopyRequestPB tc_request_;
   StartTabletCopyResponsePB tc_response_;
-
-  // Reference-counted pointers to any ReplicateMsgs which are in-flight to the peer. We
-  // may have loaded these messages from the LogCache, in which case we are potentially
-  // sharing the same object as other peers. Since the PB request_ itself can't hold
-  // reference counts, this holds them.
-  std::vector<ReplicateRefPtr> replicate_msg_refs_;
-
   rpc::RpcController controller_;
 
   std::shared_ptr<rpc::Messenger> messenger_;
@@ -185,10 +218,13 @@ class Peer : public std::enable_shared_from_this<Peer> {
 
   // lock that protects Peer state changes, initialization, etc.
   mutable simple_spinlock peer_lock_;
-  bool request_pending_ = false;
+  bool tablet_copy_pending_ = false;
   bool closed_ = false;
   bool has_sent_first_request_ = false;
 
+  // Whether the peer may be sent operations in RPC sidecars. Cleared if the
+  // peer turns out not to support it.
+  bool replicate_sidecars_supported_ = true;
 };
 
 // A proxy to another peer. Usually a thin wrapper around an rpc proxy but can
@@ -202,6 +238,16 @@ class PeerProxy {
                            rpc::RpcController* controller,
                            const rpc::ResponseCallback& callback) = 0;
 
+  // Like UpdateAsync(), for requests which carry neither operations nor a new
+  // commit index. Such requests may be batched with the heartbeats of other
+  // tablets sent to the same server.
+  virtual void UpdateHeartbeatAsync(const ConsensusRequestPB* request,
+                                    ConsensusResponsePB* response,
+                                    rpc::RpcController* controller,
+                                    const rpc::ResponseCallback& callback) {
+    UpdateAsync(request, response, controller, callback);
+  }
+
   // Sends a RequestConsensusVote to a remote peer.
   virtual void RequestConsensusVoteAsync(const VoteRequestPB* request,
                                          VoteResponsePB* response,
@@ -216,6 +262,12 @@ class PeerProxy {
     LOG(DFATAL) << "Not implemented";
   }
 
+  // Whether the operations of the requests passed to UpdateAsync() may be
+  // carried in RPC sidecars of their controllers.
+  virtual bool SupportsReplicateSidecars() const {
+    return false;
+  }
+
   virtual ~PeerProxy() {}
 };
 
@@ -235,14 +287,21 @@ class PeerProxyFactory {
 // PeerProxy implementation that does RPC calls
 class RpcPeerProxy : public PeerProxy {
  public:
+  // If 'heartbeat_batcher' is set, heartbeats are sent through it.
   RpcPeerProxy(gscoped_ptr<HostPort> hostport,
-               gscoped_ptr<ConsensusServiceProxy> consensus_proxy);
+               gscoped_ptr<ConsensusServiceProxy> consensus_proxy,
+               std::shared_ptr<MultiRaftHeartbeatBatcher> heartbeat_batcher = nullptr);
 
   virtual void UpdateAsync(const ConsensusRequestPB* request,
                            ConsensusResponsePB* response,
                            rpc::RpcController* controller,
                            const rpc::ResponseCallback& callback) OVERRIDE;
 
+  virtual void UpdateHeartbeatAsync(const ConsensusRequestPB* request,
+                                    ConsensusResponsePB* response,
+                                    rpc::RpcController* controller,
+                                    const rpc::ResponseCallback& callback) OVERRIDE;
+
   virtual void RequestConsensusVoteAsync(const VoteRequestPB* request,
                                          VoteResponsePB* response,
                                          rpc::RpcController* controller,
@@ -253,17 +312,25 @@ class RpcPeerProxy : public PeerProxy {
                                     rpc::RpcController* controller,
                                     const rpc::ResponseCallback& callback) OVERRIDE;
 
+  virtual bool SupportsReplicateSidecars() const OVERRIDE {
+    return true;
+  }
+
   virtual ~RpcPeerProxy();
 
  private:
   gscoped_ptr<HostPort> hostport_;
   gscoped_ptr<ConsensusServiceProxy> consensus_proxy_;
+  std::shared_ptr<MultiRaftHeartbeatBatcher> heartbeat_batcher_;
 };
 
 // PeerProxyFactory implementation that generates RPCPeerProxies
 class RpcPeerProxyFactory : public PeerProxyFactory {
  public:
-  explicit RpcPeerProxyFactory(std::shared_ptr<rpc::Messenger> messenger);
+  // If 'multi_raft_manager' is set and --enable_multi_raft_heartbeat_batcher
+  // is on, the heartbeats of the proxies are batched by destination server.
+  explicit RpcPeerProxyFactory(std::shared_ptr<rpc::Messenger> messenger,
+                               MultiRaftManager* multi_raft_manager = nullptr);
 
   Status NewProxy(const RaftPeerPB& peer_pb,
                   gscoped_ptr<PeerProxy>* proxy) override;
@@ -276,6 +343,7 @@ class RpcPeerProxyFactory : public PeerProxyFactory {
 
  private:
   std::shared_ptr<rpc::Messenger> messenger_;
+  MultiRaftManager* const multi_raft_manager_;
 };
 
 // Query the consensus service at last known host/port that is
@@ -337,6 +337,180 @@ TEST_F(ConsensusQueueTest, TestGetPagedMessages) {
   request.mutable_ops()->ExtractSubrange(0, request.ops_size(), nullptr);
 }
 
+// Tests that pipelined requests pick up after the operations in flight, and
+// fall back to the peer's acknowledged position once an exchange fails.
+TEST_F(ConsensusQueueTest, TestPipelinedRequests) {
+  queue_->SetLeaderMode(kMinimumOpIdIndex, kMinimumTerm, BuildRaftConfigPBForTests(2));
+
+  // Size the batches to hold 10 ops each, as in TestGetPagedMessages.
+  ConsensusRequestPB page_size_estimator;
+  page_size_estimator.set_caller_term(14);
+  page_size_estimator.set_committed_index(0);
+  page_size_estimator.set_all_replicated_index(0);
+  page_size_estimator.set_last_idx_appended_to_leader(0);
+  page_size_estimator.mutable_preceding_id()->CopyFrom(MinimumOpId());
+  const int kOpsPerRequest = 10;
+  for (int i = 0; i < kOpsPerRequest; i++) {
+    page_size_estimator.mutable_ops()->AddAllocated(
+        CreateDummyReplicate(0, 0, clock_->Now(), 0).release());
+  }
+  google::FlagSaver saver;
+  FLAGS_consensus_max_batch_size_bytes = page_size_estimator.ByteSize();
+
+  ConsensusRequestPB requests[5];
+  ConsensusResponsePB response;
+  response.set_responder_uuid(kPeerUuid);
+  bool more_pending = false;
+  UpdatePeerWatermarkToOp(&requests[0], &response, MinimumOpId(), MinimumOpId(), &more_pending);
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 1, 35);
+
+  vector<ReplicateRefPtr> refs;
+  bool needs_tablet_copy;
+  auto request_for_peer = [&](ConsensusRequestPB* request, bool pipelined) {
+    ASSERT_OK(queue_->RequestForPeer(kPeerUuid, request, &refs, &needs_tablet_copy,
+                                     pipelined));
+    ASSERT_FALSE(needs_tablet_copy);
+  };
+
+  // The peer hasn't successfully received anything yet, so the request
+  // can't be pipelined.
+  NO_FATALS(request_for_peer(&requests[0], true));
+  ASSERT_EQ(1, requests[0].ops(0).id().index());
+  SetLastReceivedAndLastCommitted(&response, requests[0].ops(kOpsPerRequest - 1).id());
+  queue_->ResponseFromPeer(kPeerUuid, response, &more_pending);
+
+  // Send a request and pipeline two more behind it.
+  NO_FATALS(request_for_peer(&requests[1], false));
+  ASSERT_EQ(11, requests[1].ops(0).id().index());
+  NO_FATALS(request_for_peer(&requests[2], true));
+  ASSERT_EQ(21, requests[2].ops(0).id().index());
+  ASSERT_EQ(20, requests[2].preceding_id().index());
+  NO_FATALS(request_for_peer(&requests[3], true));
+  ASSERT_EQ(31, requests[3].ops(0).id().index());
+  ASSERT_EQ(5, requests[3].ops_size());
+
+  // Once the first is acknowledged, everything is still in flight.
+  SetLastReceivedAndLastCommitted(&response, requests[1].ops(kOpsPerRequest - 1).id());
+  queue_->ResponseFromPeer(kPeerUuid, response, &more_pending);
+  ASSERT_TRUE(more_pending);
+  NO_FATALS(request_for_peer(&requests[4], true));
+  ASSERT_EQ(0, requests[4].ops_size());
+
+  // The peer rejects the second: resume right after what it acknowledged.
+  RefuseWithLogPropertyMismatch(&response, requests[1].ops(kOpsPerRequest - 1).id(),
+                                requests[1].ops(kOpsPerRequest - 1).id());
+  queue_->ResponseFromPeer(kPeerUuid, response, &more_pending);
+  ASSERT_TRUE(more_pending);
+  NO_FATALS(request_for_peer(&requests[4], true));
+  ASSERT_EQ(21, requests[4].ops(0).id().index());
+
+  // Extract the ops from the requests to avoid double free.
+  for (auto& request : requests) {
+    request.mutable_ops()->ExtractSubrange(0, request.ops_size(), nullptr);
+  }
+}
+
+// Tests that, when requests are pipelined to a peer, a response that arrives
+// after the response to a later request doesn't move the peer or the queue's
+// watermarks backwards.
+TEST_F(ConsensusQueueTest, TestPipelinedResponsesOutOfOrder) {
+  queue_->SetLeaderMode(kMinimumOpIdIndex, kMinimumTerm, BuildRaftConfigPBForTests(2));
+  ConsensusRequestPB requests[3];
+  ConsensusResponsePB response;
+  response.set_responder_uuid(kPeerUuid);
+  bool more_pending = false;
+  UpdatePeerWatermarkToOp(&requests[0], &response, MinimumOpId(), MinimumOpId(), &more_pending);
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 1, 30);
+  WaitForLocalPeerToAckIndex(30);
+
+  vector<ReplicateRefPtr> refs;
+  bool needs_tablet_copy;
+  int64_t seqnos[3];
+  for (int i = 0; i < 3; i++) {
+    ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &requests[i], &refs, &needs_tablet_copy,
+                                     i > 0, &seqnos[i]));
+  }
+  ASSERT_LT(seqnos[0], seqnos[1]);
+  ASSERT_LT(seqnos[1], seqnos[2]);
+  ASSERT_EQ(30, requests[0].ops_size());
+  const OpId op10 = requests[0].ops(9).id();
+  const OpId op20 = requests[0].ops(19).id();
+  const OpId op30 = requests[0].ops(29).id();
+
+  // The peer acknowledges the second request before the first.
+  SetLastReceivedAndLastCommitted(&response, op20, 0);
+  queue_->ResponseFromPeer(kPeerUuid, response, &more_pending, MonoTime(), seqnos[1]);
+  ASSERT_EQ(20, queue_->GetMajorityReplicatedIndexForTests());
+  SetLastReceivedAndLastCommitted(&response, op10, 0);
+  queue_->ResponseFromPeer(kPeerUuid, response, &more_pending, MonoTime(), seqnos[0]);
+  ASSERT_EQ(20, queue_->GetMajorityReplicatedIndexForTests());
+  PeerMessageQueue::TrackedPeer peer = queue_->GetTrackedPeerForTests(kPeerUuid);
+  ASSERT_OPID_EQ(op20, peer.last_received);
+  ASSERT_EQ(21, peer.next_index);
+
+  // Responses to later requests are still processed.
+  SetLastReceivedAndLastCommitted(&response, op30, 0);
+  queue_->ResponseFromPeer(kPeerUuid, response, &more_pending, MonoTime(), seqnos[2]);
+  ASSERT_EQ(30, queue_->GetMajorityReplicatedIndexForTests());
+
+  // Nothing is resent to the peer.
+  ConsensusRequestPB request;
+  ASSERT_OK(queue_->RequestForPeer(kPeerUuid, &request, &refs, &needs_tablet_copy));
+  ASSERT_EQ(0, request.ops_size());
+
+  // Extract the ops from the requests to avoid double free.
+  for (auto& r : requests) {
+    r.mutable_ops()->ExtractSubrange(0, r.ops_size(), nullptr);
+  }
+  request.mutable_ops()->ExtractSubrange(0, request.ops_size(), nullptr);
+}
+
+// Tests that the leader lease extends from the send time of the latest
+// requests accepted by a majority of the voters, once the leader has
+// committed an operation in its term.
+TEST_F(ConsensusQueueTest, TestLeaderLeaseStart) {
+  queue_->SetLeaderMode(kMinimumOpIdIndex, kMinimumTerm, BuildRaftConfigPBForTests(3));
+  queue_->TrackPeer("peer-1");
+  queue_->TrackPeer("peer-2");
+  AppendReplicateMessagesToQueue(queue_.get(), clock_, 1, 5);
+  WaitForLocalPeerToAckIndex(5);
+  ASSERT_EQ(MonoTime::Min(), queue_->LeaderLeaseStart());
+
+  ConsensusResponsePB response;
+  response.set_responder_term(0);
+  SetLastReceivedAndLastCommitted(&response, MakeOpId(0, 5), MinimumOpId().index());
+  bool more_pending;
+
+  // A response without a send time doesn't extend the lease, even though it
+  // commits the operations.
+  response.set_responder_uuid("peer-1");
+  queue_->ResponseFromPeer(response.responder_uuid(), response, &more_pending);
+  ASSERT_TRUE(queue_->IsCommittedIndexInCurrentTerm());
+  ASSERT_EQ(MonoTime::Min(), queue_->LeaderLeaseStart());
+
+  // Together with the leader, 'peer-1' makes a majority.
+  MonoTime t1 = MonoTime::Now();
+  queue_->ResponseFromPeer(response.responder_uuid(), response, &more_pending, t1);
+  ASSERT_EQ(t1, queue_->LeaderLeaseStart());
+
+  // Now 'peer-2' accepted a later request, so a majority was reached later.
+  MonoTime t2 = t1 + MonoDelta::FromMilliseconds(10);
+  response.set_responder_uuid("peer-2");
+  queue_->ResponseFromPeer(response.responder_uuid(), response, &more_pending, t2);
+  ASSERT_EQ(t2, queue_->LeaderLeaseStart());
+
+  // Rejected requests don't extend the lease.
+  RefuseWithLogPropertyMismatch(&response, MakeOpId(0, 5), MakeOpId(0, 5));
+  response.set_responder_uuid("peer-1");
+  queue_->ResponseFromPeer(response.responder_uuid(), response, &more_pending,
+                           t2 + MonoDelta::FromMilliseconds(10));
+  ASSERT_EQ(t2, queue_->LeaderLeaseStart());
+
+  // Leases are only held by leaders.
+  queue_->SetNonLeaderMode();
+  ASSERT_EQ(MonoTime::Min(), queue_->LeaderLeaseStart());
+}
+
 TEST_F(ConsensusQueueTest, TestPeersDontAckBeyondWatermarks) {
   queue_->SetLeaderMode(kMinimumOpIdIndex, kMinimumTerm, BuildRaftConfigPBForTests(3));
   AppendReplicateMessagesToQueue(queue_.get(), clock_, 1, 100);
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <mutex>
 #include <string>
@@ -56,6 +57,13 @@ DEFINE_int32(consensus_max_batch_size_bytes, 1024 * 1024,
              "The maximum per-tablet RPC batch size when updating peers.");
 TAG_FLAG(consensus_max_batch_size_bytes, advanced);
 
+DEFINE_bool(consensus_replicate_sidecars, true,
+            "Whether a leader serializes each replicated operation once and sends "
+            "the serialized form to all of its peers as RPC sidecars, rather than "
+            "serializing the operation into the request to each peer.");
+TAG_FLAG(consensus_replicate_sidecars, advanced);
+TAG_FLAG(consensus_replicate_sidecars, runtime);
+
 DEFINE_int32(follower_unavailable_considered_failed_sec, 300,
              "Seconds that a leader is unable to successfully heartbeat to a "
              "follower after which the follower is considered to be failed and "
@@ -100,6 +108,10 @@ METRIC_DEFINE_gauge_int64(tablet, in_progress_ops, "Operations in Progress",
                           MetricUnit::kOperations,
                           "Number of operations in the peer's queue ack'd by a minority of "
                           "peers.");
+METRIC_DEFINE_counter(tablet, raft_pipelined_requests, "Pipelined Raft Requests",
+                      MetricUnit::kRequests,
+                      "Number of requests with operations which the leader sent to a "
+                      "peer while previous requests to the same peer were in flight.");
 METRIC_DEFINE_gauge_int64(tablet, ops_behind_leader, "Operations Behind Leader",
                           MetricUnit::kOperations,
                           "Number of operations this server believes it is behind the leader.");
@@ -122,10 +134,12 @@ const char* PeerStatusToString(PeerStatus p) {
 
 std::string PeerMessageQueue::TrackedPeer::ToString() const {
   return Substitute("Peer: $0, Status: $1, Last received: $2, Next index: $3, "
-                    "Last known committed idx: $4, Time since last communication: $5",
+                    "Next index in flight: $4, Last known committed idx: $5, "
+                    "Time since last communication: $6",
                     uuid,
                     PeerStatusToString(last_exchange_status),
                     OpIdToString(last_received), next_index,
+                    next_index_in_flight,
                     last_known_committed_index,
                     (MonoTime::Now() - last_communication_time).ToString());
 }
@@ -135,7 +149,8 @@ std::string PeerMessageQueue::TrackedPeer::ToString() const {
 PeerMessageQueue::Metrics::Metrics(const scoped_refptr<MetricEntity>& metric_entity)
   : num_majority_done_ops(INSTANTIATE_METRIC(METRIC_majority_done_ops)),
     num_in_progress_ops(INSTANTIATE_METRIC(METRIC_in_progress_ops)),
-    num_ops_behind_leader(INSTANTIATE_METRIC(METRIC_ops_behind_leader)) {
+    num_ops_behind_leader(INSTANTIATE_METRIC(METRIC_ops_behind_leader)),
+    num_pipelined_requests(METRIC_raft_pipelined_requests.Instantiate(metric_entity)) {
 }
 #undef INSTANTIATE_METRIC
 
@@ -150,6 +165,8 @@ PeerMessageQueue::PeerMessageQueue(scoped_refptr<MetricEntity> metric_entity,
     : raft_pool_observers_token_(std::move(raft_pool_observers_token)),
       local_peer_pb_(std::move(local_peer_pb)),
       tablet_id_(std::move(tablet_id)),
+      next_request_seqno_(0),
+      replicate_serializer_(FLAGS_consensus_max_batch_size_bytes),
       log_cache_(metric_entity, log, local_peer_pb_.permanent_uuid(), tablet_id_),
       metrics_(metric_entity),
       time_manager_(std::move(time_manager)) {
@@ -353,11 +370,19 @@ Status PeerMessageQueue::AppendOperations(const vector<ReplicateRefPtr>& msgs,
     time_manager_->AdvanceSafeTimeWithMessage(*msgs.back()->get());
   }
 
+  // As leader, serialize the operations once for all the remote peers. The
+  // local peer is always tracked.
+  bool serialize = queue_state_.mode == LEADER && peers_map_.size() > 1 &&
+      FLAGS_consensus_replicate_sidecars;
+
   // Unlock ourselves during Append to prevent a deadlock: it's possible that
   // the log buffer is full, in which case AppendOperations would block. However,
   // for the log buffer to empty, it may need to call LocalPeerAppendFinished()
   // which also needs queue_lock_.
   lock.unlock();
+  if (serialize) {
+    replicate_serializer_.Serialize(msgs);
+  }
   RETURN_NOT_OK(log_cache_.AppendOperations(msgs,
                                             Bind(&PeerMessageQueue::LocalPeerAppendFinished,
                                                  Unretained(this),
@@ -537,7 +562,9 @@ HealthReportPB::HealthStatus PeerMessageQueue::PeerHealthStatus(const TrackedPee
 Status PeerMessageQueue::RequestForPeer(const string& uuid,
                                         ConsensusRequestPB* request,
                                         vector<ReplicateRefPtr>* msg_refs,
-                                        bool* needs_tablet_copy) {
+                                        bool* needs_tablet_copy,
+                                        bool pipelined,
+                                        int64_t* request_seqno) {
   // Maintain a thread-safe copy of necessary members.
   OpId preceding_id;
   int64_t current_term;
@@ -553,9 +580,22 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
       return Status::NotFound("Peer not tracked or queue not in leader mode.");
     }
     peer_copy = *peer;
+    if (request_seqno) {
+      *request_seqno = next_request_seqno_++;
+    }
+
+    // Pick up after the operations already in flight to the peer, so long as
+    // they are expected to be accepted.
+    pipelined = pipelined &&
+        peer_copy.last_exchange_status == PeerStatus::OK &&
+        peer_copy.next_index_in_flight > peer_copy.next_index;
+    if (pipelined) {
+      peer_copy.next_index = peer_copy.next_index_in_flight;
+    }
 
     // Clear the requests without deleting the entries, as they may be in use by other peers.
     request->mutable_ops()->ExtractSubrange(0, request->ops_size(), nullptr);
+    request->clear_ops_sidecars();
 
     // This is initialized to the queue's last appended op but gets set to the id of the
     // log entry preceding the first one in 'messages' if messages are found for the peer.
@@ -638,6 +678,17 @@ Status PeerMessageQueue::RequestForPeer(const string& uuid,
       request->mutable_ops()->AddAllocated(msg->get());
     }
     msg_refs->swap(messages);
+
+    if (request->ops_size() > 0) {
+      std::lock_guard<simple_spinlock> lock(queue_lock_);
+      TrackedPeer* peer = FindPtrOrNull(peers_map_, uuid);
+      if (peer) {
+        peer->next_index_in_flight = request->ops(request->ops_size() - 1).id().index() + 1;
+      }
+      if (pipelined) {
+        metrics_.num_pipelined_requests->Increment();
+      }
+    }
   }
 
   DCHECK(preceding_id.IsInitialized());
@@ -804,6 +855,10 @@ void PeerMessageQueue::UpdatePeerStatus(const string& peer_uuid,
   TrackedPeer* peer = FindPtrOrNull(peers_map_, peer_uuid);
   if (!peer) return;
   peer->last_exchange_status = ps;
+  if (ps != PeerStatus::OK) {
+    // Any requests still in flight are unlikely to be accepted.
+    peer->next_index_in_flight = kInvalidOpIdIndex;
+  }
 
   if (ps != PeerStatus::RPC_LAYER_ERROR) {
     // So long as we got _any_ response from the follower, we consider it a 'communication'.
@@ -851,7 +906,9 @@ void PeerMessageQueue::UpdatePeerStatus(const string& peer_uuid,
 
 void PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
                                         const ConsensusResponsePB& response,
-                                        bool* more_pending) {
+                                        bool* more_pending,
+                                        MonoTime request_send_time,
+                                        int64_t request_seqno) {
   DCHECK(response.IsInitialized()) << "Error: Uninitialized: "
       << response.InitializationErrorString() << ". Response: " << SecureShortDebugString(response);
   CHECK(!response.has_error());
@@ -889,6 +946,24 @@ void PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
 
     const ConsensusStatusPB& status = response.status();
 
+    // With pipelined requests, responses may arrive out of order. A response
+    // to a request older than one already answered reflects an earlier state
+    // of the peer: applying it would move the peer, and with it the queue's
+    // watermarks, backwards and cause operations to be resent.
+    if (request_seqno >= 0) {
+      if (PREDICT_FALSE(request_seqno < peer->last_response_seqno)) {
+        VLOG_WITH_PREFIX_UNLOCKED(1) << "Disregarding stale response to request "
+                                     << request_seqno << " from peer " << peer_uuid
+                                     << " (already processed " << peer->last_response_seqno
+                                     << "): " << SecureShortDebugString(response);
+        peer->last_communication_time = MonoTime::Now();
+        *more_pending = log_cache_.HasOpBeenWritten(peer->next_index) ||
+            (peer->last_known_committed_index < queue_state_.committed_index);
+        return;
+      }
+      peer->last_response_seqno = request_seqno;
+    }
+
     // Take a snapshot of the current peer status.
     TrackedPeer previous = *peer;
 
@@ -965,7 +1040,15 @@ void PeerMessageQueue::ResponseFromPeer(const std::string& peer_uuid,
           << "Falling back to committed index " << peer->last_known_committed_index;
     }
 
+    if (PREDICT_TRUE(!status.has_error()) && request_send_time.Initialized() &&
+        request_send_time > peer->last_accepted_request_send_time) {
+      peer->last_accepted_request_send_time = request_send_time;
+    }
+
     if (PREDICT_FALSE(status.has_error())) {
+      // The peer rejected the request, and with it any requests pipelined
+      // behind it: resume from 'next_index' as set above.
+      peer->next_index_in_flight = kInvalidOpIdIndex;
       switch (status.error().code()) {
         case ConsensusErrorPB::PRECEDING_ENTRY_DIDNT_MATCH: {
           peer->last_exchange_status = PeerStatus::LMP_MISMATCH;
@@ -1107,6 +1190,38 @@ bool PeerMessageQueue::IsCommittedIndexInCurrentTerm() const {
       queue_state_.committed_index >= *queue_state_.first_index_in_current_term;
 }
 
+MonoTime PeerMessageQueue::LeaderLeaseStart() const {
+  std::lock_guard<simple_spinlock> lock(queue_lock_);
+  if (queue_state_.mode != LEADER ||
+      queue_state_.first_index_in_current_term == boost::none ||
+      queue_state_.committed_index < *queue_state_.first_index_in_current_term) {
+    return MonoTime::Min();
+  }
+
+  // Voters which aren't tracked yet haven't accepted anything.
+  const RaftConfigPB& config = *DCHECK_NOTNULL(queue_state_.active_config.get());
+  vector<MonoTime> send_times;
+  for (const RaftPeerPB& peer_pb : config.peers()) {
+    if (peer_pb.member_type() != RaftPeerPB::VOTER) {
+      continue;
+    }
+    const string& uuid = peer_pb.permanent_uuid();
+    if (uuid == local_peer_pb_.permanent_uuid()) {
+      send_times.push_back(MonoTime::Max());
+      continue;
+    }
+    const TrackedPeer* peer = FindPtrOrNull(peers_map_, uuid);
+    send_times.push_back(peer ? peer->last_accepted_request_send_time : MonoTime::Min());
+  }
+  int majority_size = MajoritySize(send_times.size());
+  if (majority_size == 0) {
+    return MonoTime::Min();
+  }
+  std::nth_element(send_times.begin(), send_times.begin() + majority_size - 1,
+                   send_times.end(), std::greater<MonoTime>());
+  return send_times[majority_size - 1];
+}
+
 int64_t PeerMessageQueue::GetMajorityReplicatedIndexForTests() const {
   std::lock_guard<simple_spinlock> lock(queue_lock_);
   return queue_state_.majority_replicated_index;
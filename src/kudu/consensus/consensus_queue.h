@@ -35,6 +35,7 @@
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/consensus/opid_util.h"
 #include "kudu/consensus/ref_counted_replicate.h"
+#include "kudu/consensus/replicate_sidecars.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/threading/thread_collision_warner.h"
@@ -116,10 +117,13 @@ class PeerMessageQueue {
     explicit TrackedPeer(std::string uuid)
         : uuid(std::move(uuid)),
           next_index(kInvalidOpIdIndex),
+          next_index_in_flight(kInvalidOpIdIndex),
           last_received(MinimumOpId()),
           last_known_committed_index(MinimumOpId().index()),
           last_exchange_status(PeerStatus::NEW),
           last_communication_time(MonoTime::Now()),
+          last_accepted_request_send_time(MonoTime::Min()),
+          last_response_seqno(-1),
           wal_catchup_possible(true),
           last_overall_health_status(HealthReportPB::UNKNOWN),
           last_seen_term_(0) {}
@@ -145,6 +149,13 @@ class PeerMessageQueue {
     // This corresponds to "nextIndex" as specified in Raft.
     int64_t next_index;
 
+    // One past the index of the last operation sent to this peer in a request
+    // which may still be in flight, or kInvalidOpIdIndex if unknown. Requests
+    // pipelined behind in-flight ones start from here rather than from
+    // 'next_index', which only advances as responses arrive. Reset whenever
+    // an exchange with the peer fails.
+    int64_t next_index_in_flight;
+
     // The last operation that we've sent to this peer and that
     // it acked. Used for watermark movement.
     OpId last_received;
@@ -167,6 +178,18 @@ class PeerMessageQueue {
     // successful communication ever took place.
     MonoTime last_communication_time;
 
+    // The time at which the latest request that the peer accepted was sent.
+    // Having accepted it, the peer withholds its vote from other candidates
+    // for the minimum election timeout after receiving the request, which
+    // is what leader leases are measured from.
+    MonoTime last_accepted_request_send_time;
+
+    // The sequence number of the newest request whose response has been
+    // processed, or -1 if none. With several requests pipelined to the peer,
+    // responses may arrive out of order; a response to an older request than
+    // this one carries stale state and is disregarded.
+    int64_t last_response_seqno;
+
     // Set to false if it is determined that the remote peer has fallen behind
     // the local peer's WAL.
     bool wal_catchup_possible;
@@ -271,10 +294,22 @@ class PeerMessageQueue {
   // instance of ConsensusRequestPB to RequestForPeer(): the buffer will
   // replace the old entries with new ones without de-allocating the old
   // ones if they are still required.
+  //
+  // If 'pipelined' is true, the caller has other requests to the peer in
+  // flight, and the request picks up after the operations they carry rather
+  // than at the peer's acknowledged 'next_index'. Pipelined requests are only
+  // built while the exchanges with the peer are succeeding; otherwise the
+  // request starts at 'next_index' as usual.
+  //
+  // If 'request_seqno' is not null, it is set to a sequence number that
+  // orders the request among all those built by this queue. It should be
+  // passed back to ResponseFromPeer() along with the response.
   Status RequestForPeer(const std::string& uuid,
                         ConsensusRequestPB* request,
                         std::vector<ReplicateRefPtr>* msg_refs,
-                        bool* needs_tablet_copy);
+                        bool* needs_tablet_copy,
+                        bool pipelined = false,
+                        int64_t* request_seqno = nullptr);
 
   // Fill in a StartTabletCopyRequest for the specified peer.
   // If that peer should not initiate Tablet Copy, returns a non-OK status.
@@ -293,9 +328,19 @@ class PeerMessageQueue {
 
   // Updates the request queue with the latest response of a peer, returns
   // whether this peer has more requests pending.
+  //
+  // 'request_send_time', if initialized, is the time at which the request
+  // that 'response' answers was sent. It is used to extend the leader lease.
+  //
+  // 'request_seqno', if not negative, is the sequence number RequestForPeer()
+  // assigned to the request. A response to a request older than one whose
+  // response was already processed is stale: it does not move the peer's
+  // position or the queue's watermarks backwards.
   void ResponseFromPeer(const std::string& peer_uuid,
                         const ConsensusResponsePB& response,
-                        bool* more_pending);
+                        bool* more_pending,
+                        MonoTime request_send_time = MonoTime(),
+                        int64_t request_seqno = -1);
 
   // Called by the consensus implementation to update the queue's watermarks
   // based on information provided by the leader. This is used for metrics and
@@ -324,6 +369,16 @@ class PeerMessageQueue {
   // Return true if the committed index falls within the current term.
   bool IsCommittedIndexInCurrentTerm() const;
 
+  // Returns the time by which a majority of the voters in the active config,
+  // counting the local peer, had last been sent a request which they then
+  // accepted. Leader leases extend from this time.
+  //
+  // Returns MonoTime::Min() if the queue is not in leader mode, or if the
+  // committed index doesn't yet fall within the current term: until then,
+  // the leader may not have applied everything committed by its
+  // predecessors.
+  MonoTime LeaderLeaseStart() const;
+
   // Returns the current majority replicated index, for tests.
   int64_t GetMajorityReplicatedIndexForTests() const;
 
@@ -351,6 +406,9 @@ class PeerMessageQueue {
     // Keeps track of the number of ops. behind the leader the peer is, measured as the difference
     // between the latest appended op index on this peer versus on the leader (0 if leader).
     scoped_refptr<AtomicGauge<int64_t> > num_ops_behind_leader;
+    // Counts the requests carrying operations which were sent to a peer while
+    // previous requests to it were still in flight.
+    scoped_refptr<Counter> num_pipelined_requests;
 
     explicit Metrics(const scoped_refptr<MetricEntity>& metric_entity);
   };
@@ -522,11 +580,20 @@ class PeerMessageQueue {
   PeersMap peers_map_;
   mutable simple_spinlock queue_lock_; // TODO: rename
 
+  // The sequence number to assign to the next request built for a peer.
+  // Protected by 'queue_lock_'.
+  int64_t next_request_seqno_;
+
   // We assume that we never have multiple threads racing to append to the queue.
   // This fake mutex adds some extra assurance that this implementation property
   // doesn't change.
   DFAKE_MUTEX(append_fake_lock_);
 
+  // Serializes the operations appended while in LEADER mode, so that they
+  // can be sent to peers without being serialized for each of them. Only
+  // used by the appending thread.
+  ReplicateSerializer replicate_serializer_;
+
   LogCache log_cache_;
 
   Metrics metrics_;
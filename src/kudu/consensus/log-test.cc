@@ -63,8 +63,12 @@
 DEFINE_int32(num_batches, 10000,
              "Number of batches to write to/read from the Log in TestWriteManyBatches");
 
+DEFINE_int32(num_catch_up_ops, 20000,
+             "Number of operations to read from the Log in TestCatchUpReadThroughput");
+
 DECLARE_int32(log_min_segments_to_retain);
 DECLARE_int32(log_max_segments_to_retain);
+DECLARE_int32(log_reader_readahead_bytes);
 DECLARE_double(log_inject_io_error_on_preallocate_fraction);
 DECLARE_int64(fs_wal_dir_reserved_bytes);
 DECLARE_int64(disk_reserved_bytes_free_for_testing);
@@ -1050,6 +1054,76 @@ TEST_P(LogTestOptionalCompression, TestReadReplicatesHighIndex) {
   ASSERT_GT(op_id.index(), std::numeric_limits<int32_t>::max());
 }
 
+// Test that reading a few operations doesn't read ahead further into the log
+// than needed, and that the bytes read are counted as read from disk.
+TEST_P(LogTestOptionalCompression, TestReadAheadIsBounded) {
+  FLAGS_log_reader_readahead_bytes = 1024 * 1024;
+  const int kNumOps = 1000;
+
+  ASSERT_OK(BuildLog());
+  OpId op_id = MakeOpId(1, 1);
+  for (int i = 0; i < kNumOps; i++) {
+    ASSERT_OK(AppendNoOpsToLogSync(clock_, log_.get(), &op_id, 1));
+  }
+  shared_ptr<LogReader> reader = log_->reader();
+
+  // A single operation.
+  int64_t bytes_read = reader->bytes_read_->value();
+  {
+    vector<ReplicateMsg*> replicates;
+    ElementDeleter deleter(&replicates);
+    ASSERT_OK(reader->ReadReplicatesInRange(10, 10, LogReader::kNoSizeLimit, &replicates));
+    ASSERT_EQ(1, replicates.size());
+  }
+  ASSERT_GT(reader->bytes_read_->value(), bytes_read);
+  ASSERT_LT(reader->bytes_read_->value() - bytes_read, 1024);
+
+  // The whole log, but with a small byte budget.
+  bytes_read = reader->bytes_read_->value();
+  {
+    vector<ReplicateMsg*> replicates;
+    ElementDeleter deleter(&replicates);
+    ASSERT_OK(reader->ReadReplicatesInRange(1, kNumOps, 4096, &replicates));
+    ASSERT_LT(replicates.size(), kNumOps);
+  }
+  ASSERT_LT(reader->bytes_read_->value() - bytes_read, 2 * 4096);
+}
+
+// Benchmark of reading ranges of operations out of the log the way a leader
+// does to catch up a lagging peer, with and without read-ahead.
+TEST_P(LogTestOptionalCompression, TestCatchUpReadThroughput) {
+  const int kNumOps = AllowSlowTests() ? FLAGS_num_catch_up_ops : 1000;
+  const int kOpsPerBatch = 4;
+  const int64_t kMaxBytesPerRead = 1024 * 1024;
+
+  ASSERT_OK(BuildLog());
+  OpId op_id = MakeOpId(1, 1);
+  for (int i = 0; i < kNumOps; i += kOpsPerBatch) {
+    ASSERT_OK(AppendNoOpsToLogSync(clock_, log_.get(), &op_id, kOpsPerBatch));
+  }
+  const int64_t last_index = op_id.index() - 1;
+  shared_ptr<LogReader> reader = log_->reader();
+
+  for (int readahead_bytes : { 0, 64 * 1024, 1024 * 1024 }) {
+    FLAGS_log_reader_readahead_bytes = readahead_bytes;
+    int64_t next_index = 1;
+    LOG_TIMING(INFO, Substitute("reading $0 ops with $1 bytes of read-ahead",
+                                last_index, readahead_bytes)) {
+      while (next_index <= last_index) {
+        vector<ReplicateMsg*> replicates;
+        ElementDeleter deleter(&replicates);
+        ASSERT_OK(reader->ReadReplicatesInRange(next_index, last_index, kMaxBytesPerRead,
+                                                &replicates));
+        ASSERT_FALSE(replicates.empty());
+        for (const ReplicateMsg* replicate : replicates) {
+          ASSERT_EQ(next_index, replicate->id().index());
+          next_index++;
+        }
+      }
+    }
+  }
+}
+
 // Test various situations where we expect different segments depending on what the
 // min log index is.
 TEST_F(LogTest, TestGetGCableDataSize) {
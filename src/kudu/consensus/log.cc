@@ -31,8 +31,10 @@
 #include "kudu/consensus/log_index.h"
 #include "kudu/consensus/log_metrics.h"
 #include "kudu/consensus/log_reader.h"
+#include "kudu/consensus/log_syncer.h"
 #include "kudu/consensus/log_util.h"
 #include "kudu/fs/fs_manager.h"
+#include "kudu/fs/wal_dirs.h"
 #include "kudu/gutil/atomicops.h"
 #include "kudu/gutil/bind.h"
 #include "kudu/gutil/bind_helpers.h"
@@ -40,10 +42,12 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/gutil/walltime.h"
 #include "kudu/util/async_util.h"
 #include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/compression/compression_codec.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
 #include "kudu/util/env_util.h"
@@ -85,6 +89,13 @@ DEFINE_int32(group_commit_queue_size_bytes, 4 * 1024 * 1024,
 TAG_FLAG(group_commit_queue_size_bytes, advanced);
 
 
+DEFINE_bool(log_prepare_next_group_during_sync, true,
+            "Whether the log append thread should compress and checksum the next "
+            "group of entries on a shared thread pool while it syncs the previous "
+            "group, rather than after the sync has completed.");
+TAG_FLAG(log_prepare_next_group_during_sync, advanced);
+TAG_FLAG(log_prepare_next_group_during_sync, runtime);
+
 DEFINE_int32(log_thread_idle_threshold_ms, 1000,
              "Number of milliseconds after which the log append thread decides that a "
              "log is idle, and considers shutting down. Used by tests.");
@@ -178,6 +189,24 @@ using std::vector;
 using std::unique_ptr;
 using strings::Substitute;
 
+namespace {
+
+// Returns the thread pool shared by all logs to prepare groups of entries
+// while their append threads are syncing.
+ThreadPool* GetPreparePool() {
+  static ThreadPool* pool = []() {
+    gscoped_ptr<ThreadPool> pool;
+    CHECK_OK(ThreadPoolBuilder("log-prepare")
+             .set_min_threads(0)
+             .set_max_threads(base::NumCPUs())
+             .Build(&pool));
+    return pool.release();
+  }();
+  return pool;
+}
+
+} // anonymous namespace
+
 // Manages the thread which drains groups of batches from the log's queue and
 // appends them to the underlying log instance.
 //
@@ -191,6 +220,10 @@ using strings::Substitute;
 // Instead, a generic 'DoWork()' task is used which loops collecting work until
 // it finds that it has been idle for a while, at which point the task finishes.
 //
+// Appending a group is pipelined: while a group is being synced, the next
+// group is drained from the queue and compressed on a shared thread pool, so
+// that it's ready to be written as soon as the sync completes.
+//
 // The trick, then, lies in two areas:
 //
 // 1) after appending a batch, we need to ensure that a task is already running,
@@ -235,7 +268,20 @@ class Log::AppendThread {
 
   // Handle the actual appending of a group of entries. Responsible for deleting the
   // LogEntryBatch* pointers.
-  void HandleGroup(vector<LogEntryBatch*> entry_batches);
+  //
+  // If the group must be synced, the next group may be drained from the queue
+  // and prepared during the sync, in which case it's returned in
+  // 'next_batches'. Its size keeps counting against the queue's limit until
+  // it has been handled in turn, and is returned in 'next_held_size'.
+  void HandleGroup(vector<LogEntryBatch*> entry_batches,
+                   vector<LogEntryBatch*>* next_batches,
+                   size_t* next_held_size);
+
+  // Syncs the log. If enabled, meanwhile drains the next group into
+  // 'next_batches' and prepares it on the shared pool. See HandleGroup() for
+  // 'next_held_size'.
+  Status SyncAndPrepareNextGroup(vector<LogEntryBatch*>* next_batches,
+                                 size_t* next_held_size);
 
   string LogPrefix() const;
 
@@ -328,23 +374,39 @@ bool Log::AppendThread::GoIdle() {
 void Log::AppendThread::DoWork() {
   DCHECK_EQ(ANNOTATE_UNPROTECTED_READ(worker_state_), WORKER_ACTIVE);
   VLOG_WITH_PREFIX(2) << "WAL Appender going active";
+  // A group drained and prepared while the previous group was synced, and
+  // the part of the queue's size it holds on to.
+  vector<LogEntryBatch*> next_batches;
+  size_t next_held_size = 0;
   while (true) {
-    MonoTime deadline = MonoTime::Now() +
-        MonoDelta::FromMilliseconds(FLAGS_log_thread_idle_threshold_ms);
     vector<LogEntryBatch*> entry_batches;
-    Status s = log_->entry_queue()->BlockingDrainTo(&entry_batches, deadline);
-    if (PREDICT_FALSE(s.IsAborted())) {
-      break;
-    } else if (PREDICT_FALSE(s.IsTimedOut())) {
-      if (GoIdle()) break;
-      continue;
+    size_t held_size = 0;
+    if (!next_batches.empty()) {
+      entry_batches.swap(next_batches);
+      held_size = next_held_size;
+      next_held_size = 0;
+    } else {
+      MonoTime deadline = MonoTime::Now() +
+          MonoDelta::FromMilliseconds(FLAGS_log_thread_idle_threshold_ms);
+      Status s = log_->entry_queue()->BlockingDrainTo(&entry_batches, deadline);
+      if (PREDICT_FALSE(s.IsAborted())) {
+        break;
+      } else if (PREDICT_FALSE(s.IsTimedOut())) {
+        if (GoIdle()) break;
+        continue;
+      }
     }
-    HandleGroup(std::move(entry_batches));
+    HandleGroup(std::move(entry_batches), &next_batches, &next_held_size);
+    // The group has been written and freed, so let producers refill the
+    // queue in its place.
+    log_->entry_queue()->ReleaseHeldSize(held_size);
   }
   VLOG_WITH_PREFIX(2) << "WAL Appender going idle";
 }
 
-void Log::AppendThread::HandleGroup(vector<LogEntryBatch*> entry_batches) {
+void Log::AppendThread::HandleGroup(vector<LogEntryBatch*> entry_batches,
+                                    vector<LogEntryBatch*>* next_batches,
+                                    size_t* next_held_size) {
   if (log_->metrics_) {
     log_->metrics_->entry_batches_per_group->Increment(entry_batches.size());
   }
@@ -374,7 +436,7 @@ void Log::AppendThread::HandleGroup(vector<LogEntryBatch*> entry_batches) {
 
   Status s;
   if (!is_all_commits) {
-    s = log_->Sync();
+    s = SyncAndPrepareNextGroup(next_batches, next_held_size);
   }
   if (PREDICT_FALSE(!s.ok())) {
     LOG_WITH_PREFIX(ERROR) << "Error syncing log: " << s.ToString();
@@ -400,6 +462,43 @@ void Log::AppendThread::HandleGroup(vector<LogEntryBatch*> entry_batches) {
   }
 }
 
+Status Log::AppendThread::SyncAndPrepareNextGroup(vector<LogEntryBatch*>* next_batches,
+                                                 size_t* next_held_size) {
+  DCHECK(next_batches->empty());
+  if (!FLAGS_log_prepare_next_group_during_sync || !log_->codec_) {
+    // Without compression, there's little work to overlap with the sync.
+    return log_->Sync();
+  }
+
+  // Collect whatever is already queued, without waiting. The batches keep
+  // counting against the queue's limit until they're written, so that the
+  // WAL doesn't hold twice its configured limit in memory meanwhile.
+  *next_held_size = log_->entry_queue()->DrainAndHoldTo(next_batches);
+  if (next_batches->empty()) {
+    return log_->Sync();
+  }
+  CountDownLatch prepared(1);
+  const vector<LogEntryBatch*>* batches = next_batches;
+  Status submit_status = GetPreparePool()->SubmitFunc([this, batches, &prepared]() {
+      log_->PrepareGroup(*batches);
+      prepared.CountDown();
+    });
+  if (PREDICT_FALSE(!submit_status.ok())) {
+    // The batches will be prepared as they are appended.
+    prepared.CountDown();
+  }
+
+  Status s = log_->Sync();
+
+  MonoTime wait_start = MonoTime::Now();
+  prepared.Wait();
+  if (log_->metrics_) {
+    log_->metrics_->prepare_stall_latency->Increment(
+        (MonoTime::Now() - wait_start).ToMicroseconds());
+  }
+  return s;
+}
+
 void Log::AppendThread::Shutdown() {
   log_->entry_queue()->Shutdown();
   if (append_pool_) {
@@ -437,7 +536,7 @@ Status Log::Open(const LogOptions &options,
                  const scoped_refptr<MetricEntity>& metric_entity,
                  scoped_refptr<Log>* log) {
 
-  string tablet_wal_path = fs_manager->GetTabletWalDir(tablet_id);
+  string tablet_wal_path = fs_manager->GetOrPlaceTabletWalDir(tablet_id);
   RETURN_NOT_OK(env_util::CreateDirIfMissing(
       fs_manager->env(), tablet_wal_path));
 
@@ -469,6 +568,8 @@ Log::Log(LogOptions options, FsManager* fs_manager, string log_path,
       append_thread_(new AppendThread(this)),
       force_sync_all_(options_.force_fsync_all),
       sync_disabled_(false),
+      syncer_(nullptr),
+      wal_dir_(nullptr),
       allocation_state_(kAllocationNotStarted),
       codec_(nullptr),
       metric_entity_(metric_entity),
@@ -492,6 +593,10 @@ Status Log::Init() {
     }
   }
 
+  // Find the WAL directory the log was placed in by Open(), for per-directory
+  // metrics.
+  wal_dir_ = CHECK_NOTNULL(fs_manager_->wd_manager()->FindTablet(tablet_id_));
+
   // Init the index
   log_index_.reset(new LogIndex(log_dir_));
 
@@ -507,7 +612,7 @@ Status Log::Init() {
   // sequence numbers.
   if (reader_->num_segments() != 0) {
     VLOG_WITH_PREFIX(1) << "Using existing " << reader_->num_segments()
-                        << " segments from path: " << fs_manager_->GetWalsRootDir();
+                        << " segments from path: " << log_dir_;
 
     vector<scoped_refptr<ReadableLogSegment> > segments;
     RETURN_NOT_OK(reader_->GetSegmentsSnapshot(&segments));
@@ -516,6 +621,9 @@ Status Log::Init() {
 
   if (force_sync_all_) {
     KLOG_FIRST_N(INFO, 1) << LogPrefix() << "Log is configured to fsync() on all Append() calls";
+    if (options_.group_sync_across_tablets) {
+      syncer_ = LogSyncer::GetForDir(fs_manager_->env(), DirName(log_dir_));
+    }
   } else {
     KLOG_FIRST_N(INFO, 1) << LogPrefix()
                           << "Log is configured to *not* fsync() on all Append() calls";
@@ -659,11 +767,17 @@ Status Log::DoAppend(LogEntryBatch* entry_batch) {
 
   int64_t start_offset = active_segment_->written_offset();
 
+  if (!entry_batch->prepared()) {
+    SCOPED_LATENCY_METRIC(metrics_, prepare_latency);
+    RETURN_NOT_OK(entry_batch->Prepare(codec_));
+  }
+
   LOG_SLOW_EXECUTION(WARNING, 50, Substitute("$0Append to log took a long time", LogPrefix())) {
     SCOPED_LATENCY_METRIC(metrics_, append_latency);
+    SCOPED_LATENCY_METRIC(wal_dir_->metrics(), wal_dir_append_latency);
     SCOPED_WATCH_STACK(500);
 
-    RETURN_NOT_OK(active_segment_->WriteEntryBatch(entry_batch_data, codec_));
+    RETURN_NOT_OK(active_segment_->WritePreparedEntryBatch(entry_batch->prepared_entry_));
 
     // Update the reader on how far it can read the active segment.
     reader_->UpdateLastSegmentOffset(active_segment_->written_offset());
@@ -676,6 +790,7 @@ Status Log::DoAppend(LogEntryBatch* entry_batch) {
   if (metrics_) {
     metrics_->bytes_logged->IncrementBy(entry_batch_bytes);
   }
+  wal_dir_->RecordBytesWritten(entry_batch_bytes);
 
   CHECK_OK(UpdateIndexForBatch(*entry_batch, start_offset));
   UpdateFooterForBatch(entry_batch);
@@ -683,6 +798,15 @@ Status Log::DoAppend(LogEntryBatch* entry_batch) {
   return Status::OK();
 }
 
+void Log::PrepareGroup(const vector<LogEntryBatch*>& entry_batches) {
+  TRACE_EVENT1("log", "PrepareGroup", "batch_size", entry_batches.size());
+  for (LogEntryBatch* entry_batch : entry_batches) {
+    if (entry_batch->total_size_bytes() == 0) continue;
+    SCOPED_LATENCY_METRIC(metrics_, prepare_latency);
+    WARN_NOT_OK(entry_batch->Prepare(codec_), "Could not prepare log entry batch");
+  }
+}
+
 Status Log::UpdateIndexForBatch(const LogEntryBatch& batch,
                                 int64_t start_offset) {
   if (batch.type_ != REPLICATE) {
@@ -741,7 +865,12 @@ Status Log::Sync() {
 
   if (force_sync_all_ && !sync_disabled_) {
     LOG_SLOW_EXECUTION(WARNING, 50, Substitute("$0Fsync log took a long time", LogPrefix())) {
-      RETURN_NOT_OK(active_segment_->Sync());
+      SCOPED_LATENCY_METRIC(wal_dir_->metrics(), wal_dir_sync_latency);
+      if (syncer_) {
+        RETURN_NOT_OK(active_segment_->SyncWith(syncer_));
+      } else {
+        RETURN_NOT_OK(active_segment_->Sync());
+      }
 
       if (log_hooks_) {
         RETURN_NOT_OK_PREPEND(log_hooks_->PostSyncIfFsyncEnabled(),
@@ -975,13 +1104,13 @@ bool Log::HasOnDiskData(FsManager* fs_manager, const string& tablet_id) {
 Status Log::DeleteOnDiskData(FsManager* fs_manager, const string& tablet_id) {
   string wal_dir = fs_manager->GetTabletWalDir(tablet_id);
   Env* env = fs_manager->env();
-  if (!env->FileExists(wal_dir)) {
-    return Status::OK();
+  if (env->FileExists(wal_dir)) {
+    LOG(INFO) << Substitute("T $0 P $1: Deleting WAL directory at $2",
+                            tablet_id, fs_manager->uuid(), wal_dir);
+    RETURN_NOT_OK_PREPEND(env->DeleteRecursively(wal_dir),
+                          "Unable to recursively delete WAL dir for tablet " + tablet_id);
   }
-  LOG(INFO) << Substitute("T $0 P $1: Deleting WAL directory at $2",
-                          tablet_id, fs_manager->uuid(), wal_dir);
-  RETURN_NOT_OK_PREPEND(env->DeleteRecursively(wal_dir),
-                        "Unable to recursively delete WAL dir for tablet " + tablet_id);
+  fs_manager->wd_manager()->RemoveTablet(tablet_id);
   return Status::OK();
 }
 
@@ -1136,7 +1265,8 @@ LogEntryBatch::LogEntryBatch(LogEntryTypePB type,
       total_size_bytes_(
           PREDICT_FALSE(count == 1 && entry_batch_pb_->entry(0).type() == FLUSH_MARKER) ?
           0 : entry_batch_pb_->ByteSize()),
-      count_(count) {
+      count_(count),
+      prepared_(false) {
 }
 
 LogEntryBatch::~LogEntryBatch() {
@@ -1159,6 +1289,13 @@ void LogEntryBatch::Serialize() {
   pb_util::AppendToString(*entry_batch_pb_, &buffer_);
 }
 
+Status LogEntryBatch::Prepare(const CompressionCodec* codec) {
+  DCHECK(!prepared_);
+  RETURN_NOT_OK(WritableLogSegment::PrepareEntryBatch(data(), codec, &prepared_entry_));
+  prepared_ = true;
+  return Status::OK();
+}
+
 
 }  // namespace log
 }  // namespace kudu
@@ -57,6 +57,10 @@ class ThreadPool;
 class WritableFile;
 struct WritableFileOptions;
 
+namespace fs {
+class WalDir;
+} // namespace fs
+
 namespace log {
 
 struct LogEntryBatchLogicalSize;
@@ -65,6 +69,7 @@ struct RetentionIndexes;
 class LogEntryBatch;
 class LogIndex;
 class LogReader;
+class LogSyncer;
 
 typedef BlockingQueue<LogEntryBatch*, LogEntryBatchLogicalSize> LogEntryBatchQueue;
 
@@ -299,6 +304,11 @@ class Log : public RefCountedThreadSafe<Log> {
   // AppenderThread.
   Status DoAppend(LogEntryBatch* entry_batch);
 
+  // Compresses and checksums the batches in 'entry_batches' ahead of their
+  // append. Failures are ignored: DoAppend() retries preparing any batch
+  // which wasn't prepared, and reports the error.
+  void PrepareGroup(const std::vector<LogEntryBatch*>& entry_batches);
+
   // Update footer_builder_ to reflect the log indexes seen in 'batch'.
   void UpdateFooterForBatch(LogEntryBatch* batch);
 
@@ -393,6 +403,14 @@ class Log : public RefCountedThreadSafe<Log> {
   // This is used to disable fsync during bootstrap.
   bool sync_disabled_;
 
+  // If non-null, the syncer shared with the other logs in the same WAL
+  // directory, through which the active segment is synced.
+  LogSyncer* syncer_;
+
+  // The WAL directory this log was placed in. Owned by the FsManager's
+  // WalDirManager.
+  fs::WalDir* wal_dir_;
+
   // The status of the most recent log-allocation action.
   Promise<Status> allocation_status_;
 
@@ -463,6 +481,15 @@ class LogEntryBatch {
   // Serializes contents of the entry to an internal buffer.
   void Serialize();
 
+  // Prepares the serialized contents of the entry to be written to a segment
+  // whose entries are compressed with 'codec'. See
+  // WritableLogSegment::PrepareEntryBatch().
+  Status Prepare(const CompressionCodec* codec);
+
+  bool prepared() const {
+    return prepared_;
+  }
+
   // Sets the callback that will be invoked after the entry is
   // appended and synced to disk
   void set_callback(const StatusCallback& cb) {
@@ -528,6 +555,10 @@ class LogEntryBatch {
   // 'Serialize()'
   faststring buffer_;
 
+  // The contents of 'buffer_', compressed and checksummed by 'Prepare()'.
+  PreparedEntryBatch prepared_entry_;
+  bool prepared_;
+
   DISALLOW_COPY_AND_ASSIGN(LogEntryBatch);
 };
 
@@ -40,6 +40,7 @@
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/consensus/opid_util.h"
 #include "kudu/consensus/ref_counted_replicate.h"
+#include "kudu/consensus/replicate_sidecars.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/bind.h"
 #include "kudu/gutil/gscoped_ptr.h"
@@ -337,6 +338,35 @@ TEST_F(LogCacheTest, TestReplaceMessages) {
             cache_->ToString());
 }
 
+// Test that the chunk holding the serialized form of cached messages is
+// charged once, in full, until the last message referencing it is evicted.
+TEST_F(LogCacheTest, TestSerializedChunkMemory) {
+  shared_ptr<MemTracker> tracker = cache_->tracker_;
+  vector<ReplicateRefPtr> msgs;
+  for (int64_t index = 1; index <= 2; index++) {
+    msgs.push_back(make_scoped_refptr_replicate(
+        CreateDummyReplicate(0, index, clock_->Now(), 100).release()));
+  }
+  ReplicateSerializer serializer(1024 * 1024);
+  serializer.Serialize(msgs);
+  ASSERT_EQ(msgs[0]->serialized_chunk(), msgs[1]->serialized_chunk());
+  const int64_t chunk_size = msgs[0]->serialized_chunk()->capacity();
+  const int64_t first_size = msgs[0]->get()->SpaceUsed();
+  const int64_t second_size = msgs[1]->get()->SpaceUsed();
+
+  ASSERT_OK(cache_->AppendOperations(msgs, Bind(&FatalOnError)));
+  msgs.clear();
+  log_->WaitUntilAllFlushed();
+  ASSERT_EQ(first_size + second_size + chunk_size, tracker->consumption());
+
+  // The chunk is still referenced by the second message.
+  cache_->EvictThroughOp(1);
+  ASSERT_EQ(second_size + chunk_size, tracker->consumption());
+
+  cache_->EvictThroughOp(2);
+  ASSERT_EQ(0, tracker->consumption());
+}
+
 // Test that the cache truncates any future messages when either explicitly
 // truncated or replacing any earlier message.
 TEST_F(LogCacheTest, TestTruncation) {
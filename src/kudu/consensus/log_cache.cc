@@ -79,6 +79,12 @@ static const char kParentMemTrackerId[] = "log_cache";
 
 typedef vector<const ReplicateMsg*>::const_iterator MsgIter;
 
+// Returns the memory used by a cached message, excluding its serialized form,
+// which is accounted for per chunk.
+static int64_t MessageMemUsage(const ReplicateRefPtr& msg) {
+  return msg->get()->SpaceUsed();
+}
+
 LogCache::LogCache(const scoped_refptr<MetricEntity>& metric_entity,
                    const scoped_refptr<log::Log>& log,
                    const string& local_uuid,
@@ -165,7 +171,13 @@ Status LogCache::AppendOperations(const vector<ReplicateRefPtr>& msgs,
 
   int64_t mem_required = 0;
   for (const auto& msg : msgs) {
-    mem_required += msg->get()->SpaceUsed();
+    mem_required += MessageMemUsage(msg);
+    // The whole chunk holding the serialized form of the message stays
+    // allocated for as long as any cached message references it.
+    const auto& chunk = msg->serialized_chunk();
+    if (chunk && chunk_refs_[chunk.get()]++ == 0) {
+      mem_required += chunk->capacity();
+    }
   }
 
   // Try to consume the memory. If it can't be consumed, we may need to evict.
@@ -399,8 +411,7 @@ void LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evic
     }
 
     VLOG_WITH_PREFIX_UNLOCKED(2) << "Evicting cache. Removing: " << msg->get()->id();
-    AccountForMessageRemovalUnlocked(msg);
-    bytes_evicted += msg->get()->SpaceUsed();
+    bytes_evicted += AccountForMessageRemovalUnlocked(msg);
     cache_.erase(iter++);
 
     if (bytes_evicted >= bytes_to_evict) {
@@ -410,10 +421,21 @@ void LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evic
   VLOG_WITH_PREFIX_UNLOCKED(1) << "Evicting log cache: after state: " << ToStringUnlocked();
 }
 
-void LogCache::AccountForMessageRemovalUnlocked(const ReplicateRefPtr& msg) {
-  tracker_->Release(msg->get()->SpaceUsed());
-  metrics_.log_cache_size->DecrementBy(msg->get()->SpaceUsed());
+int64_t LogCache::AccountForMessageRemovalUnlocked(const ReplicateRefPtr& msg) {
+  int64_t mem_usage = MessageMemUsage(msg);
+  const auto& chunk = msg->serialized_chunk();
+  if (chunk) {
+    auto iter = chunk_refs_.find(chunk.get());
+    DCHECK(iter != chunk_refs_.end());
+    if (--iter->second == 0) {
+      chunk_refs_.erase(iter);
+      mem_usage += chunk->capacity();
+    }
+  }
+  tracker_->Release(mem_usage);
+  metrics_.log_cache_size->DecrementBy(mem_usage);
   metrics_.log_cache_num_ops->Decrement();
+  return mem_usage;
 }
 
 int64_t LogCache::BytesUsed() const {
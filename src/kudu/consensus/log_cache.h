@@ -22,6 +22,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <gtest/gtest_prod.h>
@@ -146,6 +147,7 @@ class LogCache {
   FRIEND_TEST(LogCacheTest, TestAppendAndGetMessages);
   FRIEND_TEST(LogCacheTest, TestGlobalMemoryLimit);
   FRIEND_TEST(LogCacheTest, TestReplaceMessages);
+  FRIEND_TEST(LogCacheTest, TestSerializedChunkMemory);
   FRIEND_TEST(LogCacheTest, TestTruncation);
   friend class LogCacheTest;
 
@@ -155,8 +157,8 @@ class LogCache {
   void EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evict);
 
   // Update metrics and MemTracker to account for the removal of the
-  // given message.
-  void AccountForMessageRemovalUnlocked(const ReplicateRefPtr& msg);
+  // given message. Returns the number of bytes released.
+  int64_t AccountForMessageRemovalUnlocked(const ReplicateRefPtr& msg);
 
   void TruncateOpsAfterUnlocked(int64_t index);
 
@@ -187,6 +189,11 @@ class LogCache {
   typedef std::map<uint64_t, ReplicateRefPtr> MessageCache;
   MessageCache cache_;
 
+  // The number of cached messages whose serialized form is held by each
+  // chunk. The full capacity of a chunk is charged to 'tracker_' for as long
+  // as it's referenced by a cached message.
+  std::unordered_map<const SerializedReplicateChunk*, int> chunk_refs_;
+
   // The next log index to append. Each append operation must either
   // start with this log index, or go backward (but never skip forward).
   int64_t next_sequential_op_index_;
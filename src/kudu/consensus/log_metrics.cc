@@ -48,6 +48,19 @@ METRIC_DEFINE_histogram(tablet, log_entry_batches_per_group, "Log Group Commit B
                         "Number of log entry batches in a group commit group",
                         1024, 2);
 
+METRIC_DEFINE_histogram(tablet, log_prepare_latency, "Log Prepare Latency",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Microseconds spent on compressing and checksumming a log entry "
+                        "batch, either ahead of time while the previous group is synced, "
+                        "or when the batch is appended",
+                        60000000LU, 2);
+
+METRIC_DEFINE_histogram(tablet, log_prepare_stall_latency, "Log Prepare Stall Latency",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Microseconds the log append thread spent waiting, after syncing "
+                        "a group, for the next group to finish being prepared",
+                        60000000LU, 2);
+
 namespace kudu {
 namespace log {
 
@@ -58,7 +71,9 @@ LogMetrics::LogMetrics(const scoped_refptr<MetricEntity>& metric_entity)
       MINIT(append_latency),
       MINIT(group_commit_latency),
       MINIT(roll_latency),
-      MINIT(entry_batches_per_group) {
+      MINIT(entry_batches_per_group),
+      MINIT(prepare_latency),
+      MINIT(prepare_stall_latency) {
 }
 #undef MINIT
 
@@ -18,9 +18,11 @@
 #include "kudu/consensus/log_reader.h"
 
 #include <algorithm>
+#include <memory>
 #include <mutex>
 #include <ostream>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/consensus/consensus.pb.h"
@@ -34,10 +36,19 @@
 #include "kudu/gutil/strings/util.h"
 #include "kudu/util/env.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/path_util.h"
 #include "kudu/util/pb_util.h"
 
+DEFINE_int32(log_reader_readahead_bytes, 1024 * 1024,
+             "The number of bytes read at a time from a log segment when reading "
+             "ranges of operations out of the log, e.g. to catch up a lagging "
+             "peer. Consecutive log entries within this many bytes are read with "
+             "a single IO. If 0, each entry is read on its own.");
+TAG_FLAG(log_reader_readahead_bytes, advanced);
+TAG_FLAG(log_reader_readahead_bytes, runtime);
+
 METRIC_DEFINE_counter(tablet, log_reader_bytes_read, "Bytes Read From Log",
                       kudu::MetricUnit::kBytes,
                       "Data read from the WAL since tablet start");
@@ -57,6 +68,7 @@ using kudu::pb_util::SecureDebugString;
 using kudu::pb_util::SecureShortDebugString;
 using std::shared_ptr;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 
@@ -245,6 +257,8 @@ scoped_refptr<ReadableLogSegment> LogReader::GetSegmentBySequenceNumber(int64_t
 }
 
 Status LogReader::ReadBatchUsingIndexEntry(const LogIndexEntry& index_entry,
+                                           LogSegmentReadahead* readahead,
+                                           int64_t readahead_bytes,
                                            faststring* tmp_buf,
                                            gscoped_ptr<LogEntryBatchPB>* batch) const {
   const int64_t index = index_entry.op_id.index();
@@ -260,9 +274,20 @@ Status LogReader::ReadBatchUsingIndexEntry(const LogIndexEntry& index_entry,
   CHECK_GT(index_entry.offset_in_segment, 0);
   int64_t offset = index_entry.offset_in_segment;
   ScopedLatencyMetric scoped(read_batch_latency_.get());
-  EntryHeaderStatus unused_status_detail;
-  RETURN_NOT_OK_PREPEND(segment->ReadEntryHeaderAndBatch(&offset, tmp_buf, batch,
-                                                         &unused_status_detail),
+  Status s;
+  // With read-ahead, count what was actually read from the segment, rather
+  // than the size of the batch.
+  int64_t bytes_read = 0;
+  if (readahead) {
+    const int64_t readahead_bytes_before = readahead->bytes_read();
+    s = segment->ReadEntryHeaderAndBatch(&offset, readahead_bytes, readahead, tmp_buf, batch);
+    bytes_read = readahead->bytes_read() - readahead_bytes_before;
+  } else {
+    EntryHeaderStatus unused_status_detail;
+    s = segment->ReadEntryHeaderAndBatch(&offset, tmp_buf, batch, &unused_status_detail);
+    bytes_read = offset - index_entry.offset_in_segment;
+  }
+  RETURN_NOT_OK_PREPEND(s,
                         Substitute("Failed to read LogEntry for index $0 from log segment "
                                    "$1 offset $2",
                                    index,
@@ -270,7 +295,7 @@ Status LogReader::ReadBatchUsingIndexEntry(const LogIndexEntry& index_entry,
                                    index_entry.offset_in_segment));
 
   if (bytes_read_) {
-    bytes_read_->IncrementBy(segment->entry_header_size() + tmp_buf->length());
+    bytes_read_->IncrementBy(bytes_read);
     entries_read_->IncrementBy((**batch).entry_size());
   }
 
@@ -293,6 +318,20 @@ Status LogReader::ReadReplicatesInRange(int64_t starting_at,
   bool limit_exceeded = false;
   faststring tmp_buf;
   gscoped_ptr<LogEntryBatchPB> batch;
+  // The batches of consecutive operations are usually next to each other in
+  // the same segment: read them through a window of the segment rather than
+  // one by one.
+  unique_ptr<LogSegmentReadahead> readahead;
+  const int64_t max_readahead_bytes = FLAGS_log_reader_readahead_bytes;
+  // Where the last requested batch starts, so as not to read ahead past it.
+  LogIndexEntry last_index_entry;
+  last_index_entry.segment_sequence_number = -1;
+  if (max_readahead_bytes > 0) {
+    readahead.reset(new LogSegmentReadahead);
+    if (!log_index_->GetEntry(up_to, &last_index_entry).ok()) {
+      last_index_entry.segment_sequence_number = -1;
+    }
+  }
   for (int64_t index = starting_at; index <= up_to && !limit_exceeded; index++) {
     LogIndexEntry index_entry;
     RETURN_NOT_OK_PREPEND(log_index_->GetEntry(index, &index_entry),
@@ -305,7 +344,21 @@ Status LogReader::ReadReplicatesInRange(int64_t starting_at,
     if (index == starting_at ||
         index_entry.segment_sequence_number != prev_index_entry.segment_sequence_number ||
         index_entry.offset_in_segment != prev_index_entry.offset_in_segment) {
-      RETURN_NOT_OK(ReadBatchUsingIndexEntry(index_entry, &tmp_buf, &batch));
+      // Don't read ahead more than the rest of the byte budget calls for (a
+      // batch takes up about as much room on disk as in memory, or less if
+      // compressed), nor past the start of the last requested batch. The window never shrinks below the
+      // header or batch being read, nor extends past the readable part of the
+      // segment.
+      int64_t readahead_bytes = max_readahead_bytes;
+      if (max_bytes_to_read > 0) {
+        readahead_bytes = std::min(readahead_bytes, max_bytes_to_read - total_size);
+      }
+      if (index_entry.segment_sequence_number == last_index_entry.segment_sequence_number) {
+        readahead_bytes = std::min(
+            readahead_bytes, last_index_entry.offset_in_segment - index_entry.offset_in_segment);
+      }
+      RETURN_NOT_OK(ReadBatchUsingIndexEntry(index_entry, readahead.get(), readahead_bytes,
+                                             &tmp_buf, &batch));
 
       // Sanity-check the property that a batch should only have increasing indexes.
       int64_t prev_index = 0;
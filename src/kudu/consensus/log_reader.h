@@ -114,6 +114,7 @@ class LogReader {
  private:
   FRIEND_TEST(LogTestOptionalCompression, TestLogReader);
   FRIEND_TEST(LogTestOptionalCompression, TestReadLogWithReplacedReplicates);
+  FRIEND_TEST(LogTestOptionalCompression, TestReadAheadIsBounded);
   friend class Log;
   friend class LogTest;
   friend class LogTestOptionalCompression;
@@ -160,8 +161,12 @@ class LogReader {
   void UpdateLastSegmentOffset(int64_t readable_to_offset);
 
   // Read the LogEntryBatchPB pointed to by the provided index entry.
-  // 'tmp_buf' is used as scratch space to avoid extra allocation.
+  // 'tmp_buf' is used as scratch space to avoid extra allocation. If
+  // 'readahead' is set, the batch is read through it, refilling its window
+  // with up to 'readahead_bytes' at a time.
   Status ReadBatchUsingIndexEntry(const LogIndexEntry& index_entry,
+                                  LogSegmentReadahead* readahead,
+                                  int64_t readahead_bytes,
                                   faststring* tmp_buf,
                                   gscoped_ptr<LogEntryBatchPB>* batch) const;
 
@@ -0,0 +1,163 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/consensus/log_syncer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags_declare.h>
+#include <gtest/gtest.h>
+
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/env.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_double(env_inject_eio);
+DECLARE_int32(log_syncer_min_filesystem_sync_group_size);
+DECLARE_string(env_inject_eio_globs);
+
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace log {
+
+class LogSyncerTest : public KuduTest {
+ protected:
+  // Has 'num_threads' threads each append to and sync their own file
+  // 'syncs_per_thread' times through a shared syncer.
+  void RunConcurrentSyncs(int num_threads, int syncs_per_thread, LogSyncer* syncer) {
+    vector<unique_ptr<WritableFile>> files(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+      ASSERT_OK(env_->NewWritableFile(GetTestPath(Substitute("file-$0", i)), &files[i]));
+    }
+    vector<Status> statuses(num_threads);
+    vector<thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([&, i]() {
+        for (int j = 0; j < syncs_per_thread; j++) {
+          Status s = files[i]->Append(Slice("data"));
+          if (s.ok()) {
+            s = syncer->Sync(files[i].get());
+          }
+          if (!s.ok()) {
+            statuses[i] = s;
+            return;
+          }
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    for (const auto& s : statuses) {
+      ASSERT_OK(s);
+    }
+    for (const auto& f : files) {
+      ASSERT_OK(f->Close());
+    }
+  }
+};
+
+// Test that concurrent syncs of different files are grouped.
+TEST_F(LogSyncerTest, TestConcurrentSyncs) {
+  const int kNumThreads = 8;
+  const int kSyncsPerThread = 100;
+  LogSyncer syncer(env_, test_dir_);
+  ASSERT_OK(syncer.Init());
+  NO_FATALS(RunConcurrentSyncs(kNumThreads, kSyncsPerThread, &syncer));
+
+  LOG(INFO) << "Synced " << kNumThreads * kSyncsPerThread << " requests in "
+            << syncer.num_groups() << " groups, " << syncer.num_filesystem_syncs()
+            << " of which with a filesystem-wide sync";
+  ASSERT_GT(syncer.num_groups(), 0);
+  ASSERT_LE(syncer.num_groups(), kNumThreads * kSyncsPerThread);
+  ASSERT_LE(syncer.num_filesystem_syncs(), syncer.num_groups());
+}
+
+// Test that every group is synced with a filesystem-wide sync when the
+// minimum group size allows it, and with per-file syncs when it doesn't.
+TEST_F(LogSyncerTest, TestFilesystemSyncThreshold) {
+  FLAGS_log_syncer_min_filesystem_sync_group_size = 1;
+  {
+    LogSyncer syncer(env_, test_dir_);
+    ASSERT_OK(syncer.Init());
+    NO_FATALS(RunConcurrentSyncs(4, 10, &syncer));
+    // Filesystem-wide syncs are unavailable on some platforms and kernels, in
+    // which case the syncer falls back to per-file syncs.
+    unique_ptr<SyncableFileSystem> fs;
+    if (env_->NewSyncableFileSystem(test_dir_, &fs).IsNotSupported()) {
+      ASSERT_EQ(0, syncer.num_filesystem_syncs());
+    } else {
+      ASSERT_EQ(syncer.num_groups(), syncer.num_filesystem_syncs());
+    }
+  }
+
+  FLAGS_log_syncer_min_filesystem_sync_group_size = 1000;
+  {
+    LogSyncer syncer(env_, test_dir_);
+    ASSERT_OK(syncer.Init());
+    NO_FATALS(RunConcurrentSyncs(4, 10, &syncer));
+    ASSERT_EQ(0, syncer.num_filesystem_syncs());
+  }
+}
+
+// Test that errors syncing the WAL filesystem through the handle the syncer
+// holds open are reported to the group.
+TEST_F(LogSyncerTest, TestFilesystemSyncErrors) {
+  FLAGS_log_syncer_min_filesystem_sync_group_size = 1;
+  unique_ptr<SyncableFileSystem> fs;
+  if (env_->NewSyncableFileSystem(test_dir_, &fs).IsNotSupported()) {
+    LOG(INFO) << "Filesystem-wide syncs are not supported, skipping test";
+    return;
+  }
+  LogSyncer syncer(env_, test_dir_);
+  ASSERT_OK(syncer.Init());
+  unique_ptr<WritableFile> file;
+  ASSERT_OK(env_->NewWritableFile(GetTestPath("file"), &file));
+  ASSERT_OK(file->Append(Slice("data")));
+
+  // Only fail I/O on the filesystem handle, which was opened on the directory.
+  FLAGS_env_inject_eio_globs = test_dir_;
+  FLAGS_env_inject_eio = 1.0;
+  Status s = syncer.Sync(file.get());
+  ASSERT_TRUE(s.IsIOError()) << s.ToString();
+  ASSERT_EQ(1, syncer.num_filesystem_syncs());
+
+  FLAGS_env_inject_eio = 0;
+  ASSERT_OK(syncer.Sync(file.get()));
+  ASSERT_OK(file->Close());
+}
+
+// Test that the syncer for a directory is shared.
+TEST_F(LogSyncerTest, TestGetForDir) {
+  LogSyncer* syncer = LogSyncer::GetForDir(env_, test_dir_);
+  ASSERT_EQ(syncer, LogSyncer::GetForDir(env_, test_dir_));
+  ASSERT_NE(syncer, LogSyncer::GetForDir(env_, GetTestPath("other")));
+}
+
+} // namespace log
+} // namespace kudu
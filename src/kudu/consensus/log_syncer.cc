@@ -0,0 +1,135 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/consensus/log_syncer.h"
+
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/port.h"
+#include "kudu/util/debug/trace_event.h"
+#include "kudu/util/env.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/locks.h"
+
+DEFINE_int32(log_syncer_min_filesystem_sync_group_size, 4,
+             "When the WALs of multiple tablets share a syncer, the minimum number "
+             "of WAL segments which must be waiting to be synced for the whole WAL "
+             "filesystem to be synced at once, rather than each segment in turn.");
+TAG_FLAG(log_syncer_min_filesystem_sync_group_size, advanced);
+TAG_FLAG(log_syncer_min_filesystem_sync_group_size, runtime);
+
+using std::map;
+using std::shared_ptr;
+using std::string;
+
+namespace kudu {
+namespace log {
+
+LogSyncer* LogSyncer::GetForDir(Env* env, const string& dir) {
+  static simple_spinlock registry_lock;
+  static map<string, LogSyncer*>* registry = new map<string, LogSyncer*>();
+
+  std::lock_guard<simple_spinlock> l(registry_lock);
+  LogSyncer** syncer = &LookupOrInsert(registry, dir, nullptr);
+  if (*syncer == nullptr) {
+    *syncer = new LogSyncer(env, dir);
+    WARN_NOT_OK((*syncer)->Init(),
+                "Unable to open WAL filesystem, syncing individual segments instead");
+  }
+  return *syncer;
+}
+
+LogSyncer::LogSyncer(Env* env, string dir)
+    : env_(env),
+      dir_(std::move(dir)),
+      cond_(&lock_),
+      sync_in_progress_(false),
+      num_groups_(0),
+      num_filesystem_syncs_(0) {
+}
+
+LogSyncer::~LogSyncer() {
+}
+
+Status LogSyncer::Init() {
+  Status s = env_->NewSyncableFileSystem(dir_, &fs_);
+  if (s.IsNotSupported()) {
+    LOG(INFO) << "Syncing WAL filesystem is not supported, syncing individual "
+              << "segments instead: " << s.ToString();
+    return Status::OK();
+  }
+  return s;
+}
+
+Status LogSyncer::Sync(WritableFile* file) {
+  MutexLock l(lock_);
+  if (!pending_) {
+    pending_ = std::make_shared<Group>();
+  }
+  shared_ptr<Group> group = pending_;
+  group->files.push_back(file);
+
+  // Wait for our group to be synced by someone else, or for the group ahead
+  // of ours to finish so that we can lead ours.
+  while (sync_in_progress_ && !group->done) {
+    cond_.Wait();
+  }
+  if (group->done) {
+    return group->status;
+  }
+
+  // We're the leader of our group: close it to new requests and sync it.
+  DCHECK_EQ(group.get(), pending_.get());
+  pending_.reset();
+  sync_in_progress_ = true;
+  l.Unlock();
+  Status s = SyncGroup(*group);
+  l.Lock();
+
+  group->status = s;
+  group->done = true;
+  sync_in_progress_ = false;
+  cond_.Broadcast();
+  return s;
+}
+
+Status LogSyncer::SyncGroup(const Group& group) {
+  TRACE_EVENT1("log", "LogSyncer::SyncGroup", "num_files", group.files.size());
+  base::subtle::NoBarrier_AtomicIncrement(&num_groups_, 1);
+
+  if (fs_ &&
+      static_cast<int>(group.files.size()) >=
+          FLAGS_log_syncer_min_filesystem_sync_group_size) {
+    base::subtle::NoBarrier_AtomicIncrement(&num_filesystem_syncs_, 1);
+    return fs_->Sync();
+  }
+
+  for (WritableFile* file : group.files) {
+    RETURN_NOT_OK(file->Sync());
+  }
+  return Status::OK();
+}
+
+}  // namespace log
+}  // namespace kudu
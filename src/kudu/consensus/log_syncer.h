@@ -0,0 +1,134 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CONSENSUS_LOG_SYNCER_H
+#define KUDU_CONSENSUS_LOG_SYNCER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/gutil/atomicops.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Env;
+class SyncableFileSystem;
+class WritableFile;
+
+namespace log {
+
+// Coalesces the fsyncs issued by the WALs of all the tablets which share a
+// WAL directory.
+//
+// On servers hosting many replicas which each receive a trickle of writes,
+// every tablet's Log would otherwise fsync its own active segment after each
+// group commit, and write latency becomes bound by the number of fsyncs the
+// disk can sustain. Instead, a Log configured with a shared syncer hands its
+// segment to the syncer, which groups concurrent requests: the first caller
+// of a group becomes its leader and makes every file in the group durable,
+// with a single syncfs() of the WAL filesystem if the group is large enough,
+// or else by syncing each file in turn. Callers which arrive while a group is
+// being synced form the next group.
+//
+// syncfs() only reports writeback errors recorded after the file descriptor
+// it's called on was opened, so the syncer opens the WAL filesystem once,
+// before any of the segments it syncs are written, and keeps it open.
+//
+// Every tablet still writes its own segments, so that replay, GC and tablet
+// copy are unaffected.
+//
+// This class is thread-safe.
+class LogSyncer {
+ public:
+  // Returns the process-wide syncer for the WAL directory 'dir', creating and
+  // initializing it if necessary. The returned syncer is never destroyed.
+  static LogSyncer* GetForDir(Env* env, const std::string& dir);
+
+  LogSyncer(Env* env, std::string dir);
+  ~LogSyncer();
+
+  // Opens the WAL filesystem so that groups can be synced with a single
+  // filesystem-wide sync. Must be called before any file synced through the
+  // syncer is written. If this fails, or if filesystem-wide syncs aren't
+  // supported, each file of a group is synced in turn instead.
+  Status Init();
+
+  // Makes the contents of 'file', which must be on the filesystem of the
+  // syncer's directory, durable. Blocks until a group including 'file' has
+  // been synced, and returns the result of syncing that group.
+  Status Sync(WritableFile* file);
+
+  // The number of groups synced so far.
+  int64_t num_groups() const {
+    return base::subtle::NoBarrier_Load(&num_groups_);
+  }
+
+  // The number of groups synced with a single filesystem-wide sync.
+  int64_t num_filesystem_syncs() const {
+    return base::subtle::NoBarrier_Load(&num_filesystem_syncs_);
+  }
+
+ private:
+  // A group of files synced together.
+  struct Group {
+    Group() : done(false) {}
+
+    std::vector<WritableFile*> files;
+
+    // Set by the group's leader once the files have been synced.
+    bool done;
+    Status status;
+  };
+
+  // Syncs the files in 'group'. Called by the group's leader without holding
+  // 'lock_'.
+  Status SyncGroup(const Group& group);
+
+  Env* const env_;
+  const std::string dir_;
+
+  // Protects the fields below.
+  Mutex lock_;
+
+  // Signaled whenever a group has been synced.
+  ConditionVariable cond_;
+
+  // The group collecting new requests, or null if there are none.
+  std::shared_ptr<Group> pending_;
+
+  // Whether a leader is currently syncing a group.
+  bool sync_in_progress_;
+
+  // The WAL filesystem, kept open for the lifetime of the syncer. Null if
+  // filesystem-wide syncs are unsupported.
+  std::unique_ptr<SyncableFileSystem> fs_;
+
+  base::subtle::Atomic64 num_groups_;
+  base::subtle::Atomic64 num_filesystem_syncs_;
+
+  DISALLOW_COPY_AND_ASSIGN(LogSyncer);
+};
+
+}  // namespace log
+}  // namespace kudu
+
+#endif /* KUDU_CONSENSUS_LOG_SYNCER_H */
@@ -25,6 +25,7 @@
 #include <glog/logging.h>
 
 #include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/log_syncer.h"
 #include "kudu/consensus/opid_util.h"
 #include "kudu/consensus/ref_counted_replicate.h"
 #include "kudu/fs/fs_manager.h"
@@ -53,6 +54,17 @@ DEFINE_bool(log_force_fsync_all, false,
             "Whether the Log/WAL should explicitly call fsync() after each write.");
 TAG_FLAG(log_force_fsync_all, stable);
 
+DEFINE_bool(log_group_sync_across_tablets, false,
+            "Whether the WALs of all tablets in a WAL directory should share a single "
+            "group commit pipeline for their fsyncs, rather than each WAL syncing its "
+            "own segments. This reduces the number of fsyncs on servers hosting many "
+            "tablets. Large groups are synced with a single syncfs() call, so this "
+            "should only be enabled if the WAL directory is on its own filesystem. "
+            "syncfs() only reports writeback errors as of Linux 5.8; on older kernels "
+            "each segment of a group is synced in turn instead. Only relevant if "
+            "--log_force_fsync_all is set.");
+TAG_FLAG(log_group_sync_across_tablets, experimental);
+
 DEFINE_bool(log_preallocate_segments, true,
             "Whether the WAL should preallocate the entire segment before writing to it");
 TAG_FLAG(log_preallocate_segments, advanced);
@@ -100,6 +112,7 @@ const uint32_t kLogSegmentMaxHeaderOrFooterSize = 8 * 1024 * 1024;
 LogOptions::LogOptions()
 : segment_size_mb(FLAGS_log_segment_size_mb),
   force_fsync_all(FLAGS_log_force_fsync_all),
+  group_sync_across_tablets(FLAGS_log_group_sync_across_tablets),
   preallocate_segments(FLAGS_log_preallocate_segments),
   async_preallocate_segments(FLAGS_log_async_preallocate_segments) {
 }
@@ -654,6 +667,45 @@ Status ReadableLogSegment::ReadEntryHeaderAndBatch(int64_t* offset, faststring*
   return Status::OK();
 }
 
+Status ReadableLogSegment::ReadEntryHeaderAndBatch(int64_t* offset,
+                                                   int64_t readahead_bytes,
+                                                   LogSegmentReadahead* readahead,
+                                                   faststring* tmp_buf,
+                                                   gscoped_ptr<LogEntryBatchPB>* batch) {
+  const size_t header_size = entry_header_size();
+  Slice data;
+  RETURN_NOT_OK_PREPEND(readahead->Read(this, *offset, header_size, readahead_bytes, &data),
+                        "Could not read log entry header");
+  EntryHeader header;
+  switch (DecodeEntryHeader(data, &header)) {
+    case EntryHeaderStatus::CRC_MISMATCH:
+      return Status::Corruption("CRC mismatch in log entry header");
+    case EntryHeaderStatus::ALL_ZEROS:
+      return Status::Corruption("preallocated space found");
+    case EntryHeaderStatus::OK:
+      break;
+    default:
+      LOG(FATAL) << "unexpected result from decoding";
+      return Status::Corruption("unexpected result from decoded");
+  }
+  if (header.msg_length == 0) {
+    return Status::Corruption("Invalid 0 entry length");
+  }
+
+  const int64_t batch_offset = *offset + header_size;
+  RETURN_NOT_OK_PREPEND(readahead->Read(this, batch_offset, header.msg_length_compressed,
+                                        readahead_bytes, &data),
+                        "Could not read entry");
+  uint8_t* uncompress_buf = nullptr;
+  if (codec_) {
+    tmp_buf->resize(header.msg_length);
+    uncompress_buf = tmp_buf->data();
+  }
+  RETURN_NOT_OK(DecodeEntryBatch(batch_offset, header, data, uncompress_buf, batch));
+  *offset = batch_offset + header.msg_length_compressed;
+  return Status::OK();
+}
+
 Status ReadableLogSegment::ReadEntryHeader(int64_t *offset, EntryHeader* header,
                                            EntryHeaderStatus* status_detail) {
   const size_t header_size = entry_header_size();
@@ -742,38 +794,87 @@ Status ReadableLogSegment::ReadEntryBatch(int64_t *offset,
   if (!s.ok()) return Status::IOError(Substitute("Could not read entry. Cause: $0",
                                                  s.ToString()));
 
+  // We pre-reserved space for the decompression up above.
+  uint8_t* uncompress_buf = codec_ ? &(*tmp_buf)[header.msg_length_compressed] : nullptr;
+  RETURN_NOT_OK(DecodeEntryBatch(*offset, header, entry_batch_slice, uncompress_buf,
+                                 entry_batch));
+  *offset += header.msg_length_compressed;
+  return Status::OK();
+}
+
+Status ReadableLogSegment::DecodeEntryBatch(int64_t offset,
+                                            const EntryHeader& header,
+                                            const Slice& data,
+                                            uint8_t* uncompress_buf,
+                                            gscoped_ptr<LogEntryBatchPB>* entry_batch) {
+  DCHECK_EQ(header.msg_length_compressed, data.size());
+  Slice entry_batch_slice = data;
+
   // Verify the CRC.
   uint32_t read_crc = crc::Crc32c(entry_batch_slice.data(), entry_batch_slice.size());
   if (PREDICT_FALSE(read_crc != header.msg_crc)) {
     return Status::Corruption(Substitute("Entry CRC mismatch in byte range $0-$1: "
                                          "expected CRC=$2, computed=$3",
-                                         *offset, *offset + header.msg_length,
+                                         offset, offset + header.msg_length,
                                          header.msg_crc, read_crc));
   }
 
   // If it was compressed, decompress it.
   if (codec_) {
-    // We pre-reserved space for the decompression up above.
-    uint8_t* uncompress_buf = &(*tmp_buf)[header.msg_length_compressed];
+    DCHECK(uncompress_buf);
     RETURN_NOT_OK_PREPEND(codec_->Uncompress(entry_batch_slice, uncompress_buf, header.msg_length),
                           "failed to uncompress entry");
     entry_batch_slice = Slice(uncompress_buf, header.msg_length);
   }
 
   gscoped_ptr<LogEntryBatchPB> read_entry_batch(new LogEntryBatchPB());
-  s = pb_util::ParseFromArray(read_entry_batch.get(),
-                              entry_batch_slice.data(),
-                              header.msg_length);
+  Status s = pb_util::ParseFromArray(read_entry_batch.get(),
+                                     entry_batch_slice.data(),
+                                     header.msg_length);
 
   if (!s.ok()) {
     return Status::Corruption(Substitute("Could not parse PB. Cause: $0", s.ToString()));
   }
 
-  *offset += header.msg_length_compressed;
   entry_batch->reset(read_entry_batch.release());
   return Status::OK();
 }
 
+Status LogSegmentReadahead::Read(ReadableLogSegment* segment,
+                                 int64_t offset,
+                                 int64_t length,
+                                 int64_t readahead_bytes,
+                                 Slice* result) {
+  const int64_t seqno = segment->header().sequence_number();
+  if (seqno == segment_seqno_ &&
+      offset >= offset_ &&
+      offset + length <= offset_ + static_cast<int64_t>(data_.size())) {
+    *result = Slice(data_.data() + (offset - offset_), length);
+    return Status::OK();
+  }
+
+  int64_t limit = segment->readable_up_to();
+  if (PREDICT_FALSE(offset + length > limit)) {
+    // The log was likely truncated during writing.
+    return Status::Corruption(
+        Substitute("Could not read $0 bytes from offset $1 in $2: "
+                   "log only readable up to offset $3",
+                   length, offset, segment->path(), limit));
+  }
+  int64_t to_read = std::min(std::max(length, readahead_bytes), limit - offset);
+  segment_seqno_ = -1;
+  data_.resize(to_read);
+  Status s = segment->readable_file()->Read(offset, Slice(data_.data(), to_read));
+  if (PREDICT_FALSE(!s.ok())) {
+    return Status::IOError(Substitute("Could not read log segment. Cause: $0", s.ToString()));
+  }
+  segment_seqno_ = seqno;
+  offset_ = offset;
+  bytes_read_ += to_read;
+  *result = Slice(data_.data(), length);
+  return Status::OK();
+}
+
 WritableLogSegment::WritableLogSegment(string path,
                                        shared_ptr<WritableFile> writable_file)
     : path_(std::move(path)),
@@ -830,39 +931,51 @@ Status WritableLogSegment::WriteFooterAndClose(const LogSegmentFooterPB& footer)
   return Status::OK();
 }
 
-Status WritableLogSegment::WriteEntryBatch(const Slice& data,
-                                           const CompressionCodec* codec) {
-  DCHECK(is_header_written_);
-  DCHECK(!is_footer_written_);
-  uint8_t header_buf[kEntryHeaderSizeV2];
+Status WritableLogSegment::SyncWith(LogSyncer* syncer) {
+  return syncer->Sync(writable_file_.get());
+}
 
+Status WritableLogSegment::PrepareEntryBatch(const Slice& data,
+                                             const CompressionCodec* codec,
+                                             PreparedEntryBatch* prepared) {
   const uint32_t uncompressed_len = data.size();
 
   // If necessary, compress the data.
-  Slice data_to_write;
+  prepared->compressed = codec != nullptr;
   if (codec) {
-    DCHECK_NE(header_.compression_codec(), NO_COMPRESSION);
-    compress_buf_.resize(codec->MaxCompressedLength(uncompressed_len));
+    faststring* buf = &prepared->compress_buf;
+    buf->resize(codec->MaxCompressedLength(uncompressed_len));
     size_t compressed_len;
-    RETURN_NOT_OK(codec->Compress(data, &compress_buf_[0], &compressed_len));
-    compress_buf_.resize(compressed_len);
-    data_to_write = Slice(compress_buf_.data(), compress_buf_.size());
+    RETURN_NOT_OK(codec->Compress(data, buf->data(), &compressed_len));
+    buf->resize(compressed_len);
+    prepared->data = Slice(*buf);
   } else {
-    data_to_write = data;
+    prepared->data = data;
   }
 
   // Fill in the header.
+  const Slice& data_to_write = prepared->data;
+  prepared->header.resize(kEntryHeaderSizeV2);
+  uint8_t* header_buf = prepared->header.data();
   InlineEncodeFixed32(&header_buf[0], data_to_write.size());
   InlineEncodeFixed32(&header_buf[4], uncompressed_len);
   InlineEncodeFixed32(&header_buf[8], crc::Crc32c(data_to_write.data(), data_to_write.size()));
   InlineEncodeFixed32(&header_buf[12], crc::Crc32c(&header_buf[0], kEntryHeaderSizeV2 - 4));
+  return Status::OK();
+}
+
+Status WritableLogSegment::WritePreparedEntryBatch(const PreparedEntryBatch& prepared) {
+  DCHECK(is_header_written_);
+  DCHECK(!is_footer_written_);
+  DCHECK_EQ(prepared.compressed, header_.compression_codec() != NO_COMPRESSION);
+  DCHECK_EQ(kEntryHeaderSizeV2, prepared.header.size());
 
   // Write the header to the file, followed by the batch data itself.
   Slice slices[2] = {
-    Slice(header_buf, arraysize(header_buf)),
-    data_to_write };
+    Slice(prepared.header),
+    prepared.data };
   RETURN_NOT_OK(writable_file_->AppendV(slices));
-  written_offset_ += arraysize(header_buf) + data_to_write.size();
+  written_offset_ += prepared.header.size() + prepared.data.size();
   return Status::OK();
 }
 
@@ -54,6 +54,8 @@ namespace log {
 // implementation for details.
 extern const size_t kEntryHeaderSizeV2;
 
+class LogSegmentReadahead;
+class LogSyncer;
 class ReadableLogSegment;
 
 // Options for the State Machine/Write Ahead Log
@@ -66,6 +68,11 @@ struct LogOptions {
   // Whether to call fsync on every call to Append().
   bool force_fsync_all;
 
+  // Whether to group the fsyncs of this log with those of the logs of other
+  // tablets in the same WAL directory. Only relevant if 'force_fsync_all' is
+  // set.
+  bool group_sync_across_tablets;
+
   // Whether to fallocate segments before writing to them.
   bool preallocate_segments;
 
@@ -340,6 +347,15 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
                                  gscoped_ptr<LogEntryBatchPB>* batch,
                                  EntryHeaderStatus* status_detail);
 
+  // Like ReadEntryHeaderAndBatch(), but reads the entry through 'readahead',
+  // which reads at least 'readahead_bytes' of the segment at a time. Reading
+  // consecutive entries this way takes a single IO for many of them.
+  Status ReadEntryHeaderAndBatch(int64_t* offset,
+                                 int64_t readahead_bytes,
+                                 LogSegmentReadahead* readahead,
+                                 faststring* tmp_buf,
+                                 gscoped_ptr<LogEntryBatchPB>* batch);
+
   // Reads a log entry header from the segment.
   //
   // Also increments the passed offset* by the length of the entry on successful
@@ -362,6 +378,15 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
                         faststring* tmp_buf,
                         gscoped_ptr<LogEntryBatchPB>* entry_batch);
 
+  // Verifies the checksum of 'data', the batch found at 'offset' with the
+  // given header, then decodes it into 'entry_batch'. If the segment is
+  // compressed, 'uncompress_buf' must have room for 'header.msg_length' bytes.
+  Status DecodeEntryBatch(int64_t offset,
+                          const EntryHeader& header,
+                          const Slice& data,
+                          uint8_t* uncompress_buf,
+                          gscoped_ptr<LogEntryBatchPB>* entry_batch);
+
   void UpdateReadableToOffset(int64_t readable_to_offset);
 
   const std::string path_;
@@ -401,6 +426,66 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
   DISALLOW_COPY_AND_ASSIGN(ReadableLogSegment);
 };
 
+// A window of the contents of a log segment, read ahead of the entries being
+// decoded so that consecutive entries don't each require their own IO.
+//
+// Since the written part of a segment never changes, a window remains valid
+// for as long as its segment exists.
+class LogSegmentReadahead {
+ public:
+  LogSegmentReadahead()
+      : segment_seqno_(-1),
+        offset_(0) {
+  }
+
+  // Sets 'result' to the 'length' bytes found at 'offset' in 'segment'. If
+  // they aren't in the window, replaces the window with the at least
+  // 'readahead_bytes' of the segment which start at 'offset'.
+  //
+  // 'result' remains valid until the next call.
+  Status Read(ReadableLogSegment* segment, int64_t offset, int64_t length,
+              int64_t readahead_bytes, Slice* result);
+
+  // Returns the number of bytes read from segments into windows so far.
+  int64_t bytes_read() const {
+    return bytes_read_;
+  }
+
+ private:
+  // The sequence number of the segment the window belongs to, or -1 if the
+  // window is empty.
+  int64_t segment_seqno_;
+
+  // The offset of the window in its segment.
+  int64_t offset_;
+
+  faststring data_;
+
+  int64_t bytes_read_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(LogSegmentReadahead);
+};
+
+// A serialized batch of log entries which has been compressed and checksummed,
+// and is ready to be appended to a WritableLogSegment. See
+// WritableLogSegment::PrepareEntryBatch().
+struct PreparedEntryBatch {
+  PreparedEntryBatch() : compressed(false) {}
+
+  // The entry header.
+  faststring header;
+
+  // Whether 'data' was compressed.
+  bool compressed;
+
+  // The data to write after the header. Points either to 'compress_buf' or to
+  // the uncompressed data which was prepared.
+  Slice data;
+
+  // Buffer holding the compressed data, if compressed.
+  faststring compress_buf;
+};
+
 // A writable log segment where state data is stored.
 class WritableLogSegment {
  public:
@@ -422,17 +507,30 @@ class WritableLogSegment {
     return writable_file_->Size();
   }
 
-  // Appends the provided batch of data, including a header
-  // and checksum. If 'codec' is not NULL, compresses the batch.
+  // Prepares the provided batch of data to be appended to a segment:
+  // computes its header and checksum and, if 'codec' is not NULL, compresses
+  // it. 'data' must outlive 'prepared'.
+  //
+  // This does not depend on the state of any segment, so may be called
+  // concurrently from any thread, ahead of the write.
+  static Status PrepareEntryBatch(const Slice& data,
+                                  const CompressionCodec* codec,
+                                  PreparedEntryBatch* prepared);
+
+  // Appends a batch of data prepared by PrepareEntryBatch(), using the codec
+  // specified in this segment's header.
   // Makes sure that the log segment has not been closed.
-  // Write a compressed entry to the log.
-  Status WriteEntryBatch(const Slice& data, const CompressionCodec* codec);
+  Status WritePreparedEntryBatch(const PreparedEntryBatch& prepared);
 
   // Makes sure the I/O buffers in the underlying writable file are flushed.
   Status Sync() {
     return writable_file_->Sync();
   }
 
+  // Like Sync(), but the sync is grouped with those of other segments sharing
+  // 'syncer'.
+  Status SyncWith(LogSyncer* syncer);
+
   // Returns true if the segment header has already been written to disk.
   bool IsHeaderWritten() const {
     return is_header_written_;
@@ -491,9 +589,6 @@ class WritableLogSegment {
   // The offset where the last written entry ends.
   int64_t written_offset_;
 
-  // Buffer used for output when compressing.
-  faststring compress_buf_;
-
   DISALLOW_COPY_AND_ASSIGN(WritableLogSegment);
 };
 
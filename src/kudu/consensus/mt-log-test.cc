@@ -68,6 +68,11 @@ DEFINE_bool(verify_log, true, "Whether to verify the log by reading it after the
 
 DECLARE_int32(log_thread_idle_threshold_ms);
 DECLARE_int32(log_inject_thread_lifecycle_latency_ms);
+DECLARE_bool(log_inject_latency);
+DECLARE_int32(log_inject_latency_ms_mean);
+DECLARE_int32(log_inject_latency_ms_stddev);
+
+METRIC_DECLARE_histogram(log_prepare_stall_latency);
 
 namespace kudu {
 namespace log {
@@ -244,6 +249,25 @@ TEST_F(MultiThreadedLogTest, TestAppends) {
   }
 }
 
+// Test that, with slow syncs, the next group of entries is prepared while the
+// previous one is synced, and that the entries are appended correctly.
+TEST_F(MultiThreadedLogTest, TestPrepareNextGroupDuringSync) {
+  if (google::GetCommandLineFlagInfoOrDie("num_batches_per_thread").is_default) {
+    FLAGS_num_batches_per_thread = 200;
+  }
+  FLAGS_log_inject_latency = true;
+  FLAGS_log_inject_latency_ms_mean = 1;
+  FLAGS_log_inject_latency_ms_stddev = 0;
+  ASSERT_OK(BuildLog());
+  ASSERT_NO_FATAL_FAILURE(Run());
+  ASSERT_OK(log_->Close());
+  ASSERT_NO_FATAL_FAILURE(VerifyLog());
+
+  scoped_refptr<Histogram> stalls =
+      METRIC_log_prepare_stall_latency.Instantiate(metric_entity_);
+  ASSERT_GT(stalls->TotalCount(), 0);
+}
+
 // The lifecycle of the appender task starting and stopping is a bit complicated
 // (see Log::AppendThread::GoIdle for details). This injects some latency in key
 // points of that lifecycle to ensure that the different potential interleavings
@@ -0,0 +1,301 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/consensus/multi_raft_batcher.h"
+
+#include <cstddef>
+#include <ostream>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/common/wire_protocol.h"
+#include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/consensus.proxy.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/periodic.h"
+#include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/net/net_util.h"
+#include "kudu/util/net/sockaddr.h"
+
+DEFINE_bool(enable_multi_raft_heartbeat_batcher, false,
+            "Whether to batch the heartbeats sent by the leader replicas of a server "
+            "to the replicas hosted by another server into a single RPC, rather than "
+            "sending one RPC per tablet.");
+TAG_FLAG(enable_multi_raft_heartbeat_batcher, experimental);
+
+DEFINE_int32(multi_raft_heartbeat_window_ms, 100,
+             "How often batched heartbeats are sent to each server, when "
+             "--enable_multi_raft_heartbeat_batcher is set. Heartbeats may be delayed "
+             "by up to this long, which should remain well below "
+             "--raft_heartbeat_interval_ms.");
+TAG_FLAG(multi_raft_heartbeat_window_ms, experimental);
+
+DEFINE_int32(multi_raft_batch_size, 256,
+             "The maximum number of heartbeats sent in a single batch. Batches reaching "
+             "this size are sent right away.");
+TAG_FLAG(multi_raft_batch_size, experimental);
+TAG_FLAG(multi_raft_batch_size, runtime);
+
+DECLARE_int32(consensus_rpc_timeout_ms);
+
+METRIC_DEFINE_counter(server, raft_heartbeats_batched,
+                      "Raft Heartbeats Batched",
+                      kudu::MetricUnit::kRequests,
+                      "Number of Raft heartbeats sent to other servers as part of "
+                      "MultiRaftUpdateConsensus batches");
+
+using kudu::rpc::Messenger;
+using kudu::rpc::PeriodicTimer;
+using kudu::rpc::RpcController;
+using kudu::tserver::TabletServerErrorPB;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using std::weak_ptr;
+using strings::Substitute;
+
+namespace kudu {
+namespace consensus {
+
+struct MultiRaftHeartbeatBatcher::Batch {
+  MultiRaftConsensusRequestPB request;
+  MultiRaftConsensusResponsePB response;
+  RpcController controller;
+  vector<QueuedHeartbeat> heartbeats;
+};
+
+MultiRaftHeartbeatBatcher::MultiRaftHeartbeatBatcher(string dest,
+                                                     unique_ptr<ConsensusServiceProxy> proxy,
+                                                     shared_ptr<Messenger> messenger,
+                                                     scoped_refptr<Counter> heartbeats_batched)
+    : dest_(std::move(dest)),
+      proxy_(std::move(proxy)),
+      messenger_(std::move(messenger)),
+      heartbeats_batched_(std::move(heartbeats_batched)),
+      supported_(true),
+      shutdown_(false) {
+}
+
+MultiRaftHeartbeatBatcher::~MultiRaftHeartbeatBatcher() {
+  if (flush_timer_) {
+    flush_timer_->Stop();
+  }
+}
+
+void MultiRaftHeartbeatBatcher::Start() {
+  // Capture a weak_ptr reference into the functor so it can safely handle
+  // outliving the batcher.
+  weak_ptr<MultiRaftHeartbeatBatcher> w = shared_from_this();
+  flush_timer_ = PeriodicTimer::Create(
+      messenger_,
+      [w]() {
+        if (auto b = w.lock()) {
+          b->FlushBatch();
+        }
+      },
+      MonoDelta::FromMilliseconds(FLAGS_multi_raft_heartbeat_window_ms));
+  flush_timer_->Start();
+}
+
+void MultiRaftHeartbeatBatcher::Shutdown() {
+  if (flush_timer_) {
+    flush_timer_->Stop();
+  }
+  // The callbacks of the dropped heartbeats may hold the last references to
+  // their peers: destroy them outside of the lock.
+  vector<QueuedHeartbeat> dropped;
+  std::lock_guard<simple_spinlock> l(lock_);
+  shutdown_ = true;
+  dropped.swap(queued_);
+}
+
+void MultiRaftHeartbeatBatcher::AddRequestToBatch(const ConsensusRequestPB* request,
+                                                  ConsensusResponsePB* response,
+                                                  RpcController* controller,
+                                                  rpc::ResponseCallback callback) {
+  DCHECK_EQ(0, request->ops_size());
+  vector<QueuedHeartbeat> heartbeats;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    if (PREDICT_TRUE(supported_ && !shutdown_)) {
+      queued_.push_back({ request, response, controller, std::move(callback) });
+      if (queued_.size() < static_cast<size_t>(FLAGS_multi_raft_batch_size)) {
+        return;
+      }
+      heartbeats.swap(queued_);
+    }
+  }
+  if (heartbeats.empty()) {
+    heartbeats.push_back({ request, response, controller, std::move(callback) });
+    SendIndividually(&heartbeats);
+    return;
+  }
+  SendBatch(std::move(heartbeats));
+}
+
+void MultiRaftHeartbeatBatcher::FlushBatch() {
+  vector<QueuedHeartbeat> heartbeats;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    heartbeats.swap(queued_);
+  }
+  if (!heartbeats.empty()) {
+    SendBatch(std::move(heartbeats));
+  }
+}
+
+void MultiRaftHeartbeatBatcher::SendBatch(vector<QueuedHeartbeat> heartbeats) {
+  unique_ptr<Batch> batch(new Batch);
+  batch->request.mutable_heartbeats()->Reserve(heartbeats.size());
+  for (const auto& hb : heartbeats) {
+    *batch->request.add_heartbeats() = *hb.request;
+  }
+  batch->heartbeats = std::move(heartbeats);
+  batch->controller.set_timeout(MonoDelta::FromMilliseconds(FLAGS_consensus_rpc_timeout_ms));
+  batch->controller.RequireServerFeature(ConsensusFeatures::MULTI_RAFT_HEARTBEATS);
+
+  // The batch is owned by the callback, which frees it. Capture a shared_ptr
+  // reference so that the batcher outlives the RPC.
+  Batch* raw_batch = batch.release();
+  shared_ptr<MultiRaftHeartbeatBatcher> s_this = shared_from_this();
+  proxy_->MultiRaftUpdateConsensusAsync(
+      raw_batch->request, &raw_batch->response, &raw_batch->controller,
+      [s_this, raw_batch]() {
+        s_this->BatchResponseCallback(unique_ptr<Batch>(raw_batch));
+      });
+}
+
+void MultiRaftHeartbeatBatcher::BatchResponseCallback(unique_ptr<Batch> batch) {
+  const RpcController& controller = batch->controller;
+  const Status& s = controller.status();
+  if (PREDICT_FALSE(!s.ok())) {
+    if (s.IsRemoteError() && controller.error_response() &&
+        controller.error_response()->unsupported_feature_flags_size() > 0) {
+      // The heartbeats were rejected right away: they're still fresh.
+      LOG(INFO) << "Server " << dest_ << " does not support batched heartbeats; "
+                << "sending them individually";
+      {
+        std::lock_guard<simple_spinlock> l(lock_);
+        supported_ = false;
+      }
+      SendIndividually(&batch->heartbeats);
+      return;
+    }
+    // By now the heartbeats are stale: rather than resending them, report the
+    // failure to each of their peers, as if it had sent its heartbeat on its
+    // own, and let them retry.
+    VLOG(1) << "Unable to send a batch of " << batch->heartbeats.size()
+            << " heartbeats to " << dest_ << ": " << s.ToString();
+    for (QueuedHeartbeat& hb : batch->heartbeats) {
+      hb.controller->ShareFinishedCall(controller);
+      hb.callback();
+    }
+    return;
+  }
+  if (PREDICT_FALSE(batch->response.responses_size() !=
+                    static_cast<int>(batch->heartbeats.size()))) {
+    Status bad_response = Status::Corruption(Substitute(
+        "batch of $0 heartbeats got $1 responses", batch->heartbeats.size(),
+        batch->response.responses_size()));
+    LOG(WARNING) << "Invalid response from " << dest_ << ": " << bad_response.ToString();
+    for (QueuedHeartbeat& hb : batch->heartbeats) {
+      hb.response->Clear();
+      StatusToPB(bad_response, hb.response->mutable_error()->mutable_status());
+      hb.response->mutable_error()->set_code(TabletServerErrorPB::UNKNOWN_ERROR);
+      hb.callback();
+    }
+    return;
+  }
+
+  if (heartbeats_batched_) {
+    heartbeats_batched_->IncrementBy(batch->heartbeats.size());
+  }
+  for (int i = 0; i < batch->response.responses_size(); i++) {
+    QueuedHeartbeat& hb = batch->heartbeats[i];
+    hb.response->Swap(batch->response.mutable_responses(i));
+    hb.callback();
+  }
+}
+
+void MultiRaftHeartbeatBatcher::SendIndividually(vector<QueuedHeartbeat>* heartbeats) {
+  for (QueuedHeartbeat& hb : *heartbeats) {
+    hb.controller->set_timeout(MonoDelta::FromMilliseconds(FLAGS_consensus_rpc_timeout_ms));
+    proxy_->UpdateConsensusAsync(*hb.request, hb.response, hb.controller, hb.callback);
+  }
+}
+
+MultiRaftManager::MultiRaftManager(shared_ptr<Messenger> messenger,
+                                   const scoped_refptr<MetricEntity>& entity)
+    : messenger_(std::move(messenger)),
+      shutdown_(false) {
+  if (entity) {
+    heartbeats_batched_ = METRIC_raft_heartbeats_batched.Instantiate(entity);
+  }
+}
+
+MultiRaftManager::~MultiRaftManager() {
+  Shutdown();
+}
+
+Status MultiRaftManager::GetOrCreateBatcher(const HostPort& hostport,
+                                            shared_ptr<MultiRaftHeartbeatBatcher>* batcher) {
+  const string key = hostport.ToString();
+  std::lock_guard<std::mutex> l(lock_);
+  if (PREDICT_FALSE(shutdown_)) {
+    return Status::IllegalState("Multi-Raft manager is shut down");
+  }
+  const auto* existing = FindOrNull(batchers_, key);
+  if (existing) {
+    *batcher = *existing;
+    return Status::OK();
+  }
+
+  vector<Sockaddr> addrs;
+  RETURN_NOT_OK(hostport.ResolveAddresses(&addrs));
+  unique_ptr<ConsensusServiceProxy> proxy(
+      new ConsensusServiceProxy(messenger_, addrs[0], hostport.host()));
+  auto new_batcher = std::make_shared<MultiRaftHeartbeatBatcher>(
+      key, std::move(proxy), messenger_, heartbeats_batched_);
+  new_batcher->Start();
+  InsertOrDie(&batchers_, key, new_batcher);
+  *batcher = std::move(new_batcher);
+  return Status::OK();
+}
+
+void MultiRaftManager::Shutdown() {
+  std::unordered_map<string, shared_ptr<MultiRaftHeartbeatBatcher>> batchers;
+  {
+    std::lock_guard<std::mutex> l(lock_);
+    shutdown_ = true;
+    batchers.swap(batchers_);
+  }
+  for (const auto& e : batchers) {
+    e.second->Shutdown();
+  }
+}
+
+} // namespace consensus
+} // namespace kudu
@@ -0,0 +1,165 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/rpc/response_callback.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class HostPort;
+
+namespace rpc {
+class Messenger;
+class PeriodicTimer;
+class RpcController;
+} // namespace rpc
+
+namespace consensus {
+
+class ConsensusRequestPB;
+class ConsensusResponsePB;
+class ConsensusServiceProxy;
+
+// Batches the heartbeats sent by the leader replicas of a server to the
+// replicas hosted by another server, so that they are sent as one
+// MultiRaftUpdateConsensus RPC every --multi_raft_heartbeat_window_ms rather
+// than as one UpdateConsensus RPC per tablet. Requests carrying operations
+// are not batched: they are sent right away by their peers.
+//
+// If the batch RPC fails, its failure is reported to the peer of each of its
+// heartbeats the same way as if the heartbeat had been sent on its own; the
+// stale heartbeats aren't resent. If the destination server doesn't support
+// batches, the heartbeats are sent on their own instead.
+//
+// This class is thread-safe.
+class MultiRaftHeartbeatBatcher : public std::enable_shared_from_this<MultiRaftHeartbeatBatcher> {
+ public:
+  MultiRaftHeartbeatBatcher(std::string dest,
+                            std::unique_ptr<ConsensusServiceProxy> proxy,
+                            std::shared_ptr<rpc::Messenger> messenger,
+                            scoped_refptr<Counter> heartbeats_batched);
+  ~MultiRaftHeartbeatBatcher();
+
+  // Starts flushing batches periodically.
+  void Start();
+
+  // Stops flushing batches, dropping the heartbeats which are still queued.
+  void Shutdown();
+
+  // Queues the heartbeat 'request' for the next batch. Once the response to
+  // the batch arrives, it fills in 'response' and runs 'callback', as
+  // ConsensusServiceProxy::UpdateConsensusAsync() would. 'controller' is only
+  // used if the heartbeat ends up being sent on its own.
+  //
+  // 'request', 'response' and 'controller' must remain valid until 'callback'
+  // runs.
+  void AddRequestToBatch(const ConsensusRequestPB* request,
+                         ConsensusResponsePB* response,
+                         rpc::RpcController* controller,
+                         rpc::ResponseCallback callback);
+
+ private:
+  struct QueuedHeartbeat {
+    const ConsensusRequestPB* request;
+    ConsensusResponsePB* response;
+    rpc::RpcController* controller;
+    rpc::ResponseCallback callback;
+  };
+  struct Batch;
+
+  // Sends the queued heartbeats, if any, as one batch.
+  void FlushBatch();
+
+  // Sends 'heartbeats' with one MultiRaftUpdateConsensus RPC.
+  void SendBatch(std::vector<QueuedHeartbeat> heartbeats);
+
+  // Hands the responses to 'batch' over to its heartbeats.
+  void BatchResponseCallback(std::unique_ptr<Batch> batch);
+
+  // Sends each of 'heartbeats' with its own UpdateConsensus RPC.
+  void SendIndividually(std::vector<QueuedHeartbeat>* heartbeats);
+
+  // The destination server's host/port, for logging.
+  const std::string dest_;
+
+  const std::unique_ptr<ConsensusServiceProxy> proxy_;
+  const std::shared_ptr<rpc::Messenger> messenger_;
+  const scoped_refptr<Counter> heartbeats_batched_;
+
+  std::shared_ptr<rpc::PeriodicTimer> flush_timer_;
+
+  // Protects the members below.
+  simple_spinlock lock_;
+
+  // The heartbeats to send with the next batch.
+  std::vector<QueuedHeartbeat> queued_;
+
+  // Whether the destination server implements MultiRaftUpdateConsensus. Once
+  // it's found not to, heartbeats are no longer batched.
+  bool supported_;
+
+  bool shutdown_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiRaftHeartbeatBatcher);
+};
+
+// Hands out the heartbeat batcher of each destination server. One instance is
+// shared by all the tablet replicas of a server.
+//
+// This class is thread-safe.
+class MultiRaftManager {
+ public:
+  MultiRaftManager(std::shared_ptr<rpc::Messenger> messenger,
+                   const scoped_refptr<MetricEntity>& entity);
+  ~MultiRaftManager();
+
+  // Sets '*batcher' to the batcher of heartbeats sent to 'hostport', creating
+  // it if necessary.
+  Status GetOrCreateBatcher(const HostPort& hostport,
+                            std::shared_ptr<MultiRaftHeartbeatBatcher>* batcher);
+
+  // Shuts down all the batchers.
+  void Shutdown();
+
+ private:
+  const std::shared_ptr<rpc::Messenger> messenger_;
+  scoped_refptr<Counter> heartbeats_batched_;
+
+  std::mutex lock_;
+
+  // Batchers keyed by the string form of their destination's host/port.
+  std::unordered_map<std::string, std::shared_ptr<MultiRaftHeartbeatBatcher>> batchers_;
+
+  bool shutdown_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiRaftManager);
+};
+
+} // namespace consensus
+} // namespace kudu
@@ -49,6 +49,7 @@ namespace consensus {
 PendingRounds::PendingRounds(string log_prefix, scoped_refptr<TimeManager> time_manager)
     : log_prefix_(std::move(log_prefix)),
       last_committed_op_id_(MinimumOpId()),
+      last_committed_op_timestamp_(Timestamp::kMin),
       time_manager_(std::move(time_manager)) {}
 
 PendingRounds::~PendingRounds() {
@@ -181,6 +182,9 @@ Status PendingRounds::AdvanceCommittedIndex(int64_t committed_index) {
 
     pending_txns_.erase(iter++);
     last_committed_op_id_ = round->id();
+    if (round->replicate_msg()->has_timestamp()) {
+      last_committed_op_timestamp_ = Timestamp(round->replicate_msg()->timestamp());
+    }
     time_manager_->AdvanceSafeTimeWithMessage(*round->replicate_msg());
     round->NotifyReplicationFinished(Status::OK());
   }
@@ -232,6 +236,10 @@ int64_t PendingRounds::GetTermWithLastCommittedOp() const {
   return last_committed_op_id_.term();
 }
 
+Timestamp PendingRounds::GetLastCommittedOpTimestamp() const {
+  return last_committed_op_timestamp_;
+}
+
 int PendingRounds::GetNumPendingTxns() const {
   return pending_txns_.size();
 }
@@ -21,6 +21,7 @@
 #include <map>
 #include <string>
 
+#include "kudu/common/timestamp.h"
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
@@ -91,6 +92,11 @@ class PendingRounds {
   int64_t GetCommittedIndex() const;
   int64_t GetTermWithLastCommittedOp() const;
 
+  // Returns the timestamp of the last operation committed since startup, or
+  // Timestamp::kMin if none has been. Operations committed before startup
+  // were applied during bootstrap.
+  Timestamp GetLastCommittedOpTimestamp() const;
+
   // Checks that 'current' correctly follows 'previous'. Specifically it checks
   // that the term is the same or higher and that the index is sequential.
   static Status CheckOpInSequence(const OpId& previous, const OpId& current);
@@ -109,6 +115,9 @@ class PendingRounds {
   // The OpId of the round that was last committed. Initialized to MinimumOpId().
   OpId last_committed_op_id_;
 
+  // The timestamp of the round that was last committed, if any.
+  Timestamp last_committed_op_timestamp_;
+
   scoped_refptr<TimeManager> time_manager_;
 
   DISALLOW_COPY_AND_ASSIGN(PendingRounds);
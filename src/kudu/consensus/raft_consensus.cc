@@ -129,6 +129,29 @@ DEFINE_bool(raft_prepare_replacement_before_eviction, false,
 TAG_FLAG(raft_prepare_replacement_before_eviction, advanced);
 TAG_FLAG(raft_prepare_replacement_before_eviction, experimental);
 
+DEFINE_bool(raft_enable_leader_leases, false,
+            "Whether a leader holds a lease while a majority of the voters "
+            "have recently accepted its requests, during which no other replica "
+            "can be elected. A leader then only serves scans of the latest data "
+            "while it holds a lease, once the operations committed before the "
+            "scan started have been applied. With leases enabled, replicas "
+            "withhold their votes for the minimum election timeout after "
+            "starting up or hearing from a leader, even from candidates of "
+            "forced elections.");
+TAG_FLAG(raft_enable_leader_leases, experimental);
+
+DEFINE_int32(raft_leader_lease_max_clock_drift_ppm, 1000,
+             "Upper bound, in parts per million, on the rate at which the local "
+             "clocks of any two replicas may drift apart. Leader leases are "
+             "shortened by this fraction, so that a leader's lease runs out "
+             "before the voters which granted it, each measuring time with its "
+             "own clock, may vote for another candidate. The default allows for "
+             "each clock to be off by the 500 ppm that NTP tolerates.");
+TAG_FLAG(raft_leader_lease_max_clock_drift_ppm, advanced);
+TAG_FLAG(raft_leader_lease_max_clock_drift_ppm, experimental);
+DEFINE_validator(raft_leader_lease_max_clock_drift_ppm,
+                 [](const char* /*n*/, int32_t v) { return v >= 0 && v < 1000000; });
+
 DECLARE_int32(memory_limit_warn_threshold_percentage);
 
 // Metrics
@@ -143,6 +166,11 @@ METRIC_DEFINE_gauge_int64(tablet, raft_term,
                           kudu::MetricUnit::kUnits,
                           "Current Term of the Raft Consensus algorithm. This number increments "
                           "each time a leader election is started.");
+METRIC_DEFINE_gauge_bool(tablet, raft_leader_lease_held,
+                         "Raft Leader Lease Held",
+                         kudu::MetricUnit::kState,
+                         "Whether this replica is the leader and holds a leader lease. "
+                         "Always false unless leader leases are enabled.");
 
 using boost::optional;
 using google::protobuf::util::MessageDifferencer;
@@ -330,9 +358,20 @@ Status RaftConsensus::Start(const ConsensusBootstrapInfo& info,
     // Now assume non-leader replica duties.
     RETURN_NOT_OK(BecomeReplicaUnlocked(fd_initial_delta));
 
+    // Before going down, this replica may have accepted a request from a
+    // leader which now counts on it for its lease: don't help elect anyone
+    // else until that lease has run out.
+    if (FLAGS_raft_enable_leader_leases && CurrentTermUnlocked() > 0) {
+      withhold_votes_until_ = MonoTime::Now() + MinimumElectionTimeout();
+    }
+
     SetStateUnlocked(kRunning);
   }
 
+  METRIC_raft_leader_lease_held.InstantiateFunctionGauge(
+      metric_entity, Bind(&RaftConsensus::HasLeaderLease, Unretained(this)))
+      ->AutoDetach(&metric_detacher_);
+
   if (IsSingleVoterConfig() && FLAGS_enable_leader_failure_detection) {
     LOG_WITH_PREFIX(INFO) << "Only one voter in the Raft config. Triggering election immediately";
     RETURN_NOT_OK(StartElection(NORMAL_ELECTION, INITIAL_SINGLE_NODE_ELECTION));
@@ -866,6 +905,17 @@ void RaftConsensus::TryPromoteNonVoterTask(const std::string& peer_uuid,
 
 Status RaftConsensus::Update(const ConsensusRequestPB* request,
                              ConsensusResponsePB* response) {
+  return DoUpdate(request, response, /*wait_for_update_lock=*/ true);
+}
+
+Status RaftConsensus::TryUpdate(const ConsensusRequestPB* request,
+                                ConsensusResponsePB* response) {
+  return DoUpdate(request, response, /*wait_for_update_lock=*/ false);
+}
+
+Status RaftConsensus::DoUpdate(const ConsensusRequestPB* request,
+                               ConsensusResponsePB* response,
+                               bool wait_for_update_lock) {
   update_calls_for_tests_.Increment();
 
   if (PREDICT_FALSE(FLAGS_follower_reject_update_consensus_requests)) {
@@ -873,12 +923,16 @@ Status RaftConsensus::Update(const ConsensusRequestPB* request,
                                 "is set to true.");
   }
 
-  response->set_responder_uuid(peer_uuid());
-
   VLOG_WITH_PREFIX(2) << "Replica received request: " << SecureShortDebugString(*request);
 
   // see var declaration
-  std::lock_guard<simple_spinlock> lock(update_lock_);
+  std::unique_lock<simple_spinlock> lock(update_lock_, std::defer_lock);
+  if (wait_for_update_lock) {
+    lock.lock();
+  } else if (!lock.try_lock()) {
+    return Status::ServiceUnavailable("replica is busy handling another update");
+  }
+  response->set_responder_uuid(peer_uuid());
   Status s = UpdateReplica(request, response);
   if (PREDICT_FALSE(VLOG_IS_ON(1))) {
     if (request->ops().empty()) {
@@ -1581,7 +1635,11 @@ Status RaftConsensus::RequestVote(const VoteRequestPB* request,
   //
   // See also https://ramcloud.stanford.edu/~ongaro/thesis.pdf
   // section 4.2.3.
-  if (!request->ignore_live_leader() && MonoTime::Now() < withhold_votes_until_) {
+  //
+  // With leader leases, even forced elections must wait for the leader's lease
+  // to run out.
+  if ((!request->ignore_live_leader() || FLAGS_raft_enable_leader_leases) &&
+      MonoTime::Now() < withhold_votes_until_) {
     return RequestVoteRespondLeaderIsAlive(request, response);
   }
 
@@ -2706,6 +2764,59 @@ MonoDelta RaftConsensus::MinimumElectionTimeout() const {
   return MonoDelta::FromMilliseconds(failure_timeout);
 }
 
+MonoDelta RaftConsensus::LeaderLeaseDuration() const {
+  int64_t timeout_nanos = MinimumElectionTimeout().ToNanoseconds();
+  return MonoDelta::FromNanoseconds(
+      timeout_nanos - timeout_nanos / 1000000 * FLAGS_raft_leader_lease_max_clock_drift_ppm);
+}
+
+bool RaftConsensus::HasLeaderLease() const {
+  if (!FLAGS_raft_enable_leader_leases) {
+    return false;
+  }
+  MonoTime lease_start = queue_->LeaderLeaseStart();
+  if (lease_start == MonoTime::Max()) {
+    // This is the only voter.
+    return true;
+  }
+  return lease_start.Initialized() && lease_start != MonoTime::Min() &&
+      MonoTime::Now() < lease_start + LeaderLeaseDuration();
+}
+
+Status RaftConsensus::WaitForLeaderLease(const MonoTime& deadline,
+                                         Timestamp* committed_timestamp) {
+  if (!FLAGS_raft_enable_leader_leases) {
+    return Status::NotSupported("leader leases are not enabled");
+  }
+  // A lease is normally obtained within a heartbeat: poll a few times per
+  // heartbeat interval.
+  int backoff_ms = 1;
+  const int max_backoff_ms = std::max(1, FLAGS_raft_heartbeat_interval_ms / 4);
+  while (true) {
+    // Read the commit state before checking the lease: if the lease still
+    // holds afterwards, no other leader can have committed anything since.
+    Timestamp ts;
+    {
+      ThreadRestrictions::AssertWaitAllowed();
+      LockGuard l(lock_);
+      if (cmeta_->active_role() != RaftPeerPB::LEADER) {
+        return Status::IllegalState("replica is not the leader");
+      }
+      ts = pending_->GetLastCommittedOpTimestamp();
+    }
+    if (HasLeaderLease()) {
+      *committed_timestamp = ts;
+      return Status::OK();
+    }
+    MonoTime now = MonoTime::Now();
+    if (now >= deadline) {
+      return Status::TimedOut("timed out waiting for a leader lease");
+    }
+    SleepFor(std::min(MonoDelta::FromMilliseconds(backoff_ms), deadline - now));
+    backoff_ms = std::min(backoff_ms * 2, max_backoff_ms);
+  }
+}
+
 MonoDelta RaftConsensus::LeaderElectionExpBackoffDeltaUnlocked() {
   DCHECK(lock_.is_locked());
   // Compute a backoff factor based on how many leader elections have
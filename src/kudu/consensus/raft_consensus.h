@@ -242,6 +242,14 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
   Status Update(const ConsensusRequestPB* request,
                 ConsensusResponsePB* response);
 
+  // Like Update(), but returns ServiceUnavailable right away, leaving
+  // 'response' untouched, if the replica is busy handling another update
+  // (e.g. one waiting on a slow WAL append). Used for the heartbeats of
+  // MultiRaftUpdateConsensus batches, so that a busy replica doesn't hold up
+  // the heartbeats of the other tablets of the batch.
+  Status TryUpdate(const ConsensusRequestPB* request,
+                   ConsensusResponsePB* response);
+
   // Messages sent from CANDIDATEs to voting peers to request their vote
   // in leader election.
   //
@@ -287,6 +295,25 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
 
   scoped_refptr<TimeManager> time_manager() const { return time_manager_; }
 
+  // Returns true if leader leases are enabled and this replica is the leader
+  // and holds a lease: a majority of the voters accepted its requests
+  // recently enough that they won't vote for any other candidate for now.
+  // While this holds, no other replica can have become leader.
+  //
+  // Requires that Start() has been called.
+  bool HasLeaderLease() const;
+
+  // Waits until this replica holds a leader lease, or until 'deadline'.
+  // On success, sets 'committed_timestamp' to the timestamp of the last
+  // operation committed while the lease was held, or Timestamp::kMin if no
+  // operation has been committed since startup. A read which observes every
+  // operation up to that timestamp observes every write acknowledged before
+  // this call.
+  //
+  // Returns NotSupported if leader leases are disabled, IllegalState if this
+  // replica is not the leader, and TimedOut if no lease was obtained in time.
+  Status WaitForLeaderLease(const MonoTime& deadline, Timestamp* committed_timestamp);
+
   enum IncludeHealthReport {
     EXCLUDE_HEALTH_REPORT,
     INCLUDE_HEALTH_REPORT
@@ -464,6 +491,12 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
   // 'lock_' must be held for configuration change before calling.
   Status BecomeReplicaUnlocked(boost::optional<MonoDelta> fd_delta = boost::none);
 
+  // Implements Update() and TryUpdate(): handles 'request' once the update
+  // lock is acquired, waiting for it only if 'wait_for_update_lock' is true.
+  Status DoUpdate(const ConsensusRequestPB* request,
+                  ConsensusResponsePB* response,
+                  bool wait_for_update_lock);
+
   // Updates the state in a replica by storing the received operations in the log
   // and triggering the required transactions. This method won't return until all
   // operations have been stored in the log and all Prepares() have been completed,
@@ -614,6 +647,11 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
   // jitter, election timeouts may be longer than this.
   MonoDelta MinimumElectionTimeout() const;
 
+  // Returns how long a leader lease lasts after a majority of the voters
+  // accepted a request: the time for which the voters withhold their votes,
+  // shortened by --raft_leader_lease_max_clock_drift_ppm.
+  MonoDelta LeaderLeaseDuration() const;
+
   // Calculates a snooze delta for leader election.
   //
   // The delta increases exponentially with the difference between the current
@@ -859,6 +897,7 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
 
   scoped_refptr<Counter> follower_memory_pressure_rejections_;
   scoped_refptr<AtomicGauge<int64_t> > term_metric_;
+  FunctionGaugeDetacher metric_detacher_;
 
   DISALLOW_COPY_AND_ASSIGN(RaftConsensus);
 };
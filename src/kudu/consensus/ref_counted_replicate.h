@@ -18,13 +18,56 @@
 #ifndef KUDU_CONSENSUS_REF_COUNTED_REPLICATE_H_
 #define KUDU_CONSENSUS_REF_COUNTED_REPLICATE_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <glog/logging.h>
+
 #include "kudu/consensus/consensus.pb.h"
-#include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/slice.h"
 
 namespace kudu {
 namespace consensus {
 
+// A ref-counted, fixed-capacity buffer holding the serialized form of
+// consecutive replicates. Data is only ever appended, so slices of data
+// appended earlier remain valid while more is appended.
+class SerializedReplicateChunk : public RefCountedThreadSafe<SerializedReplicateChunk> {
+ public:
+  explicit SerializedReplicateChunk(size_t capacity)
+      : data_(new uint8_t[capacity]),
+        capacity_(capacity),
+        size_(0) {
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  size_t remaining() const { return capacity_ - size_; }
+
+  // Returns a pointer to 'len' bytes at the end of the chunk's data, which
+  // the caller must fill in. 'len' must not exceed remaining().
+  uint8_t* Append(size_t len) {
+    DCHECK_LE(len, remaining());
+    uint8_t* dst = &data_[size_];
+    size_ += len;
+    return dst;
+  }
+
+ private:
+  friend class RefCountedThreadSafe<SerializedReplicateChunk>;
+  ~SerializedReplicateChunk() {}
+
+  gscoped_array<uint8_t> data_;
+  const size_t capacity_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(SerializedReplicateChunk);
+};
+
 // A simple ref-counted wrapper around ReplicateMsg.
 class RefCountedReplicate : public RefCountedThreadSafe<RefCountedReplicate> {
  public:
@@ -34,8 +77,28 @@ class RefCountedReplicate : public RefCountedThreadSafe<RefCountedReplicate> {
     return msg_.get();
   }
 
+  // The length-prefixed serialized form of the message, if it was serialized
+  // to be sent to peers, or an empty slice otherwise.
+  const Slice& serialized() const {
+    return serialized_;
+  }
+
+  // The chunk which 'serialized()' points into.
+  const scoped_refptr<SerializedReplicateChunk>& serialized_chunk() const {
+    return serialized_chunk_;
+  }
+
+  // Records the serialized form of the message. Must be called before the
+  // message is shared with other threads.
+  void set_serialized(scoped_refptr<SerializedReplicateChunk> chunk, Slice serialized) {
+    serialized_chunk_ = std::move(chunk);
+    serialized_ = serialized;
+  }
+
  private:
   gscoped_ptr<ReplicateMsg> msg_;
+  scoped_refptr<SerializedReplicateChunk> serialized_chunk_;
+  Slice serialized_;
 };
 
 typedef scoped_refptr<RefCountedReplicate> ReplicateRefPtr;
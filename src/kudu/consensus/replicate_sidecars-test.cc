@@ -0,0 +1,146 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/consensus/replicate_sidecars.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "kudu/common/timestamp.h"
+#include "kudu/consensus/consensus-test-util.h"
+#include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/opid.pb.h"
+#include "kudu/rpc/rpc_controller.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace kudu {
+namespace consensus {
+
+class ReplicateSidecarsTest : public KuduTest {
+ protected:
+  // Creates 'n' replicates starting at 'first_index', each with a payload of
+  // 'payload_size' bytes.
+  static vector<ReplicateRefPtr> CreateReplicates(int64_t first_index, int n,
+                                                  int payload_size) {
+    vector<ReplicateRefPtr> msgs;
+    for (int i = 0; i < n; i++) {
+      msgs.emplace_back(make_scoped_refptr_replicate(CreateDummyReplicate(
+          1, first_index + i, Timestamp(first_index + i), payload_size).release()));
+    }
+    return msgs;
+  }
+
+  // Sets the ops of 'request' to 'msgs', as the queue does.
+  static void AddOps(const vector<ReplicateRefPtr>& msgs, ConsensusRequestPB* request) {
+    for (const auto& msg : msgs) {
+      request->mutable_ops()->AddAllocated(msg->get());
+    }
+  }
+};
+
+// Test that serialized replicates round-trip, and that consecutive
+// replicates share chunks and are laid out contiguously within them.
+TEST_F(ReplicateSidecarsTest, TestSerializeAndParse) {
+  ReplicateSerializer serializer(1024);
+  vector<ReplicateRefPtr> msgs = CreateReplicates(1, 10, 100);
+  serializer.Serialize(msgs);
+
+  ConsensusRequestPB request;
+  for (int i = 0; i < msgs.size(); i++) {
+    const auto& msg = msgs[i];
+    ASSERT_FALSE(msg->serialized().empty());
+    ASSERT_TRUE(msg->serialized_chunk());
+    if (i > 0 && msg->serialized_chunk() == msgs[i - 1]->serialized_chunk()) {
+      const Slice& prev = msgs[i - 1]->serialized();
+      ASSERT_EQ(prev.data() + prev.size(), msg->serialized().data());
+    }
+    ASSERT_OK(ParseOpsFromSidecar(msg->serialized(), &request));
+  }
+  ASSERT_EQ(msgs.size(), request.ops_size());
+  for (int i = 0; i < msgs.size(); i++) {
+    ASSERT_EQ(msgs[i]->get()->SerializeAsString(), request.ops(i).SerializeAsString());
+  }
+
+  // Chunks are sized to the replicates they hold.
+  map<const SerializedReplicateChunk*, size_t> chunk_bytes;
+  for (const auto& msg : msgs) {
+    chunk_bytes[msg->serialized_chunk().get()] += msg->serialized().size();
+  }
+  for (const auto& e : chunk_bytes) {
+    ASSERT_EQ(e.second, e.first->capacity());
+    ASSERT_LE(e.first->capacity(), 1024);
+  }
+
+  // A replicate larger than a chunk gets a chunk of its own.
+  vector<ReplicateRefPtr> large = CreateReplicates(11, 1, 4096);
+  serializer.Serialize(large);
+  ASSERT_NE(msgs.back()->serialized_chunk(), large[0]->serialized_chunk());
+  request.Clear();
+  ASSERT_OK(ParseOpsFromSidecar(large[0]->serialized(), &request));
+  ASSERT_EQ(1, request.ops_size());
+  ASSERT_EQ(11, request.ops(0).id().index());
+
+  // Truncated data is detected.
+  Slice truncated(large[0]->serialized().data(), large[0]->serialized().size() - 1);
+  Status s = ParseOpsFromSidecar(truncated, &request);
+  ASSERT_TRUE(s.IsCorruption()) << s.ToString();
+}
+
+TEST_F(ReplicateSidecarsTest, TestMoveOpsToSidecars) {
+  // 10 replicates of ~100 bytes span a few chunks of 256 bytes.
+  ReplicateSerializer serializer(256);
+  vector<ReplicateRefPtr> msgs = CreateReplicates(1, 10, 100);
+  serializer.Serialize(msgs);
+  int num_chunks = 1;
+  for (int i = 1; i < msgs.size(); i++) {
+    if (msgs[i]->serialized_chunk() != msgs[i - 1]->serialized_chunk()) {
+      num_chunks++;
+    }
+  }
+  ASSERT_GT(num_chunks, 1);
+
+  ConsensusRequestPB request;
+  AddOps(msgs, &request);
+  rpc::RpcController controller;
+  ASSERT_TRUE(MoveOpsToSidecars(msgs, &request, &controller));
+  ASSERT_EQ(0, request.ops_size());
+  ASSERT_EQ(num_chunks, request.ops_sidecars_size());
+
+  // Replicates which weren't serialized are left in the request.
+  vector<ReplicateRefPtr> unserialized = CreateReplicates(11, 2, 100);
+  request.Clear();
+  AddOps(unserialized, &request);
+  rpc::RpcController controller2;
+  ASSERT_FALSE(MoveOpsToSidecars(unserialized, &request, &controller2));
+  ASSERT_EQ(2, request.ops_size());
+  ASSERT_EQ(0, request.ops_sidecars_size());
+  request.mutable_ops()->ExtractSubrange(0, request.ops_size(), nullptr);
+}
+
+} // namespace consensus
+} // namespace kudu
@@ -0,0 +1,167 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/consensus/replicate_sidecars.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include <glog/logging.h>
+#include <google/protobuf/io/coded_stream.h>
+
+#include "kudu/consensus/consensus.pb.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_sidecar.h"
+#include "kudu/rpc/transfer.h"
+
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace consensus {
+
+namespace {
+
+// A sidecar referencing a range of a chunk of serialized replicates, keeping
+// the chunk alive until the RPC carrying it completes.
+class ReplicateChunkSidecar : public rpc::RpcSidecar {
+ public:
+  ReplicateChunkSidecar(scoped_refptr<SerializedReplicateChunk> chunk, Slice data)
+      : chunk_(std::move(chunk)),
+        data_(data) {
+  }
+
+  Slice AsSlice() const override { return data_; }
+
+ private:
+  const scoped_refptr<SerializedReplicateChunk> chunk_;
+  const Slice data_;
+};
+
+} // anonymous namespace
+
+ReplicateSerializer::ReplicateSerializer(size_t max_chunk_size)
+    : max_chunk_size_(max_chunk_size) {
+}
+
+void ReplicateSerializer::Serialize(const vector<ReplicateRefPtr>& msgs) {
+  // Compute the serialized size of every replicate up front, so that chunks
+  // can be allocated with exactly the capacity their replicates need.
+  vector<size_t> sizes;
+  sizes.reserve(msgs.size());
+  for (const ReplicateRefPtr& msg : msgs) {
+    DCHECK(msg->serialized().empty());
+    uint32_t pb_size = msg->get()->ByteSize();
+    sizes.push_back(CodedOutputStream::VarintSize32(pb_size) + pb_size);
+  }
+
+  scoped_refptr<SerializedReplicateChunk> chunk;
+  for (int i = 0; i < msgs.size(); i++) {
+    const ReplicateMsg& pb = *msgs[i]->get();
+    const size_t size = sizes[i];
+    if (!chunk || chunk->remaining() < size) {
+      // Start a chunk holding this replicate and as many of the following
+      // ones as fit in 'max_chunk_size_'.
+      size_t capacity = size;
+      for (int j = i + 1; j < msgs.size() && capacity + sizes[j] <= max_chunk_size_; j++) {
+        capacity += sizes[j];
+      }
+      chunk = new SerializedReplicateChunk(capacity);
+    }
+
+    uint32_t pb_size = pb.GetCachedSize();
+    uint8_t* dst = chunk->Append(size);
+    uint8_t* end = CodedOutputStream::WriteVarint32ToArray(pb_size, dst);
+    end = pb.SerializeWithCachedSizesToArray(end);
+    DCHECK_EQ(size, static_cast<size_t>(end - dst));
+    msgs[i]->set_serialized(chunk, Slice(dst, size));
+  }
+  DCHECK(!chunk || chunk->remaining() == 0);
+}
+
+bool MoveOpsToSidecars(const vector<ReplicateRefPtr>& msgs,
+                       ConsensusRequestPB* request,
+                       rpc::RpcController* controller) {
+  DCHECK_EQ(msgs.size(), request->ops_size());
+  if (msgs.empty()) {
+    return false;
+  }
+
+  // Merge the serialized form of consecutive replicates which are adjacent
+  // in the same chunk into a single sidecar.
+  vector<std::pair<const ReplicateRefPtr*, Slice>> ranges;
+  for (const ReplicateRefPtr& msg : msgs) {
+    const Slice& serialized = msg->serialized();
+    if (serialized.empty()) {
+      return false;
+    }
+    if (!ranges.empty()) {
+      auto& last = ranges.back();
+      if ((*last.first)->serialized_chunk() == msg->serialized_chunk() &&
+          last.second.data() + last.second.size() == serialized.data()) {
+        last.second = Slice(last.second.data(), last.second.size() + serialized.size());
+        continue;
+      }
+    }
+    ranges.emplace_back(&msg, serialized);
+  }
+  if (ranges.size() > rpc::TransferLimits::kMaxSidecars) {
+    return false;
+  }
+
+  for (const auto& range : ranges) {
+    int idx;
+    Status s = controller->AddOutboundSidecar(unique_ptr<rpc::RpcSidecar>(
+        new ReplicateChunkSidecar((*range.first)->serialized_chunk(), range.second)), &idx);
+    // The sidecars were counted above, and UpdateConsensus requests carry no
+    // other sidecars.
+    CHECK_OK(s);
+    request->add_ops_sidecars(idx);
+  }
+
+  // The replicates are owned by 'msgs'; release them without deleting them.
+  request->mutable_ops()->ExtractSubrange(0, request->ops_size(), nullptr);
+  return true;
+}
+
+Status ParseOpsFromSidecar(Slice sidecar, ConsensusRequestPB* request) {
+  CodedInputStream in(sidecar.data(), sidecar.size());
+  in.PushLimit(sidecar.size());
+  while (in.BytesUntilLimit() > 0) {
+    uint32_t size;
+    if (!in.ReadVarint32(&size)) {
+      return Status::Corruption("could not read the length of a replicate in a sidecar");
+    }
+    CodedInputStream::Limit limit = in.PushLimit(size);
+    ReplicateMsg* op = request->add_ops();
+    if (!op->ParseFromCodedStream(&in) || !in.ConsumedEntireMessage() ||
+        in.BytesUntilLimit() != 0) {
+      return Status::Corruption(Substitute(
+          "could not parse a replicate of $0 bytes from a sidecar", size));
+    }
+    in.PopLimit(limit);
+  }
+  return Status::OK();
+}
+
+} // namespace consensus
+} // namespace kudu
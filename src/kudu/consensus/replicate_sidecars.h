@@ -0,0 +1,78 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "kudu/consensus/ref_counted_replicate.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+namespace rpc {
+class RpcController;
+} // namespace rpc
+
+namespace consensus {
+
+class ConsensusRequestPB;
+
+// Serializes the replicates appended to a leader's queue, once for all of its
+// peers. Consecutive replicates are laid out contiguously in shared chunks so
+// that a batch of them can be sent to each peer as a few RPC sidecars, making
+// the cost of sending a batch independent of the number of peers. Each chunk
+// is sized to the replicates of the batch it holds, so that no memory is
+// pinned beyond their serialized form.
+//
+// This class is not thread-safe: replicates must be serialized in the order
+// they are appended to the queue, one batch at a time.
+class ReplicateSerializer {
+ public:
+  // Creates a serializer whose chunks hold at most 'max_chunk_size' bytes.
+  // Replicates larger than that get chunks of their own.
+  explicit ReplicateSerializer(size_t max_chunk_size);
+
+  // Serializes each of 'msgs', recording its serialized form in it.
+  void Serialize(const std::vector<ReplicateRefPtr>& msgs);
+
+ private:
+  const size_t max_chunk_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReplicateSerializer);
+};
+
+// Moves the operations of 'request', which must be those of 'msgs', into
+// RPC sidecars of 'controller', referencing their serialized form rather
+// than copying it, and sets 'request->ops_sidecars' accordingly.
+//
+// Returns false, leaving 'request' and 'controller' untouched, if one of the
+// replicates was not serialized or if the replicates would require more
+// sidecars than an RPC may carry.
+bool MoveOpsToSidecars(const std::vector<ReplicateRefPtr>& msgs,
+                       ConsensusRequestPB* request,
+                       rpc::RpcController* controller);
+
+// Parses the replicates held in 'sidecar', as sent by MoveOpsToSidecars(),
+// appending them to 'request->ops'.
+Status ParseOpsFromSidecar(Slice sidecar, ConsensusRequestPB* request);
+
+} // namespace consensus
+} // namespace kudu
@@ -24,6 +24,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -37,6 +38,7 @@
 #include "kudu/fs/block_manager.h"
 #include "kudu/fs/data_dirs.h"
 #include "kudu/fs/fs_manager.h"
+#include "kudu/fs/wal_dirs.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/stringprintf.h"
@@ -55,6 +57,7 @@
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
+using std::unordered_map;
 using std::unordered_set;
 using std::vector;
 using strings::Substitute;
@@ -490,6 +493,71 @@ TEST_F(FsManagerTestBase, TestAddDataDirs) {
   }
 }
 
+TEST_F(FsManagerTestBase, TestMultipleWalDirs) {
+  const string wal_path1 = GetTestPath("wal1");
+  const string wal_path2 = GetTestPath("wal2");
+  FsManagerOpts opts;
+  opts.wal_root = GetTestPath("wal0");
+  opts.additional_wal_roots = { wal_path1, wal_path2 };
+  opts.data_roots = { fs_root_ };
+  ReinitFsManagerWithOpts(opts);
+
+  // The fs_root_ is already formatted; start over with a fresh layout.
+  ASSERT_OK(env_->DeleteRecursively(fs_root_));
+  ASSERT_OK(fs_manager()->CreateInitialFileSystemLayout());
+  ASSERT_OK(fs_manager()->Open());
+  ASSERT_EQ(3, fs_manager()->GetWalsRootDirs().size());
+
+  // Tablets without any writes should be spread evenly across the directories.
+  const int kNumTablets = 9;
+  unordered_map<string, int> tablets_per_dir;
+  vector<string> tablet_ids;
+  for (int i = 0; i < kNumTablets; i++) {
+    string tablet_id = Substitute("tablet-$0", i);
+    string wal_dir = fs_manager()->GetOrPlaceTabletWalDir(tablet_id);
+    ASSERT_OK(env_->CreateDir(wal_dir));
+    tablets_per_dir[DirName(wal_dir)]++;
+    tablet_ids.emplace_back(std::move(tablet_id));
+  }
+  ASSERT_EQ(3, tablets_per_dir.size());
+  for (const auto& e : tablets_per_dir) {
+    ASSERT_EQ(kNumTablets / 3, e.second) << e.first;
+  }
+
+  // A tablet's placement is stable and is rediscovered upon reopening.
+  unordered_map<string, string> placements;
+  for (const auto& tablet_id : tablet_ids) {
+    placements[tablet_id] = fs_manager()->GetTabletWalDir(tablet_id);
+  }
+  ReinitFsManagerWithOpts(opts);
+  ASSERT_OK(fs_manager()->Open());
+  for (const auto& tablet_id : tablet_ids) {
+    ASSERT_EQ(placements[tablet_id], fs_manager()->GetTabletWalDir(tablet_id));
+  }
+  ASSERT_EQ(kNumTablets, fs_manager()->wd_manager()->GetPlacements().size());
+
+  // Looking up the WAL of a tablet which has none doesn't place it.
+  ASSERT_FALSE(env_->FileExists(fs_manager()->GetTabletWalDir("unknown-tablet")));
+  ASSERT_EQ(kNumTablets, fs_manager()->wd_manager()->GetPlacements().size());
+
+  // Opening with an unformatted WAL root fails.
+  opts.additional_wal_roots = { wal_path1, GetTestPath("wal3") };
+  ReinitFsManagerWithOpts(opts);
+  Status s = fs_manager()->Open();
+  ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+
+  // Unless new roots may be created.
+  opts.additional_wal_roots = { wal_path1, wal_path2, GetTestPath("wal3") };
+  opts.update_on_disk = true;
+  ReinitFsManagerWithOpts(opts);
+  ASSERT_OK(fs_manager()->Open());
+  ASSERT_EQ(4, fs_manager()->GetWalsRootDirs().size());
+
+  // New tablets favor the empty directory.
+  ASSERT_EQ(fs_manager()->GetWalsRootDirs().back(),
+            DirName(fs_manager()->GetOrPlaceTabletWalDir("new-tablet")));
+}
+
 TEST_F(FsManagerTestBase, TestAddDataDirsFuzz) {
   const int kNumAttempts = AllowSlowTests() ? 1000 : 100;
 
@@ -85,6 +85,12 @@ DEFINE_string(fs_wal_dir, "",
               "Directory with write-ahead logs. If this is not specified, the "
               "program will not start. May be the same as fs_data_dirs");
 TAG_FLAG(fs_wal_dir, stable);
+DEFINE_string(fs_additional_wal_dirs, "",
+              "Comma-separated list of additional directories with write-ahead logs. "
+              "The write-ahead log of each tablet is placed in one of fs_wal_dir and "
+              "these directories, balancing their write rates, so that the write-ahead "
+              "log throughput scales with the number of disks.");
+TAG_FLAG(fs_additional_wal_dirs, experimental);
 DEFINE_string(fs_data_dirs, "",
               "Comma-separated list of directories with data blocks. If this "
               "is not specified, fs_wal_dir will be used as the sole data "
@@ -127,15 +133,19 @@ const char *FsManager::kInstanceMetadataFileName = "instance";
 const char *FsManager::kConsensusMetadataDirName = "consensus-meta";
 
 FsManagerOpts::FsManagerOpts()
-  : wal_root(FLAGS_fs_wal_dir),
+  : metric_registry(nullptr),
+    wal_root(FLAGS_fs_wal_dir),
     block_manager_type(FLAGS_block_manager),
     read_only(false),
     update_on_disk(false) {
+  additional_wal_roots = strings::Split(FLAGS_fs_additional_wal_dirs, ",",
+                                        strings::SkipEmpty());
   data_roots = strings::Split(FLAGS_fs_data_dirs, ",", strings::SkipEmpty());
 }
 
 FsManagerOpts::FsManagerOpts(const string& root)
-  : wal_root(root),
+  : metric_registry(nullptr),
+    wal_root(root),
     data_roots({ root }),
     block_manager_type(FLAGS_block_manager),
     read_only(false),
@@ -178,6 +188,7 @@ Status FsManager::Init() {
 
   // Deduplicate all of the roots.
   unordered_set<string> all_roots = { opts_.wal_root };
+  all_roots.insert(opts_.additional_wal_roots.begin(), opts_.additional_wal_roots.end());
   all_roots.insert(opts_.data_roots.begin(), opts_.data_roots.end());
 
   // Build a map of original root --> canonicalized root, sanitizing each
@@ -219,6 +230,13 @@ Status FsManager::Init() {
   // All done, use the map to set the canonicalized state.
 
   canonicalized_wal_fs_root_ = FindOrDie(canonicalized_roots, opts_.wal_root);
+  unordered_set<string> wal_roots = { canonicalized_wal_fs_root_.path };
+  for (const string& wal_fs_root : opts_.additional_wal_roots) {
+    const auto& root = FindOrDie(canonicalized_roots, wal_fs_root);
+    if (InsertIfNotPresent(&wal_roots, root.path)) {
+      canonicalized_additional_wal_fs_roots_.emplace_back(root);
+    }
+  }
   if (!opts_.data_roots.empty()) {
     unordered_set<string> unique_roots;
     for (const string& data_fs_root : opts_.data_roots) {
@@ -232,12 +250,20 @@ Status FsManager::Init() {
     if (!ContainsKey(unique_roots, canonicalized_wal_fs_root_.path)) {
       canonicalized_all_fs_roots_.emplace_back(canonicalized_wal_fs_root_);
     }
+    for (const auto& root : canonicalized_additional_wal_fs_roots_) {
+      if (!ContainsKey(unique_roots, root.path)) {
+        canonicalized_all_fs_roots_.emplace_back(root);
+      }
+    }
   } else {
     LOG(INFO) << "Data directories (fs_data_dirs) not provided";
     LOG(INFO) << "Using write-ahead log directory (fs_wal_dir) as data directory";
     canonicalized_metadata_fs_root_ = canonicalized_wal_fs_root_;
     canonicalized_data_fs_roots_.emplace_back(canonicalized_wal_fs_root_);
     canonicalized_all_fs_roots_.emplace_back(canonicalized_wal_fs_root_);
+    for (const auto& root : canonicalized_additional_wal_fs_roots_) {
+      canonicalized_all_fs_roots_.emplace_back(root);
+    }
   }
 
   // The server cannot start if the WAL root or metadata root failed to
@@ -245,12 +271,18 @@ Status FsManager::Init() {
   const string& wal_root = canonicalized_wal_fs_root_.path;
   RETURN_NOT_OK_PREPEND(canonicalized_wal_fs_root_.status,
       Substitute("Write-ahead log directory $0 failed to canonicalize", wal_root));
+  for (const auto& root : canonicalized_additional_wal_fs_roots_) {
+    RETURN_NOT_OK_PREPEND(root.status,
+        Substitute("Write-ahead log directory $0 failed to canonicalize", root.path));
+  }
   const string& meta_root = canonicalized_metadata_fs_root_.path;
   RETURN_NOT_OK_PREPEND(canonicalized_metadata_fs_root_.status,
       Substitute("Metadata directory $0 failed to canonicalize", meta_root));
 
   if (VLOG_IS_ON(1)) {
     VLOG(1) << "WAL root: " << canonicalized_wal_fs_root_.path;
+    VLOG(1) << "Additional WAL roots: " <<
+      JoinStrings(DataDirManager::GetRootNames(canonicalized_additional_wal_fs_roots_), ",");
     VLOG(1) << "Metadata root: " << canonicalized_metadata_fs_root_.path;
     VLOG(1) << "Data roots: " <<
       JoinStrings(DataDirManager::GetRootNames(canonicalized_data_fs_roots_), ",");
@@ -258,6 +290,13 @@ Status FsManager::Init() {
       JoinStrings(DataDirManager::GetRootNames(canonicalized_all_fs_roots_), ",");
   }
 
+  vector<string> wal_root_paths = { canonicalized_wal_fs_root_.path };
+  for (const auto& root : canonicalized_additional_wal_fs_roots_) {
+    wal_root_paths.emplace_back(root.path);
+  }
+  wd_manager_.reset(new fs::WalDirManager(env_, wal_root_paths, kWalDirName,
+                                          opts_.metric_registry));
+
   initted_ = true;
   return Status::OK();
 }
@@ -353,6 +392,31 @@ Status FsManager::Open(FsReport* report) {
                           "unable to create missing filesystem roots");
   }
 
+  // Ensure the WAL directories of the additional WAL roots exist, creating
+  // them in any newly added roots.
+  unordered_set<string> missing_paths;
+  for (const auto& root : missing_roots) {
+    missing_paths.insert(root.path);
+  }
+  for (const auto& root : canonicalized_additional_wal_fs_roots_) {
+    string d = JoinPathSegments(root.path, kWalDirName);
+    if (ContainsKey(missing_paths, root.path) && !env_->FileExists(d)) {
+      RETURN_NOT_OK_PREPEND(env_->CreateDir(d),
+                            Substitute("Unable to create directory $0", d));
+      created_dirs.emplace_back(d);
+    }
+    bool is_dir;
+    RETURN_NOT_OK_PREPEND(env_->IsDirectory(d, &is_dir),
+                          Substitute("could not verify required directory $0", d));
+    if (!is_dir) {
+      return Status::Corruption(
+          Substitute("Required directory $0 exists but is not a directory", d));
+    }
+  }
+
+  // Discover which WAL directory each existing tablet's WAL lives in.
+  RETURN_NOT_OK_PREPEND(wd_manager_->LoadPlacements(), "could not load WAL placements");
+
   // Remove leftover temporary files from the WAL root and fix permissions.
   //
   // Temporary files in the data directory roots will be removed by the block
@@ -450,9 +514,9 @@ Status FsManager::CreateInitialFileSystemLayout(boost::optional<string> uuid) {
                         "unable to create file system roots");
 
   // Create ancillary directories.
-  vector<string> ancillary_dirs = { GetWalsRootDir(),
-                                    GetTabletMetadataDir(),
-                                    GetConsensusMetadataDir() };
+  vector<string> ancillary_dirs = GetWalsRootDirs();
+  ancillary_dirs.emplace_back(GetTabletMetadataDir());
+  ancillary_dirs.emplace_back(GetConsensusMetadataDir());
   for (const string& dir : ancillary_dirs) {
     bool created;
     RETURN_NOT_OK_PREPEND(env_util::CreateDirIfMissing(env_, dir, &created),
@@ -626,8 +690,26 @@ string FsManager::GetInstanceMetadataPath(const string& root) const {
   return JoinPathSegments(root, kInstanceMetadataFileName);
 }
 
+vector<string> FsManager::GetWalsRootDirs() const {
+  DCHECK(initted_);
+  vector<string> dirs;
+  for (const auto& dir : wd_manager_->dirs()) {
+    dirs.emplace_back(dir->dir());
+  }
+  return dirs;
+}
+
+string FsManager::GetTabletWalDir(const string& tablet_id) const {
+  const fs::WalDir* dir = wd_manager_->FindTablet(tablet_id);
+  return JoinPathSegments(dir ? dir->dir() : GetWalsRootDir(), tablet_id);
+}
+
+string FsManager::GetOrPlaceTabletWalDir(const string& tablet_id) {
+  return JoinPathSegments(wd_manager_->FindOrPlaceTablet(tablet_id)->dir(), tablet_id);
+}
+
 string FsManager::GetTabletWalRecoveryDir(const string& tablet_id) const {
-  string path = JoinPathSegments(GetWalsRootDir(), tablet_id);
+  string path = GetTabletWalDir(tablet_id);
   StrAppend(&path, kWalsRecoveryDirSuffix);
   return path;
 }
@@ -642,9 +724,10 @@ string FsManager::GetWalSegmentFileName(const string& tablet_id,
 
 void FsManager::CleanTmpFiles() {
   DCHECK(!opts_.read_only);
-  for (const auto& s : { GetWalsRootDir(),
-                         GetTabletMetadataDir(),
-                         GetConsensusMetadataDir() }) {
+  vector<string> dirs = GetWalsRootDirs();
+  dirs.emplace_back(GetTabletMetadataDir());
+  dirs.emplace_back(GetConsensusMetadataDir());
+  for (const auto& s : dirs) {
     WARN_NOT_OK(env_util::DeleteTmpFilesRecursively(env_, s),
                 Substitute("Error deleting tmp files in $0", s));
   }
@@ -30,6 +30,7 @@
 
 #include "kudu/fs/data_dirs.h"
 #include "kudu/fs/error_manager.h"
+#include "kudu/fs/wal_dirs.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/env.h"
@@ -44,6 +45,7 @@ namespace kudu {
 class BlockId;
 class InstanceMetadataPB;
 class MemTracker;
+class MetricRegistry;
 
 namespace fs {
 
@@ -75,6 +77,12 @@ struct FsManagerOpts {
   // Defaults to NULL.
   scoped_refptr<MetricEntity> metric_entity;
 
+  // The registry under which per-WAL-directory metric entities are created.
+  // If NULL, those metrics will not be produced.
+  //
+  // Defaults to NULL.
+  MetricRegistry* metric_registry;
+
   // The memory tracker under which all new memory trackers will be parented.
   // If NULL, new memory trackers will be parented to the root tracker.
   std::shared_ptr<MemTracker> parent_mem_tracker;
@@ -82,6 +90,10 @@ struct FsManagerOpts {
   // The directory root where WALs will be stored. Cannot be empty.
   std::string wal_root;
 
+  // Additional directory roots where WALs will be stored. Each tablet's WAL
+  // is placed in one of 'wal_root' and these roots.
+  std::vector<std::string> additional_wal_roots;
+
   // The directory root where data blocks will be stored. Cannot be empty.
   std::vector<std::string> data_roots;
 
@@ -184,14 +196,23 @@ class FsManager {
   // ==========================================================================
   std::vector<std::string> GetDataRootDirs() const;
 
+  // Returns the WAL directory of the primary WAL root.
   std::string GetWalsRootDir() const {
     DCHECK(initted_);
     return JoinPathSegments(canonicalized_wal_fs_root_.path, kWalDirName);
   }
 
-  std::string GetTabletWalDir(const std::string& tablet_id) const {
-    return JoinPathSegments(GetWalsRootDir(), tablet_id);
-  }
+  // Returns the WAL directories of all WAL roots, the primary one first.
+  std::vector<std::string> GetWalsRootDirs() const;
+
+  // Returns the directory of the tablet's WAL. If the tablet isn't placed in
+  // any WAL directory, i.e. it has no WAL, returns where it would be in the
+  // primary WAL directory, which doesn't exist.
+  std::string GetTabletWalDir(const std::string& tablet_id) const;
+
+  // Like GetTabletWalDir(), but places the tablet in one of the WAL
+  // directories if it isn't placed yet. Must be used when creating the WAL.
+  std::string GetOrPlaceTabletWalDir(const std::string& tablet_id);
 
   std::string GetTabletWalRecoveryDir(const std::string& tablet_id) const;
 
@@ -242,6 +263,10 @@ class FsManager {
     return dd_manager_.get();
   }
 
+  fs::WalDirManager* wd_manager() const {
+    return wd_manager_.get();
+  }
+
   fs::BlockManager* block_manager() {
     return block_manager_.get();
   }
@@ -318,6 +343,7 @@ class FsManager {
   // - The first data root is used as the metadata root.
   // - Common roots in the collections have been deduplicated.
   CanonicalizedRootAndStatus canonicalized_wal_fs_root_;
+  CanonicalizedRootsList canonicalized_additional_wal_fs_roots_;
   CanonicalizedRootAndStatus canonicalized_metadata_fs_root_;
   CanonicalizedRootsList canonicalized_data_fs_roots_;
   CanonicalizedRootsList canonicalized_all_fs_roots_;
@@ -326,6 +352,7 @@ class FsManager {
 
   std::unique_ptr<fs::FsErrorManager> error_manager_;
   std::unique_ptr<fs::DataDirManager> dd_manager_;
+  std::unique_ptr<fs::WalDirManager> wd_manager_;
   std::unique_ptr<fs::BlockManager> block_manager_;
 
   bool initted_;
@@ -0,0 +1,235 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/fs/wal_dirs.h"
+
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/strip.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/strings/util.h"
+#include "kudu/util/env.h"
+#include "kudu/util/path_util.h"
+
+METRIC_DEFINE_entity(wal_dir);
+
+METRIC_DEFINE_counter(wal_dir, wal_dir_bytes_written, "WAL Directory Bytes Written",
+                      kudu::MetricUnit::kBytes,
+                      "Number of bytes written to the WALs in this directory");
+
+METRIC_DEFINE_histogram(wal_dir, wal_dir_append_latency, "WAL Directory Append Latency",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Microseconds spent on appending to the WAL segments in this "
+                        "directory",
+                        60000000LU, 2);
+
+METRIC_DEFINE_histogram(wal_dir, wal_dir_sync_latency, "WAL Directory Sync Latency",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Microseconds spent on synchronizing the WAL segments in this "
+                        "directory",
+                        60000000LU, 2);
+
+METRIC_DEFINE_gauge_uint64(wal_dir, wal_dir_tablets, "WAL Directory Tablets",
+                           kudu::MetricUnit::kTablets,
+                           "Number of tablets whose WALs are placed in this directory");
+
+using std::string;
+using std::unique_ptr;
+using std::unordered_map;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace fs {
+
+#define MINIT(x) x(METRIC_##x.Instantiate(entity))
+#define GINIT(x) x(METRIC_##x.Instantiate(entity, 0))
+WalDirMetrics::WalDirMetrics(const scoped_refptr<MetricEntity>& entity)
+    : MINIT(wal_dir_bytes_written),
+      MINIT(wal_dir_append_latency),
+      MINIT(wal_dir_sync_latency),
+      GINIT(wal_dir_tablets) {
+}
+#undef GINIT
+#undef MINIT
+
+WalDir::WalDir(string root, string dir, unique_ptr<WalDirMetrics> metrics)
+    : root_(std::move(root)),
+      dir_(std::move(dir)),
+      metrics_(std::move(metrics)),
+      bytes_written_(0),
+      num_tablets_(0),
+      bytes_at_last_estimate_(0),
+      write_rate_(0) {
+}
+
+WalDirManager::WalDirManager(Env* env,
+                             const vector<string>& roots,
+                             const string& wal_dir_name,
+                             MetricRegistry* metric_registry)
+    : env_(env),
+      last_rate_estimate_(MonoTime::Now()) {
+  DCHECK(!roots.empty());
+  for (const auto& root : roots) {
+    unique_ptr<WalDirMetrics> metrics;
+    if (metric_registry) {
+      metrics.reset(new WalDirMetrics(METRIC_ENTITY_wal_dir.Instantiate(
+          metric_registry, root, { { "path", root } })));
+    }
+    dirs_.emplace_back(new WalDir(root, JoinPathSegments(root, wal_dir_name),
+                                  std::move(metrics)));
+  }
+}
+
+Status WalDirManager::LoadPlacements() {
+  vector<vector<string>> children_by_dir(dirs_.size());
+  for (size_t i = 0; i < dirs_.size(); i++) {
+    RETURN_NOT_OK_PREPEND(env_->GetChildren(dirs_[i]->dir(), &children_by_dir[i]),
+                          Substitute("Couldn't list WALs in $0", dirs_[i]->dir()));
+  }
+
+  std::lock_guard<simple_spinlock> l(lock_);
+  for (size_t i = 0; i < dirs_.size(); i++) {
+    WalDir* dir = dirs_[i].get();
+    for (const string& child : children_by_dir[i]) {
+      if (HasPrefixString(child, ".") ||
+          child.find(kTmpInfix) != string::npos ||
+          child.find(kOldTmpInfix) != string::npos) {
+        continue;
+      }
+      // A WAL which was being recovered is placed like any other.
+      string tablet_id;
+      if (!TryStripSuffixString(child, FsManager::kWalsRecoveryDirSuffix, &tablet_id)) {
+        tablet_id = child;
+      }
+
+      WalDir* existing = FindPtrOrNull(tablet_to_dir_, tablet_id);
+      if (existing == dir) {
+        // Both the WAL and its recovery directory are present.
+        continue;
+      }
+      if (existing) {
+        return Status::Corruption(Substitute(
+            "WAL of tablet $0 found in multiple WAL directories: $1 and $2",
+            tablet_id, existing->dir(), dir->dir()));
+      }
+      AddPlacementUnlocked(tablet_id, dir);
+    }
+  }
+  return Status::OK();
+}
+
+WalDir* WalDirManager::FindTablet(const string& tablet_id) const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return FindPtrOrNull(tablet_to_dir_, tablet_id);
+}
+
+WalDir* WalDirManager::FindOrPlaceTablet(const string& tablet_id) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  WalDir* dir = FindPtrOrNull(tablet_to_dir_, tablet_id);
+  if (dir) {
+    return dir;
+  }
+  dir = PickDirForNewTabletUnlocked();
+  AddPlacementUnlocked(tablet_id, dir);
+  VLOG(1) << Substitute("Placed WAL of tablet $0 in $1", tablet_id, dir->dir());
+  return dir;
+}
+
+void WalDirManager::RemoveTablet(const string& tablet_id) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  WalDir* dir = EraseKeyReturnValuePtr(&tablet_to_dir_, tablet_id);
+  if (!dir) {
+    return;
+  }
+  dir->num_tablets_--;
+  if (dir->metrics_) {
+    dir->metrics_->wal_dir_tablets->set_value(dir->num_tablets_);
+  }
+}
+
+unordered_map<string, const WalDir*> WalDirManager::GetPlacements() const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return unordered_map<string, const WalDir*>(tablet_to_dir_.begin(), tablet_to_dir_.end());
+}
+
+WalDir* WalDirManager::PickDirForNewTabletUnlocked() {
+  if (dirs_.size() == 1) {
+    return dirs_[0].get();
+  }
+
+  // Update the estimated write rate of each directory: an exponentially
+  // weighted average of the rate since the previous estimate, with more
+  // weight given to longer intervals.
+  static const double kRateHalfLifeSecs = 60;
+  MonoTime now = MonoTime::Now();
+  double elapsed_secs = (now - last_rate_estimate_).ToSeconds();
+  if (elapsed_secs > 0) {
+    double weight = 1 - std::pow(0.5, elapsed_secs / kRateHalfLifeSecs);
+    for (const auto& dir : dirs_) {
+      int64_t bytes = dir->bytes_written_;
+      double rate = (bytes - dir->bytes_at_last_estimate_) / elapsed_secs;
+      dir->write_rate_ += (rate - dir->write_rate_) * weight;
+      dir->bytes_at_last_estimate_ = bytes;
+    }
+    last_rate_estimate_ = now;
+  }
+
+  // The write rate of a newly placed tablet is unknown, so balance both the
+  // write rate and the number of tablets.
+  double total_rate = 0;
+  int total_tablets = 0;
+  for (const auto& dir : dirs_) {
+    total_rate += dir->write_rate_;
+    total_tablets += dir->num_tablets_;
+  }
+  WalDir* best = nullptr;
+  double best_score = std::numeric_limits<double>::max();
+  for (const auto& dir : dirs_) {
+    double score = 0;
+    if (total_rate > 0) {
+      score += dir->write_rate_ / total_rate;
+    }
+    if (total_tablets > 0) {
+      score += static_cast<double>(dir->num_tablets_) / total_tablets;
+    }
+    if (score < best_score) {
+      best = dir.get();
+      best_score = score;
+    }
+  }
+  return best;
+}
+
+void WalDirManager::AddPlacementUnlocked(const string& tablet_id, WalDir* dir) {
+  InsertOrDie(&tablet_to_dir_, tablet_id, dir);
+  dir->num_tablets_++;
+  if (dir->metrics_) {
+    dir->metrics_->wal_dir_tablets->set_value(dir->num_tablets_);
+  }
+}
+
+} // namespace fs
+} // namespace kudu
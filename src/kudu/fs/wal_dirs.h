@@ -0,0 +1,168 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Env;
+
+namespace fs {
+
+// Metrics for a single WAL directory, grouped under a "wal_dir" entity.
+struct WalDirMetrics {
+  explicit WalDirMetrics(const scoped_refptr<MetricEntity>& entity);
+
+  scoped_refptr<Counter> wal_dir_bytes_written;
+  scoped_refptr<Histogram> wal_dir_append_latency;
+  scoped_refptr<Histogram> wal_dir_sync_latency;
+  scoped_refptr<AtomicGauge<uint64_t>> wal_dir_tablets;
+};
+
+// A directory in which the WALs of tablets are stored.
+//
+// This class is thread-safe.
+class WalDir {
+ public:
+  // The root of the filesystem containing the directory.
+  const std::string& root() const { return root_; }
+
+  // The directory containing the WALs, one subdirectory per tablet.
+  const std::string& dir() const { return dir_; }
+
+  // Metrics for the directory, or null if metrics aren't enabled.
+  WalDirMetrics* metrics() const { return metrics_.get(); }
+
+  // Records that 'bytes' were written to a WAL in this directory.
+  void RecordBytesWritten(int64_t bytes) {
+    bytes_written_ += bytes;
+    if (metrics_) {
+      metrics_->wal_dir_bytes_written->IncrementBy(bytes);
+    }
+  }
+
+  // The number of tablets whose WALs are placed in this directory.
+  int num_tablets() const {
+    return num_tablets_;
+  }
+
+ private:
+  friend class WalDirManager;
+
+  WalDir(std::string root, std::string dir, std::unique_ptr<WalDirMetrics> metrics);
+
+  const std::string root_;
+  const std::string dir_;
+  const std::unique_ptr<WalDirMetrics> metrics_;
+
+  // Bytes written to the directory since it was opened.
+  std::atomic<int64_t> bytes_written_;
+
+  // The state below is protected by the WalDirManager's lock.
+
+  int num_tablets_;
+
+  // Value of 'bytes_written_' when the write rate was last estimated.
+  int64_t bytes_at_last_estimate_;
+
+  // Estimated write rate to the directory, in bytes per second.
+  double write_rate_;
+
+  DISALLOW_COPY_AND_ASSIGN(WalDir);
+};
+
+// Manages the set of WAL directories, and the placement of tablets' WALs
+// across them.
+//
+// A tablet's WAL lives entirely within one WAL directory. The placement of
+// existing WALs is discovered from disk when the directories are opened; new
+// tablets are placed in the directory with the lowest combined share of the
+// recent write rate and of the tablets. Placements are remembered for the
+// lifetime of the manager.
+//
+// This class is thread-safe.
+class WalDirManager {
+ public:
+  // Creates a manager for WAL directories named 'wal_dir_name' in each of the
+  // canonicalized filesystem roots 'roots'. The first root is the primary
+  // one. If 'metric_registry' is not null, per-directory metrics are
+  // registered under it.
+  WalDirManager(Env* env,
+                const std::vector<std::string>& roots,
+                const std::string& wal_dir_name,
+                MetricRegistry* metric_registry);
+
+  // Discovers the placement of the WALs which already exist on disk.
+  Status LoadPlacements();
+
+  // Returns the directory containing the WAL of 'tablet_id', or null if the
+  // tablet isn't placed in any directory.
+  WalDir* FindTablet(const std::string& tablet_id) const;
+
+  // Returns the directory containing the WAL of 'tablet_id', placing the
+  // tablet in one of the directories if it has none yet. Should only be
+  // called when the tablet's WAL is about to be created.
+  WalDir* FindOrPlaceTablet(const std::string& tablet_id);
+
+  // Forgets the placement of 'tablet_id', whose WAL has been deleted.
+  void RemoveTablet(const std::string& tablet_id);
+
+  // Returns the placement of every known tablet, keyed by tablet ID.
+  std::unordered_map<std::string, const WalDir*> GetPlacements() const;
+
+  const std::vector<std::unique_ptr<WalDir>>& dirs() const {
+    return dirs_;
+  }
+
+ private:
+  // Picks the directory in which to place a new tablet.
+  WalDir* PickDirForNewTabletUnlocked();
+
+  // Records that the WAL of 'tablet_id' is in 'dir'.
+  void AddPlacementUnlocked(const std::string& tablet_id, WalDir* dir);
+
+  Env* const env_;
+
+  std::vector<std::unique_ptr<WalDir>> dirs_;
+
+  // Protects the placements and the placement state of each WalDir.
+  mutable simple_spinlock lock_;
+
+  std::unordered_map<std::string, WalDir*> tablet_to_dir_;
+
+  // When the directories' write rates were last estimated.
+  MonoTime last_rate_estimate_;
+
+  DISALLOW_COPY_AND_ASSIGN(WalDirManager);
+};
+
+} // namespace fs
+} // namespace kudu
@@ -87,7 +87,10 @@ DECLARE_int32(num_replicas);
 DECLARE_int32(num_tablet_servers);
 DECLARE_int32(rpc_timeout);
 
+METRIC_DECLARE_entity(server);
 METRIC_DECLARE_entity(tablet);
+METRIC_DECLARE_counter(raft_heartbeats_batched);
+METRIC_DECLARE_counter(raft_pipelined_requests);
 METRIC_DECLARE_counter(transaction_memory_pressure_rejections);
 
 using kudu::client::KuduInsert;
@@ -2064,6 +2067,96 @@ TEST_F(RaftConsensusITest, TestLargeBatches) {
   ASSERT_LE(num_wals, num_batches + 2);
 }
 
+// Test that a leader pipelines requests to followers which are slow to
+// respond, and that the replicas converge nonetheless.
+TEST_F(RaftConsensusITest, TestPipelinedUpdatesWithSlowResponses) {
+  const vector<string> kTsFlags = {
+    "--consensus_max_inflight_requests_per_peer=8",
+    // Make every round trip from the leader to its followers slow.
+    "--consensus_inject_latency_ms_in_update_response=50",
+    // Keep batches small so that several are needed per round trip.
+    "--consensus_max_batch_size_bytes=16384",
+  };
+  NO_FATALS(BuildAndStart(kTsFlags));
+
+  TServerDetails* leader;
+  ASSERT_OK(GetLeaderReplicaWithRetries(tablet_id_, &leader));
+  const int leader_idx = cluster_->tablet_server_index_by_uuid(leader->uuid());
+  ASSERT_NE(-1, leader_idx);
+
+  TestWorkload workload(cluster_.get());
+  workload.set_table_name(kTableId);
+  workload.set_num_write_threads(8);
+  workload.set_payload_bytes(1024);
+  workload.Setup();
+  workload.Start();
+  while (workload.rows_inserted() < 5000) {
+    SleepFor(MonoDelta::FromMilliseconds(100));
+  }
+  workload.StopAndJoin();
+
+  ClusterVerifier v(cluster_.get());
+  NO_FATALS(v.CheckCluster());
+  NO_FATALS(v.CheckRowCount(workload.table_name(),
+                            ClusterVerifier::AT_LEAST,
+                            workload.rows_inserted()));
+
+  // The leader should have sent requests while others were in flight.
+  int64_t num_pipelined = 0;
+  ASSERT_OK(GetInt64Metric(
+      cluster_->tablet_server(leader_idx)->bound_http_hostport(),
+      &METRIC_ENTITY_tablet,
+      tablet_id_.c_str(),
+      &METRIC_raft_pipelined_requests,
+      "value",
+      &num_pipelined));
+  ASSERT_GT(num_pipelined, 0);
+}
+
+// Test that heartbeats are batched by destination server when requested, and
+// that replication carries on as usual alongside them.
+TEST_F(RaftConsensusITest, TestBatchedHeartbeats) {
+  const vector<string> kTsFlags = {
+    "--enable_multi_raft_heartbeat_batcher",
+    "--multi_raft_heartbeat_window_ms=10",
+    "--raft_heartbeat_interval_ms=100",
+  };
+  NO_FATALS(BuildAndStart(kTsFlags));
+
+  TServerDetails* leader;
+  ASSERT_OK(GetLeaderReplicaWithRetries(tablet_id_, &leader));
+  const int leader_idx = cluster_->tablet_server_index_by_uuid(leader->uuid());
+  ASSERT_NE(-1, leader_idx);
+
+  TestWorkload workload(cluster_.get());
+  workload.set_table_name(kTableId);
+  workload.Setup();
+  workload.Start();
+  while (workload.rows_inserted() < 1000) {
+    SleepFor(MonoDelta::FromMilliseconds(100));
+  }
+  workload.StopAndJoin();
+
+  ClusterVerifier v(cluster_.get());
+  NO_FATALS(v.CheckCluster());
+  NO_FATALS(v.CheckRowCount(workload.table_name(),
+                            ClusterVerifier::AT_LEAST,
+                            workload.rows_inserted()));
+
+  // The leader's idle heartbeats should have gone through the batcher.
+  ASSERT_EVENTUALLY([&]() {
+    int64_t num_batched = 0;
+    ASSERT_OK(GetInt64Metric(
+        cluster_->tablet_server(leader_idx)->bound_http_hostport(),
+        &METRIC_ENTITY_server,
+        nullptr,
+        &METRIC_raft_heartbeats_batched,
+        "value",
+        &num_batched));
+    ASSERT_GT(num_batched, 0);
+  });
+}
+
 
 // Regression test for KUDU-1469, a case in which a leader and follower could get "stuck"
 // in a tight RPC loop, in which the leader would repeatedly send a batch of ops that the
@@ -167,7 +167,8 @@ Status Master::StartAsync() {
       this, catalog_manager_.get()));
 
   RETURN_NOT_OK(RegisterService(std::move(impl)));
-  RETURN_NOT_OK(RegisterService(std::move(consensus_service)));
+  RETURN_NOT_OK(RegisterService(std::move(consensus_service),
+                                ConsensusServiceImpl::PoolOptions()));
   RETURN_NOT_OK(RegisterService(std::move(tablet_copy_service)));
   RETURN_NOT_OK(KuduServer::Start());
 
@@ -39,6 +39,7 @@
 #include "kudu/rpc/blocking_ops.h"
 #include "kudu/rpc/constants.h"
 #include "kudu/rpc/messenger.h"
+#include "kudu/rpc/negotiation.h"
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/sasl_common.h"
 #include "kudu/rpc/sasl_helper.h"
@@ -52,6 +53,8 @@
 #include "kudu/util/slice.h"
 #include "kudu/util/trace.h"
 
+DECLARE_bool(rpc_compression);
+
 using std::map;
 using std::set;
 using std::string;
@@ -59,8 +62,6 @@ using std::unique_ptr;
 
 using strings::Substitute;
 
-DECLARE_bool(rpc_encrypt_loopback_connections);
-
 namespace kudu {
 namespace rpc {
 
@@ -309,12 +310,16 @@ Status ClientNegotiation::SendNegotiate() {
 
   if (encryption_ != RpcEncryption::DISABLED) {
     client_features_.insert(TLS);
-    // If the remote peer is local, then we allow using TLS for authentication
-    // without encryption or integrity.
-    if (socket_->IsLoopbackConnection() && !FLAGS_rpc_encrypt_loopback_connections) {
+    // If the remote peer is local or in a subnet exempted from encryption,
+    // then we allow using TLS for authentication without encryption or
+    // integrity.
+    if (Negotiation::IsEncryptionExempt(*socket_)) {
       client_features_.insert(TLS_AUTHENTICATION_ONLY);
     }
   }
+  if (FLAGS_rpc_compression) {
+    client_features_.insert(COMPRESSION);
+  }
 
   for (RpcFeatureFlag feature : client_features_) {
     msg.add_supported_features(feature);
@@ -17,9 +17,13 @@
 
 #include "kudu/rpc/connection.h"
 
+#include <sys/uio.h>
+
 #include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -30,10 +34,12 @@
 #include <boost/intrusive/detail/list_iterator.hpp>
 #include <boost/intrusive/list.hpp>
 #include <ev.h>
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/move.h"
+#include "kudu/gutil/ref_counted.h"
 #include "kudu/util/slice.h"
 #include "kudu/gutil/strings/human_readable.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -45,10 +51,13 @@
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/rpc_introspection.pb.h"
 #include "kudu/rpc/transfer.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/net/socket.h"
 #include "kudu/util/status.h"
 
+DECLARE_bool(rpc_compression);
+
 using std::function;
 using std::includes;
 using std::set;
@@ -61,6 +70,15 @@ namespace rpc {
 
 typedef OutboundCall::Phase Phase;
 
+namespace {
+
+// The maximum number of iovecs written to a socket by a single syscall.
+const int kMaxIovecsPerWrite = IOV_MAX;
+static_assert(kMaxIovecsPerWrite >= TransferLimits::kMaxPayloadSlices,
+              "the data of any transfer must fit into a single write");
+
+} // anonymous namespace
+
 ///
 /// Connection
 ///
@@ -78,6 +96,11 @@ Connection::Connection(ReactorThread *reactor_thread,
       next_call_id_(1),
       credentials_policy_(policy),
       negotiation_complete_(false),
+      compression_enabled_(false),
+      uncompressed_bytes_sent_(0),
+      compressed_bytes_sent_(0),
+      uncompressed_bytes_received_(0),
+      compressed_bytes_received_(0),
       scheduled_for_shutdown_(false) {
 }
 
@@ -335,7 +358,13 @@ void Connection::QueueOutboundCall(const shared_ptr<OutboundCall> &call) {
 
   // Serialize the actual bytes to be put on the wire.
   TransferPayload tmp_slices;
-  size_t n_slices = call->SerializeTo(&tmp_slices);
+  size_t n_slices = call->SerializeTo(&tmp_slices, compression_enabled_);
+  int64_t uncompressed_bytes;
+  int64_t compressed_bytes;
+  if (call->GetRequestCompression(&uncompressed_bytes, &compressed_bytes)) {
+    uncompressed_bytes_sent_ += uncompressed_bytes;
+    compressed_bytes_sent_ += compressed_bytes;
+  }
 
   call->SetQueued();
 
@@ -466,6 +495,12 @@ void Connection::QueueResponseForCall(gscoped_ptr<InboundCall> call) {
 
   TransferPayload tmp_slices;
   size_t n_slices = call->SerializeResponseTo(&tmp_slices);
+  int64_t uncompressed_bytes;
+  int64_t compressed_bytes;
+  if (call->GetResponseCompression(&uncompressed_bytes, &compressed_bytes)) {
+    uncompressed_bytes_sent_ += uncompressed_bytes;
+    compressed_bytes_sent_ += compressed_bytes;
+  }
 
   TransferCallbacks *cb = new ResponseTransferCallbacks(std::move(call), this);
   // After the response is sent, can delete the InboundCall object.
@@ -499,42 +534,95 @@ void Connection::ReadHandler(ev::io &watcher, int revents) {
   }
   last_activity_time_ = reactor_thread_->cur_time();
 
+  // Handling a transfer may destroy the connection, so keep it alive until
+  // we're done with it.
+  scoped_refptr<Connection> self(this);
+  faststring* read_buf = reactor_thread_->read_buffer();
+  const int32_t read_buf_size = read_buf->size();
   while (true) {
     if (!inbound_) {
       inbound_.reset(new InboundTransfer());
     }
-    Status status = inbound_->ReceiveBuffer(*socket_);
+
+    if (inbound_->bytes_remaining() >= read_buf_size) {
+      // Large transfers are received directly into their own buffer rather
+      // than copied out of the read buffer.
+      Status status = inbound_->ReceiveBuffer(*socket_);
+      reactor_thread_->RecordSocketSyscall();
+      if (PREDICT_FALSE(!status.ok())) {
+        HandleReadError(status);
+        return;
+      }
+      if (!inbound_->TransferFinished()) {
+        DVLOG(3) << ToString() << ": read is not yet finished yet.";
+        return;
+      }
+      HandleFinishedInboundTransfer();
+      return;
+    }
+
+    // Read as much as is available into the read buffer, so that several
+    // small calls which arrived together are read with a single syscall.
+    int32_t nread = 0;
+    Status status = socket_->Recv(read_buf->data(), read_buf_size, &nread);
     if (PREDICT_FALSE(!status.ok())) {
-      if (status.posix_code() == ESHUTDOWN) {
-        VLOG(1) << ToString() << " shut down by remote end.";
-      } else {
-        LOG(WARNING) << ToString() << " recv error: " << status.ToString();
+      if (Socket::IsTemporarySocketError(status.posix_code())) {
+        return;
       }
-      reactor_thread_->DestroyConnection(this, status);
+      HandleReadError(status);
       return;
     }
-    if (!inbound_->TransferFinished()) {
-      DVLOG(3) << ToString() << ": read is not yet finished yet.";
+    reactor_thread_->RecordSocketSyscall();
+    if (nread == 0) {
       return;
     }
-    DVLOG(3) << ToString() << ": finished reading " << inbound_->data().size() << " bytes";
 
-    if (direction_ == CLIENT) {
-      HandleCallResponse(std::move(inbound_));
-    } else if (direction_ == SERVER) {
-      HandleIncomingCall(std::move(inbound_));
-    } else {
-      LOG(FATAL) << "Invalid direction: " << direction_;
+    Slice data(read_buf->data(), nread);
+    while (!data.empty()) {
+      if (!inbound_) {
+        inbound_.reset(new InboundTransfer());
+      }
+      Status s = inbound_->ReceiveFromSlice(&data);
+      if (PREDICT_FALSE(!s.ok())) {
+        HandleReadError(s);
+        return;
+      }
+      if (!inbound_->TransferFinished()) {
+        DCHECK(data.empty());
+        DVLOG(3) << ToString() << ": read is not yet finished yet.";
+        break;
+      }
+      HandleFinishedInboundTransfer();
+      if (PREDICT_FALSE(!shutdown_status_.ok())) {
+        return;
+      }
+    }
+
+    if (nread < read_buf_size) {
+      // There is likely nothing more to read yet.
+      return;
     }
+  }
+}
 
-    // TODO: it would seem that it would be good to loop around and see if
-    // there is more data on the socket by trying another recv(), but it turns
-    // out that it really hurts throughput to do so. A better approach
-    // might be for each InboundTransfer to actually try to read an extra byte,
-    // and if it succeeds, then we'd copy that byte into a new InboundTransfer
-    // and loop around, since it's likely the next call also arrived at the
-    // same time.
-    break;
+void Connection::HandleReadError(const Status& status) {
+  if (status.posix_code() == ESHUTDOWN) {
+    VLOG(1) << ToString() << " shut down by remote end.";
+  } else {
+    LOG(WARNING) << ToString() << " recv error: " << status.ToString();
+  }
+  reactor_thread_->DestroyConnection(this, status);
+}
+
+void Connection::HandleFinishedInboundTransfer() {
+  DVLOG(3) << ToString() << ": finished reading " << inbound_->data().size() << " bytes";
+  reactor_thread_->RecordTransfer();
+  if (direction_ == CLIENT) {
+    HandleCallResponse(std::move(inbound_));
+  } else if (direction_ == SERVER) {
+    HandleIncomingCall(std::move(inbound_));
+  } else {
+    LOG(FATAL) << "Invalid direction: " << direction_;
   }
 }
 
@@ -549,6 +637,12 @@ void Connection::HandleIncomingCall(gscoped_ptr<InboundTransfer> transfer) {
     // "unsynchronized"
     return;
   }
+  int64_t uncompressed_bytes;
+  int64_t compressed_bytes;
+  if (call->GetRequestCompression(&uncompressed_bytes, &compressed_bytes)) {
+    uncompressed_bytes_received_ += uncompressed_bytes;
+    compressed_bytes_received_ += compressed_bytes;
+  }
 
   if (!InsertIfNotPresent(&calls_being_handled_, call->call_id(), call.get())) {
     LOG(WARNING) << ToString() << ": received call ID " << call->call_id() <<
@@ -566,6 +660,12 @@ void Connection::HandleCallResponse(gscoped_ptr<InboundTransfer> transfer) {
   DCHECK(reactor_thread_->IsCurrentThread());
   gscoped_ptr<CallResponse> resp(new CallResponse);
   CHECK_OK(resp->ParseFrom(std::move(transfer)));
+  int64_t uncompressed_bytes;
+  int64_t compressed_bytes;
+  if (resp->GetCompression(&uncompressed_bytes, &compressed_bytes)) {
+    uncompressed_bytes_received_ += uncompressed_bytes;
+    compressed_bytes_received_ += compressed_bytes;
+  }
 
   CallAwaitingResponse *car_ptr =
     EraseKeyReturnValuePtr(&awaiting_response_, resp->call_id());
@@ -601,7 +701,6 @@ void Connection::WriteHandler(ev::io &watcher, int revents) {
   }
   DVLOG(3) << ToString() << ": writeHandler: revents = " << revents;
 
-  OutboundTransfer *transfer;
   if (outbound_transfers_.empty()) {
     LOG(WARNING) << ToString() << " got a ready-to-write callback, but there is "
       "nothing to write.";
@@ -609,63 +708,62 @@ void Connection::WriteHandler(ev::io &watcher, int revents) {
     return;
   }
 
+  struct iovec iov[kMaxIovecsPerWrite];
   while (!outbound_transfers_.empty()) {
-    transfer = &(outbound_transfers_.front());
-
-    if (!transfer->TransferStarted()) {
-
-      if (transfer->is_for_outbound_call()) {
-        CallAwaitingResponse* car = FindOrDie(awaiting_response_, transfer->call_id());
-        if (!car->call) {
-          // If the call has already timed out or has already been cancelled, the 'call'
-          // field would be set to NULL. In that case, don't bother sending it.
-          outbound_transfers_.pop_front();
-          transfer->Abort(Status::Aborted("already timed out or cancelled"));
-          delete transfer;
-          continue;
-        }
-
-        // If this is the start of the transfer, then check if the server has the
-        // required RPC flags. We have to wait until just before the transfer in
-        // order to ensure that the negotiation has taken place, so that the flags
-        // are available.
-        const set<RpcFeatureFlag>& required_features = car->call->required_rpc_features();
-        if (!includes(remote_features_.begin(), remote_features_.end(),
-                      required_features.begin(), required_features.end())) {
-          outbound_transfers_.pop_front();
-          Status s = Status::NotSupported("server does not support the required RPC features");
-          transfer->Abort(s);
-          Phase phase = negotiation_complete_ ? Phase::REMOTE_CALL : Phase::CONNECTION_NEGOTIATION;
-          car->call->SetFailed(std::move(s), phase);
-          // Test cancellation when 'call_' is in 'FINISHED_ERROR' state.
-          MaybeInjectCancellation(car->call);
-          car->call.reset();
-          delete transfer;
-          continue;
-        }
-
-        car->call->SetSending();
-
-        // Test cancellation when 'call_' is in 'SENDING' state.
-        MaybeInjectCancellation(car->call);
+    // Gather the data of as many of the pending transfers as fit, so that
+    // small transfers such as heartbeats and their responses are written
+    // with a single syscall.
+    int n_iovecs = 0;
+    int n_transfers = 0;
+    auto it = outbound_transfers_.begin();
+    while (it != outbound_transfers_.end()) {
+      OutboundTransfer* transfer = &*it;
+      int n = transfer->FillIovecs(&iov[n_iovecs], kMaxIovecsPerWrite - n_iovecs);
+      if (n == 0) {
+        break;
+      }
+      if (!transfer->TransferStarted() && !StartOutboundTransfer(transfer)) {
+        it = outbound_transfers_.erase(it);
+        delete transfer;
+        continue;
       }
+      n_iovecs += n;
+      n_transfers++;
+      ++it;
+    }
+    if (n_transfers == 0) {
+      // All the gathered transfers were aborted.
+      continue;
     }
 
     last_activity_time_ = reactor_thread_->cur_time();
-    Status status = transfer->SendBuffer(*socket_);
+    int32_t written = 0;
+    Status status = socket_->Writev(iov, n_iovecs, &written);
     if (PREDICT_FALSE(!status.ok())) {
+      if (Socket::IsTemporarySocketError(status.posix_code())) {
+        DVLOG(3) << ToString() << ": writeHandler: socket not ready.";
+        return;
+      }
       LOG(WARNING) << ToString() << " send error: " << status.ToString();
       reactor_thread_->DestroyConnection(this, status);
       return;
     }
-
-    if (!transfer->TransferFinished()) {
-      DVLOG(3) << ToString() << ": writeHandler: xfer not finished.";
-      return;
+    reactor_thread_->RecordSocketSyscall();
+
+    // Account for what was written, completing the transfers which were
+    // entirely sent.
+    for (int i = 0; i < n_transfers; i++) {
+      OutboundTransfer* transfer = &outbound_transfers_.front();
+      transfer->AdvanceWritten(&written);
+      if (!transfer->TransferFinished()) {
+        DVLOG(3) << ToString() << ": writeHandler: xfer not finished.";
+        return;
+      }
+      outbound_transfers_.pop_front();
+      delete transfer;
+      reactor_thread_->RecordTransfer();
     }
-
-    outbound_transfers_.pop_front();
-    delete transfer;
+    DCHECK_EQ(0, written);
   }
 
   // If we were able to write all of our outbound transfers,
@@ -673,6 +771,42 @@ void Connection::WriteHandler(ev::io &watcher, int revents) {
   write_io_.stop();
 }
 
+bool Connection::StartOutboundTransfer(OutboundTransfer* transfer) {
+  if (!transfer->is_for_outbound_call()) {
+    return true;
+  }
+  CallAwaitingResponse* car = FindOrDie(awaiting_response_, transfer->call_id());
+  if (!car->call) {
+    // If the call has already timed out or has already been cancelled, the 'call'
+    // field would be set to NULL. In that case, don't bother sending it.
+    transfer->Abort(Status::Aborted("already timed out or cancelled"));
+    return false;
+  }
+
+  // If this is the start of the transfer, then check if the server has the
+  // required RPC flags. We have to wait until just before the transfer in
+  // order to ensure that the negotiation has taken place, so that the flags
+  // are available.
+  const set<RpcFeatureFlag>& required_features = car->call->required_rpc_features();
+  if (!includes(remote_features_.begin(), remote_features_.end(),
+                required_features.begin(), required_features.end())) {
+    Status s = Status::NotSupported("server does not support the required RPC features");
+    transfer->Abort(s);
+    Phase phase = negotiation_complete_ ? Phase::REMOTE_CALL : Phase::CONNECTION_NEGOTIATION;
+    car->call->SetFailed(std::move(s), phase);
+    // Test cancellation when 'call_' is in 'FINISHED_ERROR' state.
+    MaybeInjectCancellation(car->call);
+    car->call.reset();
+    return false;
+  }
+
+  car->call->SetSending();
+
+  // Test cancellation when 'call_' is in 'SENDING' state.
+  MaybeInjectCancellation(car->call);
+  return true;
+}
+
 std::string Connection::ToString() const {
   // This may be called from other threads, so we cannot
   // include anything in the output about the current state,
@@ -725,6 +859,10 @@ void Connection::CompleteNegotiation(Status negotiation_status,
 void Connection::MarkNegotiationComplete() {
   DCHECK(reactor_thread_->IsCurrentThread());
   negotiation_complete_ = true;
+  // We advertise COMPRESSION only if --rpc_compression is set, so both sides
+  // agreed to it if the remote advertised it too.
+  compression_enabled_ = FLAGS_rpc_compression &&
+      ContainsKey(remote_features_, COMPRESSION);
 }
 
 Status Connection::DumpPB(const DumpRunningRpcsRequestPB& req,
@@ -736,6 +874,12 @@ Status Connection::DumpPB(const DumpRunningRpcsRequestPB& req,
   } else {
     resp->set_state(RpcConnectionPB::NEGOTIATING);
   }
+  if (compression_enabled_) {
+    resp->set_uncompressed_bytes_sent(uncompressed_bytes_sent_);
+    resp->set_compressed_bytes_sent(compressed_bytes_sent_);
+    resp->set_uncompressed_bytes_received(uncompressed_bytes_received_);
+    resp->set_compressed_bytes_received(compressed_bytes_received_);
+  }
 
   if (direction_ == CLIENT) {
     for (const car_map_t::value_type& entry : awaiting_response_) {
@@ -18,6 +18,7 @@
 #ifndef KUDU_RPC_CONNECTION_H
 #define KUDU_RPC_CONNECTION_H
 
+#include <atomic>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -185,6 +186,13 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // Indicate that negotiation is complete and that the Reactor is now in control of the socket.
   void MarkNegotiationComplete();
 
+  // Whether call and response payloads on this connection may be compressed,
+  // i.e. both sides advertised the COMPRESSION feature. Set when negotiation
+  // completes; calls queued before that are sent uncompressed.
+  bool compression_enabled() const {
+    return compression_enabled_;
+  }
+
   Status DumpPB(const DumpRunningRpcsRequestPB& req,
                 RpcConnectionPB* resp);
 
@@ -264,6 +272,18 @@ class Connection : public RefCountedThreadSafe<Connection> {
     return call_id;
   }
 
+  // Destroys the connection after failing to read from its socket.
+  void HandleReadError(const Status& status);
+
+  // Hands 'inbound_', which has finished transferring, off to either
+  // HandleIncomingCall() or HandleCallResponse().
+  void HandleFinishedInboundTransfer();
+
+  // Checks whether the outbound call of 'transfer', if any, should still be
+  // sent, and marks it as being sent if so. Otherwise, aborts 'transfer' and
+  // returns false, in which case the caller must dispose of it.
+  bool StartOutboundTransfer(OutboundTransfer* transfer);
+
   // An incoming packet has completed transferring on the server side.
   // This parses the call and delivers it into the call queue.
   void HandleIncomingCall(gscoped_ptr<InboundTransfer> transfer);
@@ -364,6 +384,17 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // Whether we completed connection negotiation.
   bool negotiation_complete_;
 
+  // See compression_enabled().
+  bool compression_enabled_;
+
+  // Total sizes of the payloads which were compressed on this connection,
+  // before and after compression. Responses are serialized by the threads
+  // responding to calls, hence atomics.
+  std::atomic<int64_t> uncompressed_bytes_sent_;
+  std::atomic<int64_t> compressed_bytes_sent_;
+  std::atomic<int64_t> uncompressed_bytes_received_;
+  std::atomic<int64_t> compressed_bytes_received_;
+
   // Whether the connection is scheduled for shutdown.
   bool scheduled_for_shutdown_;
 };
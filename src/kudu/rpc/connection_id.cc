@@ -30,14 +30,15 @@ using std::string;
 namespace kudu {
 namespace rpc {
 
-ConnectionId::ConnectionId() {}
+ConnectionId::ConnectionId() : connection_index_(0) {}
 
 ConnectionId::ConnectionId(const Sockaddr& remote,
                            std::string hostname,
                            UserCredentials user_credentials)
     : remote_(remote),
       hostname_(std::move(hostname)),
-      user_credentials_(std::move(user_credentials)) {
+      user_credentials_(std::move(user_credentials)),
+      connection_index_(0) {
   CHECK(!hostname_.empty());
 }
 
@@ -45,6 +46,11 @@ void ConnectionId::set_user_credentials(UserCredentials user_credentials) {
   user_credentials_ = std::move(user_credentials);
 }
 
+void ConnectionId::set_connection_index(int idx) {
+  DCHECK_GE(idx, 0);
+  connection_index_ = idx;
+}
+
 string ConnectionId::ToString() const {
   string remote;
   if (hostname_ != remote_.host()) {
@@ -53,6 +59,12 @@ string ConnectionId::ToString() const {
     remote = remote_.ToString();
   }
 
+  if (connection_index_ != 0) {
+    return strings::Substitute("{remote=$0, user_credentials=$1, connection_index=$2}",
+                               remote,
+                               user_credentials_.ToString(),
+                               connection_index_);
+  }
   return strings::Substitute("{remote=$0, user_credentials=$1}",
                              remote,
                              user_credentials_.ToString());
@@ -63,13 +75,15 @@ size_t ConnectionId::HashCode() const {
   boost::hash_combine(seed, remote_.HashCode());
   boost::hash_combine(seed, hostname_);
   boost::hash_combine(seed, user_credentials_.HashCode());
+  boost::hash_combine(seed, connection_index_);
   return seed;
 }
 
 bool ConnectionId::Equals(const ConnectionId& other) const {
   return remote() == other.remote() &&
       hostname_ == other.hostname_ &&
-      user_credentials().Equals(other.user_credentials());
+      user_credentials().Equals(other.user_credentials()) &&
+      connection_index_ == other.connection_index_;
 }
 
 size_t ConnectionIdHash::operator() (const ConnectionId& conn_id) const {
@@ -50,6 +50,12 @@ class ConnectionId {
 
   const UserCredentials& user_credentials() const { return user_credentials_; }
 
+  // Distinguishes the connections a messenger keeps in parallel to the same
+  // remote with the same credentials. See --rpc_connections_per_peer.
+  void set_connection_index(int idx);
+
+  int connection_index() const { return connection_index_; }
+
   // Copy state from another object to this one.
   void CopyFrom(const ConnectionId& other);
 
@@ -68,6 +74,8 @@ class ConnectionId {
   std::string hostname_;
 
   UserCredentials user_credentials_;
+
+  int connection_index_;
 };
 
 class ConnectionIdHash {
@@ -19,11 +19,15 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <ostream>
+#include <utility>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <google/protobuf/message.h>
 #include <google/protobuf/message_lite.h>
+#include <google/protobuf/io/coded_stream.h>
 
 #include "kudu/gutil/move.h"
 #include "kudu/gutil/port.h"
@@ -36,6 +40,9 @@
 #include "kudu/rpc/service_if.h"
 #include "kudu/rpc/transfer.h"
 #include "kudu/util/debug/trace_event.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/trace.h"
@@ -46,9 +53,18 @@ class FieldDescriptor;
 }
 }
 
+DEFINE_int32(rpc_response_buffer_pool_size, 1024,
+             "The maximum number of buffers kept around for serializing RPC "
+             "responses into, rather than being allocated for every response.");
+TAG_FLAG(rpc_response_buffer_pool_size, advanced);
+
+DECLARE_int32(rpc_compression_max_response_bytes);
+DECLARE_int32(rpc_compression_min_bytes);
+
 using google::protobuf::FieldDescriptor;
 using google::protobuf::Message;
 using google::protobuf::MessageLite;
+using google::protobuf::io::CodedOutputStream;
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -57,6 +73,53 @@ using strings::Substitute;
 namespace kudu {
 namespace rpc {
 
+namespace {
+
+// A pool of the buffers that responses are serialized into. Those are small
+// and needed for every call, so they are reused rather than allocated and
+// freed each time. Buffers are taken by the threads responding to calls and
+// given back by the reactor threads once the responses are sent, so the pool
+// is shared by all threads rather than thread-local.
+class ResponseBufferPool {
+ public:
+  unique_ptr<faststring> Get() {
+    {
+      std::lock_guard<simple_spinlock> l(lock_);
+      if (!buffers_.empty()) {
+        unique_ptr<faststring> buf = std::move(buffers_.back());
+        buffers_.pop_back();
+        return buf;
+      }
+    }
+    return unique_ptr<faststring>(new faststring());
+  }
+
+  void Put(unique_ptr<faststring> buf) {
+    // Don't hold on to the rare large responses.
+    if (buf->capacity() > kMaxPooledBufferBytes) {
+      return;
+    }
+    buf->clear();
+    std::lock_guard<simple_spinlock> l(lock_);
+    if (static_cast<int64_t>(buffers_.size()) < FLAGS_rpc_response_buffer_pool_size) {
+      buffers_.emplace_back(std::move(buf));
+    }
+  }
+
+ private:
+  static constexpr size_t kMaxPooledBufferBytes = 64 * 1024;
+
+  simple_spinlock lock_;
+  vector<unique_ptr<faststring>> buffers_;
+};
+
+ResponseBufferPool* GetResponseBufferPool() {
+  static ResponseBufferPool* pool = new ResponseBufferPool();
+  return pool;
+}
+
+} // anonymous namespace
+
 InboundCall::InboundCall(Connection* conn)
   : conn_(conn),
     trace_(new Trace),
@@ -64,7 +127,11 @@ InboundCall::InboundCall(Connection* conn)
   RecordCallReceived();
 }
 
-InboundCall::~InboundCall() {}
+InboundCall::~InboundCall() {
+  if (response_buf_) {
+    GetResponseBufferPool()->Put(std::move(response_buf_));
+  }
+}
 
 Status InboundCall::ParseFrom(gscoped_ptr<InboundTransfer> transfer) {
   TRACE_EVENT_FLOW_BEGIN0("rpc", "InboundCall", this);
@@ -87,15 +154,41 @@ Status InboundCall::ParseFrom(gscoped_ptr<InboundTransfer> transfer) {
             header_.sidecar_offsets_size(), TransferLimits::kMaxSidecars));
   }
 
+  // Retain the buffer that we have a view into.
+  transfer_.swap(transfer);
+
+  if (header_.has_uncompressed_size()) {
+    if (PREDICT_FALSE(!conn_->compression_enabled())) {
+      return Status::Corruption("Compressed request on a connection without compression");
+    }
+    // The payload is uncompressed by UncompressRequest() on a service thread
+    // rather than here, on the reactor thread.
+    compressed_request_size_ = CodedOutputStream::VarintSize32(serialized_request_.size()) +
+        serialized_request_.size();
+    return Status::OK();
+  }
+  return ParseSidecars();
+}
+
+Status InboundCall::UncompressRequest() {
+  if (!header_.has_uncompressed_size()) {
+    return Status::OK();
+  }
+  TRACE_EVENT0("rpc", "InboundCall::UncompressRequest");
+  DCHECK_EQ(0, uncompressed_request_buf_.size());
+  RETURN_NOT_OK(serialization::UncompressMessage(
+      serialized_request_, header_.uncompressed_size(), &uncompressed_request_buf_));
+  serialized_request_ = Slice(uncompressed_request_buf_);
+  return ParseSidecars();
+}
+
+Status InboundCall::ParseSidecars() {
   RETURN_NOT_OK(RpcSidecar::ParseSidecars(
           header_.sidecar_offsets(), serialized_request_, inbound_sidecar_slices_));
   if (header_.sidecar_offsets_size() > 0) {
     // Trim the request to just the message
     serialized_request_ = Slice(serialized_request_.data(), header_.sidecar_offsets(0));
   }
-
-  // Retain the buffer that we have a view into.
-  transfer_.swap(transfer);
   return Status::OK();
 }
 
@@ -184,22 +277,48 @@ void InboundCall::SerializeResponseBuffer(const MessageLite& response,
   }
 
   int additional_size = absolute_sidecar_offset - protobuf_msg_size;
-  serialization::SerializeMessage(response, &response_msg_buf_,
-                                  additional_size, true);
-  int main_msg_size = additional_size + response_msg_buf_.size();
-  serialization::SerializeHeader(resp_hdr, main_msg_size,
-                                 &response_hdr_buf_);
+  if (!response_buf_) {
+    response_buf_ = GetResponseBufferPool()->Get();
+  }
+  if (conn_->compression_enabled() &&
+      absolute_sidecar_offset >= FLAGS_rpc_compression_min_bytes &&
+      absolute_sidecar_offset <= FLAGS_rpc_compression_max_response_bytes) {
+    // Serialize the message on its own first, then replace it with the header
+    // once it has been compressed along with the sidecars.
+    serialization::SerializeMessage(response, response_buf_.get(), additional_size, true);
+    vector<Slice> sidecar_slices;
+    sidecar_slices.reserve(outbound_sidecars_.size());
+    for (const unique_ptr<RpcSidecar>& car : outbound_sidecars_) {
+      sidecar_slices.emplace_back(car->AsSlice());
+    }
+    if (serialization::CompressMessage(Slice(*response_buf_), sidecar_slices,
+                                       &compressed_response_buf_, &compressed_response_,
+                                       &uncompressed_response_size_)) {
+      resp_hdr.set_uncompressed_size(uncompressed_response_size_);
+      serialization::SerializeHeader(resp_hdr, compressed_response_.size(),
+                                     response_buf_.get());
+      return;
+    }
+    compressed_response_.clear();
+  }
+  serialization::SerializeHeaderAndMessage(resp_hdr, response, additional_size,
+                                           response_buf_.get());
 }
 
 size_t InboundCall::SerializeResponseTo(TransferPayload* slices) const {
   TRACE_EVENT0("rpc", "InboundCall::SerializeResponseTo");
-  DCHECK_GT(response_hdr_buf_.size(), 0);
-  DCHECK_GT(response_msg_buf_.size(), 0);
-  size_t n_slices = 2 + outbound_sidecars_.size();
+  DCHECK_GT(response_buf_->size(), 0);
+  if (!compressed_response_.empty()) {
+    // The sidecars are part of the compressed payload.
+    DCHECK_LE(2, slices->size());
+    (*slices)[0] = Slice(*response_buf_);
+    (*slices)[1] = compressed_response_;
+    return 2;
+  }
+  size_t n_slices = 1 + outbound_sidecars_.size();
   DCHECK_LE(n_slices, slices->size());
   auto slice_iter = slices->begin();
-  *slice_iter++ = Slice(response_hdr_buf_);
-  *slice_iter++ = Slice(response_msg_buf_);
+  *slice_iter++ = Slice(*response_buf_);
   for (auto& sidecar : outbound_sidecars_) {
     *slice_iter++ = sidecar->AsSlice();
   }
@@ -209,7 +328,7 @@ size_t InboundCall::SerializeResponseTo(TransferPayload* slices) const {
 
 Status InboundCall::AddOutboundSidecar(unique_ptr<RpcSidecar> car, int* idx) {
   // Check that the number of sidecars does not exceed the number of payload
-  // slices that are free (two are used up by the header and main message
+  // slices that are free (one is used up by the header and main message
   // protobufs).
   if (outbound_sidecars_.size() > TransferLimits::kMaxSidecars) {
     return Status::ServiceUnavailable("All available sidecars already used");
@@ -311,6 +430,10 @@ MonoTime InboundCall::GetTimeReceived() const {
   return timing_.time_received;
 }
 
+MonoTime InboundCall::GetTimeHandled() const {
+  return timing_.time_handled;
+}
+
 vector<uint32_t> InboundCall::GetRequiredFeatures() const {
   vector<uint32_t> features;
   for (uint32_t feature : header_.required_feature_flags()) {
@@ -331,11 +454,13 @@ Status InboundCall::GetInboundSidecar(int idx, Slice* sidecar) const {
 
 void InboundCall::DiscardTransfer() {
   transfer_.reset();
+  uncompressed_request_buf_.clear();
+  uncompressed_request_buf_.shrink_to_fit();
 }
 
 size_t InboundCall::GetTransferSize() {
   if (!transfer_) return 0;
-  return transfer_->data().size();
+  return transfer_->data().size() + uncompressed_request_buf_.size();
 }
 
 } // namespace rpc
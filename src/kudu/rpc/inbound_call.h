@@ -83,6 +83,12 @@ class InboundCall {
   // from the reactor thread.
   Status ParseFrom(gscoped_ptr<InboundTransfer> transfer);
 
+  // If the request payload was received compressed, uncompresses it and
+  // extracts the inbound sidecars from it. Until then, neither the sidecars
+  // nor serialized_request() are available for such calls. This is called
+  // from a service thread, so as not to hold up the reactor thread.
+  Status UncompressRequest() WARN_UNUSED_RESULT;
+
   // Return the serialized request parameter protobuf.
   const Slice& serialized_request() const {
     DCHECK(transfer_) << "Transfer discarded before parameter parsing";
@@ -130,6 +136,31 @@ class InboundCall {
   // Returns the number of slices in the serialized response.
   size_t SerializeResponseTo(TransferPayload* slices) const;
 
+  // Returns true if the request payload was received compressed, in which case
+  // 'uncompressed_bytes' and 'compressed_bytes' are set to its size before and
+  // after compression.
+  bool GetRequestCompression(int64_t* uncompressed_bytes,
+                             int64_t* compressed_bytes) const {
+    if (!header_.has_uncompressed_size()) {
+      return false;
+    }
+    *uncompressed_bytes = header_.uncompressed_size();
+    *compressed_bytes = compressed_request_size_;
+    return true;
+  }
+
+  // Like GetRequestCompression(), for the response payload serialized for the
+  // finished call.
+  bool GetResponseCompression(int64_t* uncompressed_bytes,
+                              int64_t* compressed_bytes) const {
+    if (compressed_response_.empty()) {
+      return false;
+    }
+    *uncompressed_bytes = uncompressed_response_size_;
+    *compressed_bytes = compressed_response_.size();
+    return true;
+  }
+
   // See RpcContext::AddRpcSidecar()
   Status AddOutboundSidecar(std::unique_ptr<RpcSidecar> car, int* idx);
 
@@ -190,6 +221,9 @@ class InboundCall {
   // Return the time when this call was received.
   MonoTime GetTimeReceived() const;
 
+  // Return the time when handling of this call started, if it has.
+  MonoTime GetTimeHandled() const;
+
   // Returns the set of application-specific feature flags required to service
   // the RPC.
   std::vector<uint32_t> GetRequiredFeatures() const;
@@ -198,7 +232,7 @@ class InboundCall {
   // returns an error.
   Status GetInboundSidecar(int idx, Slice* sidecar) const;
 
-  // Releases the buffer that contains the request + sidecar data. It is an error to
+  // Releases the buffers that contain the request + sidecar data. It is an error to
   // access sidecars or serialized_request() after this method is called.
   void DiscardTransfer();
 
@@ -209,6 +243,10 @@ class InboundCall {
  private:
   friend class RpczStore;
 
+  // Extracts the inbound sidecars from 'serialized_request_' and trims it to
+  // the request message.
+  Status ParseSidecars();
+
   // Serialize and queue the response.
   void Respond(const google::protobuf::MessageLite& response,
                bool is_success);
@@ -240,9 +278,23 @@ class InboundCall {
   // by 'serialized_request_' above.
   gscoped_ptr<InboundTransfer> transfer_;
 
-  // The buffers for serialized response. Set by SerializeResponseBuffer().
-  faststring response_hdr_buf_;
-  faststring response_msg_buf_;
+  // If the request payload was compressed, the size it was received with, and
+  // the uncompressed payload which 'serialized_request_' and the inbound
+  // sidecars refer into instead of 'transfer_'.
+  int64_t compressed_request_size_ = 0;
+  faststring uncompressed_request_buf_;
+
+  // The buffer for the serialized response header and message, taken from a
+  // shared pool and returned to it on destruction. Set by
+  // SerializeResponseBuffer().
+  std::unique_ptr<faststring> response_buf_;
+
+  // If the response payload was compressed by SerializeResponseBuffer(), it
+  // follows the header in 'response_buf_' as 'compressed_response_', which
+  // points into 'compressed_response_buf_'.
+  faststring compressed_response_buf_;
+  Slice compressed_response_;
+  uint32_t uncompressed_response_size_ = 0;
 
   // Vector of additional sidecars that are tacked on to the call's response
   // after serialization of the protobuf. See rpc/rpc_sidecar.h for more info.
@@ -42,6 +42,7 @@
 #include "kudu/rpc/outbound_call.h"
 #include "kudu/rpc/reactor.h"
 #include "kudu/rpc/remote_method.h"
+#include "kudu/rpc/rpc_controller.h"
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/rpc_service.h"
 #include "kudu/rpc/rpcz_store.h"
@@ -117,6 +118,39 @@ DEFINE_int32(rpc_default_keepalive_time_ms, 65000,
              "will disconnect the client.");
 TAG_FLAG(rpc_default_keepalive_time_ms, advanced);
 
+DEFINE_int32(rpc_connections_per_peer, 1,
+             "Number of connections an RPC client keeps open in parallel to each "
+             "remote server. With more than one, calls marked as bulk transfers or "
+             "with requests of at least --rpc_bulk_call_threshold_bytes are spread "
+             "over the extra connections, each of which may be handled by a "
+             "different reactor thread, so they neither delay small calls nor "
+             "limit throughput to a single reactor.");
+TAG_FLAG(rpc_connections_per_peer, advanced);
+TAG_FLAG(rpc_connections_per_peer, experimental);
+DEFINE_validator(rpc_connections_per_peer,
+                 [](const char* /*flagname*/, int32_t value) { return value >= 1; });
+
+DEFINE_int32(rpc_reactor_busy_poll_us, 0,
+             "If positive, the number of microseconds each RPC reactor thread keeps "
+             "polling for new network events and queued calls without blocking "
+             "after the last one it handled, before it goes back to sleep in "
+             "epoll_wait(). The value is also set as SO_BUSY_POLL on RPC sockets, "
+             "which takes effect only if the process has CAP_NET_ADMIN or the "
+             "value is within net.core.busy_read. Trades CPU usage for lower call "
+             "latency. Reactors that busy-poll report high reactor_load_percent.");
+TAG_FLAG(rpc_reactor_busy_poll_us, advanced);
+TAG_FLAG(rpc_reactor_busy_poll_us, experimental);
+DEFINE_validator(rpc_reactor_busy_poll_us,
+                 [](const char* /*flagname*/, int32_t value) { return value >= 0; });
+
+DEFINE_int64(rpc_bulk_call_threshold_bytes, 1024 * 1024,
+             "Outbound calls whose request, including sidecars, is at least this "
+             "many bytes are sent over the bulk connections to their remote. Only "
+             "takes effect if --rpc_connections_per_peer is greater than 1.");
+TAG_FLAG(rpc_bulk_call_threshold_bytes, advanced);
+TAG_FLAG(rpc_bulk_call_threshold_bytes, experimental);
+TAG_FLAG(rpc_bulk_call_threshold_bytes, runtime);
+
 DECLARE_string(keytab_file);
 DECLARE_bool(allow_world_readable_credentials);
 
@@ -229,6 +263,8 @@ MessengerBuilder::MessengerBuilder(std::string name)
       connection_keepalive_time_(
           MonoDelta::FromMilliseconds(FLAGS_rpc_default_keepalive_time_ms)),
       num_reactors_(4),
+      connections_per_peer_(FLAGS_rpc_connections_per_peer),
+      reactor_busy_poll_us_(FLAGS_rpc_reactor_busy_poll_us),
       min_negotiation_threads_(0),
       max_negotiation_threads_(4),
       coarse_timer_granularity_(MonoDelta::FromMilliseconds(100)),
@@ -246,6 +282,18 @@ MessengerBuilder& MessengerBuilder::set_num_reactors(int num_reactors) {
   return *this;
 }
 
+MessengerBuilder& MessengerBuilder::set_connections_per_peer(int connections_per_peer) {
+  CHECK_GE(connections_per_peer, 1);
+  connections_per_peer_ = connections_per_peer;
+  return *this;
+}
+
+MessengerBuilder& MessengerBuilder::set_reactor_busy_poll_us(int busy_poll_us) {
+  CHECK_GE(busy_poll_us, 0);
+  reactor_busy_poll_us_ = busy_poll_us;
+  return *this;
+}
+
 MessengerBuilder& MessengerBuilder::set_min_negotiation_threads(int min_negotiation_threads) {
   min_negotiation_threads_ = min_negotiation_threads;
   return *this;
@@ -456,10 +504,27 @@ Status Messenger::UnregisterService(const string& service_name) {
 }
 
 void Messenger::QueueOutboundCall(const shared_ptr<OutboundCall> &call) {
-  Reactor *reactor = RemoteToReactor(call->conn_id().remote());
+  if (connections_per_peer_ > 1) {
+    call->set_connection_index(ConnectionIndexForCall(*call));
+  }
+  Reactor *reactor = RemoteToReactor(call->conn_id().remote(),
+                                     call->conn_id().connection_index());
   reactor->QueueOutboundCall(call);
 }
 
+int Messenger::ConnectionIndexForCall(const OutboundCall& call) {
+  DCHECK_GT(connections_per_peer_, 1);
+  // Connection 0 is reserved for small calls, such as consensus heartbeats,
+  // which must not wait behind a large transfer on the same socket. Bulk calls
+  // are handed out round-robin over the remaining connections.
+  if (!call.controller()->bulk_transfer() &&
+      call.request_payload_size() < FLAGS_rpc_bulk_call_threshold_bytes) {
+    return 0;
+  }
+  uint32_t n = next_bulk_connection_.fetch_add(1, std::memory_order_relaxed);
+  return 1 + n % (connections_per_peer_ - 1);
+}
+
 void Messenger::QueueInboundCall(gscoped_ptr<InboundCall> call) {
   shared_lock<rw_spinlock> guard(lock_.get_lock());
   scoped_refptr<RpcService>* service = FindOrNull(rpc_services_,
@@ -479,7 +544,8 @@ void Messenger::QueueInboundCall(gscoped_ptr<InboundCall> call) {
 }
 
 void Messenger::QueueCancellation(const shared_ptr<OutboundCall> &call) {
-  Reactor *reactor = RemoteToReactor(call->conn_id().remote());
+  Reactor *reactor = RemoteToReactor(call->conn_id().remote(),
+                                     call->conn_id().connection_index());
   reactor->QueueCancellation(call);
 }
 
@@ -498,6 +564,8 @@ Messenger::Messenger(const MessengerBuilder &bld)
     rpcz_store_(new RpczStore()),
     metric_entity_(bld.metric_entity_),
     sasl_proto_name_(bld.sasl_proto_name_),
+    connections_per_peer_(bld.connections_per_peer_),
+    next_bulk_connection_(0),
     retain_self_(this) {
   for (int i = 0; i < bld.num_reactors_; i++) {
     reactors_.push_back(new Reactor(retain_self_, i, bld));
@@ -518,9 +586,10 @@ Messenger::~Messenger() {
   STLDeleteElements(&reactors_);
 }
 
-Reactor* Messenger::RemoteToReactor(const Sockaddr &remote) {
+Reactor* Messenger::RemoteToReactor(const Sockaddr &remote, int conn_idx) {
   uint32_t hashCode = remote.HashCode();
-  int reactor_idx = hashCode % reactors_.size();
+  // Parallel connections to the same remote land on consecutive reactors.
+  int reactor_idx = (hashCode + conn_idx) % reactors_.size();
   // This is just a static partitioning; we could get a lot
   // fancier with assigning Sockaddrs to Reactors.
   return reactors_[reactor_idx];
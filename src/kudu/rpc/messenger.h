@@ -17,6 +17,7 @@
 #ifndef KUDU_RPC_MESSENGER_H
 #define KUDU_RPC_MESSENGER_H
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -107,6 +108,15 @@ class MessengerBuilder {
   // receiving.
   MessengerBuilder &set_num_reactors(int num_reactors);
 
+  // Set the number of connections kept open in parallel to each remote server.
+  // Defaults to --rpc_connections_per_peer.
+  MessengerBuilder &set_connections_per_peer(int connections_per_peer);
+
+  // Set the number of microseconds each reactor thread busy-polls for new
+  // events before blocking, which is also set as SO_BUSY_POLL on its sockets.
+  // 0 disables busy-polling. Defaults to --rpc_reactor_busy_poll_us.
+  MessengerBuilder &set_reactor_busy_poll_us(int busy_poll_us);
+
   // Set the minimum number of connection-negotiation threads that will be used
   // to handle the blocking connection-negotiation step.
   MessengerBuilder &set_min_negotiation_threads(int min_negotiation_threads);
@@ -133,6 +143,8 @@ class MessengerBuilder {
   const std::string name_;
   MonoDelta connection_keepalive_time_;
   int num_reactors_;
+  int connections_per_peer_;
+  int reactor_busy_poll_us_;
   int min_negotiation_threads_;
   int max_negotiation_threads_;
   MonoDelta coarse_timer_granularity_;
@@ -274,10 +286,19 @@ class Messenger {
   FRIEND_TEST(TestRpc, TestConnectionKeepalive);
   FRIEND_TEST(TestRpc, TestCredentialsPolicy);
   FRIEND_TEST(TestRpc, TestReopenOutboundConnections);
+  FRIEND_TEST(TestRpc, TestReactorSyscallMetrics);
+  FRIEND_TEST(TestRpc, TestConnectionsPerPeer);
 
   explicit Messenger(const MessengerBuilder &bld);
 
-  Reactor* RemoteToReactor(const Sockaddr &remote);
+  // Returns the reactor handling the connection to 'remote' with index
+  // 'conn_idx' (see ConnectionId::connection_index()).
+  Reactor* RemoteToReactor(const Sockaddr &remote, int conn_idx = 0);
+
+  // Picks which of the parallel connections to its remote 'call' is sent on,
+  // based on its size and whether it's marked as a bulk transfer.
+  int ConnectionIndexForCall(const OutboundCall& call);
+
   Status Init();
   void RunTimeoutThread();
   void UpdateCurTime();
@@ -341,6 +362,12 @@ class Messenger {
   // The SASL protocol name that is used for the SASL negotiation.
   const std::string sasl_proto_name_;
 
+  // Number of connections kept open in parallel to each remote server.
+  const int connections_per_peer_;
+
+  // Counter used to spread bulk calls over their remote's bulk connections.
+  std::atomic<uint32_t> next_bulk_connection_;
+
   // The ownership of the Messenger object is somewhat subtle. The pointer graph
   // looks like this:
   //
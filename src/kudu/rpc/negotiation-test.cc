@@ -84,6 +84,7 @@ DEFINE_bool(is_test_child, false,
             "See TestDisableInit.");
 DECLARE_bool(rpc_encrypt_loopback_connections);
 DECLARE_bool(rpc_trace_negotiation);
+DECLARE_string(rpc_unencrypted_subnets);
 
 using std::string;
 using std::thread;
@@ -1129,6 +1130,20 @@ TEST_F(TestNegotiation, TestGSSAPIInvalidNegotiation) {
 }
 #endif
 
+// Test that only peers within --rpc_unencrypted_subnets are exempted from
+// encryption after TLS authentication.
+TEST_F(TestNegotiation, TestEncryptionExemptSubnets) {
+  // Reports 8.8.8.8 as the peer address.
+  NegotiationTestSocket socket;
+  ASSERT_FALSE(Negotiation::IsEncryptionExempt(socket));
+
+  FLAGS_rpc_unencrypted_subnets = "10.0.0.0/8";
+  ASSERT_FALSE(Negotiation::IsEncryptionExempt(socket));
+
+  FLAGS_rpc_unencrypted_subnets = "10.0.0.0/8,8.8.0.0/16";
+  ASSERT_TRUE(Negotiation::IsEncryptionExempt(socket));
+}
+
 #ifndef __APPLE__
 // Test that the pre-flight check for servers requiring Kerberos provides
 // nice error messages for missing or bad keytabs.
@@ -20,12 +20,14 @@
 #include <poll.h>
 #include <sys/socket.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <ctime>
 #include <memory>
 #include <ostream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <boost/optional/optional.hpp>
 #include <gflags/gflags.h>
@@ -49,6 +51,8 @@
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/net/net_util.h"
+#include "kudu/util/net/sockaddr.h"
 #include "kudu/util/net/socket.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
@@ -76,8 +80,55 @@ DEFINE_bool(rpc_encrypt_loopback_connections, false,
             "an attacker.");
 TAG_FLAG(rpc_encrypt_loopback_connections, advanced);
 
+DEFINE_string(rpc_unencrypted_subnets, "",
+              "Comma-separated list of subnets, in CIDR notation, within which "
+              "RPC connections use TLS to authenticate the peer but then transfer "
+              "data unencrypted, as is done for loopback connections. Only takes "
+              "effect for a connection when each side finds the other's address "
+              "in its list. Intended for physically secured networks where the "
+              "cost of wire encryption outweighs its benefit.");
+TAG_FLAG(rpc_unencrypted_subnets, advanced);
+TAG_FLAG(rpc_unencrypted_subnets, experimental);
+
+static bool ValidateUnencryptedSubnets(const char* /*flagname*/, const std::string& value) {
+  std::vector<kudu::Network> networks;
+  kudu::Status s = kudu::Network::ParseCIDRStrings(value, &networks);
+  if (!s.ok()) {
+    LOG(ERROR) << "Invalid --rpc_unencrypted_subnets: " << s.ToString();
+    return false;
+  }
+  return true;
+}
+DEFINE_validator(rpc_unencrypted_subnets, &ValidateUnencryptedSubnets);
+
+DEFINE_bool(rpc_compression, false,
+            "Whether to offer compression of RPC payloads to peers. If both sides "
+            "of a connection offer it, calls and responses whose message and "
+            "sidecars amount to at least --rpc_compression_min_bytes are sent "
+            "LZ4-compressed. Useful where network bandwidth rather than CPU is "
+            "the bottleneck.");
+TAG_FLAG(rpc_compression, experimental);
+
+DEFINE_int32(rpc_compression_min_bytes, 64 * 1024,
+             "The minimum size of the message and sidecars of an RPC call or "
+             "response for it to be compressed, on connections which use "
+             "compression. See --rpc_compression.");
+TAG_FLAG(rpc_compression_min_bytes, advanced);
+TAG_FLAG(rpc_compression_min_bytes, experimental);
+TAG_FLAG(rpc_compression_min_bytes, runtime);
+
+DEFINE_int32(rpc_compression_max_response_bytes, 1024 * 1024,
+             "The maximum size of the message and sidecars of an RPC response for "
+             "it to be compressed, on connections which use compression. Responses "
+             "are uncompressed on the client's reactor thread, so this bounds how "
+             "long a single response may hold it up. See --rpc_compression.");
+TAG_FLAG(rpc_compression_max_response_bytes, advanced);
+TAG_FLAG(rpc_compression_max_response_bytes, experimental);
+TAG_FLAG(rpc_compression_max_response_bytes, runtime);
+
 using std::string;
 using std::unique_ptr;
+using std::vector;
 using strings::Substitute;
 
 namespace kudu {
@@ -97,6 +148,27 @@ std::ostream& operator<<(std::ostream& o, AuthenticationType authentication_type
   return o << AuthenticationTypeToString(authentication_type);
 }
 
+bool Negotiation::IsEncryptionExempt(const Socket& socket) {
+  if (socket.IsLoopbackConnection() && !FLAGS_rpc_encrypt_loopback_connections) {
+    return true;
+  }
+  if (FLAGS_rpc_unencrypted_subnets.empty()) {
+    return false;
+  }
+  Sockaddr remote;
+  if (!socket.GetPeerAddress(&remote).ok()) {
+    return false;
+  }
+  // The list is short and parsing it is cheap compared to the TLS handshake
+  // which follows, so it isn't cached.
+  vector<Network> subnets;
+  if (!Network::ParseCIDRStrings(FLAGS_rpc_unencrypted_subnets, &subnets).ok()) {
+    return false;
+  }
+  return std::any_of(subnets.begin(), subnets.end(),
+                     [&](const Network& n) { return n.WithinNetwork(remote); });
+}
+
 // Wait for the client connection to be established and become ready for writing.
 static Status WaitForClientConnect(Socket* socket, const MonoTime& deadline) {
   TRACE("Waiting for socket to connect");
@@ -25,6 +25,7 @@
 namespace kudu {
 
 class MonoTime;
+class Socket;
 
 namespace rpc {
 
@@ -50,6 +51,15 @@ class Negotiation {
                              RpcAuthentication authentication,
                              RpcEncryption encryption,
                              MonoTime deadline);
+
+  // Returns true if TLS may be used only to authenticate the peer of 'socket',
+  // with data then transferred unencrypted: either the connection stays within
+  // the host and --rpc_encrypt_loopback_connections is unset, or the peer
+  // address is in one of the subnets listed in --rpc_unencrypted_subnets.
+  //
+  // Both sides of a connection must agree for encryption to be skipped.
+  static bool IsEncryptionExempt(const Socket& socket);
+
  private:
   DISALLOW_IMPLICIT_CONSTRUCTORS(Negotiation);
 };
@@ -27,6 +27,7 @@
 #include <boost/function.hpp>
 #include <gflags/gflags.h>
 #include <google/protobuf/message.h>
+#include <google/protobuf/io/coded_stream.h>
 
 #include "kudu/gutil/move.h"
 #include "kudu/gutil/port.h"
@@ -61,6 +62,9 @@ DEFINE_int32(rpc_inject_cancellation_state, -1,
              "will be injected. Should use values in OutboundCall::State only");
 TAG_FLAG(rpc_inject_cancellation_state, unsafe);
 
+DECLARE_bool(rpc_compression);
+DECLARE_int32(rpc_compression_min_bytes);
+
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -69,6 +73,7 @@ namespace kudu {
 namespace rpc {
 
 using google::protobuf::Message;
+using google::protobuf::io::CodedOutputStream;
 using strings::Substitute;
 
 static const double kMicrosPerSecond = 1000000.0;
@@ -110,7 +115,7 @@ OutboundCall::~OutboundCall() {
   DVLOG(4) << "OutboundCall " << this << " destroyed with state_: " << StateName(state_);
 }
 
-size_t OutboundCall::SerializeTo(TransferPayload* slices) {
+size_t OutboundCall::SerializeTo(TransferPayload* slices, bool compress) {
   DCHECK_LT(0, request_buf_.size())
       << "Must call SetRequestPayload() before SerializeTo()";
 
@@ -124,6 +129,19 @@ size_t OutboundCall::SerializeTo(TransferPayload* slices) {
   }
 
   DCHECK_LE(0, sidecar_byte_size_);
+  if (compress && !compressed_request_.empty()) {
+    // The sidecars are part of the compressed payload.
+    header_.set_uncompressed_size(uncompressed_request_size_);
+    serialization::SerializeHeader(header_, compressed_request_.size(), &header_buf_);
+    DCHECK_LE(2, slices->size());
+    (*slices)[0] = Slice(header_buf_);
+    (*slices)[1] = compressed_request_;
+    return 2;
+  }
+  compressed_request_.clear();
+  compressed_buf_.clear();
+  compressed_buf_.shrink_to_fit();
+
   serialization::SerializeHeader(
       header_, sidecar_byte_size_ + request_buf_.size(), &header_buf_);
 
@@ -156,6 +174,23 @@ void OutboundCall::SetRequestPayload(const Message& req,
   }
 
   serialization::SerializeMessage(req, &request_buf_, sidecar_byte_size_, true);
+
+  // Compress the payload here, on the calling thread, rather than on the
+  // reactor thread in SerializeTo(). Whether the connection the call goes out
+  // on negotiated compression is only known there.
+  if (FLAGS_rpc_compression && request_payload_size() >= FLAGS_rpc_compression_min_bytes) {
+    vector<Slice> sidecar_slices;
+    sidecar_slices.reserve(sidecars_.size());
+    for (const unique_ptr<RpcSidecar>& car : sidecars_) {
+      sidecar_slices.emplace_back(car->AsSlice());
+    }
+    if (!serialization::CompressMessage(Slice(request_buf_), sidecar_slices,
+                                        &compressed_buf_, &compressed_request_,
+                                        &uncompressed_request_size_)) {
+      compressed_request_.clear();
+      compressed_buf_.clear();
+    }
+  }
 }
 
 Status OutboundCall::status() const {
@@ -511,6 +546,13 @@ Status CallResponse::ParseFrom(gscoped_ptr<InboundTransfer> transfer) {
   CHECK(!parsed_);
   RETURN_NOT_OK(serialization::ParseMessage(transfer->data(), &header_,
                                             &serialized_response_));
+  if (header_.has_uncompressed_size()) {
+    compressed_size_ = CodedOutputStream::VarintSize32(serialized_response_.size()) +
+        serialized_response_.size();
+    RETURN_NOT_OK(serialization::UncompressMessage(
+        serialized_response_, header_.uncompressed_size(), &uncompressed_buf_));
+    serialized_response_ = Slice(uncompressed_buf_);
+  }
 
   // Use information from header to extract the payload slices.
   RETURN_NOT_OK(RpcSidecar::ParseSidecars(header_.sidecar_offsets(),
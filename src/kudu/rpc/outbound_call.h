@@ -94,6 +94,9 @@ class OutboundCall {
   //
   // Because the request data is fully serialized by this call, 'req' may be subsequently
   // mutated with no ill effects.
+  //
+  // With --rpc_compression, a payload of at least --rpc_compression_min_bytes is
+  // also compressed here, so that it needn't be on the reactor thread.
   void SetRequestPayload(const google::protobuf::Message& req,
       std::vector<std::unique_ptr<RpcSidecar>>&& sidecars);
 
@@ -104,10 +107,38 @@ class OutboundCall {
     header_.set_call_id(call_id);
   }
 
+  // Selects which of the parallel connections to the remote carries this call.
+  // Must be called before the call is queued on a reactor.
+  void set_connection_index(int idx) {
+    conn_id_.set_connection_index(idx);
+  }
+
+  // Returns the size in bytes of the serialized request, including sidecars.
+  // Requires that SetRequestPayload() is called first.
+  int64_t request_payload_size() const {
+    DCHECK_LE(0, sidecar_byte_size_);
+    return request_buf_.size() + sidecar_byte_size_;
+  }
+
   // Serialize the call for the wire. Requires that SetRequestPayload()
   // is called first. This is called from the Reactor thread.
+  // If 'compress' is true, the request payload is sent compressed if
+  // SetRequestPayload() compressed it, see there.
   // Returns the number of slices in the serialized call.
-  size_t SerializeTo(TransferPayload* slices);
+  size_t SerializeTo(TransferPayload* slices, bool compress = false);
+
+  // Returns true if SerializeTo() compressed the request payload, in which case
+  // 'uncompressed_bytes' and 'compressed_bytes' are set to its size before and
+  // after compression.
+  bool GetRequestCompression(int64_t* uncompressed_bytes,
+                             int64_t* compressed_bytes) const {
+    if (!header_.has_uncompressed_size()) {
+      return false;
+    }
+    *uncompressed_bytes = header_.uncompressed_size();
+    *compressed_bytes = compressed_request_.size();
+    return true;
+  }
 
   // Mark in the call that cancellation has been requested. If the call hasn't yet
   // started sending or has finished sending the RPC request but is waiting for a
@@ -255,7 +286,8 @@ class OutboundCall {
   // RPC-system features required to send this call.
   std::set<RpcFeatureFlag> required_rpc_features_;
 
-  const ConnectionId conn_id_;
+  // Only modified by set_connection_index() before the call is queued.
+  ConnectionId conn_id_;
   ResponseCallback callback_;
   RpcController* controller_;
 
@@ -266,6 +298,13 @@ class OutboundCall {
   faststring header_buf_;
   faststring request_buf_;
 
+  // If SetRequestPayload() compressed the request payload, holds the
+  // compressed payload which 'compressed_request_' points into, and the size
+  // of the payload before compression.
+  faststring compressed_buf_;
+  Slice compressed_request_;
+  uint32_t uncompressed_request_size_ = 0;
+
   // Once a response has been received for this call, contains that response.
   // Otherwise NULL.
   gscoped_ptr<CallResponse> call_response_;
@@ -320,6 +359,20 @@ class CallResponse {
   // See RpcController::GetSidecar()
   Status GetSidecar(int idx, Slice* sidecar) const;
 
+  // Returns true if the response payload was received compressed, in which
+  // case 'uncompressed_bytes' and 'compressed_bytes' are set to its size before
+  // and after compression.
+  bool GetCompression(int64_t* uncompressed_bytes,
+                      int64_t* compressed_bytes) const {
+    DCHECK(parsed_);
+    if (!header_.has_uncompressed_size()) {
+      return false;
+    }
+    *uncompressed_bytes = header_.uncompressed_size();
+    *compressed_bytes = compressed_size_;
+    return true;
+  }
+
  private:
   // True once ParseFrom() is called.
   bool parsed_;
@@ -338,6 +391,12 @@ class CallResponse {
   // and sidecar_slices_ refer into its data.
   gscoped_ptr<InboundTransfer> transfer_;
 
+  // If the response payload was compressed, the size it was received with,
+  // and the uncompressed payload which serialized_response_ and
+  // sidecar_slices_ refer into instead.
+  int64_t compressed_size_ = 0;
+  faststring uncompressed_buf_;
+
   DISALLOW_COPY_AND_ASSIGN(CallResponse);
 };
 
@@ -17,6 +17,7 @@
 
 #include "kudu/rpc/reactor.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <memory>
 #include <mutex>
@@ -45,6 +46,7 @@
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/debug/sanitizer_scopes.h"
 #include "kudu/util/flag_tags.h"
+#include "kudu/util/logging.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/sockaddr.h"
@@ -85,6 +87,13 @@ DEFINE_bool(rpc_reopen_outbound_connections, false,
 TAG_FLAG(rpc_reopen_outbound_connections, unsafe);
 TAG_FLAG(rpc_reopen_outbound_connections, runtime);
 
+DEFINE_int32(rpc_read_buffer_size, 64 * 1024,
+             "Size in bytes of the buffer that each reactor thread reads inbound "
+             "RPC data into. Calls and responses that arrive together and fit in "
+             "it are read with a single syscall; larger ones are read directly "
+             "into their own buffers.");
+TAG_FLAG(rpc_read_buffer_size, advanced);
+
 METRIC_DEFINE_histogram(server, reactor_load_percent,
                         "Reactor Thread Load Percentage",
                         kudu::MetricUnit::kUnits,
@@ -102,6 +111,19 @@ METRIC_DEFINE_histogram(server, reactor_active_latency_us,
                         "to the latency of both inbound and outbound RPCs.",
                         1000000, 2);
 
+METRIC_DEFINE_counter(server, reactor_socket_syscalls,
+                      "Reactor Socket Syscalls",
+                      kudu::MetricUnit::kOperations,
+                      "Number of reads and writes made by reactor threads on RPC "
+                      "sockets. Divided by reactor_rpc_transfers, this gives the "
+                      "number of syscalls spent per RPC request or response.");
+
+METRIC_DEFINE_counter(server, reactor_rpc_transfers,
+                      "Reactor RPC Transfers",
+                      kudu::MetricUnit::kMessages,
+                      "Number of RPC requests and responses sent or received by "
+                      "reactor threads.");
+
 namespace kudu {
 namespace rpc {
 
@@ -137,6 +159,7 @@ ReactorThread::ReactorThread(Reactor *reactor, const MessengerBuilder& bld)
     reactor_(reactor),
     connection_keepalive_time_(bld.connection_keepalive_time_),
     coarse_timer_granularity_(bld.coarse_timer_granularity_),
+    busy_poll_us_(bld.reactor_busy_poll_us_),
     total_client_conns_cnt_(0),
     total_server_conns_cnt_(0) {
 
@@ -145,7 +168,13 @@ ReactorThread::ReactorThread(Reactor *reactor, const MessengerBuilder& bld)
         METRIC_reactor_active_latency_us.Instantiate(bld.metric_entity_);
     load_percent_histogram_ =
         METRIC_reactor_load_percent.Instantiate(bld.metric_entity_);
+    socket_syscalls_counter_ =
+        METRIC_reactor_socket_syscalls.Instantiate(bld.metric_entity_);
+    transfers_counter_ =
+        METRIC_reactor_rpc_transfers.Instantiate(bld.metric_entity_);
   }
+  // Don't let the buffer get too small to batch any reads.
+  read_buf_.resize(std::max(FLAGS_rpc_read_buffer_size, 1024));
 }
 
 Status ReactorThread::Init() {
@@ -178,11 +207,14 @@ void ReactorThread::InvokePendingCb(struct ev_loop* loop) {
   // This is called quite frequently so we use CycleClock rather than MonoTime
   // since it's a bit faster.
   int64_t start = CycleClock::Now();
+  ReactorThread* thr = static_cast<ReactorThread*>(ev_userdata(loop));
+  if (ev_pending_count(loop) > 0) {
+    thr->last_active_cycles_ = start;
+  }
   ev_invoke_pending(loop);
   int64_t dur_cycles = CycleClock::Now() - start;
 
   // Contribute this to our histogram.
-  ReactorThread* thr = static_cast<ReactorThread*>(ev_userdata(loop));
   if (thr->invoke_us_histogram_) {
     thr->invoke_us_histogram_->Increment(dur_cycles * 1e6 / base::CyclesPerSecond());
   }
@@ -268,6 +300,8 @@ Status ReactorThread::GetMetrics(ReactorMetrics* metrics) {
   metrics->num_server_connections_ = server_conns_.size();
   metrics->total_client_connections_ = total_client_conns_cnt_;
   metrics->total_server_connections_ = total_server_conns_cnt_;
+  metrics->total_socket_syscalls_ = total_socket_syscalls_cnt_;
+  metrics->total_transfers_ = total_transfers_cnt_;
   return Status::OK();
 }
 
@@ -301,6 +335,7 @@ void ReactorThread::AsyncHandler(ev::async& /*watcher*/, int /*revents*/) {
 
   if (PREDICT_FALSE(reactor_->closing())) {
     ShutdownInternal();
+    loop_stopped_ = true;
     loop_.break_loop(); // break the epoll loop and terminate the thread
     return;
   }
@@ -470,7 +505,11 @@ void ReactorThread::RunThread() {
   ThreadRestrictions::SetWaitAllowed(false);
   ThreadRestrictions::SetIOAllowed(false);
   DVLOG(6) << "Calling ReactorThread::RunThread()...";
-  loop_.run(0);
+  if (busy_poll_us_ > 0) {
+    RunBusyPollLoop();
+  } else {
+    loop_.run(0);
+  }
   VLOG(1) << name() << " thread exiting.";
 
   // No longer need the messenger. This causes the messenger to
@@ -478,6 +517,20 @@ void ReactorThread::RunThread() {
   reactor_->messenger_.reset();
 }
 
+void ReactorThread::RunBusyPollLoop() {
+  const int64_t busy_poll_cycles =
+      static_cast<int64_t>(busy_poll_us_ * base::CyclesPerSecond() / 1e6);
+  last_active_cycles_ = CycleClock::Now();
+  while (!loop_stopped_) {
+    // While spinning, the reactor picks up new events and queued tasks without
+    // the latency of being woken from epoll_wait(). libev also skips writing to
+    // its eventfd in ev_async_send() unless the loop is about to block, which
+    // saves the callers of WakeThread() a syscall.
+    bool spin = CycleClock::Now() - last_active_cycles_ < busy_poll_cycles;
+    loop_.run(spin ? ev::NOWAIT : ev::ONCE);
+  }
+}
+
 bool ReactorThread::FindConnection(const ConnectionId& conn_id,
                                    CredentialsPolicy cred_policy,
                                    scoped_refptr<Connection>* conn) {
@@ -604,6 +657,16 @@ void ReactorThread::CompleteConnectionNegotiation(
     return;
   }
 
+  if (busy_poll_us_ > 0) {
+    // Requires CAP_NET_ADMIN to raise above net.core.busy_read; the reactor
+    // still busy-polls its event loop if this fails.
+    s = conn->socket()->SetBusyPoll(busy_poll_us_);
+    if (PREDICT_FALSE(!s.ok())) {
+      KLOG_FIRST_N(WARNING, 1) << "Unable to enable busy-polling on RPC socket: "
+                               << s.ToString();
+    }
+  }
+
   conn->MarkNegotiationComplete();
   conn->EpollRegister(loop_);
 }
@@ -886,6 +949,7 @@ void Reactor::QueueCancellation(const shared_ptr<OutboundCall>& call) {
 }
 
 void Reactor::ScheduleReactorTask(ReactorTask *task) {
+  bool was_empty;
   {
     std::unique_lock<LockType> l(lock_);
     if (closing_) {
@@ -894,9 +958,16 @@ void Reactor::ScheduleReactorTask(ReactorTask *task) {
       task->Abort(ShutdownError(false));
       return;
     }
+    was_empty = pending_tasks_.empty();
     pending_tasks_.push_back(*task);
   }
-  thread_.WakeThread();
+  // If tasks were already pending, the reactor has been woken up for them and
+  // hasn't drained the queue yet, so it will run this task along with them.
+  // Only the first task queued after a drain needs to wake it, which batches
+  // the wakeups of bursts of outbound calls.
+  if (was_empty) {
+    thread_.WakeThread();
+  }
 }
 
 bool Reactor::DrainTaskQueue(boost::intrusive::list<ReactorTask> *tasks) { // NOLINT(*)
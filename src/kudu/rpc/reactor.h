@@ -35,6 +35,7 @@
 #include "kudu/rpc/connection_id.h"
 #include "kudu/rpc/messenger.h"
 #include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
@@ -69,6 +70,11 @@ struct ReactorMetrics {
   uint64_t total_client_connections_;
   // Total number of server RPC connections opened during Reactor's lifetime.
   uint64_t total_server_connections_;
+
+  // Total number of reads and writes made on RPC sockets during Reactor's lifetime.
+  uint64_t total_socket_syscalls_;
+  // Total number of RPC transfers sent or received during Reactor's lifetime.
+  uint64_t total_transfers_;
 };
 
 // A task which can be enqueued to run on the reactor thread.
@@ -197,6 +203,32 @@ class ReactorThread {
   // Must be called from the reactor thread.
   Status GetMetrics(ReactorMetrics *metrics);
 
+  // Return the buffer that connections read inbound data into before
+  // splitting it into transfers. It's shared by all the connections of this
+  // reactor thread, so it must not hold any data once a read is handled.
+  // Must be called from the reactor thread.
+  faststring* read_buffer() {
+    return &read_buf_;
+  }
+
+  // Account for a read or write made on the socket of a connection.
+  // Must be called from the reactor thread.
+  void RecordSocketSyscall() {
+    total_socket_syscalls_cnt_++;
+    if (socket_syscalls_counter_) {
+      socket_syscalls_counter_->Increment();
+    }
+  }
+
+  // Account for an RPC transfer sent or received by a connection.
+  // Must be called from the reactor thread.
+  void RecordTransfer() {
+    total_transfers_cnt_++;
+    if (transfers_counter_) {
+      transfers_counter_->Increment();
+    }
+  }
+
  private:
   friend class AssignOutboundCallTask;
   friend class CancellationTask;
@@ -206,6 +238,12 @@ class ReactorThread {
   // Run the main event loop of the reactor.
   void RunThread();
 
+  // Runs the event loop when busy-polling is enabled: the loop is polled
+  // without blocking for as long as events keep arriving less than
+  // 'busy_poll_us_' apart, and only blocks in epoll_wait() once the reactor
+  // has been idle for longer than that.
+  void RunBusyPollLoop();
+
   // When libev has noticed that it needs to wake up an application watcher,
   // it calls this callback. The callback simply calls back into libev's
   // ev_invoke_pending() to trigger all the watcher callbacks, but
@@ -308,9 +346,21 @@ class ReactorThread {
   // Scan for idle connections on this granularity.
   const MonoDelta coarse_timer_granularity_;
 
+  // If positive, the number of microseconds the reactor spins polling for new
+  // events before blocking, and the SO_BUSY_POLL value set on its sockets.
+  const int busy_poll_us_;
+
+  // Set once the reactor has shut down and its event loop should exit.
+  bool loop_stopped_ = false;
+
+  // The cycle-time at which the event loop last had callbacks to invoke.
+  int64_t last_active_cycles_ = 0;
+
   // Metrics.
   scoped_refptr<Histogram> invoke_us_histogram_;
   scoped_refptr<Histogram> load_percent_histogram_;
+  scoped_refptr<Counter> socket_syscalls_counter_;
+  scoped_refptr<Counter> transfers_counter_;
 
   // Total number of client connections opened during Reactor's lifetime.
   uint64_t total_client_conns_cnt_;
@@ -318,6 +368,15 @@ class ReactorThread {
   // Total number of server connections opened during Reactor's lifetime.
   uint64_t total_server_conns_cnt_;
 
+  // Total number of reads and writes made on sockets during Reactor's lifetime.
+  uint64_t total_socket_syscalls_cnt_ = 0;
+
+  // Total number of RPC transfers sent or received during Reactor's lifetime.
+  uint64_t total_transfers_cnt_ = 0;
+
+  // See read_buffer().
+  faststring read_buf_;
+
   // Set prior to calling epoll and then reset back to -1 after each invocation
   // completes. Used for accounting total_poll_cycles_.
   int64_t cycle_clock_before_poll_ = -1;
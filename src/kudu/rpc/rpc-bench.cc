@@ -41,6 +41,7 @@
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/sockaddr.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_util.h"
@@ -70,7 +71,13 @@ DEFINE_int32(server_reactors, 4,
 
 DEFINE_int32(run_seconds, 1, "Seconds to run the test");
 
+DEFINE_int32(response_sidecar_bytes, 0,
+             "Size of a sidecar carried by each response, in bytes, to benchmark "
+             "responses with bulk data such as scan results. 0 for no sidecar.");
+
 DECLARE_bool(rpc_encrypt_loopback_connections);
+DECLARE_bool(rpc_tls_kernel_offload);
+DECLARE_int32(rpc_reactor_busy_poll_us);
 DEFINE_bool(enable_encryption, false, "Whether to enable TLS encryption for rpc-bench");
 
 METRIC_DECLARE_histogram(reactor_load_percent);
@@ -83,7 +90,8 @@ class RpcBench : public RpcTestBase {
  public:
   RpcBench()
       : should_run_(true),
-        stop_(0)
+        stop_(0),
+        call_latency_us_(60 * 1000 * 1000, 2)
   {}
 
   void SetUp() override {
@@ -119,11 +127,16 @@ class RpcBench : public RpcTestBase {
     LOG(INFO) << "Worker threads:   " << FLAGS_worker_threads;
     LOG(INFO) << "Server reactors:  " << FLAGS_server_reactors;
     LOG(INFO) << "Encryption:       " << FLAGS_enable_encryption;
+    LOG(INFO) << "Kernel TLS:       " << FLAGS_rpc_tls_kernel_offload;
+    LOG(INFO) << "Busy-poll:        " << FLAGS_rpc_reactor_busy_poll_us << "us";
+    LOG(INFO) << "Response sidecar: " << FLAGS_response_sidecar_bytes << " bytes";
     LOG(INFO) << "----------------------------------";
     LOG(INFO) << "Reqs/sec:         " << reqs_per_second;
     LOG(INFO) << "User CPU per req: " << user_cpu_micros_per_req << "us";
     LOG(INFO) << "Sys CPU per req:  " << sys_cpu_micros_per_req << "us";
     LOG(INFO) << "Ctx Sw. per req:  " << csw_per_req;
+    LOG(INFO) << "Latency (50p):    " << call_latency_us_.ValueAtPercentile(50) << "us";
+    LOG(INFO) << "Latency (99p):    " << call_latency_us_.ValueAtPercentile(99) << "us";
     LOG(INFO) << "Server Reactor load (mean):     "
               << reactor_load.MeanValue() << "%";
     LOG(INFO) << "Server Reactor load (95p):      "
@@ -142,6 +155,9 @@ class RpcBench : public RpcTestBase {
   Sockaddr server_addr_;
   Atomic32 should_run_;
   CountDownLatch stop_;
+
+  // Client-side latency of each call, recorded by all client threads.
+  HdrHistogram call_latency_us_;
 };
 
 class ClientThread {
@@ -166,13 +182,23 @@ class ClientThread {
 
     AddRequestPB req;
     AddResponsePB resp;
+    if (FLAGS_response_sidecar_bytes > 0) {
+      req.set_response_sidecar_size(FLAGS_response_sidecar_bytes);
+    }
     while (Acquire_Load(&bench_->should_run_)) {
       req.set_x(request_count_);
       req.set_y(request_count_);
       RpcController controller;
       controller.set_timeout(MonoDelta::FromSeconds(10));
+      MonoTime start = MonoTime::Now();
       CHECK_OK(p.Add(req, &resp, &controller));
+      bench_->call_latency_us_.Increment((MonoTime::Now() - start).ToMicroseconds());
       CHECK_EQ(req.x() + req.y(), resp.result());
+      if (resp.has_sidecar_idx()) {
+        Slice sidecar;
+        CHECK_OK(controller.GetInboundSidecar(resp.sidecar_idx(), &sidecar));
+        CHECK_EQ(static_cast<size_t>(FLAGS_response_sidecar_bytes), sidecar.size());
+      }
       request_count_++;
     }
   }
@@ -215,6 +241,9 @@ class ClientAsyncWorkload {
       messenger_(std::move(messenger)),
       request_count_(0) {
     controller_.set_timeout(MonoDelta::FromSeconds(10));
+    if (FLAGS_response_sidecar_bytes > 0) {
+      req_.set_response_sidecar_size(FLAGS_response_sidecar_bytes);
+    }
     proxy_.reset(new CalculatorServiceProxy(messenger_, bench_->server_addr_, "localhost"));
   }
 
@@ -222,6 +251,7 @@ class ClientAsyncWorkload {
     if (request_count_ > 0) {
       CHECK_OK(controller_.status());
       CHECK_EQ(req_.x() + req_.y(), resp_.result());
+      bench_->call_latency_us_.Increment((MonoTime::Now() - call_start_).ToMicroseconds());
     }
     if (!Acquire_Load(&bench_->should_run_)) {
       bench_->stop_.CountDown();
@@ -231,6 +261,7 @@ class ClientAsyncWorkload {
     req_.set_x(request_count_);
     req_.set_y(request_count_);
     request_count_++;
+    call_start_ = MonoTime::Now();
     proxy_->AddAsync(req_,
                      &resp_,
                      &controller_,
@@ -245,6 +276,7 @@ class ClientAsyncWorkload {
   shared_ptr<Messenger> messenger_;
   unique_ptr<CalculatorServiceProxy> proxy_;
   uint32_t request_count_;
+  MonoTime call_start_;
   RpcController controller_;
   AddRequestPB req_;
   AddResponsePB resp_;
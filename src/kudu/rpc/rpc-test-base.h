@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cstring>
 #include <memory>
 #include <string>
 
@@ -249,6 +250,14 @@ class CalculatorService : public CalculatorServiceIf {
 
   void Add(const AddRequestPB *req, AddResponsePB *resp, RpcContext *context) override {
     resp->set_result(req->x() + req->y());
+    if (req->response_sidecar_size() > 0) {
+      std::unique_ptr<faststring> sidecar(new faststring(req->response_sidecar_size()));
+      sidecar->resize(req->response_sidecar_size());
+      memset(sidecar->data(), 'x', sidecar->size());
+      int idx;
+      CHECK_OK(context->AddOutboundSidecar(RpcSidecar::FromFaststring(std::move(sidecar)), &idx));
+      resp->set_sidecar_idx(idx);
+    }
     context->RespondSuccess();
   }
 
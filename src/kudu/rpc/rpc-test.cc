@@ -47,6 +47,8 @@
 #include "kudu/rpc/proxy.h"
 #include "kudu/rpc/reactor.h"
 #include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/rpc/rpc_introspection.pb.h"
 #include "kudu/rpc/rpc_sidecar.h"
 #include "kudu/rpc/rtest.pb.h"
 #include "kudu/rpc/serialization.h"
@@ -54,6 +56,7 @@
 #include "kudu/security/test/test_certs.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/env.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/sockaddr.h"
@@ -69,8 +72,13 @@
 METRIC_DECLARE_histogram(handler_latency_kudu_rpc_test_CalculatorService_Sleep);
 METRIC_DECLARE_histogram(rpc_incoming_queue_time);
 
+DECLARE_bool(rpc_compression);
 DECLARE_bool(rpc_reopen_outbound_connections);
+DECLARE_int32(rpc_compression_max_response_bytes);
+DECLARE_int32(rpc_compression_min_bytes);
+DECLARE_int32(rpc_connections_per_peer);
 DECLARE_int32(rpc_negotiation_inject_delay_ms);
+DECLARE_int32(rpc_reactor_busy_poll_us);
 DECLARE_string(rpc_certificate_file);
 DECLARE_string(rpc_ca_certificate_file);
 DECLARE_string(rpc_private_key_file);
@@ -138,6 +146,29 @@ TEST_F(TestRpc, TestConnHeaderValidation) {
   ASSERT_OK(serialization::ValidateConnHeader(Slice(buf, conn_hdr_len)));
 }
 
+TEST_F(TestRpc, TestSerializeHeaderAndMessage) {
+  AddResponsePB resp;
+  resp.set_result(3);
+  const string kSidecar = "sidecar";
+  ResponseHeader header;
+  header.set_call_id(1);
+  header.add_sidecar_offsets(resp.ByteSize());
+
+  faststring buf;
+  serialization::SerializeHeaderAndMessage(header, resp, kSidecar.size(), &buf);
+  buf.append(kSidecar);
+
+  ResponseHeader parsed_header;
+  Slice main_msg;
+  ASSERT_OK(serialization::ParseMessage(Slice(buf), &parsed_header, &main_msg));
+  ASSERT_EQ(1, parsed_header.call_id());
+  ASSERT_EQ(resp.ByteSize() + kSidecar.size(), main_msg.size());
+  AddResponsePB parsed_resp;
+  ASSERT_TRUE(parsed_resp.ParseFromArray(main_msg.data(), resp.ByteSize()));
+  ASSERT_EQ(3, parsed_resp.result());
+  ASSERT_EQ(kSidecar, Slice(main_msg.data() + resp.ByteSize(), kSidecar.size()).ToString());
+}
+
 // Regression test for KUDU-2041
 TEST_P(TestRpc, TestNegotiationDeadlock) {
   bool enable_ssl = GetParam();
@@ -391,6 +422,54 @@ TEST_P(TestRpc, TestConnectionKeepalive) {
   ASSERT_EQ(0, metrics.num_client_connections_) << "Client should have 0 client connections";
 }
 
+// Test that reactors account for the syscalls made to send and receive calls.
+TEST_P(TestRpc, TestReactorSyscallMetrics) {
+  // Only run one reactor per messenger, so we can grab the metrics from that
+  // one without having to check all.
+  n_server_reactor_threads_ = 1;
+
+  Sockaddr server_addr;
+  bool enable_ssl = GetParam();
+  StartTestServer(&server_addr, enable_ssl);
+  shared_ptr<Messenger> client_messenger(CreateMessenger("Client", 1, enable_ssl));
+  Proxy p(client_messenger, server_addr, server_addr.host(),
+          GenericCalculatorService::static_service_name());
+
+  // Send a burst of small calls, which the reactors may batch.
+  const int kNumCalls = 100;
+  AddRequestPB req;
+  req.set_x(1);
+  req.set_y(2);
+  vector<unique_ptr<RpcController>> controllers;
+  vector<unique_ptr<AddResponsePB>> resps;
+  CountDownLatch latch(kNumCalls);
+  for (int i = 0; i < kNumCalls; i++) {
+    controllers.emplace_back(new RpcController());
+    resps.emplace_back(new AddResponsePB());
+    p.AsyncRequest(GenericCalculatorService::kAddMethodName, req, resps.back().get(),
+                   controllers.back().get(),
+                   boost::bind(&CountDownLatch::CountDown, boost::ref(latch)));
+  }
+  latch.Wait();
+  for (int i = 0; i < kNumCalls; i++) {
+    ASSERT_OK(controllers[i]->status());
+    ASSERT_EQ(3, resps[i]->result());
+  }
+
+  // Every call was received and responded to by the server, and sent and
+  // received the response of on the client.
+  for (const auto& messenger : { server_messenger_, client_messenger }) {
+    Reactor* reactor = messenger->reactors_[0];
+    ASSERT_EVENTUALLY([&]() {
+      ReactorMetrics metrics;
+      ASSERT_OK(reactor->GetMetrics(&metrics));
+      ASSERT_EQ(2 * kNumCalls, metrics.total_transfers_);
+      ASSERT_GT(metrics.total_socket_syscalls_, 0);
+      ASSERT_LE(metrics.total_socket_syscalls_, 2 * metrics.total_transfers_);
+    });
+  }
+}
+
 // Test that outbound connections to the same server are reopen upon every RPC
 // call when the 'rpc_reopen_outbound_connections' flag is set.
 TEST_P(TestRpc, TestReopenOutboundConnections) {
@@ -507,6 +586,145 @@ TEST_P(TestRpc, TestCredentialsPolicy) {
   EXPECT_EQ(1, metrics.num_client_connections_);
 }
 
+// Test that bulk calls are spread over their own connections to the server,
+// while small calls keep using a single one.
+TEST_P(TestRpc, TestConnectionsPerPeer) {
+  FLAGS_rpc_connections_per_peer = 3;
+
+  // Set up server.
+  Sockaddr server_addr;
+  bool enable_ssl = GetParam();
+  StartTestServer(&server_addr, enable_ssl);
+
+  // Set up client. With a single reactor, all of its connections can be
+  // inspected in one place.
+  shared_ptr<Messenger> client_messenger(CreateMessenger("Client", 1, enable_ssl));
+  Proxy p(client_messenger, server_addr, server_addr.host(),
+          GenericCalculatorService::static_service_name());
+
+  auto do_call = [&](bool bulk) {
+    AddRequestPB req;
+    req.set_x(rand());
+    req.set_y(rand());
+    AddResponsePB resp;
+    RpcController controller;
+    controller.set_timeout(MonoDelta::FromMilliseconds(10000));
+    controller.set_bulk_transfer(bulk);
+    RETURN_NOT_OK(p.SyncRequest(GenericCalculatorService::kAddMethodName,
+                                req, &resp, &controller));
+    CHECK_EQ(req.x() + req.y(), resp.result());
+    return Status::OK();
+  };
+
+  ReactorMetrics metrics;
+  ASSERT_OK(do_call(false));
+  ASSERT_OK(do_call(false));
+  ASSERT_OK(client_messenger->reactors_[0]->GetMetrics(&metrics));
+  EXPECT_EQ(1, metrics.num_client_connections_);
+
+  // Bulk calls open the two remaining connections, round-robin.
+  for (int i = 0; i < 4; i++) {
+    ASSERT_OK(do_call(true));
+  }
+  ASSERT_OK(client_messenger->reactors_[0]->GetMetrics(&metrics));
+  EXPECT_EQ(3, metrics.num_client_connections_);
+  EXPECT_EQ(3, metrics.total_client_connections_);
+
+  // Small calls still share the first connection.
+  ASSERT_OK(do_call(false));
+  ASSERT_OK(client_messenger->reactors_[0]->GetMetrics(&metrics));
+  EXPECT_EQ(3, metrics.total_client_connections_);
+}
+
+// Test that calls complete, and messengers shut down cleanly, when the
+// reactors busy-poll instead of blocking right away.
+TEST_P(TestRpc, TestBusyPollReactors) {
+  FLAGS_rpc_reactor_busy_poll_us = 100;
+
+  // Set up server.
+  Sockaddr server_addr;
+  bool enable_ssl = GetParam();
+  StartTestServer(&server_addr, enable_ssl);
+
+  // Set up client.
+  shared_ptr<Messenger> client_messenger(CreateMessenger("Client", 1, enable_ssl));
+  Proxy p(client_messenger, server_addr, server_addr.host(),
+          GenericCalculatorService::static_service_name());
+
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(DoTestSyncCall(p, GenericCalculatorService::kAddMethodName));
+    // Let the reactors go idle for longer than the busy-poll window, so that
+    // the next call has to wake them up from epoll_wait().
+    if (i % 2 == 0) {
+      SleepFor(MonoDelta::FromMilliseconds(1));
+    }
+  }
+}
+
+// Test that calls and responses are compressed when both sides enable
+// compression, and that their messages and sidecars survive the round trip.
+TEST_P(TestRpc, TestCompression) {
+  FLAGS_rpc_compression = true;
+  FLAGS_rpc_compression_min_bytes = 1024;
+  FLAGS_rpc_compression_max_response_bytes = 2 * 1024 * 1024;
+
+  // Set up server.
+  Sockaddr server_addr;
+  bool enable_ssl = GetParam();
+  StartTestServer(&server_addr, enable_ssl);
+
+  // Set up client.
+  shared_ptr<Messenger> client_messenger(CreateMessenger("Client", 1, enable_ssl));
+  Proxy p(client_messenger, server_addr, server_addr.host(),
+          GenericCalculatorService::static_service_name());
+
+  // Payloads below the threshold, and random ones which don't compress, are
+  // sent as they are.
+  DoTestSidecar(p, 123, 456);
+  DoTestSidecar(p, 300 * 1024, 200 * 1024);
+
+  // Compressible request sidecars.
+  DoTestOutgoingSidecarExpectOK(p, 3000 * 1024, 2000 * 1024);
+
+  // A compressible response sidecar.
+  const int kResponseSidecarSize = 1024 * 1024;
+  AddRequestPB req;
+  req.set_x(10);
+  req.set_y(20);
+  req.set_response_sidecar_size(kResponseSidecarSize);
+  AddResponsePB resp;
+  RpcController controller;
+  controller.set_timeout(MonoDelta::FromMilliseconds(10000));
+  ASSERT_OK(p.SyncRequest(GenericCalculatorService::kAddMethodName, req, &resp, &controller));
+  ASSERT_EQ(30, resp.result());
+  Slice sidecar;
+  ASSERT_OK(controller.GetInboundSidecar(resp.sidecar_idx(), &sidecar));
+  ASSERT_EQ(string(kResponseSidecarSize, 'x'), sidecar.ToString());
+
+  DumpRunningRpcsRequestPB dump_req;
+  DumpRunningRpcsResponsePB dump_resp;
+  ASSERT_OK(client_messenger->DumpRunningRpcs(dump_req, &dump_resp));
+  ASSERT_EQ(1, dump_resp.outbound_connections_size());
+  const RpcConnectionPB& conn = dump_resp.outbound_connections(0);
+  ASSERT_GT(conn.uncompressed_bytes_sent(), 5000 * 1024);
+  ASSERT_LT(conn.compressed_bytes_sent(), conn.uncompressed_bytes_sent() / 10);
+  ASSERT_GT(conn.uncompressed_bytes_received(), kResponseSidecarSize);
+  ASSERT_LT(conn.compressed_bytes_received(), conn.uncompressed_bytes_received() / 10);
+
+  // Responses above --rpc_compression_max_response_bytes are sent as they are.
+  const int64_t uncompressed_bytes_received = conn.uncompressed_bytes_received();
+  req.set_response_sidecar_size(3 * kResponseSidecarSize);
+  controller.Reset();
+  controller.set_timeout(MonoDelta::FromMilliseconds(10000));
+  ASSERT_OK(p.SyncRequest(GenericCalculatorService::kAddMethodName, req, &resp, &controller));
+  ASSERT_OK(controller.GetInboundSidecar(resp.sidecar_idx(), &sidecar));
+  ASSERT_EQ(3 * kResponseSidecarSize, sidecar.size());
+  dump_resp.Clear();
+  ASSERT_OK(client_messenger->DumpRunningRpcs(dump_req, &dump_resp));
+  ASSERT_EQ(uncompressed_bytes_received,
+            dump_resp.outbound_connections(0).uncompressed_bytes_received());
+}
+
 // Test that a call which takes longer than the keepalive time
 // succeeds -- i.e that we don't consider a connection to be "idle" on the
 // server if there is a call outstanding on it.
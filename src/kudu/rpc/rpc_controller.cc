@@ -39,7 +39,9 @@ class Slice;
 namespace rpc {
 
 RpcController::RpcController()
-    : credentials_policy_(CredentialsPolicy::ANY_CREDENTIALS), messenger_(nullptr) {
+    : credentials_policy_(CredentialsPolicy::ANY_CREDENTIALS),
+      bulk_transfer_(false),
+      messenger_(nullptr) {
   DVLOG(4) << "RpcController " << this << " constructed";
 }
 
@@ -59,6 +61,7 @@ void RpcController::Swap(RpcController* other) {
   std::swap(outbound_sidecars_, other->outbound_sidecars_);
   std::swap(timeout_, other->timeout_);
   std::swap(credentials_policy_, other->credentials_policy_);
+  std::swap(bulk_transfer_, other->bulk_transfer_);
   std::swap(call_, other->call_);
 }
 
@@ -70,9 +73,18 @@ void RpcController::Reset() {
   call_.reset();
   required_server_features_.clear();
   credentials_policy_ = CredentialsPolicy::ANY_CREDENTIALS;
+  bulk_transfer_ = false;
   messenger_ = nullptr;
 }
 
+void RpcController::ShareFinishedCall(const RpcController& other) {
+  CHECK(other.finished());
+  std::lock_guard<simple_spinlock> l(lock_);
+  DCHECK(!call_);
+  call_ = other.call_;
+  messenger_ = other.messenger_;
+}
+
 bool RpcController::finished() const {
   if (call_) {
     return call_->IsFinished();
@@ -85,6 +85,13 @@ class RpcController {
   // Note that this resets the required server features.
   void Reset();
 
+  // Makes this controller, which must not have been used for a call since it
+  // was last reset, report the outcome of the finished call made with 'other':
+  // finished(), status() and error_response() then return the same as for
+  // 'other'. Used to hand the failure of a call carrying the requests of
+  // several callers back to each of them.
+  void ShareFinishedCall(const RpcController& other);
+
   // Return true if the call has finished.
   // A call is finished if the server has responded, or if the call
   // has timed out.
@@ -210,6 +217,18 @@ class RpcController {
     credentials_policy_ = policy;
   }
 
+  // Marks the call as a bulk transfer, e.g. one expected to return a large
+  // response. When the messenger keeps several connections to each peer (see
+  // --rpc_connections_per_peer), bulk calls are kept off the connection which
+  // carries small, latency-sensitive calls, so they don't delay them.
+  void set_bulk_transfer(bool bulk_transfer) {
+    bulk_transfer_ = bulk_transfer;
+  }
+
+  bool bulk_transfer() const {
+    return bulk_transfer_;
+  }
+
   // Fills the 'sidecar' parameter with the slice pointing to the i-th
   // sidecar upon success.
   //
@@ -254,6 +273,9 @@ class RpcController {
   // RPC authentication policy for outbound calls.
   CredentialsPolicy credentials_policy_;
 
+  // Whether the call should be sent over a connection reserved for bulk calls.
+  bool bulk_transfer_;
+
   mutable simple_spinlock lock_;
 
   // The id of this request.
@@ -19,6 +19,7 @@
 
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include <gflags/gflags_declare.h>
 #include <glog/logging.h>
@@ -30,6 +31,8 @@
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/constants.h"
+#include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/slice.h"
@@ -40,6 +43,7 @@ DECLARE_int32(rpc_max_message_size);
 using google::protobuf::MessageLite;
 using google::protobuf::io::CodedInputStream;
 using google::protobuf::io::CodedOutputStream;
+using std::vector;
 using strings::Substitute;
 
 namespace kudu {
@@ -104,6 +108,98 @@ void SerializeHeader(const MessageLite& header,
   CHECK_EQ(dst, header_buf->data() + header_tot_len);
 }
 
+void SerializeHeaderAndMessage(const MessageLite& header,
+                               const MessageLite& message,
+                               int additional_size,
+                               faststring* buf) {
+  CHECK(header.IsInitialized())
+      << "RPC header missing fields: " << header.InitializationErrorString();
+
+  int pb_size = message.GetCachedSize();
+  DCHECK_EQ(message.ByteSize(), pb_size);
+  int recorded_size = pb_size + additional_size;
+  size_t msg_len = CodedOutputStream::VarintSize32(recorded_size) + pb_size;
+
+  size_t header_pb_len = header.ByteSize();
+  size_t header_tot_len = kMsgLengthPrefixLength
+      + CodedOutputStream::VarintSize32(header_pb_len)
+      + header_pb_len;
+  size_t total_size = header_tot_len + msg_len + additional_size;
+
+  if (msg_len + additional_size > FLAGS_rpc_max_message_size) {
+    LOG(WARNING) << Substitute("Serialized $0 ($1 bytes) is larger than the maximum configured "
+                               "RPC message size ($2 bytes). "
+                               "Sending anyway, but peer may reject the data.",
+                               message.GetTypeName(), msg_len + additional_size,
+                               FLAGS_rpc_max_message_size);
+  }
+
+  buf->resize(header_tot_len + msg_len);
+  uint8_t* dst = buf->data();
+  NetworkByteOrder::Store32(dst, total_size - kMsgLengthPrefixLength);
+  dst += sizeof(uint32_t);
+  dst = CodedOutputStream::WriteVarint32ToArray(header_pb_len, dst);
+  dst = header.SerializeWithCachedSizesToArray(dst);
+  dst = CodedOutputStream::WriteVarint32ToArray(recorded_size, dst);
+  dst = message.SerializeWithCachedSizesToArray(dst);
+  CHECK_EQ(dst, buf->data() + buf->size());
+}
+
+bool CompressMessage(const Slice& message,
+                     const vector<Slice>& sidecars,
+                     faststring* buf,
+                     Slice* compressed_message,
+                     uint32_t* uncompressed_size) {
+  // Strip the size prefix written by SerializeMessage(): the compressed body
+  // gets its own.
+  CodedInputStream in(message.data(), message.size());
+  uint32_t body_size;
+  CHECK(in.ReadVarint32(&body_size));
+  int prefix_len = in.CurrentPosition();
+
+  vector<Slice> body;
+  body.reserve(1 + sidecars.size());
+  body.emplace_back(message.data() + prefix_len, message.size() - prefix_len);
+  body.insert(body.end(), sidecars.begin(), sidecars.end());
+
+  const CompressionCodec* codec;
+  CHECK_OK(GetCompressionCodec(LZ4, &codec));
+
+  // Compress after enough room for the largest size prefix, and then write
+  // the actual prefix right before the compressed data.
+  const int kMaxPrefixLen = 5;
+  buf->resize(kMaxPrefixLen + codec->MaxCompressedLength(body_size));
+  size_t compressed_len;
+  if (!codec->Compress(body, buf->data() + kMaxPrefixLen, &compressed_len).ok()) {
+    return false;
+  }
+  int compressed_prefix_len = CodedOutputStream::VarintSize32(compressed_len);
+  if (compressed_prefix_len + compressed_len >= prefix_len + body_size) {
+    return false;
+  }
+  uint8_t* start = buf->data() + kMaxPrefixLen - compressed_prefix_len;
+  CodedOutputStream::WriteVarint32ToArray(compressed_len, start);
+  buf->resize(kMaxPrefixLen + compressed_len);
+  *compressed_message = Slice(start, compressed_prefix_len + compressed_len);
+  *uncompressed_size = body_size;
+  return true;
+}
+
+Status UncompressMessage(const Slice& compressed_message,
+                         uint32_t uncompressed_size,
+                         faststring* buf) {
+  if (PREDICT_FALSE(uncompressed_size > FLAGS_rpc_max_message_size)) {
+    return Status::Corruption(Substitute(
+        "Invalid packet: uncompressed size of $0 bytes is larger than the maximum "
+        "configured RPC message size ($1 bytes)",
+        uncompressed_size, FLAGS_rpc_max_message_size));
+  }
+  const CompressionCodec* codec;
+  RETURN_NOT_OK(GetCompressionCodec(LZ4, &codec));
+  buf->resize(uncompressed_size);
+  return codec->Uncompress(compressed_message, buf->data(), uncompressed_size);
+}
+
 Status ParseMessage(const Slice& buf,
                     MessageLite* parsed_header,
                     Slice* parsed_main_message) {
@@ -20,6 +20,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <vector>
 
 namespace google {
 namespace protobuf {
@@ -65,6 +66,47 @@ void SerializeHeader(const google::protobuf::MessageLite& header,
                      size_t param_len,
                      faststring* header_buf);
 
+// Serialize both the header and the message of a call into 'buf', laid out
+// as SerializeHeader() followed by SerializeMessage() would, so that they can
+// be sent as a single slice.
+// In : 'header' Protobuf header to serialize.
+//      'message' Protobuf message to serialize, whose cached size must be
+//        up to date.
+//      'additional_size' The size of the sidecars following the message.
+// Out: The faststring 'buf' to be populated with the serialized bytes.
+void SerializeHeaderAndMessage(const google::protobuf::MessageLite& header,
+                               const google::protobuf::MessageLite& message,
+                               int additional_size,
+                               faststring* buf);
+
+// Compress the main body of a call or response with LZ4, as sent on
+// connections which negotiated the COMPRESSION feature.
+// In : 'message' The message as serialized by SerializeMessage(), including
+//        its size prefix.
+//      'sidecars' The sidecars following the message.
+// Out: 'buf' populated with the compressed body.
+//      'compressed_message' pointing into 'buf' at the compressed body
+//        preceded by its size, ready to follow the header on the wire.
+//      'uncompressed_size' The size of the body before compression, to be set
+//        in the header.
+// Returns false, leaving the outputs unspecified, if compression wouldn't make
+// the body any smaller.
+bool CompressMessage(const Slice& message,
+                     const std::vector<Slice>& sidecars,
+                     faststring* buf,
+                     Slice* compressed_message,
+                     uint32_t* uncompressed_size);
+
+// Uncompress the main body of a call or response compressed by
+// CompressMessage().
+// In : 'compressed_message' The main message as returned by ParseMessage().
+//      'uncompressed_size' The size of the body, as set in the header.
+// Out: 'buf' populated with the uncompressed body, laid out like the main
+//        message of an uncompressed call or response.
+Status UncompressMessage(const Slice& compressed_message,
+                         uint32_t uncompressed_size,
+                         faststring* buf);
+
 // Deserialize the request.
 // In: data buffer Slice.
 // Out: parsed_header PB initialized,
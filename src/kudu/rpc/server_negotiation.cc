@@ -40,6 +40,7 @@
 #include "kudu/rpc/blocking_ops.h"
 #include "kudu/rpc/constants.h"
 #include "kudu/rpc/messenger.h"
+#include "kudu/rpc/negotiation.h"
 #include "kudu/rpc/serialization.h"
 #include "kudu/security/cert.h"
 #include "kudu/security/crypto.h"
@@ -72,8 +73,6 @@ DEFINE_double(rpc_inject_invalid_authn_token_ratio, 0,
 TAG_FLAG(rpc_inject_invalid_authn_token_ratio, runtime);
 TAG_FLAG(rpc_inject_invalid_authn_token_ratio, unsafe);
 
-DECLARE_bool(rpc_encrypt_loopback_connections);
-
 DEFINE_string(trusted_subnets,
               "127.0.0.0/8,10.0.0.0/8,172.16.0.0/12,192.168.0.0/16,169.254.0.0/16",
               "A trusted subnet whitelist. If set explicitly, all unauthenticated "
@@ -106,6 +105,8 @@ static bool ValidateTrustedSubnets(const char* /*flagname*/, const string& value
 
 DEFINE_validator(trusted_subnets, &ValidateTrustedSubnets);
 
+DECLARE_bool(rpc_compression);
+
 namespace kudu {
 namespace rpc {
 
@@ -502,12 +503,16 @@ Status ServerNegotiation::HandleNegotiate(const NegotiatePB& request) {
   server_features_ = kSupportedServerRpcFeatureFlags;
   if (tls_context_->has_cert() && encryption_ != RpcEncryption::DISABLED) {
     server_features_.insert(TLS);
-    // If the remote peer is local, then we allow using TLS for authentication
-    // without encryption or integrity.
-    if (socket_->IsLoopbackConnection() && !FLAGS_rpc_encrypt_loopback_connections) {
+    // If the remote peer is local or in a subnet exempted from encryption,
+    // then we allow using TLS for authentication without encryption or
+    // integrity.
+    if (Negotiation::IsEncryptionExempt(*socket_)) {
       server_features_.insert(TLS_AUTHENTICATION_ONLY);
     }
   }
+  if (FLAGS_rpc_compression) {
+    server_features_.insert(COMPRESSION);
+  }
 
   for (RpcFeatureFlag feature : server_features_) {
     response.add_supported_features(feature);
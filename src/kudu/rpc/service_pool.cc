@@ -17,11 +17,15 @@
 
 #include "kudu/rpc/service_pool.h"
 
+#include <cctype>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <ostream>
+#include <mutex>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -32,6 +36,7 @@
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/move.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/inbound_call.h"
@@ -39,6 +44,8 @@
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/service_if.h"
 #include "kudu/rpc/service_queue.h"
+#include "kudu/util/debug/leakcheck_disabler.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/net/sockaddr.h"
@@ -72,15 +79,60 @@ METRIC_DEFINE_counter(server, rpcs_queue_overflow,
 namespace kudu {
 namespace rpc {
 
+namespace {
+
+// Returns the prototype of the queue time histogram of the service queue lane
+// named 'lane_name' of the service named 'service_name', e.g.
+// rpc_incoming_queue_time_kudu_tserver_TabletServerService_scan. Services are
+// named in the metric name, like their methods' handler_latency histograms,
+// so that pools on the same metric entity each get their own histograms.
+//
+// The metrics system expects prototypes and their names to outlive every
+// metric instantiated from them, so they are never freed.
+HistogramPrototype* LaneQueueTimePrototype(const string& service_name,
+                                           const string& lane_name) {
+  static simple_spinlock lock;
+  static auto* prototypes = new std::unordered_map<string, HistogramPrototype*>();
+  string name = Substitute("rpc_incoming_queue_time_$0_$1", service_name, lane_name);
+  for (char& c : name) {
+    if (!isalnum(c)) c = '_';
+  }
+  std::lock_guard<simple_spinlock> l(lock);
+  HistogramPrototype* prototype = FindPtrOrNull(*prototypes, name);
+  if (!prototype) {
+    debug::ScopedLeakCheckDisabler disabler;
+    string description = Substitute(
+        "Number of microseconds incoming RPC requests to $0 in the '$1' service "
+        "queue lane spend in the worker queue", service_name, lane_name);
+    prototype = new HistogramPrototype(MetricPrototype::CtorArgs(
+        "server", strdup(name.c_str()), "RPC Queue Time By Lane",
+        MetricUnit::kMicroseconds, strdup(description.c_str())),
+        60000000LU, 3);
+    InsertOrDie(prototypes, name, prototype);
+  }
+  return prototype;
+}
+
+} // anonymous namespace
+
 ServicePool::ServicePool(gscoped_ptr<ServiceIf> service,
                          const scoped_refptr<MetricEntity>& entity,
-                         size_t service_queue_length)
+                         size_t service_queue_length,
+                         std::shared_ptr<ServiceQueuePolicy> queue_policy)
   : service_(std::move(service)),
-    service_queue_(service_queue_length),
+    service_queue_(service_queue_length, std::move(queue_policy)),
     incoming_queue_time_(METRIC_rpc_incoming_queue_time.Instantiate(entity)),
     rpcs_timed_out_in_queue_(METRIC_rpcs_timed_out_in_queue.Instantiate(entity)),
     rpcs_queue_overflow_(METRIC_rpcs_queue_overflow.Instantiate(entity)),
     closing_(false) {
+  const ServiceQueuePolicy* policy = service_queue_.policy();
+  if (policy) {
+    for (int i = 0; i < policy->num_lanes(); i++) {
+      lane_queue_time_.emplace_back(
+          LaneQueueTimePrototype(service_->service_name(),
+                                 policy->lane_name(i))->Instantiate(entity));
+    }
+  }
 }
 
 ServicePool::~ServicePool() {
@@ -197,6 +249,10 @@ void ServicePool::RunThread() {
     }
 
     incoming->RecordHandlingStarted(incoming_queue_time_);
+    if (!lane_queue_time_.empty()) {
+      lane_queue_time_[service_queue_.Lane(*incoming)]->Increment(
+          (incoming->GetTimeHandled() - incoming->GetTimeReceived()).ToMicroseconds());
+    }
     ADOPT_TRACE(incoming->trace());
 
     if (PREDICT_FALSE(incoming->ClientTimedOut())) {
@@ -215,6 +271,13 @@ void ServicePool::RunThread() {
       continue;
     }
 
+    Status s = incoming->UncompressRequest();
+    if (PREDICT_FALSE(!s.ok())) {
+      incoming->RespondFailure(ErrorStatusPB::ERROR_INVALID_REQUEST, s);
+      ignore_result(incoming.release());
+      continue;
+    }
+
     TRACE_TO(incoming->trace(), "Handling call");
 
     // Release the InboundCall pointer -- when the call is responded to,
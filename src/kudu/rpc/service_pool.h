@@ -19,6 +19,7 @@
 #define KUDU_SERVICE_POOL_H
 
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -50,9 +51,12 @@ struct RpcMethodInfo;
 // Also includes a queue that calls get pushed onto for handling by the pool.
 class ServicePool : public RpcService {
  public:
+  // If 'queue_policy' is set, the service queue schedules calls across its
+  // lanes, and the time calls spend in the queue is also tracked per lane.
   ServicePool(gscoped_ptr<ServiceIf> service,
               const scoped_refptr<MetricEntity>& metric_entity,
-              size_t service_queue_length);
+              size_t service_queue_length,
+              std::shared_ptr<ServiceQueuePolicy> queue_policy = nullptr);
   virtual ~ServicePool();
 
   // Start up the thread pool.
@@ -73,12 +77,26 @@ class ServicePool : public RpcService {
     return incoming_queue_time_.get();
   }
 
+  const Histogram* LaneQueueTimeMetricForTests(int lane) const {
+    return lane_queue_time_[lane].get();
+  }
+
   const Counter* RpcsQueueOverflowMetric() const {
     return rpcs_queue_overflow_.get();
   }
 
   const std::string service_name() const;
 
+  // Return the number of worker threads of this pool.
+  int num_threads() const {
+    return threads_.size();
+  }
+
+  // Return the maximum number of calls in the service queue.
+  int max_queue_length() const {
+    return service_queue_.max_size();
+  }
+
  private:
   void RunThread();
   void RejectTooBusy(InboundCall* c);
@@ -87,6 +105,8 @@ class ServicePool : public RpcService {
   std::vector<scoped_refptr<kudu::Thread> > threads_;
   LifoServiceQueue service_queue_;
   scoped_refptr<Histogram> incoming_queue_time_;
+  // Indexed by lane. Empty if the service queue has no policy.
+  std::vector<scoped_refptr<Histogram>> lane_queue_time_;
   scoped_refptr<Counter> rpcs_timed_out_in_queue_;
   scoped_refptr<Counter> rpcs_queue_overflow_;
 
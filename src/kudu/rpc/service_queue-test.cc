@@ -15,8 +15,10 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -33,7 +35,9 @@
 #include "kudu/rpc/inbound_call.h"
 #include "kudu/rpc/service_queue.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
+#include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
 using std::shared_ptr;
@@ -147,5 +151,127 @@ TEST(TestServiceQueue, LifoServiceQueuePerf) {
   LOG(INFO) << "Avg idle workers:     " << total_idle_workers / static_cast<double>(total_sample);
 }
 
+TEST(TestServiceQueue, TestParseWeightedFairQueuePolicy) {
+  std::shared_ptr<ServiceQueuePolicy> policy;
+  ASSERT_OK(WeightedFairQueuePolicy::Create(
+      "method:Write=4, method:Scan=1,user:etl=8,default=2",
+      &policy));
+  ASSERT_EQ(4, policy->num_lanes());
+  ASSERT_EQ("default", policy->lane_name(0));
+  ASSERT_EQ(2, policy->weight(0));
+  ASSERT_EQ("method:Write", policy->lane_name(1));
+  ASSERT_EQ(4, policy->weight(1));
+  ASSERT_EQ("user:etl", policy->lane_name(3));
+  ASSERT_EQ(8, policy->weight(3));
+
+  for (const char* bad_spec : { "method:Write", "method:Write=0", "method:Write=x",
+                                "table:foo=1", "service:kudu.tserver.TabletServerService=1",
+                                "method:=1", "method:Write=1,method:Write=2" }) {
+    Status s = WeightedFairQueuePolicy::Create(bad_spec, &policy);
+    ASSERT_TRUE(s.IsInvalidArgument()) << bad_spec << ": " << s.ToString();
+  }
+}
+
+// Policy which assigns calls to lanes as configured by the test.
+class TestQueuePolicy : public ServiceQueuePolicy {
+ public:
+  explicit TestQueuePolicy(vector<int> weights)
+      : weights_(std::move(weights)) {
+    for (int i = 0; i < weights_.size(); i++) {
+      names_.emplace_back(std::to_string(i));
+    }
+  }
+
+  int num_lanes() const override { return weights_.size(); }
+  int Lane(const InboundCall& call) const override { return lanes_.at(&call); }
+  int weight(int lane) const override { return weights_[lane]; }
+  const string& lane_name(int lane) const override { return names_[lane]; }
+
+  InboundCall* NewCall(int lane) {
+    auto* call = new InboundCall(nullptr);
+    lanes_[call] = lane;
+    return call;
+  }
+
+ private:
+  const vector<int> weights_;
+  vector<string> names_;
+  std::map<const InboundCall*, int> lanes_;
+};
+
+// Test that queued calls are dequeued from lanes in proportion to their
+// weights, and that a full queue drops calls from the busiest lane.
+TEST(TestServiceQueue, TestWeightedLanes) {
+  auto policy = std::make_shared<TestQueuePolicy>(vector<int>({ 3, 1 }));
+  const int kQueueSize = 40;
+  LifoServiceQueue queue(kQueueSize, policy);
+
+  // Flood the queue with calls in lane 0.
+  for (int i = 0; i < kQueueSize; i++) {
+    boost::optional<InboundCall*> evicted;
+    ASSERT_EQ(QUEUE_SUCCESS, queue.Put(policy->NewCall(0), &evicted));
+    ASSERT_TRUE(evicted == boost::none);
+  }
+  // Calls in lane 1 still get queued, evicting calls from lane 0.
+  for (int i = 0; i < kQueueSize / 4; i++) {
+    boost::optional<InboundCall*> evicted;
+    ASSERT_EQ(QUEUE_SUCCESS, queue.Put(policy->NewCall(1), &evicted));
+    ASSERT_TRUE(evicted != boost::none);
+    ASSERT_EQ(0, policy->Lane(**evicted));
+    delete *evicted;
+  }
+  // Once the lanes are balanced by weight, calls in lane 0 only displace
+  // other calls in lane 0.
+  boost::optional<InboundCall*> evicted;
+  ASSERT_EQ(QUEUE_SUCCESS, queue.Put(policy->NewCall(0), &evicted));
+  ASSERT_TRUE(evicted != boost::none);
+  ASSERT_EQ(0, policy->Lane(**evicted));
+  delete *evicted;
+
+  // The first calls are dequeued three to one.
+  vector<int> lanes;
+  for (int i = 0; i < kQueueSize; i++) {
+    unique_ptr<InboundCall> call;
+    ASSERT_TRUE(queue.BlockingGet(&call));
+    lanes.push_back(policy->Lane(*call));
+  }
+  ASSERT_TRUE(queue.empty());
+  for (int i = 0; i < kQueueSize; i += 4) {
+    ASSERT_EQ(3, std::count(lanes.begin() + i, lanes.begin() + i + 4, 0)) << i;
+  }
+  queue.Shutdown();
+}
+
+// Test that a full queue evicts calls from a non-empty lane even when the
+// weight of the new call's empty lane exceeds the queue's capacity, so that
+// every other lane is lighter relative to its weight than the new call's.
+TEST(TestServiceQueue, TestEvictWithHeavyEmptyLane) {
+  const int kQueueSize = 10;
+  auto policy = std::make_shared<TestQueuePolicy>(vector<int>({ 1, kQueueSize * 10 }));
+  LifoServiceQueue queue(kQueueSize, policy);
+
+  for (int i = 0; i < kQueueSize; i++) {
+    boost::optional<InboundCall*> evicted;
+    ASSERT_EQ(QUEUE_SUCCESS, queue.Put(policy->NewCall(0), &evicted));
+    ASSERT_TRUE(evicted == boost::none);
+  }
+  // The new call's lane is empty, so the call is queued by evicting from
+  // lane 0, and so on until the heavier lane fills most of the queue.
+  for (int i = 0; i < kQueueSize - 1; i++) {
+    boost::optional<InboundCall*> evicted;
+    ASSERT_EQ(QUEUE_SUCCESS, queue.Put(policy->NewCall(1), &evicted));
+    ASSERT_TRUE(evicted != boost::none);
+    ASSERT_EQ(0, policy->Lane(**evicted));
+    delete *evicted;
+  }
+
+  for (int i = 0; i < kQueueSize; i++) {
+    unique_ptr<InboundCall> call;
+    ASSERT_TRUE(queue.BlockingGet(&call));
+  }
+  ASSERT_TRUE(queue.empty());
+  queue.Shutdown();
+}
+
 } // namespace rpc
 } // namespace kudu
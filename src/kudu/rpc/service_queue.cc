@@ -17,26 +17,121 @@
 
 #include "kudu/rpc/service_queue.h"
 
+#include <algorithm>
 #include <mutex>
 #include <ostream>
+#include <utility>
 
 #include <boost/optional/optional.hpp>
 
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
+#include "kudu/gutil/strings/strip.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/remote_method.h"
+#include "kudu/rpc/remote_user.h"
+
+using std::string;
+using std::unordered_map;
+using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 namespace rpc {
 
+namespace {
+// The stride of a lane with weight 1.
+const uint64_t kBaseStride = 1 << 20;
+} // anonymous namespace
+
+WeightedFairQueuePolicy::WeightedFairQueuePolicy()
+    : lanes_({ { "default", 1 } }) {
+}
+
+Status WeightedFairQueuePolicy::Create(const string& spec,
+                                       std::shared_ptr<ServiceQueuePolicy>* policy) {
+  std::shared_ptr<WeightedFairQueuePolicy> ret(new WeightedFairQueuePolicy());
+  for (StringPiece lane_spec : strings::Split(spec, ",", strings::SkipWhitespace())) {
+    string lane = lane_spec.ToString();
+    StripWhiteSpace(&lane);
+    vector<string> name_and_weight = strings::Split(lane, "=");
+    int32_t weight;
+    if (name_and_weight.size() != 2 ||
+        !safe_strto32(name_and_weight[1], &weight) ||
+        weight <= 0) {
+      return Status::InvalidArgument("invalid service queue lane", lane);
+    }
+    const string& name = name_and_weight[0];
+    if (name == "default") {
+      ret->lanes_[0].weight = weight;
+      continue;
+    }
+    vector<string> kind_and_key = strings::Split(name, strings::delimiter::Limit(":", 1));
+    unordered_map<string, int>* lanes;
+    if (kind_and_key.size() != 2 || kind_and_key[1].empty()) {
+      lanes = nullptr;
+    } else if (kind_and_key[0] == "user") {
+      lanes = &ret->user_lanes_;
+    } else if (kind_and_key[0] == "method") {
+      lanes = &ret->method_lanes_;
+    } else {
+      lanes = nullptr;
+    }
+    if (!lanes) {
+      return Status::InvalidArgument(
+          "service queue lanes must be one of 'user:<name>', 'method:<name>', "
+          "or 'default'", name);
+    }
+    if (!InsertIfNotPresent(lanes, kind_and_key[1], ret->lanes_.size())) {
+      return Status::InvalidArgument("duplicate service queue lane", name);
+    }
+    ret->lanes_.push_back({ name, weight });
+  }
+  *policy = std::move(ret);
+  return Status::OK();
+}
+
+int WeightedFairQueuePolicy::Lane(const InboundCall& call) const {
+  if (!user_lanes_.empty()) {
+    const int* lane = FindOrNull(user_lanes_, call.remote_user().username());
+    if (lane) {
+      return *lane;
+    }
+  }
+  if (!method_lanes_.empty()) {
+    const int* lane = FindOrNull(method_lanes_, call.remote_method().method_name());
+    if (lane) {
+      return *lane;
+    }
+  }
+  return 0;
+}
+
 __thread LifoServiceQueue::ConsumerState* LifoServiceQueue::tl_consumer_ = nullptr;
 
-LifoServiceQueue::LifoServiceQueue(int max_size)
-   : shutdown_(false),
-     max_queue_size_(max_size) {
+LifoServiceQueue::LifoServiceQueue(int max_size,
+                                   std::shared_ptr<ServiceQueuePolicy> policy)
+   : policy_(std::move(policy)),
+     shutdown_(false),
+     max_queue_size_(max_size),
+     queue_size_(0),
+     virtual_time_(0) {
   CHECK_GT(max_queue_size_, 0);
+  int num_lanes = policy_ ? policy_->num_lanes() : 1;
+  CHECK_GT(num_lanes, 0);
+  lanes_.resize(num_lanes);
+  for (int i = 0; i < num_lanes; i++) {
+    int weight = policy_ ? policy_->weight(i) : 1;
+    CHECK_GT(weight, 0);
+    lanes_[i].stride = kBaseStride / weight;
+    lanes_[i].pass = 0;
+  }
 }
 
 LifoServiceQueue::~LifoServiceQueue() {
-  DCHECK(queue_.empty())
+  DCHECK_EQ(0, queue_size_)
       << "ServiceQueue holds bare pointers at destruction time";
 }
 
@@ -51,10 +146,20 @@ bool LifoServiceQueue::BlockingGet(std::unique_ptr<InboundCall>* out) {
   while (true) {
     {
       std::lock_guard<simple_spinlock> l(lock_);
-      if (!queue_.empty()) {
-        auto it = queue_.begin();
+      if (queue_size_ > 0) {
+        LaneQueue* next = nullptr;
+        for (auto& lane : lanes_) {
+          if (!lane.calls.empty() && (!next || lane.pass < next->pass)) {
+            next = &lane;
+          }
+        }
+        DCHECK(next);
+        auto it = next->calls.begin();
         out->reset(*it);
-        queue_.erase(it);
+        next->calls.erase(it);
+        queue_size_--;
+        virtual_time_ = next->pass;
+        next->pass += next->stride;
         return true;
       }
       if (PREDICT_FALSE(shutdown_)) {
@@ -80,10 +185,10 @@ QueueStatus LifoServiceQueue::Put(InboundCall* call,
     return QUEUE_SHUTDOWN;
   }
 
-  DCHECK(!(waiting_consumers_.size() > 0 && queue_.size() > 0));
+  DCHECK(!(waiting_consumers_.size() > 0 && queue_size_ > 0));
 
   // fast path
-  if (queue_.empty() && waiting_consumers_.size() > 0) {
+  if (queue_size_ == 0 && waiting_consumers_.size() > 0) {
     auto consumer = waiting_consumers_[waiting_consumers_.size() - 1];
     waiting_consumers_.pop_back();
     // Notify condition var(and wake up consumer thread) takes time,
@@ -93,23 +198,60 @@ QueueStatus LifoServiceQueue::Put(InboundCall* call,
     return QUEUE_SUCCESS;
   }
 
-  if (PREDICT_FALSE(queue_.size() >= max_queue_size_)) {
+  int lane_idx = Lane(*call);
+  DCHECK_GE(lane_idx, 0);
+  DCHECK_LT(lane_idx, lanes_.size());
+  if (PREDICT_FALSE(queue_size_ >= max_queue_size_)) {
     // eviction
-    DCHECK_EQ(queue_.size(), max_queue_size_);
-    auto it = queue_.end();
+    DCHECK_EQ(queue_size_, max_queue_size_);
+    int evict_idx = LaneToEvictUnlocked(lane_idx);
+    auto& evict_lane = lanes_[evict_idx];
+    auto it = evict_lane.calls.end();
     --it;
-    if (DeadlineLess(*it, call)) {
+    if (evict_idx == lane_idx && DeadlineLess(*it, call)) {
       return QUEUE_FULL;
     }
 
     *evicted = *it;
-    queue_.erase(it);
+    evict_lane.calls.erase(it);
+    queue_size_--;
   }
 
-  queue_.insert(call);
+  auto& lane = lanes_[lane_idx];
+  if (lane.calls.empty()) {
+    lane.pass = std::max(lane.pass, virtual_time_);
+  }
+  lane.calls.insert(call);
+  queue_size_++;
   return QUEUE_SUCCESS;
 }
 
+int LifoServiceQueue::LaneToEvictUnlocked(int new_call_lane) const {
+  // Compare each lane's queued calls per unit of weight, i.e. its length
+  // times its stride, counting the new call in its own lane. If the new
+  // call's lane is empty, there is nothing to evict from it, however light
+  // the other lanes are relative to their weights: evict from the most
+  // loaded of the other lanes instead.
+  int ret = -1;
+  uint64_t max_load = 0;
+  if (!lanes_[new_call_lane].calls.empty()) {
+    ret = new_call_lane;
+    max_load = (lanes_[new_call_lane].calls.size() + 1) * lanes_[new_call_lane].stride;
+  }
+  for (int i = 0; i < lanes_.size(); i++) {
+    if (lanes_[i].calls.empty()) {
+      continue;
+    }
+    uint64_t load = lanes_[i].calls.size() * lanes_[i].stride;
+    if (ret == -1 || load > max_load) {
+      ret = i;
+      max_load = load;
+    }
+  }
+  DCHECK_NE(-1, ret);
+  return ret;
+}
+
 void LifoServiceQueue::Shutdown() {
   std::lock_guard<simple_spinlock> l(lock_);
   shutdown_ = true;
@@ -123,7 +265,7 @@ void LifoServiceQueue::Shutdown() {
 
 bool LifoServiceQueue::empty() const {
   std::lock_guard<simple_spinlock> l(lock_);
-  return queue_.empty();
+  return queue_size_ == 0;
 }
 
 int LifoServiceQueue::max_size() const {
@@ -134,9 +276,14 @@ std::string LifoServiceQueue::ToString() const {
   std::string ret;
 
   std::lock_guard<simple_spinlock> l(lock_);
-  for (const auto* t : queue_) {
-    ret.append(t->ToString());
-    ret.append("\n");
+  for (int i = 0; i < lanes_.size(); i++) {
+    if (policy_ && !lanes_[i].calls.empty()) {
+      ret.append(Substitute("Lane $0:\n", policy_->lane_name(i)));
+    }
+    for (const auto* t : lanes_[i].calls) {
+      ret.append(t->ToString());
+      ret.append("\n");
+    }
   }
   return ret;
 }
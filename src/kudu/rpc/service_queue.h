@@ -17,9 +17,11 @@
 #ifndef KUDU_UTIL_SERVICE_QUEUE_H
 #define KUDU_UTIL_SERVICE_QUEUE_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include <glog/logging.h>
@@ -31,6 +33,7 @@
 #include "kudu/util/locks.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/mutex.h"
+#include "kudu/util/status.h"
 
 namespace boost {
 template <class T>
@@ -47,11 +50,88 @@ enum QueueStatus {
   QUEUE_FULL = 2
 };
 
+// Policy which divides the calls of a LifoServiceQueue into lanes. Queued
+// calls are dequeued from the lanes in proportion to the lanes' weights, so
+// that a flood of calls in one lane doesn't starve the others.
+//
+// Implementations must be thread-safe.
+class ServiceQueuePolicy {
+ public:
+  virtual ~ServiceQueuePolicy() {}
+
+  // Return the number of lanes. Must be constant and positive.
+  virtual int num_lanes() const = 0;
+
+  // Return the lane of 'call', in the range [0, num_lanes()).
+  virtual int Lane(const InboundCall& call) const = 0;
+
+  // Return the weight of 'lane'. Must be constant and positive.
+  virtual int weight(int lane) const = 0;
+
+  // Return the name of 'lane', for metrics and logging.
+  virtual const std::string& lane_name(int lane) const = 0;
+};
+
+// Policy which assigns calls to lanes by their remote user or method,
+// configured by a comma-separated list of lane specifications of the form
+// '<kind>:<name>=<weight>', where <kind> is 'user' or 'method'. For example:
+//
+//   method:Write=4,method:Scan=1,user:etl=1
+//
+// Calls are matched by their remote user first, then by their method. Calls
+// which match no lane go to the default lane, whose weight is 1 unless the
+// list includes 'default=<weight>'.
+//
+// Each service has its own queue, so lanes only divide the calls of a single
+// service; they don't arbitrate between services.
+class WeightedFairQueuePolicy : public ServiceQueuePolicy {
+ public:
+  // Parse 'spec' into a new policy. Returns an error if 'spec' is malformed.
+  static Status Create(const std::string& spec,
+                       std::shared_ptr<ServiceQueuePolicy>* policy);
+
+  int num_lanes() const override {
+    return lanes_.size();
+  }
+
+  int Lane(const InboundCall& call) const override;
+
+  int weight(int lane) const override {
+    return lanes_[lane].weight;
+  }
+
+  const std::string& lane_name(int lane) const override {
+    return lanes_[lane].name;
+  }
+
+ private:
+  struct LaneSpec {
+    std::string name;
+    int weight;
+  };
+
+  WeightedFairQueuePolicy();
+
+  // Lane 0 is the default lane.
+  std::vector<LaneSpec> lanes_;
+
+  // Lanes keyed by the remote user and the method name.
+  std::unordered_map<std::string, int> user_lanes_;
+  std::unordered_map<std::string, int> method_lanes_;
+};
+
 // Blocking queue used for passing inbound RPC calls to the service handler pool.
 // Calls are dequeued in 'earliest-deadline first' order. The queue also maintains a
 // bounded number of calls. If the queue overflows, then calls with deadlines farthest
 // in the future are evicted.
 //
+// If the queue has a ServiceQueuePolicy, calls are queued in the lanes of the
+// policy, each ordered by deadline. Lanes are dequeued using stride scheduling:
+// every dequeue from a lane advances its 'pass' by a stride inversely
+// proportional to its weight, and the next call comes from the non-empty lane
+// with the lowest pass. If the queue overflows, the evicted call comes from the
+// lane with the most queued calls relative to its weight.
+//
 // When calls do not provide deadlines, the RPC layer considers their deadline to
 // be infinitely in the future. This means that any call that does have a deadline
 // can evict any call that does not have a deadline. This incentivizes clients to
@@ -77,7 +157,9 @@ enum QueueStatus {
 // must never access any other instance.
 class LifoServiceQueue {
  public:
-  explicit LifoServiceQueue(int max_size);
+  // If 'policy' is null, all calls share a single lane.
+  explicit LifoServiceQueue(int max_size,
+                            std::shared_ptr<ServiceQueuePolicy> policy = nullptr);
 
   ~LifoServiceQueue();
 
@@ -110,14 +192,19 @@ class LifoServiceQueue {
 
   std::string ToString() const;
 
+  // Return the lane of 'call' under this queue's policy.
+  int Lane(const InboundCall& call) const {
+    return policy_ ? policy_->Lane(call) : 0;
+  }
+
+  const ServiceQueuePolicy* policy() const {
+    return policy_.get();
+  }
+
   // Return an estimate of the current queue length.
   int estimated_queue_length() const {
     ANNOTATE_IGNORE_READS_BEGIN();
-    // The C++ standard says that std::multiset::size must be constant time,
-    // so this method won't try to traverse any actual nodes of the underlying
-    // RB tree. Investigation of the libstdcxx implementation confirms that
-    // size() is a simple field access of the _Rb_tree structure.
-    int ret = queue_.size();
+    int ret = queue_size_;
     ANNOTATE_IGNORE_READS_END();
     return ret;
   }
@@ -200,8 +287,26 @@ class LifoServiceQueue {
     LifoServiceQueue* bound_queue_;
   };
 
+  // The queued calls of a single lane.
+  struct LaneQueue {
+    std::multiset<InboundCall*, DeadlineLessStruct> calls;
+
+    // The amount 'pass' advances by each time a call is dequeued.
+    uint64_t stride;
+
+    // The virtual time at which the lane is next scheduled.
+    uint64_t pass;
+  };
+
+  // Return the index of the lane to evict a call from to make room for a
+  // call in 'new_call_lane', which may be that lane itself. The returned lane
+  // is never empty, so the queue must be full.
+  int LaneToEvictUnlocked(int new_call_lane) const;
+
   static __thread ConsumerState* tl_consumer_;
 
+  const std::shared_ptr<ServiceQueuePolicy> policy_;
+
   mutable simple_spinlock lock_;
   bool shutdown_;
   int max_queue_size_;
@@ -211,7 +316,14 @@ class LifoServiceQueue {
 
   // The actual queue. Work is only added to the queue when there were no
   // consumers available for a "direct hand-off".
-  std::multiset<InboundCall*, DeadlineLessStruct> queue_;
+  std::vector<LaneQueue> lanes_;
+
+  // The total number of calls in 'lanes_'.
+  int queue_size_;
+
+  // The pass of the lane most recently dequeued from. Lanes which become
+  // non-empty start from here, so idle lanes don't accumulate credit.
+  uint64_t virtual_time_;
 
   // The total set of consumers who have ever accessed this queue.
   std::vector<std::unique_ptr<ConsumerState>> consumers_;
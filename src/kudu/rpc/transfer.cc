@@ -19,7 +19,9 @@
 
 #include <sys/uio.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <set>
 
@@ -75,6 +77,27 @@ InboundTransfer::InboundTransfer()
   buf_.resize(kMsgLengthPrefixLength);
 }
 
+Status InboundTransfer::ProcessInboundHeader() {
+  // Since we never receive more than the length prefix before processing it,
+  // we should now have exactly the length prefix in our buffer and no more.
+  DCHECK_EQ(cur_offset_, kMsgLengthPrefixLength);
+
+  // The length prefix doesn't include its own 4 bytes, so we have to
+  // add that back in.
+  total_length_ = NetworkByteOrder::Load32(&buf_[0]) + kMsgLengthPrefixLength;
+  if (total_length_ > FLAGS_rpc_max_message_size) {
+    return Status::NetworkError(Substitute(
+        "RPC frame had a length of $0, but we only support messages up to $1 bytes "
+        "long.", total_length_, FLAGS_rpc_max_message_size));
+  }
+  if (total_length_ <= kMsgLengthPrefixLength) {
+    return Status::NetworkError(Substitute("RPC frame had invalid length of $0",
+                                           total_length_));
+  }
+  buf_.resize(total_length_);
+  return Status::OK();
+}
+
 Status InboundTransfer::ReceiveBuffer(Socket &socket) {
   if (cur_offset_ < kMsgLengthPrefixLength) {
     // receive int32 length prefix
@@ -92,23 +115,7 @@ Status InboundTransfer::ReceiveBuffer(Socket &socket) {
       // reading yet.
       return Status::OK();
     }
-    // Since we only read 'rem' bytes above, we should now have exactly
-    // the length prefix in our buffer and no more.
-    DCHECK_EQ(cur_offset_, kMsgLengthPrefixLength);
-
-    // The length prefix doesn't include its own 4 bytes, so we have to
-    // add that back in.
-    total_length_ = NetworkByteOrder::Load32(&buf_[0]) + kMsgLengthPrefixLength;
-    if (total_length_ > FLAGS_rpc_max_message_size) {
-      return Status::NetworkError(Substitute(
-          "RPC frame had a length of $0, but we only support messages up to $1 bytes "
-          "long.", total_length_, FLAGS_rpc_max_message_size));
-    }
-    if (total_length_ <= kMsgLengthPrefixLength) {
-      return Status::NetworkError(Substitute("RPC frame had invalid length of $0",
-                                             total_length_));
-    }
-    buf_.resize(total_length_);
+    RETURN_NOT_OK(ProcessInboundHeader());
 
     // Fall through to receive the message body, which is likely to be already
     // available on the socket.
@@ -124,6 +131,25 @@ Status InboundTransfer::ReceiveBuffer(Socket &socket) {
   return Status::OK();
 }
 
+Status InboundTransfer::ReceiveFromSlice(Slice* data) {
+  if (cur_offset_ < kMsgLengthPrefixLength) {
+    int32_t n = std::min<size_t>(kMsgLengthPrefixLength - cur_offset_, data->size());
+    memcpy(&buf_[cur_offset_], data->data(), n);
+    data->remove_prefix(n);
+    cur_offset_ += n;
+    if (cur_offset_ < kMsgLengthPrefixLength) {
+      return Status::OK();
+    }
+    RETURN_NOT_OK(ProcessInboundHeader());
+  }
+
+  int32_t n = std::min<size_t>(total_length_ - cur_offset_, data->size());
+  memcpy(&buf_[cur_offset_], data->data(), n);
+  data->remove_prefix(n);
+  cur_offset_ += n;
+  return Status::OK();
+}
+
 bool InboundTransfer::TransferStarted() const {
   return cur_offset_ != 0;
 }
@@ -180,40 +206,39 @@ void OutboundTransfer::Abort(const Status &status) {
   aborted_ = true;
 }
 
-Status OutboundTransfer::SendBuffer(Socket &socket) {
-  CHECK_LT(cur_slice_idx_, n_payload_slices_);
-
+int OutboundTransfer::FillIovecs(struct iovec* iov, int max_iovecs) const {
+  DCHECK_LT(cur_slice_idx_, n_payload_slices_);
   int n_iovecs = n_payload_slices_ - cur_slice_idx_;
-  struct iovec iovec[n_iovecs];
-  {
-    int offset_in_slice = cur_offset_in_slice_;
-    for (int i = 0; i < n_iovecs; i++) {
-      Slice &slice = payload_slices_[cur_slice_idx_ + i];
-      iovec[i].iov_base = slice.mutable_data() + offset_in_slice;
-      iovec[i].iov_len = slice.size() - offset_in_slice;
-
-      offset_in_slice = 0;
-    }
+  if (n_iovecs > max_iovecs) {
+    return 0;
   }
+  int offset_in_slice = cur_offset_in_slice_;
+  for (int i = 0; i < n_iovecs; i++) {
+    const Slice &slice = payload_slices_[cur_slice_idx_ + i];
+    iov[i].iov_base = const_cast<uint8_t*>(slice.data()) + offset_in_slice;
+    iov[i].iov_len = slice.size() - offset_in_slice;
 
-  int32_t written;
-  Status status = socket.Writev(iovec, n_iovecs, &written);
-  RETURN_ON_ERROR_OR_SOCKET_NOT_READY(status);
+    offset_in_slice = 0;
+  }
+  return n_iovecs;
+}
 
+void OutboundTransfer::AdvanceWritten(int32_t* written) {
   // Adjust our accounting of current writer position.
   for (int i = cur_slice_idx_; i < n_payload_slices_; i++) {
     Slice &slice = payload_slices_[i];
     int rem_in_slice = slice.size() - cur_offset_in_slice_;
     DCHECK_GE(rem_in_slice, 0);
 
-    if (written >= rem_in_slice) {
+    if (*written >= rem_in_slice) {
       // Used up this entire slice, advance to the next slice.
       cur_slice_idx_++;
       cur_offset_in_slice_ = 0;
-      written -= rem_in_slice;
+      *written -= rem_in_slice;
     } else {
       // Partially used up this slice, just advance the offset within it.
-      cur_offset_in_slice_ += written;
+      cur_offset_in_slice_ += *written;
+      *written = 0;
       break;
     }
   }
@@ -225,8 +250,6 @@ Status OutboundTransfer::SendBuffer(Socket &socket) {
     DCHECK_LT(cur_slice_idx_, n_payload_slices_);
     DCHECK_LT(cur_offset_in_slice_, payload_slices_[cur_slice_idx_].size());
   }
-
-  return Status::OK();
 }
 
 bool OutboundTransfer::TransferStarted() const {
@@ -35,6 +35,8 @@
 
 DECLARE_int32(rpc_max_message_size);
 
+struct iovec;
+
 namespace kudu {
 
 class Socket;
@@ -69,6 +71,17 @@ class InboundTransfer {
   // read from the socket into our buffer
   Status ReceiveBuffer(Socket &socket);
 
+  // Receive from 'data', which was read ahead from the socket, rather than
+  // from the socket itself. Consumes the bytes of 'data' that belong to this
+  // transfer, leaving any that follow it.
+  Status ReceiveFromSlice(Slice* data);
+
+  // Return the number of bytes known to be still missing from this transfer.
+  // Until the length prefix is received, this only accounts for the prefix.
+  int32_t bytes_remaining() const {
+    return total_length_ - cur_offset_;
+  }
+
   // Return true if any bytes have yet been sent.
   bool TransferStarted() const;
 
@@ -85,6 +98,8 @@ class InboundTransfer {
 
  private:
 
+  // Parse and validate the length prefix once it has been received, sizing
+  // the buffer for the rest of the transfer.
   Status ProcessInboundHeader();
 
   faststring buf_;
@@ -136,8 +151,16 @@ class OutboundTransfer : public boost::intrusive::list_base_hook<> {
   // This triggers TransferCallbacks::NotifyTransferAborted.
   void Abort(const Status &status);
 
-  // send from our buffers into the sock
-  Status SendBuffer(Socket &socket);
+  // Fill 'iov' with the data which is still to be sent, so that it can be
+  // written to the socket along with the data of other transfers. Returns the
+  // number of iovecs filled, or 0 if more than 'max_iovecs' would be needed.
+  int FillIovecs(struct iovec* iov, int max_iovecs) const;
+
+  // Account for the first '*written' bytes of the data returned by
+  // FillIovecs() having been written to the socket, subtracting from
+  // '*written' the bytes which belonged to this transfer. Triggers
+  // TransferCallbacks::NotifyTransferFinished if the transfer is complete.
+  void AdvanceWritten(int32_t* written);
 
   // Return true if any bytes have yet been sent.
   bool TransferStarted() const;
@@ -82,6 +82,15 @@ DEFINE_string(rpc_tls_min_protocol, "TLSv1",
               "'TLSv1.2'.");
 TAG_FLAG(rpc_tls_min_protocol, advanced);
 
+DEFINE_bool(rpc_tls_kernel_offload, false,
+            "Whether to hand the record encryption of TLS-secured RPC connections "
+            "off to the kernel (kTLS) once the handshake completes. Only takes effect "
+            "for TLSv1.3 connections, with OpenSSL 3.2 or newer built with kTLS "
+            "support and a kernel with the 'tls' module loaded; otherwise, and for "
+            "connections for which the kernel refuses the offload, records are "
+            "encrypted by OpenSSL as usual.");
+TAG_FLAG(rpc_tls_kernel_offload, experimental);
+
 namespace kudu {
 namespace security {
 
@@ -102,6 +111,19 @@ TlsContext::TlsContext()
   security::InitializeOpenSSL();
 }
 
+bool TlsContext::KernelOffloadSupported() {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS) && \
+    defined(TLS1_3_VERSION) && OPENSSL_VERSION_NUMBER >= 0x30200000L
+  // The handshake runs over memory BIOs, so the keys it negotiates are never
+  // offered to the kernel; only the keys derived by a later key update are.
+  // Before 3.2, OpenSSL doesn't configure kTLS on a key update at all. Check
+  // the runtime library too, in case an older one is picked up.
+  return OpenSSL_version_num() >= 0x30200000L;
+#else
+  return false;
+#endif
+}
+
 Status TlsContext::Init() {
   SCOPED_OPENSSL_NO_PENDING_ERRORS;
   CHECK(!ctx_);
@@ -147,6 +169,22 @@ Status TlsContext::Init() {
                                    FLAGS_rpc_tls_min_protocol);
   }
 
+  if (FLAGS_rpc_tls_kernel_offload) {
+    if (KernelOffloadSupported()) {
+#ifdef SSL_OP_ENABLE_KTLS
+      // OpenSSL installs the traffic keys into the socket with
+      // setsockopt(SOL_TLS) when the TLS 1.3 key update scheduled by
+      // TlsHandshake::Finish() takes place, if the kernel and the cipher suite
+      // allow it, and silently keeps encrypting in user space otherwise.
+      options |= SSL_OP_ENABLE_KTLS;
+#endif
+    } else {
+      LOG(WARNING) << "--rpc_tls_kernel_offload requires OpenSSL 3.2 or newer "
+                   << "built with kTLS support (built against: " << OPENSSL_VERSION_TEXT
+                   << "); TLS records will be encrypted in user space";
+    }
+  }
+
   SSL_CTX_set_options(ctx_.get(), options);
 
   OPENSSL_RET_NOT_OK(
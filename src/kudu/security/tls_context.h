@@ -75,6 +75,12 @@ class TlsContext {
 
   Status Init() WARN_UNUSED_RESULT;
 
+  // Returns true if the OpenSSL library in use can hand the record encryption
+  // of established connections off to the kernel (see
+  // --rpc_tls_kernel_offload). Whether the kernel accepts the offload is only
+  // known once a connection is set up.
+  static bool KernelOffloadSupported();
+
   // Returns true if this TlsContext has been configured with a cert and key for
   // use with TLS-encrypted connections.
   bool has_cert() const {
@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 
+#include <glog/logging.h>
 #include <openssl/ssl.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
@@ -210,6 +211,25 @@ Status TlsHandshake::Finish(unique_ptr<Socket>* socket) {
     return Status::RuntimeError("TLS handshake error", GetOpenSSLErrors());
   }
 
+#if defined(SSL_OP_ENABLE_KTLS) && defined(TLS1_3_VERSION)
+  // With --rpc_tls_kernel_offload, OpenSSL installs the traffic keys into the
+  // kernel whenever the application write keys change, but only if the write
+  // BIO is a socket at that point. The handshake above ran over memory BIOs, so
+  // ask for a TLS 1.3 key update now that the SSL instance is bound to the
+  // socket: the KeyUpdate message goes out with the first write, and the
+  // freshly derived keys are handed to the kernel. The peer decrypts the
+  // resulting records as usual, so this needs no support on the other side.
+  // SSL_OP_ENABLE_KTLS is only set when TlsContext::KernelOffloadSupported(),
+  // i.e. when OpenSSL configures kTLS on key updates (3.2 and newer).
+  if ((SSL_get_options(ssl_.get()) & SSL_OP_ENABLE_KTLS) &&
+      SSL_version(ssl_.get()) >= TLS1_3_VERSION &&
+      SSL_key_update(ssl_.get(), SSL_KEY_UPDATE_NOT_REQUESTED) != 1) {
+    // Not fatal: the connection keeps encrypting in user space.
+    VLOG(2) << "unable to schedule TLS key update for kernel offload: "
+            << GetOpenSSLErrors();
+  }
+#endif
+
   // Transfer the SSL instance to the socket.
   socket->reset(new TlsSocket(fd, std::move(ssl_)));
 
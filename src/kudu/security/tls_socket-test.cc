@@ -34,12 +34,17 @@
 #include <thread>
 #include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include "kudu/gutil/casts.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/security/tls_context.h"
+#include "kudu/security/tls_socket.h"
 #include "kudu/util/countdown_latch.h"
+#include "kudu/util/env.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/net/socket.h"
@@ -50,6 +55,8 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(rpc_tls_kernel_offload);
+
 using std::string;
 using std::thread;
 using std::unique_ptr;
@@ -335,5 +342,66 @@ TEST_F(TlsSocketTest, TestNonBlockingWritev) {
   ASSERT_OK(client_sock->Close());
 }
 
+class TlsSocketKernelOffloadTest : public TlsSocketTest {
+ public:
+  void SetUp() override {
+    FLAGS_rpc_tls_kernel_offload = true;
+    TlsSocketTest::SetUp();
+  }
+};
+
+// Test that record encryption is handed off to the kernel when both OpenSSL
+// and the kernel support it, and that data round-trips intact afterwards.
+TEST_F(TlsSocketKernelOffloadTest, TestWritevRoundTrip) {
+  if (!TlsContext::KernelOffloadSupported()) {
+    LOG(WARNING) << "OpenSSL doesn't support kernel TLS offload: skipping test";
+    return;
+  }
+  faststring ulps;
+  if (!ReadFileToString(Env::Default(), "/proc/sys/net/ipv4/tcp_available_ulp", &ulps).ok() ||
+      ulps.ToString().find("tls") == string::npos) {
+    LOG(WARNING) << "kernel 'tls' module not loaded: skipping test";
+    return;
+  }
+  Random rng(GetRandomSeed32());
+
+  EchoServer server;
+  NO_FATALS(server.Start());
+
+  unique_ptr<Socket> client_sock;
+  NO_FATALS(ConnectClient(server.listen_addr(), &client_sock));
+
+  unique_ptr<uint8_t[]> buf(new uint8_t[kEchoChunkSize]);
+  unique_ptr<uint8_t[]> rbuf(new uint8_t[kEchoChunkSize]);
+  for (int i = 0; i < 3; i++) {
+    RandomString(buf.get(), kEchoChunkSize, &rng);
+    vector<struct iovec> iov = ChunkIOVec(&rng, buf.get(), kEchoChunkSize, 1024 * 1024);
+    int rem = kEchoChunkSize;
+    while (rem > 0) {
+      int32_t n;
+      ASSERT_OK(client_sock->Writev(&iov[0], iov.size(), &n));
+      rem -= n;
+      while (n > 0) {
+        if (n < iov[0].iov_len) {
+          iov[0].iov_len -= n;
+          iov[0].iov_base = reinterpret_cast<uint8_t*>(iov[0].iov_base) + n;
+          n = 0;
+        } else {
+          n -= iov[0].iov_len;
+          iov.erase(iov.begin());
+        }
+      }
+    }
+    size_t n;
+    ASSERT_OK(client_sock->BlockingRecv(rbuf.get(), kEchoChunkSize, &n,
+        MonoTime::Now() + kTimeout));
+    ASSERT_EQ(0, memcmp(buf.get(), rbuf.get(), kEchoChunkSize));
+  }
+  ASSERT_TRUE(down_cast<TlsSocket*>(client_sock.get())->kernel_send_offload());
+
+  server.Stop();
+  ASSERT_OK(client_sock->Close());
+}
+
 } // namespace security
 } // namespace kudu
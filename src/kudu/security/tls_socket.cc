@@ -35,13 +35,28 @@ namespace security {
 
 TlsSocket::TlsSocket(int fd, c_unique_ptr<SSL> ssl)
     : Socket(fd),
-      ssl_(std::move(ssl)) {
+      ssl_(std::move(ssl)),
+      ktls_requested_(false),
+      ktls_send_(false) {
+#ifdef SSL_OP_ENABLE_KTLS
+  ktls_requested_ = SSL_get_options(ssl_.get()) & SSL_OP_ENABLE_KTLS;
+  MaybeEnableSendOffload();
+#endif
 }
 
 TlsSocket::~TlsSocket() {
   ignore_result(Close());
 }
 
+void TlsSocket::MaybeEnableSendOffload() {
+#ifdef SSL_OP_ENABLE_KTLS
+  if (ktls_requested_ && !ktls_send_ && BIO_get_ktls_send(SSL_get_wbio(ssl_.get()))) {
+    VLOG(2) << "TLS record encryption offloaded to the kernel on fd " << GetFd();
+    ktls_send_ = true;
+  }
+#endif
+}
+
 Status TlsSocket::Write(const uint8_t *buf, int32_t amt, int32_t *nwritten) {
   CHECK(ssl_);
   SCOPED_OPENSSL_NO_PENDING_ERRORS;
@@ -53,6 +68,9 @@ Status TlsSocket::Write(const uint8_t *buf, int32_t amt, int32_t *nwritten) {
     // it, because SSL_write can return '0' to indicate certain types of errors.
     return Status::OK();
   }
+  if (ktls_send_) {
+    return Socket::Write(buf, amt, nwritten);
+  }
 
   errno = 0;
   int32_t bytes_written = SSL_write(ssl_.get(), buf, amt);
@@ -71,12 +89,22 @@ Status TlsSocket::Write(const uint8_t *buf, int32_t amt, int32_t *nwritten) {
                                 GetSSLErrorDescription(error_code));
   }
   *nwritten = bytes_written;
+  // With partial writes enabled, a positive return means OpenSSL holds no
+  // pending record, so it's safe to switch to writing directly from here on.
+  if (ktls_requested_) {
+    MaybeEnableSendOffload();
+  }
   return Status::OK();
 }
 
 Status TlsSocket::Writev(const struct ::iovec *iov, int iov_len, int32_t *nwritten) {
   SCOPED_OPENSSL_NO_PENDING_ERRORS;
   CHECK(ssl_);
+  if (ktls_send_) {
+    // The kernel splits the plaintext into records itself, so the whole batch
+    // goes out with a single sendmsg() and no corking is needed.
+    return Socket::Writev(iov, iov_len, nwritten);
+  }
   int32_t total_written = 0;
   // Allows packets to be aggresively be accumulated before sending.
   RETURN_NOT_OK(SetTcpCork(1));
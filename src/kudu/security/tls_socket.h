@@ -46,14 +46,30 @@ class TlsSocket : public Socket {
 
   Status Close() override WARN_UNUSED_RESULT;
 
+  // Whether outbound records on this socket are encrypted by the kernel (kTLS)
+  // rather than by OpenSSL. See --rpc_tls_kernel_offload.
+  bool kernel_send_offload() const { return ktls_send_; }
+
  private:
 
   friend class TlsHandshake;
 
   TlsSocket(int fd, c_unique_ptr<SSL> ssl);
 
+  // Checks whether OpenSSL has handed the write keys off to the kernel, which
+  // happens once the key update scheduled by TlsHandshake::Finish() is sent.
+  void MaybeEnableSendOffload();
+
   // Owned SSL handle.
   c_unique_ptr<SSL> ssl_;
+
+  // Whether kernel offload was requested for this connection, and whether the
+  // kernel accepted it for outbound records. Once 'ktls_send_' is set, writes
+  // bypass OpenSSL and go straight to the socket, where the kernel frames and
+  // encrypts them; reads still go through SSL_read(), which decrypts the
+  // records sent by the peer.
+  bool ktls_requested_;
+  bool ktls_send_;
 };
 
 } // namespace security
@@ -28,12 +28,16 @@
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/move.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/acceptor_pool.h"
 #include "kudu/rpc/messenger.h"
 #include "kudu/rpc/rpc_service.h"
 #include "kudu/rpc/service_if.h"
 #include "kudu/rpc/service_pool.h"
+#include "kudu/rpc/service_queue.h"
 #include "kudu/server/rpc_server.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/net/net_util.h"
@@ -73,6 +77,30 @@ DEFINE_int32(rpc_service_queue_length, 50,
              "Default length of queue for incoming RPC requests");
 TAG_FLAG(rpc_service_queue_length, advanced);
 
+DEFINE_string(rpc_service_pool_sizes, "",
+              "Comma-separated list of '<service name>=<num threads>:<queue length>' "
+              "entries overriding the number of RPC worker threads and the queue length "
+              "of individual services, for example "
+              "'kudu.consensus.ConsensusService=16:500'. Each service has its own pool "
+              "of worker threads and its own queue; services not listed use "
+              "their defaults, which for most services are --rpc_num_service_threads "
+              "and --rpc_service_queue_length.");
+TAG_FLAG(rpc_service_pool_sizes, advanced);
+
+DEFINE_string(rpc_service_queue_lanes, "",
+              "Comma-separated list of lanes to divide the calls in each service queue "
+              "into, each of the form '<kind>:<name>=<weight>', where <kind> is 'user' "
+              "or 'method'. For example, 'method:Write=4,method:Scan=1,user:etl=1'. "
+              "Calls are matched by remote user, then method; other calls go to a "
+              "default lane of weight 1, or as given by 'default=<weight>'. Every "
+              "service has its own queue, so the lanes only divide the calls within "
+              "each service. Queued calls are dequeued from the lanes in proportion to "
+              "their weights, and the lanes with the most calls relative to their "
+              "weights are the first to drop calls when the queue is full. If empty, "
+              "calls are queued in a single lane.");
+TAG_FLAG(rpc_service_queue_lanes, advanced);
+TAG_FLAG(rpc_service_queue_lanes, experimental);
+
 DEFINE_bool(rpc_server_allow_ephemeral_ports, false,
             "Allow binding to ephemeral ports. This can cause problems, so currently "
             "only allowed in tests.");
@@ -86,7 +114,8 @@ RpcServerOptions::RpcServerOptions()
     num_acceptors_per_address(FLAGS_rpc_num_acceptors_per_address),
     num_service_threads(FLAGS_rpc_num_service_threads),
     default_port(0),
-    service_queue_length(FLAGS_rpc_service_queue_length) {
+    service_queue_length(FLAGS_rpc_service_queue_length),
+    service_queue_lanes(FLAGS_rpc_service_queue_lanes) {
 }
 
 RpcServer::RpcServer(RpcServerOptions opts)
@@ -136,18 +165,49 @@ Status RpcServer::Init(const shared_ptr<Messenger>& messenger) {
     }
   }
 
+  for (StringPiece entry : strings::Split(FLAGS_rpc_service_pool_sizes, ",",
+                                         strings::SkipWhitespace())) {
+    vector<string> name_and_sizes = strings::Split(entry, "=");
+    vector<string> sizes;
+    if (name_and_sizes.size() == 2) {
+      sizes = strings::Split(name_and_sizes[1], ":");
+    }
+    ServicePoolOptions pool_opts;
+    uint64_t queue_length;
+    if (sizes.size() != 2 ||
+        !safe_strtou32(sizes[0], &pool_opts.num_threads) ||
+        !safe_strtou64(sizes[1], &queue_length)) {
+      return Status::InvalidArgument("invalid --rpc_service_pool_sizes entry",
+                                     entry.ToString());
+    }
+    pool_opts.queue_length = queue_length;
+    service_pool_sizes_[name_and_sizes[0]] = pool_opts;
+  }
+
+  if (!options_.service_queue_lanes.empty()) {
+    RETURN_NOT_OK_PREPEND(rpc::WeightedFairQueuePolicy::Create(options_.service_queue_lanes,
+                                                               &service_queue_policy_),
+                          "invalid --rpc_service_queue_lanes");
+  }
+
   server_state_ = INITIALIZED;
   return Status::OK();
 }
 
-Status RpcServer::RegisterService(gscoped_ptr<rpc::ServiceIf> service) {
+Status RpcServer::RegisterService(gscoped_ptr<rpc::ServiceIf> service,
+                                  const ServicePoolOptions& pool_opts) {
   CHECK(server_state_ == INITIALIZED ||
         server_state_ == BOUND) << "bad state: " << server_state_;
   string service_name = service->service_name();
+  ServicePoolOptions opts = FindWithDefault(service_pool_sizes_, service_name, pool_opts);
+  uint32_t num_threads = opts.num_threads > 0 ? opts.num_threads : options_.num_service_threads;
+  size_t queue_length = opts.queue_length > 0 ? opts.queue_length : options_.service_queue_length;
+  VLOG(1) << Substitute("Registering service $0 with $1 worker threads and queue length $2",
+                        service_name, num_threads, queue_length);
   scoped_refptr<rpc::ServicePool> service_pool =
     new rpc::ServicePool(std::move(service), messenger_->metric_entity(),
-                         options_.service_queue_length);
-  RETURN_NOT_OK(service_pool->Init(options_.num_service_threads));
+                         queue_length, service_queue_policy_);
+  RETURN_NOT_OK(service_pool->Init(num_threads));
   RETURN_NOT_OK(messenger_->RegisterService(service_name, service_pool));
   return Status::OK();
 }
@@ -21,6 +21,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "kudu/gutil/gscoped_ptr.h"
@@ -36,6 +37,7 @@ class AcceptorPool;
 class Messenger;
 class ServiceIf;
 class ServicePool;
+class ServiceQueuePolicy;
 } // namespace rpc
 
 struct RpcServerOptions {
@@ -47,6 +49,19 @@ struct RpcServerOptions {
   uint32_t num_service_threads;
   uint16_t default_port;
   size_t service_queue_length;
+  std::string service_queue_lanes;
+};
+
+// Per-service overrides of the RpcServerOptions defaults for the pool of
+// worker threads and queue of a single service. Zero means the default.
+struct ServicePoolOptions {
+  ServicePoolOptions()
+      : num_threads(0),
+        queue_length(0) {
+  }
+
+  uint32_t num_threads;
+  size_t queue_length;
 };
 
 class RpcServer {
@@ -56,8 +71,12 @@ class RpcServer {
 
   Status Init(const std::shared_ptr<rpc::Messenger>& messenger) WARN_UNUSED_RESULT;
   // Services need to be registered after Init'ing, but before Start'ing.
-  // The service's ownership will be given to a ServicePool.
-  Status RegisterService(gscoped_ptr<rpc::ServiceIf> service) WARN_UNUSED_RESULT;
+  // The service's ownership will be given to a ServicePool, with its own
+  // worker threads and queue sized by 'pool_opts'. Sizes given for the service
+  // by --rpc_service_pool_sizes take precedence.
+  Status RegisterService(gscoped_ptr<rpc::ServiceIf> service,
+                         const ServicePoolOptions& pool_opts = ServicePoolOptions())
+      WARN_UNUSED_RESULT;
   Status Bind() WARN_UNUSED_RESULT;
   Status Start() WARN_UNUSED_RESULT;
   void Shutdown();
@@ -99,6 +118,14 @@ class RpcServer {
 
   std::vector<std::shared_ptr<rpc::AcceptorPool> > acceptor_pools_;
 
+  // Scheduling policy of the service queues. Set by Init(). Null if all calls
+  // to a service share a single queue.
+  std::shared_ptr<rpc::ServiceQueuePolicy> service_queue_policy_;
+
+  // Service pool sizes from --rpc_service_pool_sizes, keyed by service name.
+  // Set by Init().
+  std::unordered_map<std::string, ServicePoolOptions> service_pool_sizes_;
+
   DISALLOW_COPY_AND_ASSIGN(RpcServer);
 };
 
@@ -165,9 +165,11 @@ ServerBase::ServerBase(string name, const ServerBaseOptions& options,
       stop_background_threads_latch_(1) {
   FsManagerOpts fs_opts;
   fs_opts.metric_entity = metric_entity_;
+  fs_opts.metric_registry = metric_registry_.get();
   fs_opts.parent_mem_tracker = mem_tracker_;
   fs_opts.block_manager_type = options.fs_opts.block_manager_type;
   fs_opts.wal_root = options.fs_opts.wal_root;
+  fs_opts.additional_wal_roots = options.fs_opts.additional_wal_roots;
   fs_opts.data_roots = options.fs_opts.data_roots;
   fs_manager_.reset(new FsManager(options.env, std::move(fs_opts)));
 
@@ -384,8 +386,9 @@ Status ServerBase::DumpServerInfo(const string& path,
   return Status::OK();
 }
 
-Status ServerBase::RegisterService(gscoped_ptr<rpc::ServiceIf> rpc_impl) {
-  return rpc_server_->RegisterService(std::move(rpc_impl));
+Status ServerBase::RegisterService(gscoped_ptr<rpc::ServiceIf> rpc_impl,
+                                   const ServicePoolOptions& pool_opts) {
+  return rpc_server_->RegisterService(std::move(rpc_impl), pool_opts);
 }
 
 Status ServerBase::StartMetricsLogging() {
@@ -133,7 +133,10 @@ class ServerBase {
 
   // Registers a new RPC service. Once Start() is called, the server will
   // process and dispatch incoming RPCs belonging to this service.
-  Status RegisterService(gscoped_ptr<rpc::ServiceIf> rpc_impl);
+  //
+  // The service gets its own worker threads and queue, sized by 'pool_opts'.
+  Status RegisterService(gscoped_ptr<rpc::ServiceIf> rpc_impl,
+                         const ServicePoolOptions& pool_opts = ServicePoolOptions());
 
   // Unregisters all RPC services. After this function returns, any subsequent
   // incoming RPCs will be rejected.
@@ -201,6 +201,13 @@ class CFileSet::Iterator : public ColumnwiseIterator {
     return cur_idx_;
   }
 
+  // Return the ordinal index one past the last row which will be returned
+  // from the iterator. Only valid after Init().
+  rowid_t upper_bound_idx() const {
+    DCHECK(initted_);
+    return upper_bound_idx_;
+  }
+
   // Collect the IO statistics for each of the underlying columns.
   virtual void GetIteratorStats(std::vector<IteratorStats> *stats) const OVERRIDE;
 
@@ -25,6 +25,8 @@
 #include <glog/logging.h>
 
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/iterator_stats.h"
+#include "kudu/tablet/delta_iterator_merger.h"
 #include "kudu/tablet/delta_store.h"
 #include "kudu/util/status.h"
 
@@ -37,15 +39,16 @@ namespace kudu {
 class ScanSpec;
 class Schema;
 class SelectionVector;
-struct IteratorStats;
 
 namespace tablet {
 
-  // Construct. The base_iter and delta_iter should not be Initted.
 DeltaApplier::DeltaApplier(shared_ptr<CFileSet::Iterator> base_iter,
-                           unique_ptr<DeltaIterator> delta_iter)
+                           SharedDeltaStoreVector delta_stores,
+                           MvccSnapshot snap)
     : base_iter_(std::move(base_iter)),
-      delta_iter_(std::move(delta_iter)),
+      delta_stores_(std::move(delta_stores)),
+      snap_(std::move(snap)),
+      delta_stores_skipped_(0),
       first_prepare_(true) {}
 
 DeltaApplier::~DeltaApplier() {
@@ -53,6 +56,21 @@ DeltaApplier::~DeltaApplier() {
 
 Status DeltaApplier::Init(ScanSpec *spec) {
   RETURN_NOT_OK(base_iter_->Init(spec));
+
+  // Now that the base iterator has determined which rows it will read, only
+  // merge in the delta stores which could affect those rows and columns.
+  SharedDeltaStoreVector stores;
+  stores.swap(delta_stores_);
+  if (base_iter_->HasNext()) {
+    RETURN_NOT_OK(DeltaIteratorMerger::CreateForScan(
+        stores, &base_iter_->schema(), snap_,
+        base_iter_->cur_ordinal_idx(), base_iter_->upper_bound_idx() - 1,
+        &delta_iter_, &delta_stores_skipped_));
+  } else {
+    RETURN_NOT_OK(DeltaIteratorMerger::Create(
+        SharedDeltaStoreVector(), &base_iter_->schema(), snap_, &delta_iter_));
+    delta_stores_skipped_ = stores.size();
+  }
   RETURN_NOT_OK(delta_iter_->Init(spec));
   return Status::OK();
 }
@@ -62,8 +80,10 @@ string DeltaApplier::ToString() const {
   string s;
   s.append("DeltaApplier(");
   s.append(base_iter_->ToString());
-  s.append(" + ");
-  s.append(delta_iter_->ToString());
+  if (delta_iter_) {
+    s.append(" + ");
+    s.append(delta_iter_->ToString());
+  }
   s.append(")");
   return s;
 }
@@ -73,7 +93,13 @@ const Schema &DeltaApplier::schema() const {
 }
 
 void DeltaApplier::GetIteratorStats(std::vector<IteratorStats>* stats) const {
-  return base_iter_->GetIteratorStats(stats);
+  base_iter_->GetIteratorStats(stats);
+  // Skipped delta stores apply to the scan as a whole rather than to any one
+  // column, so attribute them to the first column only to avoid counting them
+  // several times when the per-column stats are summed.
+  if (!stats->empty()) {
+    (*stats)[0].delta_stores_skipped += delta_stores_skipped_;
+  }
 }
 
 bool DeltaApplier::HasNext() const {
@@ -109,7 +135,9 @@ Status DeltaApplier::MaterializeColumn(ColumnMaterializationContext *ctx) {
   if (delta_iter_->MayHaveDeltas()) {
     ctx->SetDecoderEvalNotSupported();
     RETURN_NOT_OK(base_iter_->MaterializeColumn(ctx));
-    RETURN_NOT_OK(delta_iter_->ApplyUpdates(ctx->col_idx(), ctx->block()));
+    // Rows which are already deselected (deleted, or filtered out by an
+    // earlier predicate) never reach the caller, so their updates are skipped.
+    RETURN_NOT_OK(delta_iter_->ApplyUpdates(ctx->col_idx(), ctx->block(), *ctx->sel()));
   } else {
     RETURN_NOT_OK(base_iter_->MaterializeColumn(ctx));
   }
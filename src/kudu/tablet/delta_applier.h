@@ -18,6 +18,7 @@
 #define KUDU_TABLET_DELTA_APPLIER_H
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <vector>
@@ -28,6 +29,8 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/tablet/cfile_set.h"
+#include "kudu/tablet/delta_store.h"
+#include "kudu/tablet/mvcc.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -40,8 +43,6 @@ struct IteratorStats;
 
 namespace tablet {
 
-class DeltaIterator;
-
 ////////////////////////////////////////////////////////////
 // Delta-applying iterators
 ////////////////////////////////////////////////////////////
@@ -77,14 +78,26 @@ class DeltaApplier : public ColumnwiseIterator {
 
   DISALLOW_COPY_AND_ASSIGN(DeltaApplier);
 
-  // Construct. The base_iter and delta_iter should not be Initted.
+  // Construct. The base_iter should not be Initted. The iterator over
+  // 'delta_stores' is created in Init(), once the rows to be scanned are known.
   DeltaApplier(std::shared_ptr<CFileSet::Iterator> base_iter,
-               std::unique_ptr<DeltaIterator> delta_iter);
+               SharedDeltaStoreVector delta_stores,
+               MvccSnapshot snap);
   virtual ~DeltaApplier();
 
   std::shared_ptr<CFileSet::Iterator> base_iter_;
+
+  // The delta stores which may need to be applied, and the snapshot to apply
+  // them at. Only used until Init().
+  SharedDeltaStoreVector delta_stores_;
+  const MvccSnapshot snap_;
+
   std::unique_ptr<DeltaIterator> delta_iter_;
 
+  // The number of delta stores which were left out of 'delta_iter_' because
+  // they could not affect the scan.
+  int64_t delta_stores_skipped_;
+
   bool first_prepare_;
 };
 
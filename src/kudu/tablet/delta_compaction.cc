@@ -195,7 +195,7 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas() {
       for (const Mutation *mut = new_undos_head; mut != nullptr; mut = mut->next()) {
         DeltaKey undo_key(nrows + dst_row.row_index(), mut->timestamp());
         RETURN_NOT_OK(new_undo_delta_writer_->AppendDelta<UNDO>(undo_key, mut->changelist()));
-        undo_stats.UpdateStats(mut->timestamp(), mut->changelist());
+        undo_stats.UpdateStats(undo_key, mut->changelist());
         undo_delta_mutations_written_++;
       }
     }
@@ -223,7 +223,7 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas() {
                << key_and_update.Stringify(DeltaType::REDO, base_schema_);
       RETURN_NOT_OK_PREPEND(new_redo_delta_writer_->AppendDelta<REDO>(key_and_update.key, update),
                             "Failed to append a delta");
-      WARN_NOT_OK(redo_stats.UpdateStats(key_and_update.key.timestamp(), update),
+      WARN_NOT_OK(redo_stats.UpdateStats(key_and_update.key, update),
                   "Failed to update stats");
     }
     redo_delta_mutations_written_ += out.size();
@@ -66,9 +66,10 @@ Status DeltaIteratorMerger::PrepareBatch(size_t nrows, PrepareFlag flag) {
   return Status::OK();
 }
 
-Status DeltaIteratorMerger::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) {
+Status DeltaIteratorMerger::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst,
+                                         const SelectionVector& filter) {
   for (const unique_ptr<DeltaIterator> &iter : iters_) {
-    RETURN_NOT_OK(iter->ApplyUpdates(col_to_apply, dst));
+    RETURN_NOT_OK(iter->ApplyUpdates(col_to_apply, dst, filter));
   }
   return Status::OK();
 }
@@ -175,5 +176,24 @@ Status DeltaIteratorMerger::Create(
   return Status::OK();
 }
 
+Status DeltaIteratorMerger::CreateForScan(
+    const vector<shared_ptr<DeltaStore> > &stores,
+    const Schema* projection,
+    const MvccSnapshot &snapshot,
+    rowid_t first_row,
+    rowid_t last_row,
+    unique_ptr<DeltaIterator>* out,
+    int64_t* num_skipped) {
+  vector<shared_ptr<DeltaStore> > relevant_stores;
+  relevant_stores.reserve(stores.size());
+  for (const shared_ptr<DeltaStore> &store : stores) {
+    if (store->MayAffectScan(*projection, first_row, last_row)) {
+      relevant_stores.push_back(store);
+    }
+  }
+  *num_skipped = stores.size() - relevant_stores.size();
+  return Create(relevant_stores, projection, snapshot, out);
+}
+
 } // namespace tablet
 } // namespace kudu
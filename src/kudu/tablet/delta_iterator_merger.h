@@ -18,6 +18,7 @@
 #define KUDU_TABLET_DELTA_ITERATOR_MERGER_H
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <vector>
@@ -56,13 +57,31 @@ class DeltaIteratorMerger : public DeltaIterator {
       const MvccSnapshot &snapshot,
       std::unique_ptr<DeltaIterator>* out);
 
+  // Like Create(), but for iterators which will only be used to apply deltas
+  // (i.e. prepared with PREPARE_FOR_APPLY) to a scan of 'projection' over the
+  // rows in the inclusive range ['first_row', 'last_row'].
+  //
+  // Stores which cannot affect that scan according to
+  // DeltaStore::MayAffectScan() are left out of the merge entirely, so they
+  // are never seeked or read. The number of such stores is returned in
+  // 'num_skipped'.
+  static Status CreateForScan(
+      const std::vector<std::shared_ptr<DeltaStore> > &stores,
+      const Schema* projection,
+      const MvccSnapshot &snapshot,
+      rowid_t first_row,
+      rowid_t last_row,
+      std::unique_ptr<DeltaIterator>* out,
+      int64_t* num_skipped);
+
   ////////////////////////////////////////////////////////////
   // Implementations of DeltaIterator
   ////////////////////////////////////////////////////////////
   virtual Status Init(ScanSpec *spec) OVERRIDE;
   virtual Status SeekToOrdinal(rowid_t idx) OVERRIDE;
   virtual Status PrepareBatch(size_t nrows, PrepareFlag flag) OVERRIDE;
-  virtual Status ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) OVERRIDE;
+  virtual Status ApplyUpdates(size_t col_to_apply, ColumnBlock *dst,
+                              const SelectionVector& filter) OVERRIDE;
   virtual Status ApplyDeletes(SelectionVector *sel_vec) OVERRIDE;
   virtual Status CollectMutations(std::vector<Mutation *> *dst, Arena *arena) OVERRIDE;
   virtual Status FilterColumnIdsAndCollectDeltas(const std::vector<ColumnId>& col_ids,
@@ -16,6 +16,7 @@
 // under the License.
 #include "kudu/tablet/delta_stats.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <ostream>
 #include <utility>
@@ -25,9 +26,11 @@
 
 #include "kudu/common/row_changelist.h"
 #include "kudu/common/schema.h"
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/tablet.pb.h"
+#include "kudu/util/bitmap.h"
 
 using strings::Substitute;
 
@@ -42,7 +45,9 @@ DeltaStats::DeltaStats()
     : delete_count_(0),
       reinsert_count_(0),
       max_timestamp_(Timestamp::kMin),
-      min_timestamp_(Timestamp::kMax) {
+      min_timestamp_(Timestamp::kMax),
+      has_row_bitmap_(true),
+      row_bitmap_shift_(0) {
 }
 
 void DeltaStats::IncrUpdateCount(ColumnId col_id, int64_t update_count) {
@@ -58,7 +63,7 @@ void DeltaStats::IncrReinsertCount(int64_t reinsert_count) {
   reinsert_count_ += reinsert_count;
 }
 
-Status DeltaStats::UpdateStats(const Timestamp& timestamp,
+Status DeltaStats::UpdateStats(const DeltaKey& key,
                                const RowChangeList& update) {
   // Decode the mutation incrementing the update count for each of the
   // columns we find present.
@@ -84,16 +89,43 @@ Status DeltaStats::UpdateStats(const Timestamp& timestamp,
     default: LOG(FATAL) << "Invalid mutation type: " << decoder.get_type();
   }
 
+  const Timestamp& timestamp = key.timestamp();
   if (min_timestamp_ > timestamp) {
     min_timestamp_ = timestamp;
   }
   if (max_timestamp_ < timestamp) {
     max_timestamp_ = timestamp;
   }
+  AddRowToBitmap(key.row_idx());
 
   return Status::OK();
 }
 
+void DeltaStats::AddRowToBitmap(rowid_t row_idx) {
+  DCHECK(has_row_bitmap_);
+  while ((row_idx >> row_bitmap_shift_) >= kMaxRowBitmapBits) {
+    // Halve the resolution of the bitmap: bit 'i' of the coarser bitmap
+    // covers bits '2i' and '2i + 1' of the current one.
+    size_t num_bits = row_bitmap_.size() * 8;
+    string coarser(BitmapSize((num_bits + 1) / 2), '\0');
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(row_bitmap_.data());
+    uint8_t* dst = reinterpret_cast<uint8_t*>(&coarser[0]);
+    for (size_t i = 0; i < num_bits; i++) {
+      if (BitmapTest(src, i)) {
+        BitmapSet(dst, i / 2);
+      }
+    }
+    row_bitmap_.swap(coarser);
+    row_bitmap_shift_++;
+  }
+
+  size_t bit = row_idx >> row_bitmap_shift_;
+  if (row_bitmap_.size() < BitmapSize(bit + 1)) {
+    row_bitmap_.resize(BitmapSize(bit + 1), '\0');
+  }
+  BitmapSet(reinterpret_cast<uint8_t*>(&row_bitmap_[0]), bit);
+}
+
 string DeltaStats::ToString() const {
   string ret = strings::Substitute(
       "ts range=[$0, $1]",
@@ -122,6 +154,10 @@ void DeltaStats::ToPB(DeltaStatsPB* pb) const {
 
   pb->set_max_timestamp(max_timestamp_.ToUint64());
   pb->set_min_timestamp(min_timestamp_.ToUint64());
+  if (has_row_bitmap_) {
+    pb->set_row_bitmap_shift(row_bitmap_shift_);
+    pb->set_row_bitmap(row_bitmap_);
+  }
 }
 
 Status DeltaStats::InitFromPB(const DeltaStatsPB& pb) {
@@ -133,6 +169,13 @@ Status DeltaStats::InitFromPB(const DeltaStatsPB& pb) {
   }
   max_timestamp_.FromUint64(pb.max_timestamp());
   min_timestamp_.FromUint64(pb.min_timestamp());
+  has_row_bitmap_ = pb.has_row_bitmap_shift();
+  row_bitmap_shift_ = pb.row_bitmap_shift();
+  row_bitmap_ = pb.row_bitmap();
+  if (PREDICT_FALSE(row_bitmap_shift_ >= 32)) {
+    return Status::Corruption("invalid delta stats row bitmap shift",
+                              std::to_string(row_bitmap_shift_));
+  }
   return Status::OK();
 }
 
@@ -145,6 +188,35 @@ void DeltaStats::AddColumnIdsWithUpdates(std::set<ColumnId>* col_ids) const {
   }
 }
 
+bool DeltaStats::MayAffectColumns(const Schema& projection) const {
+  if (delete_count_ > 0 || reinsert_count_ > 0) {
+    return true;
+  }
+  if (!projection.has_column_ids()) {
+    return true;
+  }
+  for (size_t i = 0; i < projection.num_columns(); i++) {
+    if (update_count_for_col_id(projection.column_id(i)) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DeltaStats::MayHaveDeltasForRows(rowid_t first_row, rowid_t last_row) const {
+  DCHECK_LE(first_row, last_row);
+  if (!has_row_bitmap_) {
+    return true;
+  }
+  const size_t num_bits = row_bitmap_.size() * 8;
+  const size_t first_bit = first_row >> row_bitmap_shift_;
+  if (first_bit >= num_bits) {
+    return false;
+  }
+  const size_t end_bit = std::min<size_t>((last_row >> row_bitmap_shift_) + 1, num_bits);
+  return !BitmapIsAllZero(reinterpret_cast<const uint8_t*>(row_bitmap_.data()),
+                          first_bit, end_bit);
+}
 
 } // namespace tablet
 } // namespace kudu
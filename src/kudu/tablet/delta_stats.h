@@ -22,9 +22,11 @@
 #include <string>
 #include <unordered_map>
 
+#include "kudu/common/rowid.h"
 #include "kudu/common/schema.h" // IWYU pragma: keep
 #include "kudu/common/timestamp.h"
 #include "kudu/gutil/map-util.h"
+#include "kudu/tablet/delta_key.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -50,8 +52,8 @@ class DeltaStats {
   void IncrReinsertCount(int64_t reinsert_count);
 
   // Increment delete and update counts based on changes contained in
-  // 'update'.
-  Status UpdateStats(const Timestamp& timestamp,
+  // 'update', and record that the row identified by 'key' has a delta.
+  Status UpdateStats(const DeltaKey& key,
                      const RowChangeList& update);
 
   // Return the number of deletes in the current delta store.
@@ -97,12 +99,37 @@ class DeltaStats {
   // set 'col_ids'.
   void AddColumnIdsWithUpdates(std::set<ColumnId>* col_ids) const;
 
+  // Returns true if the delta store may contain deltas which would need to be
+  // applied when scanning 'projection': any DELETE or REINSERT, or any UPDATE
+  // to one of the projected columns.
+  bool MayAffectColumns(const Schema& projection) const;
+
+  // Returns true if the delta store may contain deltas for any row in the
+  // inclusive range ['first_row', 'last_row']. Always returns true if the
+  // stats were loaded from a delta file written without a row bitmap.
+  bool MayHaveDeltasForRows(rowid_t first_row, rowid_t last_row) const;
+
  private:
+  // The row bitmap never grows beyond this many bits; once a row index falls
+  // beyond it, the bitmap is coarsened until the row fits.
+  static const size_t kMaxRowBitmapBits = 4096;
+
+  // Sets the bit in 'row_bitmap_' which covers 'row_idx'.
+  void AddRowToBitmap(rowid_t row_idx);
+
   std::unordered_map<ColumnId, int64_t> update_counts_by_col_id_;
   uint64_t delete_count_;
   uint64_t reinsert_count_;
   Timestamp max_timestamp_;
   Timestamp min_timestamp_;
+
+  // Whether 'row_bitmap_' is known. It is false only for stats loaded from
+  // delta files which predate the row bitmap.
+  bool has_row_bitmap_;
+
+  // Each bit of 'row_bitmap_' covers 2^row_bitmap_shift_ consecutive rows.
+  uint32_t row_bitmap_shift_;
+  std::string row_bitmap_;
 };
 
 
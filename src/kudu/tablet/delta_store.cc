@@ -19,14 +19,20 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 
 #include <glog/logging.h>
 
+#include "kudu/common/columnblock.h"
 #include "kudu/common/row_changelist.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/fastmem.h"
 #include "kudu/gutil/strings/strcat.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/delta_stats.h"
@@ -51,6 +57,138 @@ string DeltaKeyAndUpdate::Stringify(DeltaType type, const Schema& schema, bool p
                                                  key.timestamp().ToString()))));
 }
 
+DecodedDeltaBatch::DecodedDeltaBatch(const Schema* projection)
+    : projection_(projection),
+      start_row_(0),
+      updates_by_col_(projection->num_columns()) {
+}
+
+void DecodedDeltaBatch::Reset(rowid_t start_row) {
+  start_row_ = start_row;
+  for (auto& updates : updates_by_col_) {
+    updates.clear();
+  }
+  liveness_changes_.clear();
+}
+
+Status DecodedDeltaBatch::AddDelta(rowid_t row_idx, const RowChangeList& changelist) {
+  DCHECK_GE(row_idx, start_row_);
+  const uint32_t idx_in_batch = row_idx - start_row_;
+
+  RowChangeListDecoder decoder(changelist);
+  RETURN_NOT_OK(decoder.Init());
+  if (decoder.is_delete()) {
+    liveness_changes_.push_back({ idx_in_batch, false });
+    return Status::OK();
+  }
+
+  DCHECK(decoder.is_update() || decoder.is_reinsert());
+  if (decoder.is_reinsert()) {
+    liveness_changes_.push_back({ idx_in_batch, true });
+  }
+  while (decoder.HasNext()) {
+    RowChangeListDecoder::DecodedUpdate dec;
+    RETURN_NOT_OK(decoder.DecodeNext(&dec));
+    int col_idx;
+    const void* col_val;
+    RETURN_NOT_OK(dec.Validate(*projection_, &col_idx, &col_val));
+    if (col_idx == Schema::kColumnNotFound) {
+      // This column isn't being projected.
+      continue;
+    }
+
+    // Deltas for a given row are always added consecutively, so if we already
+    // have an earlier update to the same cell we can just overwrite it.
+    vector<ColumnUpdate>& updates = updates_by_col_[col_idx];
+    if (updates.empty() || updates.back().idx_in_batch != idx_in_batch) {
+      updates.emplace_back();
+    }
+    ColumnUpdate& cu = updates.back();
+    cu.idx_in_batch = idx_in_batch;
+    cu.is_null = col_val == nullptr;
+    if (!cu.is_null) {
+      size_t col_size = projection_->column(col_idx).type_info()->size();
+      DCHECK_LE(col_size, sizeof(cu.new_val));
+      memcpy(cu.new_val, col_val, col_size);
+    }
+  }
+  return Status::OK();
+}
+
+Status DecodedDeltaBatch::ApplyUpdates(size_t col_idx, ColumnBlock* dst,
+                                       const SelectionVector& filter) const {
+  const vector<ColumnUpdate>& updates = updates_by_col_[col_idx];
+  if (updates.empty()) {
+    return Status::OK();
+  }
+
+  const TypeInfo* type_info = projection_->column(col_idx).type_info();
+  DCHECK_EQ(type_info->type(), dst->type_info()->type());
+  const bool nullable = dst->is_nullable();
+
+  if (type_info->physical_type() == BINARY) {
+    Arena* arena = dst->arena();
+    Slice* dst_cells = reinterpret_cast<Slice*>(dst->data());
+    for (const ColumnUpdate& cu : updates) {
+      DCHECK_LT(cu.idx_in_batch, dst->nrows());
+      // Skipping unselected rows saves copying their indirect data.
+      if (!filter.IsRowSelected(cu.idx_in_batch)) continue;
+      if (nullable) {
+        dst->SetCellIsNull(cu.idx_in_batch, cu.is_null);
+        if (cu.is_null) continue;
+      }
+      Slice src;
+      memcpy(&src, cu.new_val, sizeof(src));
+      Slice* dst_cell = &dst_cells[cu.idx_in_batch];
+      if (arena == nullptr) {
+        *dst_cell = src;
+      } else if (PREDICT_FALSE(!arena->RelocateSlice(src, dst_cell))) {
+        return Status::IOError("out of memory copying slice", src.ToString());
+      }
+    }
+    return Status::OK();
+  }
+
+  // Fixed-size types: copy the raw values straight into the block.
+  const size_t col_size = type_info->size();
+  uint8_t* dst_data = dst->data();
+  for (const ColumnUpdate& cu : updates) {
+    DCHECK_LT(cu.idx_in_batch, dst->nrows());
+    if (!filter.IsRowSelected(cu.idx_in_batch)) continue;
+    if (nullable) {
+      dst->SetCellIsNull(cu.idx_in_batch, cu.is_null);
+      if (cu.is_null) continue;
+    }
+    strings::memcpy_inlined(dst_data + cu.idx_in_batch * col_size, cu.new_val, col_size);
+  }
+  return Status::OK();
+}
+
+void DecodedDeltaBatch::ApplyDeletes(SelectionVector* sel_vec) const {
+  for (const LivenessChange& lc : liveness_changes_) {
+    DCHECK_LT(lc.idx_in_batch, sel_vec->nrows());
+    if (lc.is_reinsert) {
+      // If this is a reinsert the row must have been deleted.
+      DCHECK(!sel_vec->IsRowSelected(lc.idx_in_batch));
+      sel_vec->SetRowSelected(lc.idx_in_batch);
+    } else {
+      sel_vec->SetRowUnselected(lc.idx_in_batch);
+    }
+  }
+}
+
+bool DecodedDeltaBatch::HasDeltas() const {
+  if (!liveness_changes_.empty()) {
+    return true;
+  }
+  for (const auto& updates : updates_by_col_) {
+    if (!updates.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 Status DebugDumpDeltaIterator(DeltaType type,
                               DeltaIterator* iter,
                               const Schema& schema,
@@ -125,7 +263,7 @@ Status WriteDeltaIteratorToFile(DeltaIterator* iter,
     for (const DeltaKeyAndUpdate& cell : cells) {
       RowChangeList rcl(cell.cell);
       RETURN_NOT_OK(out->AppendDelta<Type>(cell.key, rcl));
-      RETURN_NOT_OK(stats.UpdateStats(cell.key.timestamp(), rcl));
+      RETURN_NOT_OK(stats.UpdateStats(cell.key, rcl));
     }
 
     i += n;
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "kudu/common/rowid.h"
+#include "kudu/gutil/macros.h"
 #include "kudu/tablet/delta_key.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
@@ -32,6 +33,7 @@ namespace kudu {
 
 class Arena;
 class ColumnBlock;
+class RowChangeList;
 class ScanSpec;
 class Schema;
 class SelectionVector;
@@ -74,6 +76,14 @@ class DeltaStore {
   // Set *deleted to true if the latest update for the given row is a deletion.
   virtual Status CheckRowDeleted(rowid_t row_idx, bool *deleted) const = 0;
 
+  // Returns false if this store is known not to contain any deltas which would
+  // need to be applied when scanning 'projection' over the rows in the
+  // inclusive range ['first_row', 'last_row']. It is always safe to
+  // conservatively return true.
+  virtual bool MayAffectScan(const Schema& projection,
+                             rowid_t first_row,
+                             rowid_t last_row) const = 0;
+
   // Get the store's estimated size in bytes.
   virtual uint64_t EstimateSize() const = 0;
 
@@ -102,10 +112,10 @@ typedef std::vector<std::shared_ptr<DeltaStore> > SharedDeltaStoreVector;
 //     clear row block
 //     CHECK_OK(iter->PrepareBatch(rowblock.size()));
 //     ... read column 0 from base data into row block ...
-//     CHECK_OK(iter->ApplyUpdates(0, rowblock.column(0))
+//     CHECK_OK(iter->ApplyUpdates(0, rowblock.column(0), *rowblock.selection_vector())
 //     ... check predicates for column ...
 //     ... read another column from base data...
-//     CHECK_OK(iter->ApplyUpdates(1, rowblock.column(1)))
+//     CHECK_OK(iter->ApplyUpdates(1, rowblock.column(1), *rowblock.selection_vector()))
 //     ...
 //  }
 
@@ -151,7 +161,11 @@ class DeltaIterator {
   // Apply the snapshotted updates to one of the columns.
   // 'dst' must be the same length as was previously passed to PrepareBatch()
   // Must have called PrepareBatch() with flag = PREPARE_FOR_APPLY.
-  virtual Status ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) = 0;
+  //
+  // Updates to rows which are not selected in 'filter' may be skipped, leaving
+  // those cells of 'dst' unmodified.
+  virtual Status ApplyUpdates(size_t col_to_apply, ColumnBlock *dst,
+                              const SelectionVector& filter) = 0;
 
   // Apply any deletes to the given selection vector.
   // Rows which have been deleted in the associated MVCC snapshot are set to
@@ -195,6 +209,75 @@ class DeltaIterator {
   virtual ~DeltaIterator() {}
 };
 
+// Column-oriented, pre-decoded form of the deltas which apply to a batch of
+// rows prepared by a DeltaIterator.
+//
+// PrepareBatch(PREPARE_FOR_APPLY) implementations decode each relevant
+// RowChangeList exactly once into per-column lists of (row, value) pairs and
+// a list of liveness changes. ApplyUpdates() and ApplyDeletes() then become
+// tight loops over those lists rather than re-decoding every RowChangeList
+// once per projected column.
+//
+// Values are not copied out of the encoded deltas: BINARY cells refer to the
+// memory backing the original RowChangeLists, which must remain valid until
+// the next call to Reset().
+class DecodedDeltaBatch {
+ public:
+  // 'projection' must remain valid for the lifetime of this object.
+  explicit DecodedDeltaBatch(const Schema* projection);
+
+  // Discards any previously decoded deltas and starts a new batch whose first
+  // row has ordinal 'start_row'.
+  void Reset(rowid_t start_row);
+
+  // Decodes 'changelist', which mutates row 'row_idx', and merges its effects
+  // into the batch. Deltas must be added in the order in which they would
+  // otherwise have been applied.
+  Status AddDelta(rowid_t row_idx, const RowChangeList& changelist);
+
+  // Writes the decoded updates for column 'col_idx' of the projection into
+  // 'dst', skipping rows which are not selected in 'filter'. Indirect data is
+  // copied into dst's arena, if it has one.
+  Status ApplyUpdates(size_t col_idx, ColumnBlock* dst,
+                      const SelectionVector& filter) const;
+
+  // Applies the decoded DELETEs and REINSERTs to 'sel_vec'.
+  void ApplyDeletes(SelectionVector* sel_vec) const;
+
+  // Returns true if applying this batch could modify any row.
+  bool HasDeltas() const;
+
+ private:
+  struct ColumnUpdate {
+    // The index of the updated row, relative to the start of the batch.
+    uint32_t idx_in_batch;
+
+    // True if the cell was set to NULL, in which case 'new_val' is unused.
+    bool is_null;
+
+    // The new value of the cell: a Slice for BINARY columns, or the raw
+    // little-endian value otherwise.
+    uint8_t new_val[16];
+  };
+
+  struct LivenessChange {
+    // The index of the affected row, relative to the start of the batch.
+    uint32_t idx_in_batch;
+
+    // True for a REINSERT, false for a DELETE.
+    bool is_reinsert;
+  };
+
+  const Schema* const projection_;
+
+  rowid_t start_row_;
+
+  std::vector<std::vector<ColumnUpdate>> updates_by_col_;
+  std::vector<LivenessChange> liveness_changes_;
+
+  DISALLOW_COPY_AND_ASSIGN(DecodedDeltaBatch);
+};
+
 enum {
   ITERATE_OVER_ALL_ROWS = 0
 };
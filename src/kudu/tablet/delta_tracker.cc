@@ -594,10 +594,10 @@ Status DeltaTracker::NewDeltaFileIterator(
 Status DeltaTracker::WrapIterator(const shared_ptr<CFileSet::Iterator> &base,
                                   const MvccSnapshot &mvcc_snap,
                                   gscoped_ptr<ColumnwiseIterator>* out) const {
-  unique_ptr<DeltaIterator> iter;
-  RETURN_NOT_OK(NewDeltaIterator(&base->schema(), mvcc_snap, &iter));
+  SharedDeltaStoreVector stores;
+  CollectStores(&stores, UNDOS_AND_REDOS);
 
-  out->reset(new DeltaApplier(base, std::move(iter)));
+  out->reset(new DeltaApplier(base, std::move(stores), mvcc_snap));
   return Status::OK();
 }
 
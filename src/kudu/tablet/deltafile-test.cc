@@ -42,6 +42,7 @@
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/delta_key.h"
 #include "kudu/tablet/delta_stats.h"
 #include "kudu/tablet/delta_store.h"
@@ -51,6 +52,7 @@
 #include "kudu/util/faststring.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/status.h"
+#include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
@@ -59,12 +61,15 @@ DEFINE_int32(first_row_to_update, 10000, "the first row to update");
 DEFINE_int32(last_row_to_update, 100000, "the last row to update");
 DEFINE_int32(n_verify, 1, "number of times to verify the updates"
              "(useful for benchmarks");
+DEFINE_int32(n_updates_per_row, 10, "number of updates per updated row written by "
+             "the delta application benchmark");
 
 using std::is_sorted;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
 using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 namespace tablet {
@@ -114,7 +119,7 @@ class TestDeltaFile : public KuduTest {
         DeltaKey key(i, Timestamp(timestamp));
         RowChangeList rcl(buf);
         ASSERT_OK_FAST(dfw.AppendDelta<REDO>(key, rcl));
-        ASSERT_OK_FAST(stats.UpdateStats(key.timestamp(), rcl));
+        ASSERT_OK_FAST(stats.UpdateStats(key, rcl));
       }
     }
     dfw.WriteDeltaStats(stats);
@@ -156,10 +161,13 @@ class TestDeltaFile : public KuduTest {
     return Status::OK();
   }
 
-  void VerifyTestFile() {
+  // Verifies the contents of a file written by WriteTestFile() with the same
+  // 'min_timestamp' and 'max_timestamp'.
+  void VerifyTestFile(int min_timestamp = 0, int max_timestamp = 0) {
     shared_ptr<DeltaFileReader> reader;
     ASSERT_OK(OpenDeltaFileReader(test_block_, &reader));
-    ASSERT_EQ(((FLAGS_last_row_to_update - FLAGS_first_row_to_update) / 2) + 1,
+    ASSERT_EQ((((FLAGS_last_row_to_update - FLAGS_first_row_to_update) / 2) + 1) *
+              (max_timestamp - min_timestamp + 1),
               reader->delta_stats().update_count_for_col_id(schema_.column_id(0)));
     ASSERT_EQ(0, reader->delta_stats().delete_count());
     gscoped_ptr<DeltaIterator> it;
@@ -184,7 +192,8 @@ class TestDeltaFile : public KuduTest {
 
       ASSERT_OK_FAST(it->PrepareBatch(block.nrows(), DeltaIterator::PREPARE_FOR_APPLY));
       ColumnBlock dst_col = block.column_block(0);
-      ASSERT_OK_FAST(it->ApplyUpdates(0, &dst_col));
+      block.selection_vector()->SetAllTrue();
+      ASSERT_OK_FAST(it->ApplyUpdates(0, &dst_col, *block.selection_vector()));
 
       for (int i = 0; i < block.nrows(); i++) {
         uint32_t row = start_row + i;
@@ -195,7 +204,8 @@ class TestDeltaFile : public KuduTest {
         DCHECK_EQ(block.row(i).cell_ptr(0), dst_col.cell_ptr(i));
         uint32_t updated_val = *schema_.ExtractColumnFromRow<UINT32>(block.row(i), 0);
         VLOG(2) << "row " << row << ": " << updated_val;
-        uint32_t expected_val = should_be_updated ? row : 0;
+        // The most recent update wins.
+        uint32_t expected_val = should_be_updated ? row + max_timestamp : 0;
         // Don't use ASSERT_EQ, since it's slow (records positive results, not just negative)
         if (updated_val != expected_val) {
           FAIL() << "failed on row " << row <<
@@ -286,6 +296,19 @@ TEST_F(TestDeltaFile, TestRoundTrip) {
   DoTestRoundTrip();
 }
 
+// Benchmarks applying a delta file in which every updated row carries
+// several updates, as in a heavily updated table.
+TEST_F(TestDeltaFile, BenchmarkApplyUpdates) {
+  const int kMaxTimestamp = FLAGS_n_updates_per_row - 1;
+  WriteTestFile(0, kMaxTimestamp);
+  LOG_TIMING(INFO, Substitute("applying $0 updates per row $1 times",
+                              FLAGS_n_updates_per_row, FLAGS_n_verify)) {
+    for (int i = 0; i < FLAGS_n_verify; i++) {
+      NO_FATALS(VerifyTestFile(0, kMaxTimestamp));
+    }
+  }
+}
+
 TEST_F(TestDeltaFile, TestCollectMutations) {
   WriteTestFile();
 
@@ -389,6 +412,40 @@ TEST_F(TestDeltaFile, TestLazyInit) {
   ASSERT_EQ(bytes_read_after_init, bytes_read);
 }
 
+// Test that the delta stats allow skipping a delta file for scans of rows or
+// columns which it doesn't mutate.
+TEST_F(TestDeltaFile, TestMayAffectScan) {
+  WriteTestFile();
+  shared_ptr<DeltaFileReader> reader;
+  ASSERT_OK(OpenDeltaFileReader(test_block_, &reader));
+
+  // The updated rows.
+  ASSERT_TRUE(reader->MayAffectScan(schema_, FLAGS_first_row_to_update,
+                                    FLAGS_first_row_to_update));
+  ASSERT_TRUE(reader->MayAffectScan(schema_, 0, FLAGS_last_row_to_update + 1000));
+
+  // Well before and well after the updated rows. The row bitmap is coarse, so
+  // ranges immediately adjacent to the updated rows may not be ruled out.
+  ASSERT_FALSE(reader->MayAffectScan(schema_, 0, FLAGS_first_row_to_update / 2));
+  ASSERT_FALSE(reader->MayAffectScan(schema_, FLAGS_last_row_to_update * 2,
+                                     FLAGS_last_row_to_update * 3));
+
+  // A projection which doesn't include the updated column.
+  SchemaBuilder builder(schema_);
+  ASSERT_OK(builder.AddColumn("other", UINT32));
+  Schema other_projection;
+  ASSERT_OK(builder.Build().CreateProjectionByNames({ "other" }, &other_projection));
+  ASSERT_FALSE(reader->MayAffectScan(other_projection, 0, FLAGS_last_row_to_update));
+
+  // A lazily opened file can't be ruled out until it has been initialized.
+  unique_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(test_block_, &block));
+  ASSERT_OK(DeltaFileReader::OpenNoInit(std::move(block), REDO, ReaderOptions(), &reader));
+  ASSERT_TRUE(reader->MayAffectScan(other_projection, 0, FLAGS_last_row_to_update));
+  ASSERT_OK(reader->Init());
+  ASSERT_FALSE(reader->MayAffectScan(other_projection, 0, FLAGS_last_row_to_update));
+}
+
 // Check that, if a delta file is opened but no deltas are written,
 // Finish() will return Status::Aborted().
 TEST_F(TestDeltaFile, TestEmptyFileIsAborted) {
@@ -369,6 +369,16 @@ Status DeltaFileReader::CheckRowDeleted(rowid_t row_idx, bool *deleted) const {
   return Status::OK();
 }
 
+bool DeltaFileReader::MayAffectScan(const Schema& projection,
+                                    rowid_t first_row,
+                                    rowid_t last_row) const {
+  if (!init_once_.init_succeeded()) {
+    return true;
+  }
+  return delta_stats_->MayAffectColumns(projection) &&
+      delta_stats_->MayHaveDeltasForRows(first_row, last_row);
+}
+
 uint64_t DeltaFileReader::EstimateSize() const {
   return reader_->file_size();
 }
@@ -389,6 +399,7 @@ DeltaFileIterator::DeltaFileIterator(shared_ptr<DeltaFileReader> dfr,
       prepared_(false),
       exhausted_(false),
       initted_(false),
+      decoded_(projection),
       delta_type_(delta_type),
       cache_blocks_(CFileReader::CACHE_BLOCK) {}
 
@@ -564,6 +575,10 @@ Status DeltaFileIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
   prepared_idx_ = start_row;
   prepared_count_ = nrows;
   prepared_ = true;
+
+  if (flag == PREPARE_FOR_APPLY) {
+    return DecodePreparedMutations();
+  }
   return Status::OK();
 }
 
@@ -661,140 +676,64 @@ inline bool IsUndoRelevant(const MvccSnapshot& snap,
   return true;
 }
 
+// Visitor which decodes each relevant mutation into the iterator's
+// DecodedDeltaBatch. See PrepareBatch().
 template<DeltaType Type>
-struct ApplyingVisitor {
+struct DecodingVisitor {
 
   Status Visit(const DeltaKey &key, const Slice &deltas, bool* continue_visit);
 
-  inline Status ApplyMutation(const DeltaKey &key, const Slice &deltas) {
-    int64_t rel_idx = key.row_idx() - dfi->prepared_idx_;
-    DCHECK_GE(rel_idx, 0);
-
-    // TODO: this code looks eerily similar to DMSIterator::ApplyUpdates!
-    // I bet it can be combined.
-
-    const Schema* schema = dfi->projection_;
-    RowChangeListDecoder decoder((RowChangeList(deltas)));
-    RETURN_NOT_OK(decoder.Init());
-    if (decoder.is_update() || decoder.is_reinsert()) {
-      return decoder.ApplyToOneColumn(rel_idx, dst, *schema, col_to_apply, dst->arena());
-    }
-
-    DCHECK(decoder.is_delete());
-    // If it's a DELETE, then it will be processed by LivenessVisitor.
-    return Status::OK();
-  }
-
   DeltaFileIterator *dfi;
-  size_t col_to_apply;
-  ColumnBlock *dst;
 };
 
 template<>
-inline Status ApplyingVisitor<REDO>::Visit(const DeltaKey& key,
+inline Status DecodingVisitor<REDO>::Visit(const DeltaKey& key,
                                            const Slice& deltas,
                                            bool* continue_visit) {
   if (IsRedoRelevant(dfi->mvcc_snap_, key.timestamp(), continue_visit)) {
-    DVLOG(3) << "Applied redo delta";
-    return ApplyMutation(key, deltas);
+    DVLOG(3) << "Decoded redo delta";
+    return dfi->decoded_.AddDelta(key.row_idx(), RowChangeList(deltas));
   }
-  DVLOG(3) << "Redo delta uncommitted, skipped applying.";
+  DVLOG(3) << "Redo delta uncommitted, skipped decoding.";
   return Status::OK();
 }
 
 template<>
-inline Status ApplyingVisitor<UNDO>::Visit(const DeltaKey& key,
+inline Status DecodingVisitor<UNDO>::Visit(const DeltaKey& key,
                                            const Slice& deltas,
                                            bool* continue_visit) {
   if (IsUndoRelevant(dfi->mvcc_snap_, key.timestamp(), continue_visit)) {
-    DVLOG(3) << "Applied undo delta";
-    return ApplyMutation(key, deltas);
+    DVLOG(3) << "Decoded undo delta";
+    return dfi->decoded_.AddDelta(key.row_idx(), RowChangeList(deltas));
   }
-  DVLOG(3) << "Undo delta committed, skipped applying.";
+  DVLOG(3) << "Undo delta committed, skipped decoding.";
   return Status::OK();
 }
 
-Status DeltaFileIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) {
-  DCHECK_LE(prepared_count_, dst->nrows());
-
+Status DeltaFileIterator::DecodePreparedMutations() {
+  decoded_.Reset(prepared_idx_);
   if (delta_type_ == REDO) {
-    DVLOG(3) << "Applying REDO mutations to " << col_to_apply;
-    ApplyingVisitor<REDO> visitor = {this, col_to_apply, dst};
+    DecodingVisitor<REDO> visitor = { this };
     return VisitMutations(&visitor);
   }
-  DVLOG(3) << "Applying UNDO mutations to " << col_to_apply;
-  ApplyingVisitor<UNDO> visitor = {this, col_to_apply, dst};
+  DecodingVisitor<UNDO> visitor = { this };
   return VisitMutations(&visitor);
 }
 
-// Visitor which establishes the liveness of a row by applying deletes and reinserts.
-template<DeltaType Type>
-struct LivenessVisitor {
-
-  Status Visit(const DeltaKey &key, const Slice &deltas, bool* continue_visit);
-
-  inline Status ApplyDelete(const DeltaKey &key, const Slice &deltas) {
-    int64_t rel_idx = key.row_idx() - dfi->prepared_idx_;
-    DCHECK_GE(rel_idx, 0);
-
-    RowChangeListDecoder decoder((RowChangeList(deltas)));
-    RETURN_NOT_OK(decoder.Init());
-    if (decoder.is_update()) {
-      DVLOG(3) << "Didn't delete row (update)";
-      // If this is an update the row must be selected.
-      DCHECK(sel_vec->IsRowSelected(rel_idx));
-      return Status::OK();
-    }
-
-    if (decoder.is_delete()) {
-      DVLOG(3) << "Row deleted";
-      sel_vec->SetRowUnselected(rel_idx);
-      return Status::OK();
-    }
-
-    DCHECK(decoder.is_reinsert());
-    DVLOG(3) << "Re-selected the row (reinsert)";
-    // If this is a reinsert the row must be unselected.
-    DCHECK(!sel_vec->IsRowSelected(rel_idx));
-    sel_vec->SetRowSelected(rel_idx);
-    return Status::OK();
-  }
-
-  DeltaFileIterator *dfi;
-  SelectionVector *sel_vec;
-};
-
-template<>
-inline Status LivenessVisitor<REDO>::Visit(const DeltaKey& key,
-                                           const Slice& deltas,
-                                           bool* continue_visit) {
-  if (IsRedoRelevant(dfi->mvcc_snap_, key.timestamp(), continue_visit)) {
-    return ApplyDelete(key, deltas);
-  }
-  return Status::OK();
-}
-
-template<>
-inline Status LivenessVisitor<UNDO>::Visit(const DeltaKey& key,
-                                           const Slice& deltas, bool*
-                                           continue_visit) {
-  if (IsUndoRelevant(dfi->mvcc_snap_, key.timestamp(), continue_visit)) {
-    return ApplyDelete(key, deltas);
-  }
-  return Status::OK();
+Status DeltaFileIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst,
+                                       const SelectionVector& filter) {
+  DCHECK(prepared_) << "must Prepare";
+  DCHECK_LE(prepared_count_, dst->nrows());
+  DVLOG(3) << "Applying " << DeltaType_Name(delta_type_) << " mutations to " << col_to_apply;
+  return decoded_.ApplyUpdates(col_to_apply, dst, filter);
 }
 
-
 Status DeltaFileIterator::ApplyDeletes(SelectionVector *sel_vec) {
+  DCHECK(prepared_) << "must Prepare";
   DCHECK_LE(prepared_count_, sel_vec->nrows());
-  if (delta_type_ == REDO) {
-    DVLOG(3) << "Applying REDO deletes";
-    LivenessVisitor<REDO> visitor = { this, sel_vec };
-    return VisitMutations(&visitor);
-  }
-  DVLOG(3) << "Applying UNDO deletes";
-  LivenessVisitor<UNDO> visitor = { this, sel_vec };
-  return VisitMutations(&visitor);
+  DVLOG(3) << "Applying " << DeltaType_Name(delta_type_) << " deletes";
+  decoded_.ApplyDeletes(sel_vec);
+  return Status::OK();
 }
 
 // Visitor which, for each mutation, adds it into a ColumnBlock of
@@ -856,19 +795,8 @@ bool DeltaFileIterator::HasNext() {
 }
 
 bool DeltaFileIterator::MayHaveDeltas() {
-  // TODO: change the API to take in the col_to_apply and check for deltas on
-  // that column only.
   DCHECK(prepared_) << "must Prepare";
-  for (auto& block : delta_blocks_) {
-    BinaryPlainBlockDecoder& bpd = *block->decoder_;
-    if (PREDICT_FALSE(prepared_idx_ > block->last_updated_idx_)) {
-      continue;
-    }
-    if (block->prepared_block_start_idx_ < bpd.Count()) {
-      return true;
-    }
-  }
-  return false;
+  return decoded_.HasDeltas();
 }
 
 string DeltaFileIterator::ToString() const {
@@ -73,11 +73,9 @@ namespace tablet {
 
 class Mutation;
 template<DeltaType Type>
-struct ApplyingVisitor;
-template<DeltaType Type>
 struct CollectingVisitor;
 template<DeltaType Type>
-struct LivenessVisitor;
+struct DecodingVisitor;
 
 class DeltaFileWriter {
  public:
@@ -165,6 +163,14 @@ class DeltaFileReader : public DeltaStore,
   // See DeltaStore::CheckRowDeleted
   virtual Status CheckRowDeleted(rowid_t row_idx, bool *deleted) const OVERRIDE;
 
+  // See DeltaStore::MayAffectScan
+  //
+  // Consults the delta stats, so always returns true if the file has not yet
+  // been initialized rather than incurring I/O here.
+  virtual bool MayAffectScan(const Schema& projection,
+                             rowid_t first_row,
+                             rowid_t last_row) const OVERRIDE;
+
   virtual uint64_t EstimateSize() const OVERRIDE;
 
   const BlockId& block_id() const { return reader_->block_id(); }
@@ -225,7 +231,8 @@ class DeltaFileIterator : public DeltaIterator {
 
   Status SeekToOrdinal(rowid_t idx) OVERRIDE;
   Status PrepareBatch(size_t nrows, PrepareFlag flag) OVERRIDE;
-  Status ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) OVERRIDE;
+  Status ApplyUpdates(size_t col_to_apply, ColumnBlock *dst,
+                      const SelectionVector& filter) OVERRIDE;
   Status ApplyDeletes(SelectionVector *sel_vec) OVERRIDE;
   Status CollectMutations(std::vector<Mutation *> *dst, Arena *arena) OVERRIDE;
   Status FilterColumnIdsAndCollectDeltas(const std::vector<ColumnId>& col_ids,
@@ -237,12 +244,10 @@ class DeltaFileIterator : public DeltaIterator {
 
  private:
   friend class DeltaFileReader;
-  friend struct ApplyingVisitor<REDO>;
-  friend struct ApplyingVisitor<UNDO>;
   friend struct CollectingVisitor<REDO>;
   friend struct CollectingVisitor<UNDO>;
-  friend struct LivenessVisitor<REDO>;
-  friend struct LivenessVisitor<UNDO>;
+  friend struct DecodingVisitor<REDO>;
+  friend struct DecodingVisitor<UNDO>;
   friend struct FilterAndAppendVisitor;
 
   DISALLOW_COPY_AND_ASSIGN(DeltaFileIterator);
@@ -307,6 +312,11 @@ class DeltaFileIterator : public DeltaIterator {
   template<class Visitor>
   Status VisitMutations(Visitor *visitor);
 
+  // Decode the mutations in the currently prepared row range which are
+  // relevant to the iterator's snapshot into 'decoded_', so that they can be
+  // applied one column at a time without re-parsing each RowChangeList.
+  Status DecodePreparedMutations();
+
   // Log a FATAL error message about a bad delta.
   void FatalUnexpectedDelta(const DeltaKey &key, const Slice &deltas,
                             const std::string &msg);
@@ -332,6 +342,10 @@ class DeltaFileIterator : public DeltaIterator {
   // which correspond to prepared_block_.
   std::deque<std::unique_ptr<PreparedDeltaBlock>> delta_blocks_;
 
+  // After PrepareBatch(PREPARE_FOR_APPLY), the relevant deltas of the prepared
+  // block, decoded column-by-column. Cells refer to data in 'delta_blocks_'.
+  DecodedDeltaBatch decoded_;
+
   // Temporary buffer used in seeking.
   faststring tmp_buf_;
 
@@ -36,6 +36,7 @@
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/row_changelist.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/common/types.h"
@@ -141,7 +142,9 @@ class TestDeltaMemStore : public KuduTest {
     ASSERT_OK(iter->Init(nullptr));
     ASSERT_OK(iter->SeekToOrdinal(row_idx));
     ASSERT_OK(iter->PrepareBatch(cb->nrows(), DeltaIterator::PREPARE_FOR_APPLY));
-    ASSERT_OK(iter->ApplyUpdates(0, cb));
+    SelectionVector sel(cb->nrows());
+    sel.SetAllTrue();
+    ASSERT_OK(iter->ApplyUpdates(0, cb, sel));
   }
 
 
@@ -446,6 +449,8 @@ TEST_F(TestDeltaMemStore, TestIteratorDoesUpdates) {
   // TODO: test snapshot reads from different points
   MvccSnapshot snap(mvcc_);
   ScopedColumnBlock<UINT32> block(100);
+  SelectionVector sel(block.nrows());
+  sel.SetAllTrue();
 
   DeltaIterator* raw_iter;
   Status s = dms_->NewDeltaIterator(&schema_, snap, &raw_iter);
@@ -460,7 +465,7 @@ TEST_F(TestDeltaMemStore, TestIteratorDoesUpdates) {
   int block_start_row = 50;
   ASSERT_OK(iter->SeekToOrdinal(block_start_row));
   ASSERT_OK(iter->PrepareBatch(block.nrows(), DeltaIterator::PREPARE_FOR_APPLY));
-  ASSERT_OK(iter->ApplyUpdates(kIntColumn, &block));
+  ASSERT_OK(iter->ApplyUpdates(kIntColumn, &block, sel));
 
   for (int i = 0; i < 100; i++) {
     int actual_row = block_start_row + i;
@@ -470,11 +475,27 @@ TEST_F(TestDeltaMemStore, TestIteratorDoesUpdates) {
   // Apply the next block
   block_start_row += block.nrows();
   ASSERT_OK(iter->PrepareBatch(block.nrows(), DeltaIterator::PREPARE_FOR_APPLY));
-  ASSERT_OK(iter->ApplyUpdates(kIntColumn, &block));
+  ASSERT_OK(iter->ApplyUpdates(kIntColumn, &block, sel));
   for (int i = 0; i < 100; i++) {
     int actual_row = block_start_row + i;
     ASSERT_EQ(actual_row * 10, block[i]) << "at row " << actual_row;
   }
+
+  // Apply the next block with every other row deselected: only the selected
+  // rows should be updated.
+  block_start_row += block.nrows();
+  for (int i = 0; i < 100; i++) {
+    block[i] = 0;
+    if (i % 2 == 1) {
+      sel.SetRowUnselected(i);
+    }
+  }
+  ASSERT_OK(iter->PrepareBatch(block.nrows(), DeltaIterator::PREPARE_FOR_APPLY));
+  ASSERT_OK(iter->ApplyUpdates(kIntColumn, &block, sel));
+  for (int i = 0; i < 100; i++) {
+    int actual_row = block_start_row + i;
+    ASSERT_EQ(i % 2 == 1 ? 0 : actual_row * 10, block[i]) << "at row " << actual_row;
+  }
 }
 
 TEST_F(TestDeltaMemStore, TestCollectMutations) {
@@ -134,7 +134,7 @@ Status DeltaMemStore::FlushToFile(DeltaFileWriter *dfw,
     RETURN_NOT_OK(key.DecodeFrom(&key_slice));
     RowChangeList rcl(val);
     RETURN_NOT_OK_PREPEND(dfw->AppendDelta<REDO>(key, rcl), "Failed to append delta");
-    stats->UpdateStats(key.timestamp(), rcl);
+    stats->UpdateStats(key, rcl);
     iter->Next();
   }
   dfw->WriteDeltaStats(*stats);
@@ -204,7 +204,8 @@ DMSIterator::DMSIterator(const shared_ptr<const DeltaMemStore>& dms,
       prepared_count_(0),
       prepared_for_(NOT_PREPARED),
       seeked_(false),
-      projection_(projection) {}
+      projection_(projection),
+      decoded_(projection) {}
 
 Status DMSIterator::Init(ScanSpec *spec) {
   initted_ = true;
@@ -242,13 +243,7 @@ Status DMSIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
   rowid_t start_row = prepared_idx_ + prepared_count_;
   rowid_t stop_row = start_row + nrows - 1;
 
-  if (updates_by_col_.empty()) {
-    updates_by_col_.resize(projection_->num_columns());
-  }
-  for (UpdatesForColumn& ufc : updates_by_col_) {
-    ufc.clear();
-  }
-  deleted_.clear();
+  decoded_.Reset(start_row);
   prepared_deltas_.clear();
 
   while (iter_->IsValid()) {
@@ -267,44 +262,9 @@ Status DMSIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
     }
 
     if (flag == PREPARE_FOR_APPLY) {
-      RowChangeListDecoder decoder((RowChangeList(val)));
-      decoder.InitNoSafetyChecks();
-      DCHECK(!decoder.is_reinsert()) << "Reinserts are not supported in the DeltaMemStore.";
-      if (decoder.is_delete()) {
-        deleted_.push_back(key.row_idx());
-      } else {
-        DCHECK(decoder.is_update());
-        while (decoder.HasNext()) {
-          RowChangeListDecoder::DecodedUpdate dec;
-          RETURN_NOT_OK(decoder.DecodeNext(&dec));
-          int col_idx;
-          const void* col_val;
-          RETURN_NOT_OK(dec.Validate(*projection_, &col_idx, &col_val));
-          if (col_idx == -1) {
-            // This column isn't being projected.
-            continue;
-          }
-          int col_size = projection_->column(col_idx).type_info()->size();
-
-          // If we already have an earlier update for the same column, we can
-          // just overwrite that one.
-          if (updates_by_col_[col_idx].empty() ||
-              updates_by_col_[col_idx].back().row_id != key.row_idx()) {
-            updates_by_col_[col_idx].emplace_back();
-          }
-
-          ColumnUpdate& cu = updates_by_col_[col_idx].back();
-          cu.row_id = key.row_idx();
-          if (col_val == nullptr) {
-            cu.new_val_ptr = nullptr;
-          } else {
-            memcpy(cu.new_val_buf, col_val, col_size);
-            // NOTE: we're constructing a pointer here to an element inside the deque.
-            // This is safe because deques never invalidate pointers to their elements.
-            cu.new_val_ptr = cu.new_val_buf;
-          }
-        }
-      }
+      RowChangeList changelist(val);
+      DCHECK(!changelist.is_reinsert()) << "Reinserts are not supported in the DeltaMemStore.";
+      RETURN_NOT_OK(decoded_.AddDelta(key.row_idx(), changelist));
     } else {
       DCHECK_EQ(flag, PREPARE_FOR_COLLECT);
       PreparedDelta d;
@@ -321,20 +281,12 @@ Status DMSIterator::PrepareBatch(size_t nrows, PrepareFlag flag) {
   return Status::OK();
 }
 
-Status DMSIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) {
+Status DMSIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock *dst,
+                                 const SelectionVector& filter) {
   DCHECK_EQ(prepared_for_, PREPARED_FOR_APPLY);
   DCHECK_EQ(prepared_count_, dst->nrows());
 
-  const ColumnSchema* col_schema = &projection_->column(col_to_apply);
-  for (const ColumnUpdate& cu : updates_by_col_[col_to_apply]) {
-    int32_t idx_in_block = cu.row_id - prepared_idx_;
-    DCHECK_GE(idx_in_block, 0);
-    SimpleConstCell src(col_schema, cu.new_val_ptr);
-    ColumnBlock::Cell dst_cell = dst->cell(idx_in_block);
-    RETURN_NOT_OK(CopyCell(src, &dst_cell, dst->arena()));
-  }
-
-  return Status::OK();
+  return decoded_.ApplyUpdates(col_to_apply, dst, filter);
 }
 
 
@@ -342,11 +294,7 @@ Status DMSIterator::ApplyDeletes(SelectionVector *sel_vec) {
   DCHECK_EQ(prepared_for_, PREPARED_FOR_APPLY);
   DCHECK_EQ(prepared_count_, sel_vec->nrows());
 
-  for (auto& row_id : deleted_) {
-    uint32_t idx_in_block = row_id - prepared_idx_;
-    sel_vec->SetRowUnselected(idx_in_block);
-  }
-
+  decoded_.ApplyDeletes(sel_vec);
   return Status::OK();
 }
 
@@ -379,15 +327,7 @@ bool DMSIterator::HasNext() {
 }
 
 bool DMSIterator::MayHaveDeltas() {
-  if (!deleted_.empty()) {
-    return true;
-  }
-  for (auto& col: updates_by_col_) {
-    if (!col.empty()) {
-      return true;
-    }
-  }
-  return false;
+  return decoded_.HasDeltas();
 }
 
 string DMSIterator::ToString() const {
@@ -127,6 +127,15 @@ class DeltaMemStore : public DeltaStore,
 
   virtual Status CheckRowDeleted(rowid_t row_idx, bool *deleted) const OVERRIDE;
 
+  // The DMS doesn't keep stats, so it can only rule out a scan when empty.
+  // Any mutation committed in the scan's snapshot was applied to the DMS
+  // before the snapshot was taken.
+  virtual bool MayAffectScan(const Schema& projection,
+                             rowid_t first_row,
+                             rowid_t last_row) const OVERRIDE {
+    return !Empty();
+  }
+
   virtual uint64_t EstimateSize() const OVERRIDE {
     return arena_->memory_footprint();
   }
@@ -204,7 +213,8 @@ class DMSIterator : public DeltaIterator {
 
   Status PrepareBatch(size_t nrows, PrepareFlag flag) OVERRIDE;
 
-  Status ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) OVERRIDE;
+  Status ApplyUpdates(size_t col_to_apply, ColumnBlock *dst,
+                      const SelectionVector& filter) OVERRIDE;
 
   Status ApplyDeletes(SelectionVector *sel_vec) OVERRIDE;
 
@@ -264,14 +274,7 @@ class DMSIterator : public DeltaIterator {
 
   // State when prepared_for_ == PREPARED_FOR_APPLY
   // ------------------------------------------------------------
-  struct ColumnUpdate {
-    rowid_t row_id;
-    void* new_val_ptr;
-    uint8_t new_val_buf[16];
-  };
-  typedef std::deque<ColumnUpdate> UpdatesForColumn;
-  std::vector<UpdatesForColumn> updates_by_col_;
-  std::deque<rowid_t> deleted_;
+  DecodedDeltaBatch decoded_;
 
   // State when prepared_for_ == PREPARED_FOR_COLLECT
   // ------------------------------------------------------------
@@ -163,6 +163,10 @@ class TabletPushdownTest : public KuduTabletTest,
       for (const IteratorStats& col_stats : stats) {
         EXPECT_EQ(expected_blocks_from_disk, col_stats.data_blocks_read_from_disk);
         EXPECT_EQ(expected_rows_from_disk, col_stats.cells_read_from_disk);
+        EXPECT_LE(col_stats.cells_decoded, col_stats.cells_read_from_disk);
+        // Only rows in on-disk rowsets are counted, and all the matching rows
+        // are on disk unless everything is still in memory.
+        EXPECT_EQ(GetParam() == ALL_IN_MEMORY ? 0 : results.size(), col_stats.cells_returned);
       }
     }
   }
@@ -622,7 +622,7 @@ Status TabletBootstrap::PrepareRecoveryDir(bool* needs_recovery) {
 
   FsManager* fs_manager = tablet_->metadata()->fs_manager();
   string tablet_id = tablet_->metadata()->tablet_id();
-  string log_dir = fs_manager->GetTabletWalDir(tablet_id);
+  string log_dir = fs_manager->GetOrPlaceTabletWalDir(tablet_id);
 
   // If the recovery directory exists, then we crashed mid-recovery.
   // Throw away any logs from the previous recovery attempt and restart the log
@@ -59,6 +59,14 @@ TAG_FLAG(enable_tablet_orphaned_block_deletion, advanced);
 TAG_FLAG(enable_tablet_orphaned_block_deletion, hidden);
 TAG_FLAG(enable_tablet_orphaned_block_deletion, runtime);
 
+DEFINE_bool(tablet_copy_reuse_tombstoned_blocks, false,
+            "Whether tombstoned replicas retain the data blocks of their rowsets, so "
+            "that a later tablet copy of the same tablet only downloads the blocks "
+            "it doesn't already have. Retained blocks use disk space until the "
+            "replica is copied again or deleted.");
+TAG_FLAG(tablet_copy_reuse_tombstoned_blocks, experimental);
+TAG_FLAG(tablet_copy_reuse_tombstoned_blocks, runtime);
+
 using base::subtle::Barrier_AtomicIncrement;
 using kudu::consensus::MinimumOpId;
 using kudu::consensus::OpId;
@@ -185,6 +193,7 @@ vector<BlockId> TabletMetadata::CollectBlockIds() {
                      rowset_block_ids.begin(),
                      rowset_block_ids.end());
   }
+  block_ids.insert(block_ids.end(), retained_blocks_.begin(), retained_blocks_.end());
   return block_ids;
 }
 
@@ -205,8 +214,25 @@ Status TabletMetadata::DeleteTabletData(TabletDataState delete_type,
   // we have been deleted.
   {
     std::lock_guard<LockType> l(data_lock_);
+    // The blocks of a replica which was being copied may not be durable yet:
+    // only retain those of a replica whose data was ready.
+    bool retain = delete_type != TABLET_DATA_DELETED &&
+        FLAGS_tablet_copy_reuse_tombstoned_blocks;
+    bool retain_rowsets = retain &&
+        delete_type == TABLET_DATA_TOMBSTONED &&
+        tablet_data_state_ == TABLET_DATA_READY;
     for (const shared_ptr<RowSetMetadata>& rsmd : rowsets_) {
-      AddOrphanedBlocksUnlocked(rsmd->GetAllBlocks());
+      for (const BlockId& block_id : rsmd->GetAllBlocks()) {
+        if (retain_rowsets) {
+          retained_blocks_.insert(block_id);
+        } else {
+          orphaned_blocks_.insert(block_id);
+        }
+      }
+    }
+    if (!retain) {
+      orphaned_blocks_.insert(retained_blocks_.begin(), retained_blocks_.end());
+      retained_blocks_.clear();
     }
     rowsets_.clear();
     tablet_data_state_ = delete_type;
@@ -243,7 +269,8 @@ bool TabletMetadata::IsTombstonedWithNoBlocks() const {
   std::lock_guard<LockType> l(data_lock_);
   return tablet_data_state_ == TABLET_DATA_TOMBSTONED &&
       rowsets_.empty() &&
-      orphaned_blocks_.empty();
+      orphaned_blocks_.empty() &&
+      retained_blocks_.empty();
 }
 
 Status TabletMetadata::DeleteSuperBlock() {
@@ -416,6 +443,13 @@ Status TabletMetadata::LoadFromSuperBlock(const TabletSuperBlockPB& superblock)
     }
     AddOrphanedBlocksUnlocked(orphaned_blocks);
 
+    retained_blocks_.clear();
+    for (const BlockIdPB& block_pb : superblock.retained_blocks()) {
+      BlockId retained_block_id = BlockId::FromPB(block_pb);
+      max_block_id = std::max(max_block_id, retained_block_id);
+      retained_blocks_.insert(retained_block_id);
+    }
+
     // Notify the block manager of the highest block ID seen.
     fs_manager()->block_manager()->NotifyBlockId(max_block_id);
 
@@ -627,6 +661,11 @@ boost::optional<consensus::OpId> TabletMetadata::tombstone_last_logged_opid() co
   return tombstone_last_logged_opid_;
 }
 
+vector<BlockId> TabletMetadata::retained_blocks() const {
+  std::lock_guard<LockType> l(data_lock_);
+  return vector<BlockId>(retained_blocks_.begin(), retained_blocks_.end());
+}
+
 Status TabletMetadata::ReadSuperBlockFromDisk(TabletSuperBlockPB* superblock) const {
   string path = fs_manager_->GetTabletMetadataPath(tablet_id_);
   RETURN_NOT_OK_PREPEND(
@@ -672,6 +711,10 @@ Status TabletMetadata::ToSuperBlockUnlocked(TabletSuperBlockPB* super_block,
     block_id.CopyToPB(pb.mutable_orphaned_blocks()->Add());
   }
 
+  for (const BlockId& block_id : retained_blocks_) {
+    block_id.CopyToPB(pb.mutable_retained_blocks()->Add());
+  }
+
   // Serialize the tablet's DataDirGroupPB if one exists. One may not exist if
   // this is called during a tablet deletion.
   DataDirGroupPB group_pb;
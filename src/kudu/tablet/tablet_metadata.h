@@ -107,6 +107,8 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   static std::vector<BlockIdPB> CollectBlockIdPBs(
       const TabletSuperBlockPB& superblock);
 
+  // Returns the blocks of the tablet's rowsets, as well as its retained
+  // blocks, if any.
   std::vector<BlockId> CollectBlockIds();
 
   const std::string& tablet_id() const {
@@ -191,6 +193,10 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   // 'delete_type' must be one of TABLET_DATA_DELETED, TABLET_DATA_TOMBSTONED,
   // or TABLET_DATA_COPYING.
   //
+  // If --tablet_copy_reuse_tombstoned_blocks is set, tombstoning a tablet
+  // whose data is ready retains the blocks of its rowsets rather than deleting
+  // them, and blocks already retained are kept unless the tablet is deleted.
+  //
   // 'last_logged_opid' should be set to the last opid in the log, if any is known.
   // If 'last_logged_opid' is not set, then the current value of
   // last_logged_opid is not modified. This is important for roll-forward of
@@ -200,7 +206,7 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   Status DeleteTabletData(TabletDataState delete_type,
                           const boost::optional<consensus::OpId>& last_logged_opid);
 
-  // Return true if this metadata references no blocks (either live or orphaned) and is
+  // Return true if this metadata references no blocks (live, orphaned, or retained) and is
   // already marked as tombstoned. If this is the case, then calling DeleteTabletData
   // would be a no-op.
   bool IsTombstonedWithNoBlocks() const;
@@ -230,6 +236,9 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   // Return the last-logged opid of a tombstoned tablet, if known.
   boost::optional<consensus::OpId> tombstone_last_logged_opid() const;
 
+  // Return the blocks retained from the rowsets of a tombstoned tablet.
+  std::vector<BlockId> retained_blocks() const;
+
   // Loads the currently-flushed superblock from disk into the given protobuf.
   Status ReadSuperBlockFromDisk(TabletSuperBlockPB* superblock) const;
 
@@ -354,6 +363,10 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   // Protected by 'data_lock_'.
   BlockIdSet orphaned_blocks_;
 
+  // Blocks retained from the rowsets of the tablet when it was tombstoned.
+  // Protected by 'data_lock_'.
+  BlockIdSet retained_blocks_;
+
   // The current state of tablet copy for the tablet.
   TabletDataState tablet_data_state_;
 
@@ -98,9 +98,28 @@ METRIC_DEFINE_counter(tablet, scanner_bytes_scanned_from_disk, "Scanner Bytes Sc
                       "and does not include data read from in-memory stores. However, it"
                       "includes both cache misses and cache hits.");
 
+METRIC_DEFINE_counter(tablet, scanner_cells_decoded, "Scanner Cells Decoded",
+                      kudu::MetricUnit::kCells,
+                      "Number of table cells decoded from disk by scan requests. "
+                      "Comparing this to Scanner Cells Scanned From Disk shows how "
+                      "many cells late materialization avoided decoding because "
+                      "their rows had already been filtered out by predicates.");
+
+METRIC_DEFINE_counter(tablet, scanner_delta_stores_skipped, "Scanner Delta Stores Skipped",
+                      kudu::MetricUnit::kUnits,
+                      "Number of delta stores which scan requests did not need to "
+                      "read at all, because the stores' statistics showed that they "
+                      "contained no deltas for the scanned columns or rows.");
+
 METRIC_DEFINE_counter(tablet, scans_started, "Scans Started",
                       kudu::MetricUnit::kScanners,
                       "Number of scanners which have been started on this tablet");
+METRIC_DEFINE_counter(tablet, scans_served_under_leader_lease,
+                      "Scans Served Under Leader Lease",
+                      kudu::MetricUnit::kScanners,
+                      "Number of scanners of the latest data started on this tablet "
+                      "while it was the leader, after waiting for a Raft leader lease "
+                      "and for the operations committed before the scan to be applied.");
 METRIC_DEFINE_gauge_size(tablet, tablet_active_scanners, "Active Scanners",
                          kudu::MetricUnit::kScanners,
                          "Number of scanners that are currently active on this tablet");
@@ -277,7 +296,10 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(scanner_rows_scanned),
     MINIT(scanner_cells_scanned_from_disk),
     MINIT(scanner_bytes_scanned_from_disk),
+    MINIT(scanner_cells_decoded),
+    MINIT(scanner_delta_stores_skipped),
     MINIT(scans_started),
+    MINIT(scans_served_under_leader_lease),
     GINIT(tablet_active_scanners),
     MINIT(bloom_lookups),
     MINIT(key_file_lookups),
@@ -58,7 +58,10 @@ struct TabletMetrics {
   scoped_refptr<Counter> scanner_rows_scanned;
   scoped_refptr<Counter> scanner_cells_scanned_from_disk;
   scoped_refptr<Counter> scanner_bytes_scanned_from_disk;
+  scoped_refptr<Counter> scanner_cells_decoded;
+  scoped_refptr<Counter> scanner_delta_stores_skipped;
   scoped_refptr<Counter> scans_started;
+  scoped_refptr<Counter> scans_served_under_leader_lease;
   scoped_refptr<AtomicGauge<size_t>> tablet_active_scanners;
 
   // Probe stats
@@ -89,6 +89,7 @@ using consensus::RECEIVED_OPID;
 using consensus::RaftConfigPB;
 using consensus::RaftConsensus;
 using consensus::RaftPeerPB;
+using consensus::ReplicateMsg;
 using log::Log;
 using log::LogOptions;
 using pb_util::SecureDebugString;
@@ -167,7 +168,8 @@ class TabletReplicaTest : public KuduTabletTest {
                                   messenger_,
                                   scoped_refptr<rpc::ResultTracker>(),
                                   log,
-                                  prepare_pool_.get());
+                                  prepare_pool_.get(),
+                                  nullptr);
   }
 
   Status StartReplicaAndWaitUntilLeader(const ConsensusBootstrapInfo& info) {
@@ -562,6 +564,52 @@ TEST_F(TabletReplicaTest, TestActiveTransactionPreventsLogGC) {
   ASSERT_EQ(2, segments.size());
 }
 
+// Test that a write whose request is movable has its row operations moved,
+// rather than copied, into its replicate message, and is still applied.
+TEST_F(TabletReplicaTest, TestWriteMovesRowOperationsToReplicate) {
+  ConsensusBootstrapInfo info;
+  ASSERT_OK(StartReplicaAndWaitUntilLeader(info));
+
+  // Moving the request into a replicate message leaves it without its row
+  // operations, and the transaction reads the request from the message.
+  {
+    WriteRequestPB req;
+    ASSERT_OK(GenerateSequentialInsertRequest(&req));
+    const string rows = req.row_operations().rows();
+    unique_ptr<WriteTransactionState> tx_state(new WriteTransactionState(tablet_replica_.get(),
+                                                                         &req,
+                                                                         nullptr));
+    tx_state->set_movable_request(&req);
+    WriteTransactionState* state = tx_state.get();
+    WriteTransaction transaction(std::move(tx_state), consensus::LEADER);
+    gscoped_ptr<ReplicateMsg> replicate;
+    transaction.NewReplicateMsg(&replicate);
+    ASSERT_FALSE(req.has_row_operations());
+    ASSERT_EQ(req.tablet_id(), replicate->write_request().tablet_id());
+    ASSERT_EQ(rows, replicate->write_request().row_operations().rows());
+    ASSERT_EQ(&replicate->write_request(), state->request());
+  }
+
+  // A movable write goes through like any other.
+  gscoped_ptr<WriteRequestPB> req(new WriteRequestPB());
+  gscoped_ptr<WriteResponsePB> resp(new WriteResponsePB());
+  ASSERT_OK(GenerateSequentialInsertRequest(req.get()));
+  unique_ptr<WriteTransactionState> tx_state(new WriteTransactionState(tablet_replica_.get(),
+                                                                       req.get(),
+                                                                       nullptr, // No RequestIdPB
+                                                                       resp.get()));
+  tx_state->set_movable_request(req.get());
+  CountDownLatch rpc_latch(1);
+  tx_state->set_completion_callback(gscoped_ptr<TransactionCompletionCallback>(
+      new LatchTransactionCompletionCallback<WriteResponsePB>(&rpc_latch, resp.get())));
+  ASSERT_OK(tablet_replica_->SubmitWrite(std::move(tx_state)));
+  rpc_latch.Wait();
+  ASSERT_FALSE(resp->has_error()) << SecureDebugString(*resp);
+  uint64_t num_rows;
+  ASSERT_OK(tablet()->CountRows(&num_rows));
+  ASSERT_EQ(1, num_rows);
+}
+
 TEST_F(TabletReplicaTest, TestGCEmptyLog) {
   ConsensusBootstrapInfo info;
   ASSERT_OK(StartReplica(info));
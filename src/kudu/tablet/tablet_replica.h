@@ -58,6 +58,7 @@ class Callback;
 
 namespace consensus {
 class ConsensusMetadataManager;
+class MultiRaftManager;
 class TransactionStatusPB;
 }
 
@@ -109,7 +110,8 @@ class TabletReplica : public RefCountedThreadSafe<TabletReplica>,
                std::shared_ptr<rpc::Messenger> messenger,
                scoped_refptr<rpc::ResultTracker> result_tracker,
                scoped_refptr<log::Log> log,
-               ThreadPool* prepare_pool);
+               ThreadPool* prepare_pool,
+               consensus::MultiRaftManager* multi_raft_manager);
 
   // Synchronously transition this replica to STOPPED state from any other
   // state. This also stops RaftConsensus. If a Stop() operation is already in
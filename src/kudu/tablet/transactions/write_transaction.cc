@@ -90,7 +90,7 @@ WriteTransaction::WriteTransaction(unique_ptr<WriteTransactionState> state, Driv
 void WriteTransaction::NewReplicateMsg(gscoped_ptr<ReplicateMsg>* replicate_msg) {
   replicate_msg->reset(new ReplicateMsg);
   (*replicate_msg)->set_op_type(WRITE_OP);
-  (*replicate_msg)->mutable_write_request()->CopyFrom(*state()->request());
+  state()->MoveRequestTo((*replicate_msg)->mutable_write_request());
   if (state()->are_results_tracked()) {
     (*replicate_msg)->mutable_request_id()->CopyFrom(state()->request_id());
   }
@@ -252,6 +252,23 @@ WriteTransactionState::WriteTransactionState(TabletReplica* tablet_replica,
   }
 }
 
+void WriteTransactionState::MoveRequestTo(tserver::WriteRequestPB* dst) {
+  if (movable_request_) {
+    // Swap the row operations, which hold the bulk of the request, out of the
+    // request while copying the rest of it.
+    RowOperationsPB row_ops;
+    row_ops.Swap(movable_request_->mutable_row_operations());
+    movable_request_->clear_row_operations();
+    dst->CopyFrom(*movable_request_);
+    dst->mutable_row_operations()->Swap(&row_ops);
+    movable_request_ = nullptr;
+  } else {
+    dst->CopyFrom(*request_);
+  }
+  std::lock_guard<simple_spinlock> l(txn_state_lock_);
+  request_ = dst;
+}
+
 void WriteTransactionState::SetMvccTx(gscoped_ptr<ScopedTransaction> mvcc_tx) {
   DCHECK(!mvcc_tx_) << "Mvcc transaction already started/set.";
   mvcc_tx_ = std::move(mvcc_tx);
@@ -106,6 +106,24 @@ class WriteTransactionState : public TransactionState {
     return response_;
   }
 
+  // Allows the row operations of the client request to be moved, rather than
+  // copied, into the replicate message of this transaction. Only for callers
+  // that don't read the row operations once the write is submitted, since
+  // 'request' no longer holds them afterwards.
+  //
+  // REQUIRES: 'request' is the request this state was constructed with.
+  void set_movable_request(tserver::WriteRequestPB* request) {
+    DCHECK_EQ(request, request_);
+    movable_request_ = request;
+  }
+
+  // Sets 'dst' to the client request and reads the request from 'dst' from
+  // then on. The row operations are moved into 'dst' if the request was made
+  // movable, and copied otherwise.
+  //
+  // REQUIRES: 'dst' outlives this transaction state.
+  void MoveRequestTo(tserver::WriteRequestPB* dst);
+
   // Set the MVCC transaction associated with this Write operation.
   // This must be called exactly once, after the timestamp was acquired.
   // This also copies the timestamp from the MVCC transaction into the
@@ -202,6 +220,9 @@ class WriteTransactionState : public TransactionState {
   const tserver::WriteRequestPB* request_;
   tserver::WriteResponsePB* response_;
 
+  // The request passed to set_movable_request(), if any.
+  tserver::WriteRequestPB* movable_request_ = nullptr;
+
   // The row operations which are decoded from the request during PREPARE
   // Protected by superclass's txn_state_lock_.
   std::vector<RowOp*> row_ops_;
@@ -417,7 +417,8 @@ TEST_F(ToolTest, TestModeHelp) {
         "block.*binary contents of a data block",
         "cfile.*contents of a CFile",
         "tree.*tree of a Kudu filesystem",
-        "uuid.*UUID of a Kudu filesystem"
+        "uuid.*UUID of a Kudu filesystem",
+        "wals.*placement of tablets' WALs"
     };
     NO_FATALS(RunTestHelp("fs dump", kFsDumpModeRegexes));
 
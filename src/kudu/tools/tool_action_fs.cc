@@ -21,6 +21,7 @@
 #include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -38,6 +39,7 @@
 #include "kudu/fs/block_manager.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/fs/fs_report.h"
+#include "kudu/fs/wal_dirs.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/ref_counted.h"
@@ -275,6 +277,31 @@ Status DumpFsTree(const RunnerContext& /*context*/) {
   return Status::OK();
 }
 
+Status DumpWals(const RunnerContext& /*context*/) {
+  FsManagerOpts fs_opts;
+  fs_opts.read_only = true;
+  FsManager fs_manager(Env::Default(), std::move(fs_opts));
+  RETURN_NOT_OK(fs_manager.Open());
+
+  // Group the tablets by WAL directory, listing every directory even if it
+  // holds no WALs.
+  std::map<string, vector<string>> tablets_by_dir;
+  for (const auto& dir : fs_manager.wd_manager()->dirs()) {
+    tablets_by_dir[dir->dir()];
+  }
+  for (const auto& e : fs_manager.wd_manager()->GetPlacements()) {
+    tablets_by_dir[e.second->dir()].emplace_back(e.first);
+  }
+  for (auto& e : tablets_by_dir) {
+    std::sort(e.second.begin(), e.second.end());
+    cout << e.first << " (" << e.second.size() << " tablets)" << endl;
+    for (const auto& tablet_id : e.second) {
+      cout << "  " << tablet_id << endl;
+    }
+  }
+  return Status::OK();
+}
+
 Status Update(const RunnerContext& /*context*/) {
   Env* env = Env::Default();
   FsManagerOpts opts;
@@ -293,6 +320,7 @@ static unique_ptr<Mode> BuildFsDumpMode() {
                         "and outputs the decoded row data.")
       .AddRequiredParameter({ "block_id", "block identifier" })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .AddOptionalParameter("print_meta")
       .AddOptionalParameter("print_rows")
@@ -305,6 +333,7 @@ static unique_ptr<Mode> BuildFsDumpMode() {
                         "in the block but rather outputs its binary contents directly.")
       .AddRequiredParameter({ "block_id", "block identifier" })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .Build();
 
@@ -312,6 +341,7 @@ static unique_ptr<Mode> BuildFsDumpMode() {
       ActionBuilder("tree", &DumpFsTree)
       .Description("Dump the tree of a Kudu filesystem")
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .Build();
 
@@ -319,6 +349,15 @@ static unique_ptr<Mode> BuildFsDumpMode() {
       ActionBuilder("uuid", &DumpUuid)
       .Description("Dump the UUID of a Kudu filesystem")
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
+      .AddOptionalParameter("fs_data_dirs")
+      .Build();
+
+  unique_ptr<Action> dump_wals =
+      ActionBuilder("wals", &DumpWals)
+      .Description("Dump the placement of tablets' WALs across WAL directories")
+      .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .Build();
 
@@ -328,6 +367,7 @@ static unique_ptr<Mode> BuildFsDumpMode() {
       .AddAction(std::move(dump_cfile))
       .AddAction(std::move(dump_tree))
       .AddAction(std::move(dump_uuid))
+      .AddAction(std::move(dump_wals))
       .Build();
 }
 
@@ -336,6 +376,7 @@ unique_ptr<Mode> BuildFsMode() {
       ActionBuilder("check", &Check)
       .Description("Check a Kudu filesystem for inconsistencies")
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .AddOptionalParameter("repair")
       .Build();
@@ -344,6 +385,7 @@ unique_ptr<Mode> BuildFsMode() {
       ActionBuilder("format", &Format)
       .Description("Format a new Kudu filesystem")
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .AddOptionalParameter("uuid")
       .Build();
@@ -353,6 +395,7 @@ unique_ptr<Mode> BuildFsMode() {
       .Description("Updates the set of data directories in an existing Kudu filesystem")
       .ExtraDescription("Cannot currently be used to remove data directories")
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .Build();
 
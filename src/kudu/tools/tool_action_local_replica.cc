@@ -884,6 +884,7 @@ unique_ptr<Mode> BuildDumpMode() {
       .Description("Dump the IDs of all blocks belonging to a local replica")
       .AddRequiredParameter({ kTabletIdArg, kTabletIdArgDesc })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .Build();
 
@@ -892,6 +893,7 @@ unique_ptr<Mode> BuildDumpMode() {
       .Description("Dump the metadata of a local replica")
       .AddRequiredParameter({ kTabletIdArg, kTabletIdArgDesc })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .Build();
 
@@ -901,6 +903,7 @@ unique_ptr<Mode> BuildDumpMode() {
       .AddRequiredParameter({ kTabletIdArg, kTabletIdArgDesc })
       .AddOptionalParameter("dump_data")
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .AddOptionalParameter("metadata_only")
       .AddOptionalParameter("nrows")
@@ -913,6 +916,7 @@ unique_ptr<Mode> BuildDumpMode() {
         "a local replica")
       .AddRequiredParameter({ kTabletIdArg, kTabletIdArgDesc })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .AddOptionalParameter("print_entries")
       .AddOptionalParameter("print_meta")
@@ -937,6 +941,7 @@ unique_ptr<Mode> BuildLocalReplicaMode() {
         "tablet's Raft configuration")
       .AddRequiredParameter({ kTabletIdArg, kTabletIdArgDesc })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .Build();
 
@@ -948,6 +953,7 @@ unique_ptr<Mode> BuildLocalReplicaMode() {
         "peers", "List of peers where each peer is of "
         "form 'uuid:hostname:port'" })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .Build();
 
@@ -958,6 +964,7 @@ unique_ptr<Mode> BuildLocalReplicaMode() {
       .AddRequiredParameter({ kTermArg, "the new raft term (must be greater "
         "than the current term)" })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .Build();
 
@@ -977,6 +984,7 @@ unique_ptr<Mode> BuildLocalReplicaMode() {
       .AddRequiredParameter({ "source", "Source RPC address of "
         "form hostname:port" })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .Build();
 
@@ -984,6 +992,7 @@ unique_ptr<Mode> BuildLocalReplicaMode() {
       ActionBuilder("list", &ListLocalReplicas)
       .Description("Show list of tablet replicas in the local filesystem")
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .AddOptionalParameter("list_detail")
       .Build();
@@ -994,6 +1003,7 @@ unique_ptr<Mode> BuildLocalReplicaMode() {
           "By default, leaves a tombstone record.")
       .AddRequiredParameter({ kTabletIdArg, kTabletIdArgDesc })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .AddOptionalParameter("clean_unsafe")
       .Build();
@@ -1003,6 +1013,7 @@ unique_ptr<Mode> BuildLocalReplicaMode() {
       .Description("Summarize the data size/space usage of the given local replica(s).")
       .AddRequiredParameter({ kTabletIdGlobArg, kTabletIdGlobArgDesc })
       .AddOptionalParameter("fs_wal_dir")
+      .AddOptionalParameter("fs_additional_wal_dirs")
       .AddOptionalParameter("fs_data_dirs")
       .AddOptionalParameter("format")
       .Build();
@@ -23,8 +23,10 @@
 #include <stdlib.h>
 #include <string>
 #include <thread>
+#include <unordered_set>
 #include <vector>
 
+#include <boost/none.hpp>
 #include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <glog/stl_logging.h>
@@ -44,6 +46,7 @@
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/casts.h"
 #include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/fastmem.h"
@@ -70,6 +73,8 @@ using std::string;
 using std::thread;
 using std::vector;
 
+DECLARE_bool(tablet_copy_reuse_tombstoned_blocks);
+DECLARE_int64(tablet_copy_find_matching_blocks_max_bytes);
 DECLARE_string(block_manager);
 
 METRIC_DECLARE_counter(block_manager_total_disk_sync);
@@ -201,7 +206,7 @@ TEST_F(TabletCopyClientTest, TestDownloadBlock) {
 // Basic WAL segment download unit test.
 TEST_F(TabletCopyClientTest, TestDownloadWalSegment) {
   ASSERT_OK(env_util::CreateDirIfMissing(
-      env_, fs_manager_->GetTabletWalDir(GetTabletId())));
+      env_, fs_manager_->GetOrPlaceTabletWalDir(GetTabletId())));
 
   uint64_t seqno = client_->wal_seqnos_[0];
   string path = fs_manager_->GetWalSegmentFileName(GetTabletId(), seqno);
@@ -286,6 +291,57 @@ TEST_F(TabletCopyClientTest, TestDownloadAllBlocks) {
   }
 }
 
+// Test that copying a tablet over a tombstoned replica reuses the blocks it
+// retained rather than downloading them again.
+TEST_F(TabletCopyClientTest, TestReuseRetainedBlocks) {
+  FLAGS_tablet_copy_reuse_tombstoned_blocks = true;
+  ASSERT_OK(client_->FetchAll(nullptr));
+  ASSERT_OK(client_->Finish());
+  vector<BlockId> local_blocks = ListBlocks(*client_->superblock_);
+  ASSERT_FALSE(local_blocks.empty());
+  client_.reset();
+
+  // Tombstone the copy, retaining its blocks.
+  ASSERT_OK(meta_->DeleteTabletData(tablet::TABLET_DATA_TOMBSTONED, boost::none));
+  ASSERT_EQ(local_blocks.size(), meta_->retained_blocks().size());
+
+  // Copy the tablet again: every block should be reused. Make the source
+  // answer one block per FindMatchingBlocks call to exercise resumption.
+  FLAGS_tablet_copy_find_matching_blocks_max_bytes = 1;
+  TabletCopyClientMetrics metrics(metric_entity_);
+  scoped_refptr<ConsensusMetadataManager> cmeta_manager(
+      new ConsensusMetadataManager(fs_manager_.get()));
+  client_.reset(new TabletCopyClient(GetTabletId(),
+                                     fs_manager_.get(),
+                                     cmeta_manager,
+                                     messenger_,
+                                     &metrics));
+  ASSERT_OK(client_->SetTabletToReplace(meta_, tablet_replica_->consensus()->CurrentTerm()));
+  HostPort host_port;
+  ASSERT_OK(HostPortFromPB(leader_.last_known_addr(), &host_port));
+  ASSERT_OK(client_->Start(host_port, &meta_));
+  ASSERT_OK(client_->FetchAll(nullptr));
+  ASSERT_OK(client_->Finish());
+
+  ASSERT_EQ(local_blocks.size(), metrics.blocks_reused->value());
+  ASSERT_TRUE(meta_->retained_blocks().empty());
+
+  // The reused blocks were copied into the new directory group rather than
+  // used in place, and the retained blocks were orphaned.
+  vector<BlockId> new_local_blocks = ListBlocks(*client_->superblock_);
+  ASSERT_EQ(local_blocks.size(), new_local_blocks.size());
+  BlockIdSet retained(local_blocks.begin(), local_blocks.end());
+  for (const BlockId& block_id : new_local_blocks) {
+    ASSERT_FALSE(ContainsKey(retained, block_id)) << "Block reused in place: " << block_id;
+    ASSERT_TRUE(fs_manager_->BlockExists(block_id)) << "Missing block: " << block_id;
+  }
+  BlockIdSet orphaned;
+  for (const BlockIdPB& block_pb : client_->superblock_->orphaned_blocks()) {
+    orphaned.insert(BlockId::FromPB(block_pb));
+  }
+  ASSERT_EQ(retained, orphaned);
+}
+
 // Test that failing a disk outside fo the tablet copy client will eventually
 // stop the copy client and cause it to fail.
 TEST_F(TabletCopyClientTest, TestFailedDiskStopsClient) {
@@ -394,7 +450,7 @@ TEST_P(TabletCopyClientAbortTest, TestAbort) {
 
   // Download a WAL segment.
   ASSERT_OK(env_util::CreateDirIfMissing(
-      env_, fs_manager_->GetTabletWalDir(GetTabletId())));
+      env_, fs_manager_->GetOrPlaceTabletWalDir(GetTabletId())));
   uint64_t seqno = client_->wal_seqnos_[0];
   ASSERT_OK(client_->DownloadWAL(seqno));
   string wal_path = fs_manager_->GetWalSegmentFileName(GetTabletId(), seqno);
@@ -17,6 +17,7 @@
 
 #include "kudu/tserver/tablet_copy_client.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <ostream>
@@ -40,6 +41,7 @@
 #include "kudu/fs/data_dirs.h"
 #include "kudu/fs/fs.pb.h"
 #include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/walltime.h"
@@ -50,6 +52,7 @@
 #include "kudu/tablet/tablet_replica.h"
 #include "kudu/tserver/tablet_copy.pb.h"
 #include "kudu/tserver/tablet_copy.proxy.h"
+#include "kudu/tserver/tablet_copy_source_session.h"
 #include "kudu/tserver/ts_tablet_manager.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/env.h"
@@ -64,6 +67,7 @@
 #include "kudu/util/pb_util.h"
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
+#include "kudu/util/slice.h"
 
 DEFINE_int32(tablet_copy_begin_session_timeout_ms, 3000,
              "Tablet server RPC client timeout for BeginTabletCopySession calls. "
@@ -95,6 +99,7 @@ DEFINE_double(tablet_copy_fault_crash_before_write_cmeta, 0.0,
 TAG_FLAG(tablet_copy_fault_crash_before_write_cmeta, unsafe);
 TAG_FLAG(tablet_copy_fault_crash_before_write_cmeta, runtime);
 
+DECLARE_bool(tablet_copy_reuse_tombstoned_blocks);
 DECLARE_int32(tablet_copy_transfer_chunk_size_bytes);
 
 METRIC_DEFINE_counter(server, tablet_copy_bytes_fetched,
@@ -102,6 +107,12 @@ METRIC_DEFINE_counter(server, tablet_copy_bytes_fetched,
                       kudu::MetricUnit::kBytes,
                       "Number of bytes fetched during tablet copy operations since server start");
 
+METRIC_DEFINE_counter(server, tablet_copy_blocks_reused,
+                      "Blocks Reused By Tablet Copy",
+                      kudu::MetricUnit::kBlocks,
+                      "Number of blocks that tablet copy operations reused from tombstoned "
+                      "replicas rather than fetching them, since server start");
+
 METRIC_DEFINE_gauge_int32(server, tablet_copy_open_client_sessions,
                           "Open Table Copy Client Sessions",
                           kudu::MetricUnit::kSessions,
@@ -121,6 +132,7 @@ using consensus::OpId;
 using env_util::CopyFile;
 using fs::BlockManager;
 using fs::CreateBlockOptions;
+using fs::ReadableBlock;
 using fs::WritableBlock;
 using rpc::Messenger;
 using std::shared_ptr;
@@ -139,6 +151,7 @@ using tablet::TabletSuperBlockPB;
 
 TabletCopyClientMetrics::TabletCopyClientMetrics(const scoped_refptr<MetricEntity>& metric_entity)
     : bytes_fetched(METRIC_tablet_copy_bytes_fetched.Instantiate(metric_entity)),
+      blocks_reused(METRIC_tablet_copy_blocks_reused.Instantiate(metric_entity)),
       open_client_sessions(METRIC_tablet_copy_open_client_sessions.Instantiate(metric_entity, 0)) {
 }
 
@@ -240,6 +253,13 @@ Status TabletCopyClient::Start(const HostPort& copy_source_addr,
   // Set up an RPC proxy for the TabletCopyService.
   proxy_.reset(new TabletCopyServiceProxy(messenger_, addr, copy_source_addr.host()));
 
+  // Digest the retained blocks before beginning the session: this may take a
+  // while for a large tablet, and the source would expire an idle session.
+  FindMatchingBlocksRequestPB match_req;
+  if (replace_tombstoned_tablet_ && FLAGS_tablet_copy_reuse_tombstoned_blocks) {
+    DigestRetainedBlocks(&match_req);
+  }
+
   BeginTabletCopySessionRequestPB req;
   req.set_requestor_uuid(fs_manager_->uuid());
   req.set_tablet_id(tablet_id_);
@@ -265,6 +285,18 @@ Status TabletCopyClient::Start(const HostPort& copy_source_addr,
   session_id_ = resp.session_id();
   session_idle_timeout_millis_ = resp.session_idle_timeout_millis();
 
+  if (match_req.local_block_checksums_size() > 0) {
+    match_req.set_session_id(session_id_);
+    Status s = FindMatchingBlocks(&match_req);
+    if (PREDICT_FALSE(!s.ok())) {
+      // Reusing retained blocks is only an optimization; download everything.
+      LOG_WITH_PREFIX(WARNING) << "Unable to find retained blocks matching those "
+                               << "of the tablet copy source: " << s.ToString();
+      reusable_blocks_.clear();
+      remote_block_checksums_.clear();
+    }
+  }
+
   // Store a copy of the remote (old) superblock.
   remote_superblock_.reset(resp.release_superblock());
 
@@ -277,6 +309,7 @@ Status TabletCopyClient::Start(const HostPort& copy_source_addr,
   // deleted locally. We must clear them all.
   superblock_->clear_rowsets();
   superblock_->clear_orphaned_blocks();
+  superblock_->clear_retained_blocks();
 
   // The UUIDs within the DataDirGroupPB on the remote are also unique to the
   // remote and have no meaning to us.
@@ -325,6 +358,16 @@ Status TabletCopyClient::Start(const HostPort& copy_source_addr,
                                           tablet::TABLET_DATA_COPYING,
                                           /*last_logged_opid=*/ boost::none),
         "Could not replace superblock with COPYING data state");
+
+    // Keep track of the blocks retained by the tombstoned replica until the
+    // copy finishes, so that they aren't leaked if it's aborted.
+    for (const BlockId& block_id : meta_->retained_blocks()) {
+      block_id.CopyToPB(superblock_->add_retained_blocks());
+    }
+    if (superblock_->retained_blocks_size() == 0) {
+      reusable_blocks_.clear();
+      remote_block_checksums_.clear();
+    }
     RETURN_NOT_OK_PREPEND(fs_manager_->dd_manager()->CreateDataDirGroup(tablet_id_),
         "Could not create a new directory group for tablet copy");
   } else {
@@ -398,6 +441,13 @@ Status TabletCopyClient::Finish() {
   SetStatusMessage("Replacing tablet superblock");
   superblock_->set_tablet_data_state(tablet::TABLET_DATA_READY);
   superblock_->clear_tombstone_last_logged_opid();
+
+  // Reused blocks were copied into the new directory group, so none of the
+  // retained blocks are needed anymore.
+  for (const BlockIdPB& block_pb : superblock_->retained_blocks()) {
+    *superblock_->add_orphaned_blocks() = block_pb;
+  }
+  superblock_->clear_retained_blocks();
   RETURN_NOT_OK(meta_->ReplaceSuperBlock(*superblock_));
 
   if (FLAGS_tablet_copy_save_downloaded_metadata) {
@@ -480,7 +530,7 @@ Status TabletCopyClient::DownloadWALs() {
 
   // Delete and recreate WAL dir if it already exists, to ensure stray files are
   // not kept from previous copies and runs.
-  string path = fs_manager_->GetTabletWalDir(tablet_id_);
+  string path = fs_manager_->GetOrPlaceTabletWalDir(tablet_id_);
   if (fs_manager_->env()->FileExists(path)) {
     RETURN_NOT_OK(fs_manager_->env()->DeleteRecursively(path));
   }
@@ -636,18 +686,141 @@ Status TabletCopyClient::DownloadAndRewriteBlock(const BlockIdPB& src_block_id,
                                                  int* block_count,
                                                  BlockIdPB* dest_block_id) {
   BlockId old_block_id(BlockId::FromPB(src_block_id));
-  SetStatusMessage(Substitute("Downloading block $0 ($1/$2)",
-                              old_block_id.ToString(),
-                              *block_count + 1, num_blocks));
+  BlockId local_block_id;
   BlockId new_block_id;
-  RETURN_NOT_OK_PREPEND(DownloadBlock(old_block_id, &new_block_id),
-      "Unable to download block with id " + old_block_id.ToString());
+  bool reused = false;
+  if (FindReusableBlock(old_block_id, &local_block_id)) {
+    SetStatusMessage(Substitute("Reusing block $0 for block $1 ($2/$3)",
+                                local_block_id.ToString(), old_block_id.ToString(),
+                                *block_count + 1, num_blocks));
+    Status s = CopyLocalBlock(local_block_id, &new_block_id);
+    if (s.ok()) {
+      reused = true;
+      if (tablet_copy_metrics_) {
+        tablet_copy_metrics_->blocks_reused->Increment();
+      }
+    } else {
+      LOG_WITH_PREFIX(WARNING) << "Unable to reuse retained block " << local_block_id.ToString()
+                               << ", downloading block " << old_block_id.ToString()
+                               << " instead: " << s.ToString();
+    }
+  }
+  if (!reused) {
+    SetStatusMessage(Substitute("Downloading block $0 ($1/$2)",
+                                old_block_id.ToString(),
+                                *block_count + 1, num_blocks));
+    RETURN_NOT_OK_PREPEND(DownloadBlock(old_block_id, &new_block_id),
+        "Unable to download block with id " + old_block_id.ToString());
+  }
 
   new_block_id.CopyToPB(dest_block_id);
   (*block_count)++;
   return Status::OK();
 }
 
+void TabletCopyClient::DigestRetainedBlocks(FindMatchingBlocksRequestPB* req) {
+  for (const BlockId& block_id : meta_->retained_blocks()) {
+    unique_ptr<ReadableBlock> block;
+    uint64_t size;
+    string sha256;
+    Status s = fs_manager_->OpenBlock(block_id, &block);
+    if (s.ok()) {
+      s = block->Size(&size);
+    }
+    if (s.ok()) {
+      s = DigestBlock(*block, size, &sha256);
+    }
+    if (PREDICT_FALSE(!s.ok())) {
+      LOG_WITH_PREFIX(WARNING) << "Unable to digest retained block "
+                               << block_id.ToString() << ": " << s.ToString();
+      continue;
+    }
+    BlockChecksum checksum(size, sha256);
+    vector<BlockId>& blocks = reusable_blocks_[checksum];
+    if (blocks.empty()) {
+      BlockChecksumPB* checksum_pb = req->add_local_block_checksums();
+      checksum_pb->set_length(size);
+      checksum_pb->set_sha256(std::move(sha256));
+    }
+    blocks.push_back(block_id);
+  }
+  VLOG_WITH_PREFIX(1) << "Advertising " << req->local_block_checksums_size()
+                      << " retained blocks to the tablet copy source";
+}
+
+Status TabletCopyClient::FindMatchingBlocks(FindMatchingBlocksRequestPB* req) {
+  // The source bounds the work done per call; keep asking until it has
+  // considered all of its blocks.
+  while (true) {
+    rpc::RpcController controller;
+    controller.set_timeout(MonoDelta::FromMilliseconds(session_idle_timeout_millis_));
+    FindMatchingBlocksResponsePB resp;
+    RETURN_NOT_OK(SendRpcWithRetry(&controller, [&] {
+      return proxy_->FindMatchingBlocks(*req, &resp, &controller);
+    }));
+    for (const BlockChecksumPB& block : resp.matching_blocks()) {
+      remote_block_checksums_.emplace(BlockId::FromPB(block.block_id()),
+                                      BlockChecksum(block.length(), block.sha256()));
+    }
+    if (!resp.has_resume_after()) {
+      break;
+    }
+    *req->mutable_start_after() = resp.resume_after();
+  }
+  VLOG_WITH_PREFIX(1) << "Tablet copy source has " << remote_block_checksums_.size()
+                      << " blocks matching retained blocks";
+  return Status::OK();
+}
+
+bool TabletCopyClient::FindReusableBlock(const BlockId& src_block_id, BlockId* local_block_id) {
+  const BlockChecksum* checksum = FindOrNull(remote_block_checksums_, src_block_id);
+  if (!checksum) {
+    return false;
+  }
+  vector<BlockId>* blocks = FindOrNull(reusable_blocks_, *checksum);
+  if (!blocks || blocks->empty()) {
+    return false;
+  }
+  *local_block_id = blocks->back();
+  blocks->pop_back();
+  return true;
+}
+
+Status TabletCopyClient::CopyLocalBlock(const BlockId& local_block_id,
+                                        BlockId* new_block_id) {
+  VLOG_WITH_PREFIX(1) << "Copying retained block with block_id " << local_block_id.ToString();
+  RETURN_NOT_OK_PREPEND(CheckHealthyDirGroup(), "Not copying block for replica");
+
+  unique_ptr<ReadableBlock> src;
+  RETURN_NOT_OK_PREPEND(fs_manager_->OpenBlock(local_block_id, &src),
+                        "Unable to open retained block");
+  uint64_t size;
+  RETURN_NOT_OK_PREPEND(src->Size(&size), "Unable to get size of retained block");
+
+  // The copy is created in the replica's new directory group, which the
+  // retained block may not belong to.
+  unique_ptr<WritableBlock> block;
+  RETURN_NOT_OK_PREPEND(fs_manager_->CreateNewBlock(CreateBlockOptions({ tablet_id_ }), &block),
+                        "Unable to create new block");
+
+  const uint64_t chunk_size = std::min<uint64_t>(
+      size, std::max(FLAGS_tablet_copy_transfer_chunk_size_bytes, 1));
+  unique_ptr<uint8_t[]> buf(new uint8_t[chunk_size]);
+  uint64_t offset = 0;
+  while (offset < size) {
+    Slice chunk(buf.get(), std::min(chunk_size, size - offset));
+    RETURN_NOT_OK_PREPEND(src->Read(offset, chunk),
+                          Substitute("Unable to read block $0", local_block_id.ToString()));
+    RETURN_NOT_OK(block->Append(chunk));
+    offset += chunk.size();
+  }
+
+  *new_block_id = block->id();
+  RETURN_NOT_OK_PREPEND(block->Finalize(), "Unable to finalize block");
+  transaction_->AddCreatedBlock(std::move(block));
+  return Status::OK();
+}
+
 Status TabletCopyClient::DownloadBlock(const BlockId& old_block_id,
                                        BlockId* new_block_id) {
   VLOG_WITH_PREFIX(1) << "Downloading block with block_id " << old_block_id.ToString();
@@ -688,6 +861,8 @@ Status TabletCopyClient::DownloadFile(const DataIdPB& data_id,
     // Request the next data chunk.
     FetchDataResponsePB resp;
     RETURN_NOT_OK_PREPEND(SendRpcWithRetry(&controller, [&] {
+          // Keep the data chunks off the connection used for consensus traffic.
+          controller.set_bulk_transfer(true);
           return proxy_->FetchData(req, &resp, &controller);
     }), "unable to fetch data from remote");
 
@@ -18,12 +18,16 @@
 #define KUDU_TSERVER_TABLET_COPY_CLIENT_H
 
 #include <cstdint>
+#include <map>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <gtest/gtest_prod.h>
 
+#include "kudu/fs/block_id.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/metrics.h"
@@ -32,7 +36,6 @@
 
 namespace kudu {
 
-class BlockId;
 class BlockIdPB;
 class FsManager;
 class HostPort;
@@ -59,8 +62,9 @@ class TabletSuperBlockPB;
 } // namespace tablet
 
 namespace tserver {
-class DataIdPB;
 class DataChunkPB;
+class DataIdPB;
+class FindMatchingBlocksRequestPB;
 class TabletCopyServiceProxy;
 
 // Server-wide tablet copy metrics.
@@ -68,6 +72,7 @@ struct TabletCopyClientMetrics {
   explicit TabletCopyClientMetrics(const scoped_refptr<MetricEntity>& metric_entity);
 
   scoped_refptr<Counter> bytes_fetched;
+  scoped_refptr<Counter> blocks_reused;
   scoped_refptr<AtomicGauge<int32_t>> open_client_sessions;
 };
 
@@ -136,6 +141,7 @@ class TabletCopyClient {
   FRIEND_TEST(TabletCopyClientTest, TestDownloadWalSegment);
   FRIEND_TEST(TabletCopyClientTest, TestDownloadAllBlocks);
   FRIEND_TEST(TabletCopyClientAbortTest, TestAbort);
+  FRIEND_TEST(TabletCopyClientTest, TestReuseRetainedBlocks);
 
   enum State {
     kInitialized,
@@ -171,6 +177,26 @@ class TabletCopyClient {
   // Count the number of blocks on the remote (from 'remote_superblock_').
   int CountRemoteBlocks() const;
 
+  // Digests the blocks retained by the tombstoned replica being replaced,
+  // adding them to 'reusable_blocks_' and advertising them in 'req'. Blocks
+  // that can't be read are skipped.
+  void DigestRetainedBlocks(FindMatchingBlocksRequestPB* req);
+
+  // Asks the tablet copy source which of its blocks match those advertised
+  // in 'req', issuing as many calls as the source needs to consider all of
+  // its blocks, and records them in 'remote_block_checksums_'.
+  Status FindMatchingBlocks(FindMatchingBlocksRequestPB* req);
+
+  // If one of the retained blocks has the same contents as the remote block
+  // 'src_block_id', removes it from 'reusable_blocks_' and returns true,
+  // setting 'local_block_id' to its ID.
+  bool FindReusableBlock(const BlockId& src_block_id, BlockId* local_block_id);
+
+  // Copies the retained block 'local_block_id' into a new block in the
+  // replica's directory group, setting 'new_block_id' to the new block's ID.
+  // The new block is added to the tablet copy's transaction.
+  Status CopyLocalBlock(const BlockId& local_block_id, BlockId* new_block_id);
+
   // Download all blocks belonging to a tablet sequentially. Add all
   // downloaded blocks to the tablet copy's transaction.
   //
@@ -183,6 +209,9 @@ class TabletCopyClient {
   // purposes). Add the block to the tablet copy's transaction, to close blocks
   // belonging to the transaction together when the copying is complete.
   //
+  // If a retained block has the same contents, it is copied locally instead
+  // and nothing is downloaded.
+  //
   // On success:
   // - 'dest_block_id' is set to the new ID of the downloaded block.
   // - 'block_count' is incremented by 1.
@@ -249,6 +278,17 @@ class TabletCopyClient {
   std::vector<uint64_t> wal_seqnos_;
   int64_t start_time_micros_;
 
+  // The length and SHA-256 digest of a block's contents.
+  typedef std::pair<uint64_t, std::string> BlockChecksum;
+
+  // Retained blocks of the replaced replica that haven't been reused yet,
+  // keyed by their contents.
+  std::map<BlockChecksum, std::vector<BlockId>> reusable_blocks_;
+
+  // The remote blocks whose contents match one of 'reusable_blocks_', as
+  // reported by the tablet copy source.
+  std::unordered_map<BlockId, BlockChecksum, BlockIdHash, BlockIdEqual> remote_block_checksums_;
+
   Random rng_;
 
   TabletCopyClientMetrics* tablet_copy_metrics_;
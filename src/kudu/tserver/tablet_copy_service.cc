@@ -22,6 +22,7 @@
 #include <utility>
 #include <vector>
 
+#include <boost/optional/optional.hpp>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
@@ -67,6 +68,13 @@ DEFINE_uint64(tablet_copy_timeout_poll_period_ms, 10000,
               "tablet copy sessions, in millis");
 TAG_FLAG(tablet_copy_timeout_poll_period_ms, hidden);
 
+DEFINE_int64(tablet_copy_find_matching_blocks_max_bytes, 64 * 1024 * 1024,
+             "Maximum number of bytes of block data a tablet copy source reads "
+             "in a single FindMatchingBlocks call while looking for blocks which "
+             "the destination already has. Larger requests are answered in "
+             "several calls.");
+TAG_FLAG(tablet_copy_find_matching_blocks_max_bytes, advanced);
+
 DEFINE_double(fault_crash_on_handle_tc_fetch_data, 0.0,
               "Fraction of the time when the tablet will crash while "
               "servicing a TabletCopyService FetchData() RPC call. "
@@ -250,6 +258,56 @@ void TabletCopyServiceImpl::CheckSessionActive(
   }
 }
 
+void TabletCopyServiceImpl::FindMatchingBlocks(const FindMatchingBlocksRequestPB* req,
+                                               FindMatchingBlocksResponsePB* resp,
+                                               rpc::RpcContext* context) {
+  const string& session_id = req->session_id();
+
+  // Look up and validate tablet copy session.
+  scoped_refptr<TabletCopySourceSession> session;
+  {
+    MutexLock l(sessions_lock_);
+    TabletCopyErrorPB::Code app_error;
+    RPC_RETURN_NOT_OK(FindSessionUnlocked(session_id, &app_error, &session),
+                      app_error, "No such session", context);
+    ResetSessionExpirationUnlocked(session_id);
+  }
+
+  if (!session->IsInitialized()) {
+    RPC_RETURN_NOT_OK(
+        Status::ServiceUnavailable("tablet copy session for tablet $0 is initializing",
+                                   session->tablet_id()),
+        TabletCopyErrorPB::UNKNOWN_ERROR,
+        "try again later",
+        context);
+  }
+
+  boost::optional<BlockId> start_after;
+  if (req->has_start_after()) {
+    start_after = BlockId::FromPB(req->start_after());
+  }
+  vector<BlockChecksumPB> matching_blocks;
+  boost::optional<BlockId> resume_after;
+  session->FindMatchingBlocks(req->local_block_checksums(), start_after,
+                              FLAGS_tablet_copy_find_matching_blocks_max_bytes,
+                              &matching_blocks, &resume_after);
+  for (auto& block : matching_blocks) {
+    *resp->add_matching_blocks() = std::move(block);
+  }
+  if (resume_after) {
+    resume_after->CopyToPB(resp->mutable_resume_after());
+  }
+
+  // Reading the blocks may have taken a while; don't let the session expire
+  // right after answering.
+  {
+    MutexLock l(sessions_lock_);
+    ResetSessionExpirationUnlocked(session_id);
+  }
+
+  context->RespondSuccess();
+}
+
 void TabletCopyServiceImpl::FetchData(const FetchDataRequestPB* req,
                                       FetchDataResponsePB* resp,
                                       rpc::RpcContext* context) {
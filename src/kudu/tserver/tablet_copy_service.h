@@ -71,6 +71,10 @@ class TabletCopyServiceImpl : public TabletCopyServiceIf {
                                   CheckTabletCopySessionActiveResponsePB* resp,
                                   rpc::RpcContext* context) OVERRIDE;
 
+  virtual void FindMatchingBlocks(const FindMatchingBlocksRequestPB* req,
+                                  FindMatchingBlocksResponsePB* resp,
+                                  rpc::RpcContext* context) OVERRIDE;
+
   virtual void FetchData(const FetchDataRequestPB* req,
                          FetchDataResponsePB* resp,
                          rpc::RpcContext* context) OVERRIDE;
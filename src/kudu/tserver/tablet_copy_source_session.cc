@@ -19,11 +19,16 @@
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <ostream>
+#include <set>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <boost/optional/optional.hpp>
 #include <gflags/gflags.h>
+#include <openssl/sha.h>
 
 #include "kudu/consensus/consensus.pb.h"
 #include "kudu/consensus/log.h"
@@ -88,6 +93,26 @@ using strings::Substitute;
 using tablet::TabletMetadata;
 using tablet::TabletReplica;
 
+Status DigestBlock(const ReadableBlock& block, uint64_t size, string* sha256) {
+  const uint64_t chunk_size = std::min<uint64_t>(
+      size, std::max(FLAGS_tablet_copy_transfer_chunk_size_bytes, 1));
+  unique_ptr<uint8_t[]> buf(new uint8_t[chunk_size]);
+  SHA256_CTX ctx;
+  SHA256_Init(&ctx);
+  uint64_t offset = 0;
+  while (offset < size) {
+    Slice chunk(buf.get(), std::min(chunk_size, size - offset));
+    RETURN_NOT_OK_PREPEND(block.Read(offset, chunk),
+                          Substitute("Unable to read block $0", block.id().ToString()));
+    SHA256_Update(&ctx, chunk.data(), chunk.size());
+    offset += chunk.size();
+  }
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  SHA256_Final(digest, &ctx);
+  sha256->assign(reinterpret_cast<const char*>(digest), sizeof(digest));
+  return Status::OK();
+}
+
 TabletCopySourceMetrics::TabletCopySourceMetrics(const scoped_refptr<MetricEntity>& metric_entity)
     : bytes_sent(METRIC_tablet_copy_bytes_sent.Instantiate(metric_entity)),
       open_source_sessions(METRIC_tablet_copy_open_source_sessions.Instantiate(metric_entity, 0)) {
@@ -337,6 +362,60 @@ Status TabletCopySourceSession::GetLogSegmentPiece(uint64_t segment_seqno,
   return Status::OK();
 }
 
+void TabletCopySourceSession::FindMatchingBlocks(
+    const google::protobuf::RepeatedPtrField<BlockChecksumPB>& checksums,
+    const boost::optional<BlockId>& start_after,
+    int64_t max_bytes,
+    vector<BlockChecksumPB>* matches,
+    boost::optional<BlockId>* resume_after) {
+  DCHECK(init_once_.init_succeeded());
+  *resume_after = boost::none;
+  if (checksums.empty()) {
+    return;
+  }
+  std::unordered_set<uint64_t> lengths;
+  std::set<std::pair<uint64_t, string>> wanted;
+  for (const BlockChecksumPB& checksum : checksums) {
+    lengths.insert(checksum.length());
+    wanted.emplace(checksum.length(), checksum.sha256());
+  }
+
+  // Only blocks whose length matches need to be read. Consider them in a
+  // stable order so that calls can resume where the previous one left off.
+  vector<BlockId> candidates;
+  for (const auto& e : blocks_) {
+    if ((!start_after || *start_after < e.first) && ContainsKey(lengths, e.second->size)) {
+      candidates.push_back(e.first);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+
+  int64_t bytes_read = 0;
+  for (int i = 0; i < candidates.size(); i++) {
+    const BlockId& block_id = candidates[i];
+    const ImmutableReadableBlockInfo* info = FindOrDie(blocks_, block_id);
+    if (bytes_read > 0 && bytes_read + info->size > max_bytes) {
+      *resume_after = candidates[i - 1];
+      return;
+    }
+    bytes_read += info->size;
+    string sha256;
+    Status s = DigestBlock(*info->readable, info->size, &sha256);
+    if (PREDICT_FALSE(!s.ok())) {
+      LOG(WARNING) << "Unable to digest block " << block_id.ToString()
+                   << " for tablet copy: " << s.ToString();
+      continue;
+    }
+    if (ContainsKey(wanted, std::make_pair(static_cast<uint64_t>(info->size), sha256))) {
+      BlockChecksumPB match;
+      block_id.CopyToPB(match.mutable_block_id());
+      match.set_length(info->size);
+      match.set_sha256(std::move(sha256));
+      matches->emplace_back(std::move(match));
+    }
+  }
+}
+
 bool TabletCopySourceSession::IsBlockOpenForTests(const BlockId& block_id) const {
   DCHECK(init_once_.init_succeeded());
   return ContainsKey(blocks_, block_id);
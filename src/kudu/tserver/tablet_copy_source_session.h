@@ -22,7 +22,9 @@
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include <boost/optional/optional.hpp>
 #include <glog/logging.h>
 
 #include "kudu/consensus/log_anchor_registry.h"
@@ -32,6 +34,7 @@
 #include "kudu/fs/block_manager.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tserver/tablet_copy.pb.h"
@@ -91,6 +94,11 @@ struct ImmutableReadableBlockInfo {
   }
 };
 
+// Computes the SHA-256 digest of the first 'size' bytes of 'block', reading
+// it in chunks of --tablet_copy_transfer_chunk_size_bytes.
+Status DigestBlock(const fs::ReadableBlock& block, uint64_t size,
+                   std::string* sha256) WARN_UNUSED_RESULT;
+
 // A potential Learner must establish a TabletCopySourceSession with the leader in order
 // to fetch the needed superblock, blocks, and log segments.
 // This class is refcounted to make it easy to remove it from the session map
@@ -156,6 +164,21 @@ class TabletCopySourceSession : public RefCountedThreadSafe<TabletCopySourceSess
     return log_segments_;
   }
 
+  // Finds the blocks of this session whose length and digest match one of
+  // 'checksums', appending them (with their block IDs) to 'matches'. Blocks
+  // are considered in order of their IDs, starting after 'start_after' if
+  // set. Only blocks whose length matches are read, and no more are read
+  // once about 'max_bytes' have been: 'resume_after' is then set to the last
+  // block considered. Blocks that can't be read are skipped.
+  //
+  // This method is thread-safe.
+  void FindMatchingBlocks(
+      const google::protobuf::RepeatedPtrField<BlockChecksumPB>& checksums,
+      const boost::optional<BlockId>& start_after,
+      int64_t max_bytes,
+      std::vector<BlockChecksumPB>* matches,
+      boost::optional<BlockId>* resume_after);
+
   // Check if a block is currently open.
   bool IsBlockOpenForTests(const BlockId& block_id) const;
 
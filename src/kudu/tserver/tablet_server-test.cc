@@ -66,6 +66,7 @@
 #include "kudu/rpc/messenger.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/rpc/service_pool.h"
 #include "kudu/server/rpc_server.h"
 #include "kudu/server/server_base.pb.h"
 #include "kudu/server/server_base.proxy.h"
@@ -138,13 +139,16 @@ DEFINE_int32(delete_tablet_bench_num_flushes, 200,
 DECLARE_bool(crash_on_eio);
 DECLARE_bool(enable_maintenance_manager);
 DECLARE_bool(fail_dns_resolution);
+DECLARE_bool(raft_enable_leader_leases);
 DECLARE_double(env_inject_eio);
+DECLARE_int32(consensus_rpc_service_queue_length);
 DECLARE_int32(flush_threshold_mb);
 DECLARE_int32(flush_threshold_secs);
 DECLARE_int32(maintenance_manager_num_threads);
 DECLARE_int32(metrics_retirement_age_ms);
 DECLARE_int32(scanner_batch_size_rows);
 DECLARE_int32(scanner_gc_check_interval_us);
+DECLARE_int32(rpc_service_queue_length);
 DECLARE_int32(scanner_ttl_ms);
 DECLARE_string(block_manager);
 DECLARE_string(env_inject_eio_globs);
@@ -154,6 +158,7 @@ METRIC_DECLARE_counter(rows_inserted);
 METRIC_DECLARE_counter(rows_updated);
 METRIC_DECLARE_counter(rows_deleted);
 METRIC_DECLARE_counter(scanners_expired);
+METRIC_DECLARE_counter(scans_served_under_leader_lease);
 METRIC_DECLARE_gauge_uint64(log_block_manager_blocks_under_management);
 METRIC_DECLARE_gauge_uint64(log_block_manager_containers);
 METRIC_DECLARE_counter(log_block_manager_holes_punched);
@@ -187,6 +192,22 @@ TEST_F(TabletServerTest, TestPingServer) {
   ASSERT_OK(proxy_->Ping(req, &resp, &controller));
 }
 
+// Test that each service has its own pool of workers, and that the consensus
+// service's pool is sized separately.
+TEST_F(TabletServerTest, TestServicePools) {
+  const RpcServer* rpc_server = mini_server_->server()->rpc_server();
+  const rpc::ServicePool* ts_pool =
+      rpc_server->service_pool("kudu.tserver.TabletServerService");
+  const rpc::ServicePool* consensus_pool =
+      rpc_server->service_pool("kudu.consensus.ConsensusService");
+  ASSERT_NE(nullptr, ts_pool);
+  ASSERT_NE(nullptr, consensus_pool);
+  ASSERT_NE(ts_pool, consensus_pool);
+  ASSERT_EQ(FLAGS_rpc_service_queue_length, ts_pool->max_queue_length());
+  ASSERT_EQ(FLAGS_consensus_rpc_service_queue_length, consensus_pool->max_queue_length());
+  ASSERT_GT(consensus_pool->num_threads(), 0);
+}
+
 TEST_F(TabletServerTest, TestServerClock) {
   server::ServerClockRequestPB req;
   server::ServerClockResponsePB resp;
@@ -1360,6 +1381,26 @@ TEST_F(TabletServerTest, TestScan) {
   ASSERT_EQ(0, tablet_active_scanners->value());
 }
 
+// Test that, with leader leases, a leader serves scans of the latest data
+// under its lease, once the writes it acknowledged are applied.
+TEST_F(TabletServerTest, TestScanLatestUnderLeaderLease) {
+  FLAGS_raft_enable_leader_leases = true;
+  const int kNumRows = 100;
+  InsertTestRowsRemote(0, kNumRows);
+
+  scoped_refptr<TabletReplica> tablet;
+  ASSERT_TRUE(mini_server_->server()->tablet_manager()->LookupTablet(kTabletId, &tablet));
+  scoped_refptr<Counter> scans_under_lease =
+      METRIC_scans_served_under_leader_lease.Instantiate(tablet->tablet()->GetMetricEntity());
+
+  ScanResponsePB resp;
+  ASSERT_NO_FATAL_FAILURE(OpenScannerWithAllColumns(&resp));
+  vector<string> results;
+  ASSERT_NO_FATAL_FAILURE(DrainScannerToStrings(resp.scanner_id(), schema_, &results));
+  ASSERT_EQ(kNumRows, results.size());
+  ASSERT_EQ(1, scans_under_lease->value());
+}
+
 TEST_F(TabletServerTest, TestExpiredScanner) {
   // Make scanners expire quickly.
   FLAGS_scanner_ttl_ms = 1;
@@ -1577,6 +1618,46 @@ TEST_F(TabletServerTest, TestSnapshotScan_WithoutSnapshotTimestamp) {
   ASSERT_GT(resp.propagated_timestamp(), resp.snap_timestamp());
 }
 
+// Tests that a bounded staleness scan is served at the replica's safe time,
+// which on a leader includes all of its writes, and reports the replica's lag.
+TEST_F(TabletServerTest, TestBoundedStalenessScan) {
+  vector<uint64_t> write_timestamps_collector;
+  InsertTestRowsRemote(0, 1, 1, nullptr, kTabletId, &write_timestamps_collector);
+
+  ScanRequestPB req;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  req.set_call_seq_id(0);
+  req.set_batch_size_bytes(0); // so it won't return data right away
+  scan->set_read_mode(READ_AT_BOUNDED_STALENESS);
+
+  // Without a maximum staleness the request is invalid.
+  {
+    ScanResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::INVALID_SNAPSHOT, resp.error().code());
+  }
+
+  const uint64_t kMaxStalenessUsec = 60 * 1000 * 1000;
+  scan->set_max_staleness_usec(kMaxStalenessUsec);
+  {
+    SCOPED_TRACE(SecureDebugString(req));
+    ScanResponsePB resp;
+    RpcController rpc;
+    rpc.RequireServerFeature(TabletServerFeatures::BOUNDED_STALENESS_READS);
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_GT(resp.snap_timestamp(), write_timestamps_collector[0]);
+    ASSERT_TRUE(resp.has_replica_lag_usec());
+    ASSERT_LE(resp.replica_lag_usec(), kMaxStalenessUsec);
+  }
+}
+
 // Tests that a snapshot in the future (beyond the current time plus maximum
 // synchronization error) fails as an invalid snapshot.
 TEST_F(TabletServerTest, TestSnapshotScan_SnapshotInTheFutureFails) {
@@ -32,6 +32,7 @@
 #include "kudu/gutil/move.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/service_if.h"
+#include "kudu/server/rpc_server.h"
 #include "kudu/tserver/heartbeater.h"
 #include "kudu/tserver/scanners.h"
 #include "kudu/tserver/tablet_copy_service.h"
@@ -125,7 +126,8 @@ Status TabletServer::Start() {
 
   RETURN_NOT_OK(RegisterService(std::move(ts_service)));
   RETURN_NOT_OK(RegisterService(std::move(admin_service)));
-  RETURN_NOT_OK(RegisterService(std::move(consensus_service)));
+  RETURN_NOT_OK(RegisterService(std::move(consensus_service),
+                                ConsensusServiceImpl::PoolOptions()));
   RETURN_NOT_OK(RegisterService(std::move(tablet_copy_service)));
   RETURN_NOT_OK(KuduServer::Start());
 
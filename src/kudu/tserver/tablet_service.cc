@@ -52,6 +52,7 @@
 #include "kudu/consensus/metadata.pb.h"
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/consensus/raft_consensus.h"
+#include "kudu/consensus/replicate_sidecars.h"
 #include "kudu/consensus/time_manager.h"
 #include "kudu/gutil/casts.h"
 #include "kudu/gutil/macros.h"
@@ -63,6 +64,7 @@
 #include "kudu/rpc/rpc_context.h"
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/rpc_sidecar.h"
+#include "kudu/server/rpc_server.h"
 #include "kudu/server/server_base.h"
 #include "kudu/tablet/compaction.h"
 #include "kudu/tablet/metadata.pb.h"
@@ -132,6 +134,27 @@ DEFINE_int32(scanner_inject_latency_on_each_batch_ms, 0,
              "Used for tests.");
 TAG_FLAG(scanner_inject_latency_on_each_batch_ms, unsafe);
 
+DEFINE_int32(consensus_inject_latency_ms_in_update_response, 0,
+             "If set, the tablet server will pause the specified number of "
+             "milliseconds after handling each UpdateConsensus request and "
+             "before responding to it, simulating a slow network between the "
+             "leader and its followers. Used for tests.");
+TAG_FLAG(consensus_inject_latency_ms_in_update_response, hidden);
+TAG_FLAG(consensus_inject_latency_ms_in_update_response, unsafe);
+
+DEFINE_int32(consensus_rpc_num_service_threads, 0,
+             "Number of RPC worker threads dedicated to the consensus service. "
+             "If 0, --rpc_num_service_threads is used.");
+TAG_FLAG(consensus_rpc_num_service_threads, advanced);
+
+DEFINE_int32(consensus_rpc_service_queue_length, 200,
+             "Length of the queue for incoming consensus service RPCs. It is longer "
+             "than that of other services by default, so that bursts of Raft "
+             "heartbeats aren't rejected and mistaken for leader failures. "
+             "If 0, --rpc_service_queue_length is used.");
+TAG_FLAG(consensus_rpc_service_queue_length, advanced);
+
+DECLARE_bool(raft_enable_leader_leases);
 DECLARE_int32(memory_limit_warn_threshold_percentage);
 DECLARE_int32(tablet_history_max_age_sec);
 
@@ -147,6 +170,7 @@ using kudu::consensus::GetNodeInstanceResponsePB;
 using kudu::consensus::LeaderStepDownRequestPB;
 using kudu::consensus::LeaderStepDownResponsePB;
 using kudu::consensus::OpId;
+using kudu::consensus::RaftPeerPB;
 using kudu::consensus::UnsafeChangeConfigRequestPB;
 using kudu::consensus::UnsafeChangeConfigResponsePB;
 using kudu::consensus::RaftConsensus;
@@ -209,24 +233,34 @@ bool LookupTabletReplicaOrRespond(TabletReplicaLookupIf* tablet_manager,
   return true;
 }
 
-template<class RespClass>
-void RespondTabletNotRunning(const scoped_refptr<TabletReplica>& replica,
+// Returns the error describing why 'replica', in state 'tablet_state', can't
+// serve requests, setting its code in 'error_code'.
+Status TabletNotRunningError(const scoped_refptr<TabletReplica>& replica,
                              tablet::TabletStatePB tablet_state,
-                             RespClass* resp,
-                             rpc::RpcContext* context) {
+                             TabletServerErrorPB::Code* error_code) {
   Status s = Status::IllegalState("Tablet not RUNNING",
                                   tablet::TabletStatePB_Name(tablet_state));
-  auto error_code = TabletServerErrorPB::TABLET_NOT_RUNNING;
+  *error_code = TabletServerErrorPB::TABLET_NOT_RUNNING;
   if (replica->tablet_metadata()->tablet_data_state() == TABLET_DATA_TOMBSTONED ||
       replica->tablet_metadata()->tablet_data_state() == TABLET_DATA_DELETED) {
     // Treat tombstoned tablets as if they don't exist for most purposes.
     // This takes precedence over failed, since we don't reset the failed
     // status of a TabletReplica when deleting it. Only tablet copy does that.
-    error_code = TabletServerErrorPB::TABLET_NOT_FOUND;
+    *error_code = TabletServerErrorPB::TABLET_NOT_FOUND;
   } else if (tablet_state == tablet::FAILED) {
     s = s.CloneAndAppend(replica->error().ToString());
-    error_code = TabletServerErrorPB::TABLET_FAILED;
+    *error_code = TabletServerErrorPB::TABLET_FAILED;
   }
+  return s;
+}
+
+template<class RespClass>
+void RespondTabletNotRunning(const scoped_refptr<TabletReplica>& replica,
+                             tablet::TabletStatePB tablet_state,
+                             RespClass* resp,
+                             rpc::RpcContext* context) {
+  TabletServerErrorPB::Code error_code;
+  Status s = TabletNotRunningError(replica, tablet_state, &error_code);
   SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
 }
 
@@ -877,6 +911,10 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
       req,
       context->AreResultsTracked() ? context->request_id() : nullptr,
       resp));
+  // The request is owned by the RPC context and isn't read again once the
+  // write is submitted, so let the transaction move its row operations into
+  // the replicate message rather than copy them.
+  tx_state->set_movable_request(const_cast<WriteRequestPB*>(req));
 
   // If the client sent us a timestamp, decode it and update the clock so that all future
   // timestamps are greater than the passed timestamp.
@@ -916,15 +954,50 @@ ConsensusServiceImpl::ConsensusServiceImpl(ServerBase* server,
 ConsensusServiceImpl::~ConsensusServiceImpl() {
 }
 
+ServicePoolOptions ConsensusServiceImpl::PoolOptions() {
+  ServicePoolOptions opts;
+  opts.num_threads = std::max(FLAGS_consensus_rpc_num_service_threads, 0);
+  opts.queue_length = std::max(FLAGS_consensus_rpc_service_queue_length, 0);
+  return opts;
+}
+
 bool ConsensusServiceImpl::AuthorizeServiceUser(const google::protobuf::Message* /*req*/,
                                                 google::protobuf::Message* /*resp*/,
                                                 rpc::RpcContext* rpc) {
   return server_->Authorize(rpc, ServerBase::SUPER_USER | ServerBase::SERVICE_USER);
 }
 
+bool ConsensusServiceImpl::SupportsFeature(uint32_t feature) const {
+  switch (feature) {
+    case consensus::ConsensusFeatures::REPLICATE_SIDECARS:
+    case consensus::ConsensusFeatures::MULTI_RAFT_HEARTBEATS:
+      return true;
+    default:
+      return false;
+  }
+}
+
 void ConsensusServiceImpl::UpdateConsensus(const ConsensusRequestPB* req,
                                            ConsensusResponsePB* resp,
                                            rpc::RpcContext* context) {
+  // Move any operations sent in sidecars into the request, where the rest
+  // of consensus expects them.
+  if (req->ops_sidecars_size() > 0) {
+    ConsensusRequestPB* mutable_req = const_cast<ConsensusRequestPB*>(req);
+    for (int idx : req->ops_sidecars()) {
+      Slice sidecar;
+      Status s = context->GetInboundSidecar(idx, &sidecar);
+      if (s.ok()) {
+        s = consensus::ParseOpsFromSidecar(sidecar, mutable_req);
+      }
+      if (PREDICT_FALSE(!s.ok())) {
+        context->RespondFailure(s.CloneAndPrepend("invalid operations sidecar"));
+        return;
+      }
+    }
+    mutable_req->clear_ops_sidecars();
+  }
+
   DVLOG(3) << "Received Consensus Update RPC: " << SecureDebugString(*req);
   if (!CheckUuidMatchOrRespond(tablet_manager_, "UpdateConsensus", req, resp, context)) {
     return;
@@ -952,6 +1025,79 @@ void ConsensusServiceImpl::UpdateConsensus(const ConsensusRequestPB* req,
                          context);
     return;
   }
+  if (PREDICT_FALSE(FLAGS_consensus_inject_latency_ms_in_update_response > 0)) {
+    SleepFor(MonoDelta::FromMilliseconds(FLAGS_consensus_inject_latency_ms_in_update_response));
+  }
+  context->RespondSuccess();
+}
+
+namespace {
+
+// Applies one of the heartbeats of a MultiRaftUpdateConsensus RPC, like
+// UpdateConsensus() does, except that failures are reported in 'resp' rather
+// than by responding to the RPC.
+void HandleBatchedHeartbeat(TabletReplicaLookupIf* tablet_manager,
+                            const ConsensusRequestPB* req,
+                            ConsensusResponsePB* resp) {
+  auto set_error = [resp](const Status& s, TabletServerErrorPB::Code code) {
+    // Don't leave a partially-filled response behind: see UpdateConsensus().
+    resp->Clear();
+    StatusToPB(s, resp->mutable_error()->mutable_status());
+    resp->mutable_error()->set_code(code);
+  };
+
+  const string& local_uuid = tablet_manager->NodeInstance().permanent_uuid();
+  if (PREDICT_FALSE(req->dest_uuid() != local_uuid)) {
+    set_error(Status::InvalidArgument(Substitute("UpdateConsensus: Wrong destination UUID "
+                                                 "requested. Local UUID: $0. Requested UUID: $1",
+                                                 local_uuid, req->dest_uuid())),
+              TabletServerErrorPB::WRONG_SERVER_UUID);
+    return;
+  }
+  scoped_refptr<TabletReplica> replica;
+  Status s = tablet_manager->GetTabletReplica(req->tablet_id(), &replica);
+  if (PREDICT_FALSE(!s.ok())) {
+    set_error(s, TabletServerErrorPB::TABLET_NOT_FOUND);
+    return;
+  }
+  tablet::TabletStatePB state = replica->state();
+  if (PREDICT_FALSE(state != tablet::RUNNING)) {
+    TabletServerErrorPB::Code error_code;
+    s = TabletNotRunningError(replica, state, &error_code);
+    set_error(s, error_code);
+    return;
+  }
+  shared_ptr<RaftConsensus> consensus = replica->shared_consensus();
+  if (PREDICT_FALSE(!consensus)) {
+    set_error(Status::ServiceUnavailable("Raft Consensus unavailable",
+                                         "Tablet replica not initialized"),
+              TabletServerErrorPB::TABLET_NOT_RUNNING);
+    return;
+  }
+  // Don't let a replica busy with another update hold up the heartbeats of
+  // the other tablets of the batch: its leader retries with its next heartbeat.
+  s = consensus->TryUpdate(req, resp);
+  if (PREDICT_FALSE(!s.ok())) {
+    set_error(s, s.IsServiceUnavailable() ? TabletServerErrorPB::THROTTLED
+                                          : TabletServerErrorPB::UNKNOWN_ERROR);
+  }
+}
+
+} // anonymous namespace
+
+void ConsensusServiceImpl::MultiRaftUpdateConsensus(
+    const consensus::MultiRaftConsensusRequestPB* req,
+    consensus::MultiRaftConsensusResponsePB* resp,
+    rpc::RpcContext* context) {
+  DVLOG(3) << "Received Multi-Raft Consensus Update RPC with "
+           << req->heartbeats_size() << " heartbeats";
+  resp->mutable_responses()->Reserve(req->heartbeats_size());
+  for (const ConsensusRequestPB& heartbeat : req->heartbeats()) {
+    HandleBatchedHeartbeat(tablet_manager_, &heartbeat, resp->add_responses());
+  }
+  if (PREDICT_FALSE(FLAGS_consensus_inject_latency_ms_in_update_response > 0)) {
+    SleepFor(MonoDelta::FromMilliseconds(FLAGS_consensus_inject_latency_ms_in_update_response));
+  }
   context->RespondSuccess();
 }
 
@@ -1262,6 +1408,23 @@ void SetResourceMetrics(ResourceMetricsPB* metrics, rpc::RpcContext* context) {
   metrics->set_cfile_cache_hit_bytes(
     context->trace()->metrics()->GetMetric(cfile::CFILE_CACHE_HIT_BYTES_METRIC_NAME));
 }
+
+// Fetches the current safe time of 'replica' into 'safe_time' and how far
+// behind the local clock it lags into 'lag'. Requires a clock with a physical
+// component, since the lag is measured in wall time.
+Status GetSafeTimeLag(clock::Clock* clock,
+                      TabletReplica* replica,
+                      Timestamp* safe_time,
+                      MonoDelta* lag) {
+  if (!clock->HasPhysicalComponent()) {
+    return Status::NotSupported("Bounded staleness scans not supported on this server");
+  }
+  *safe_time = replica->time_manager()->GetSafeTime();
+  Timestamp now = clock->Now();
+  *lag = now > *safe_time ? clock->GetPhysicalComponentDifference(now, *safe_time)
+                          : MonoDelta::FromMicroseconds(0);
+  return Status::OK();
+}
 } // anonymous namespace
 
 void TabletServiceImpl::Scan(const ScanRequestPB* req,
@@ -1297,6 +1460,15 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
     Status s = HandleNewScanRequest(replica.get(), req, context,
                                     &collector, &scanner_id, &scan_timestamp, &has_more_results,
                                     &error_code);
+    // Let bounded staleness clients know how far behind this replica is, so
+    // that they can prefer fresher replicas in the future.
+    if (scan_pb.read_mode() == READ_AT_BOUNDED_STALENESS) {
+      Timestamp safe_time;
+      MonoDelta lag;
+      if (GetSafeTimeLag(server_->clock(), replica.get(), &safe_time, &lag).ok()) {
+        resp->set_replica_lag_usec(lag.ToMicroseconds());
+      }
+    }
     if (PREDICT_FALSE(!s.ok())) {
       SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
       return;
@@ -1441,6 +1613,7 @@ bool TabletServiceImpl::SupportsFeature(uint32_t feature) const {
   switch (feature) {
     case TabletServerFeatures::COLUMN_PREDICATES:
     case TabletServerFeatures::PAD_UNIXTIME_MICROS_TO_16_BYTES:
+    case TabletServerFeatures::BOUNDED_STALENESS_READS:
       return true;
     default:
       return false;
@@ -1615,11 +1788,13 @@ static Status SetupScanSpec(const NewScanRequestPB& scan_pb,
 }
 
 namespace {
-// Checks if 'timestamp' is before the 'tablet's AHM if this is a READ_AT_SNAPSHOT scan.
+// Checks if 'timestamp' is before the 'tablet's AHM if this is a READ_AT_SNAPSHOT
+// or READ_AT_BOUNDED_STALENESS scan.
 // Returns Status::OK() if it's not or Status::InvalidArgument() if it is.
 Status VerifyNotAncientHistory(Tablet* tablet, ReadMode read_mode, Timestamp timestamp) {
   tablet::HistoryGcOpts history_gc_opts = tablet->GetHistoryGcOpts();
-  if (read_mode == READ_AT_SNAPSHOT && history_gc_opts.IsAncientHistory(timestamp)) {
+  if ((read_mode == READ_AT_SNAPSHOT || read_mode == READ_AT_BOUNDED_STALENESS) &&
+      history_gc_opts.IsAncientHistory(timestamp)) {
     return Status::InvalidArgument(
         Substitute("Snapshot timestamp is earlier than the ancient history mark. Consider "
                        "increasing the value of the configuration parameter "
@@ -1679,7 +1854,8 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
   if (scan_pb.order_mode() == ORDERED) {
     // Ordered scans must be at a snapshot so that we perform a serializable read (which can be
     // resumed). Otherwise, this would be read committed isolation, which is not resumable.
-    if (scan_pb.read_mode() != READ_AT_SNAPSHOT) {
+    if (scan_pb.read_mode() != READ_AT_SNAPSHOT &&
+        scan_pb.read_mode() != READ_AT_BOUNDED_STALENESS) {
       *error_code = TabletServerErrorPB::INVALID_SNAPSHOT;
           return Status::InvalidArgument("Cannot do an ordered scan that is not a snapshot read");
     }
@@ -1740,7 +1916,12 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
         return s;
       }
       case READ_LATEST: {
-        s = tablet->NewRowIterator(projection, &iter);
+        s = HandleScanLatest(rpc_context, projection, replica, &iter);
+        // If the leader couldn't obtain a lease in time, let the client try again.
+        if (s.IsServiceUnavailable()) {
+          *error_code = TabletServerErrorPB::THROTTLED;
+          return s;
+        }
         break;
       }
       case READ_AT_SNAPSHOT: {
@@ -1758,6 +1939,20 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
         }
         break;
       }
+      case READ_AT_BOUNDED_STALENESS: {
+        s = HandleScanAtBoundedStaleness(scan_pb, rpc_context, projection, replica,
+                                         &iter, snap_timestamp);
+        // The replica is lagging too far behind: the client should go elsewhere.
+        if (s.IsServiceUnavailable()) {
+          *error_code = TabletServerErrorPB::REPLICA_TOO_STALE;
+          return s;
+        }
+
+        if (!s.ok()) {
+          tmp_error_code = TabletServerErrorPB::INVALID_SNAPSHOT;
+        }
+        break;
+      }
         TRACE("Iterator created");
     }
   }
@@ -1998,6 +2193,10 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
         delta_stats.cells_read_from_disk);
     tablet->metrics()->scanner_bytes_scanned_from_disk->IncrementBy(
         delta_stats.bytes_read_from_disk);
+    tablet->metrics()->scanner_cells_decoded->IncrementBy(
+        delta_stats.cells_decoded);
+    tablet->metrics()->scanner_delta_stores_skipped->IncrementBy(
+        delta_stats.delta_stores_skipped);
   }
 
   scanner->UpdateAccessTime();
@@ -2128,5 +2327,103 @@ Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
   return Status::OK();
 }
 
+Status TabletServiceImpl::HandleScanAtBoundedStaleness(const NewScanRequestPB& scan_pb,
+                                                       const RpcContext* rpc_context,
+                                                       const Schema& projection,
+                                                       TabletReplica* replica,
+                                                       gscoped_ptr<RowwiseIterator>* iter,
+                                                       Timestamp* snap_timestamp) {
+  if (!scan_pb.has_max_staleness_usec()) {
+    return Status::InvalidArgument("Bounded staleness scans must specify a maximum staleness");
+  }
+  if (scan_pb.order_mode() == UNKNOWN_ORDER_MODE) {
+    return Status::InvalidArgument("Unknown order mode specified");
+  }
+
+  // If the client sent a timestamp update our clock with it, as for snapshot scans.
+  if (scan_pb.has_propagated_timestamp()) {
+    RETURN_NOT_OK(server_->clock()->Update(Timestamp(scan_pb.propagated_timestamp())));
+  }
+
+  // Unlike snapshot scans we don't wait for safe time to advance: the replica's
+  // current safe time is either recent enough, or the client is better served
+  // by another replica.
+  Timestamp safe_time;
+  MonoDelta lag;
+  RETURN_NOT_OK(GetSafeTimeLag(server_->clock(), replica, &safe_time, &lag));
+  const MonoDelta max_staleness = MonoDelta::FromMicroseconds(scan_pb.max_staleness_usec());
+  if (lag > max_staleness) {
+    return Status::ServiceUnavailable(
+        Substitute("safe time lags by $0, more than the maximum staleness of $1",
+                   lag.ToString(), max_staleness.ToString()));
+  }
+  TRACE("Scanning at safe time $0, lagging by $1", safe_time.ToString(), lag.ToString());
+
+  RETURN_NOT_OK(VerifyNotAncientHistory(replica->tablet(),
+                                        ReadMode::READ_AT_BOUNDED_STALENESS,
+                                        safe_time));
+
+  // Safe time was already reached, so no new transaction can be assigned a
+  // lower timestamp. We only have to wait for the ones already in flight to
+  // commit for the snapshot to be repeatable.
+  Tablet* tablet = replica->tablet();
+  tablet::MvccSnapshot snap;
+  RETURN_NOT_OK(tablet->mvcc_manager()->WaitForSnapshotWithAllCommitted(
+      safe_time, &snap, rpc_context->GetClientDeadline()));
+
+  RETURN_NOT_OK(tablet->NewRowIterator(projection, snap, scan_pb.order_mode(), iter));
+  *snap_timestamp = safe_time;
+  return Status::OK();
+}
+
+Status TabletServiceImpl::HandleScanLatest(const RpcContext* rpc_context,
+                                           const Schema& projection,
+                                           TabletReplica* replica,
+                                           gscoped_ptr<RowwiseIterator>* iter) {
+  Tablet* tablet = replica->tablet();
+  shared_ptr<RaftConsensus> consensus = replica->shared_consensus();
+  bool under_lease = false;
+  if (FLAGS_raft_enable_leader_leases && consensus &&
+      consensus->role() == RaftPeerPB::LEADER) {
+    // Without a lease, another replica may have been elected and accepted
+    // writes this one hasn't seen. With one, operations this leader committed
+    // may still be on their way to MVCC: wait for them to be applied, so that
+    // the scan observes every write acknowledged before it started.
+    MonoTime client_deadline = rpc_context->GetClientDeadline() - MonoDelta::FromMilliseconds(10);
+    bool was_clamped = false;
+    MonoTime final_deadline = ClampScanDeadlineForWait(client_deadline, &was_clamped);
+
+    TRACE("Waiting for leader lease");
+    Timestamp committed_timestamp;
+    Status s = consensus->WaitForLeaderLease(final_deadline, &committed_timestamp);
+    if (s.IsIllegalState()) {
+      // The replica is no longer the leader: scan it as any other follower.
+      VLOG(1) << "Scanning latest data without leader lease: " << s.ToString();
+    } else {
+      if (s.ok() && committed_timestamp != Timestamp::kMin) {
+        TRACE("Waiting for committed operations to be applied");
+        s = replica->time_manager()->WaitUntilSafe(committed_timestamp, final_deadline);
+        if (s.ok()) {
+          tablet::MvccSnapshot snap;
+          s = tablet->mvcc_manager()->WaitForSnapshotWithAllCommitted(
+              Timestamp(committed_timestamp.value() + 1), &snap, final_deadline);
+        }
+      }
+      if (s.IsTimedOut()) {
+        return Status::ServiceUnavailable(s.CloneAndPrepend(
+            "could not scan the latest data under a leader lease").ToString());
+      }
+      RETURN_NOT_OK(s);
+      under_lease = true;
+    }
+  }
+
+  RETURN_NOT_OK(tablet->NewRowIterator(projection, iter));
+  if (under_lease && tablet->metrics()) {
+    tablet->metrics()->scans_served_under_leader_lease->Increment();
+  }
+  return Status::OK();
+}
+
 } // namespace tserver
 } // namespace kudu
@@ -39,6 +39,7 @@ class RowwiseIterator;
 class Schema;
 class Status;
 class Timestamp;
+struct ServicePoolOptions;
 
 namespace server {
 class ServerBase;
@@ -58,6 +59,8 @@ class GetNodeInstanceRequestPB;
 class GetNodeInstanceResponsePB;
 class LeaderStepDownRequestPB;
 class LeaderStepDownResponsePB;
+class MultiRaftConsensusRequestPB;
+class MultiRaftConsensusResponsePB;
 class RunLeaderElectionRequestPB;
 class RunLeaderElectionResponsePB;
 class StartTabletCopyRequestPB;
@@ -144,6 +147,15 @@ class TabletServiceImpl : public TabletServerServiceIf {
                                    bool* has_more_results,
                                    TabletServerErrorPB::Code* error_code);
 
+  // Opens '*iter' on the latest data for a READ_LATEST scan. With leader
+  // leases enabled, a leader first waits to hold a lease and for the
+  // operations committed before the scan to be applied. Returns
+  // Status::ServiceUnavailable() if that doesn't happen in time.
+  Status HandleScanLatest(const rpc::RpcContext* rpc_context,
+                          const Schema& projection,
+                          tablet::TabletReplica* tablet_replica,
+                          gscoped_ptr<RowwiseIterator>* iter);
+
   Status HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
                               const rpc::RpcContext* rpc_context,
                               const Schema& projection,
@@ -151,6 +163,17 @@ class TabletServiceImpl : public TabletServerServiceIf {
                               gscoped_ptr<RowwiseIterator>* iter,
                               Timestamp* snap_timestamp);
 
+  // Opens '*iter' at the replica's current safe time for a
+  // READ_AT_BOUNDED_STALENESS scan, without waiting for safe time to advance.
+  // Returns Status::ServiceUnavailable() if the safe time lags behind the
+  // local clock by more than the requested maximum staleness.
+  Status HandleScanAtBoundedStaleness(const NewScanRequestPB& scan_pb,
+                                      const rpc::RpcContext* rpc_context,
+                                      const Schema& projection,
+                                      tablet::TabletReplica* tablet_replica,
+                                      gscoped_ptr<RowwiseIterator>* iter,
+                                      Timestamp* snap_timestamp);
+
   TabletServer* server_;
 };
 
@@ -185,14 +208,24 @@ class ConsensusServiceImpl : public consensus::ConsensusServiceIf {
 
   virtual ~ConsensusServiceImpl();
 
+  // Returns the options of the service's dedicated worker pool, so that
+  // Raft RPCs aren't queued behind a burst of slow calls to other services.
+  static ServicePoolOptions PoolOptions();
+
   bool AuthorizeServiceUser(const google::protobuf::Message* req,
                             google::protobuf::Message* resp,
                             rpc::RpcContext* rpc) override;
 
+  bool SupportsFeature(uint32_t feature) const override;
+
   virtual void UpdateConsensus(const consensus::ConsensusRequestPB* req,
                                consensus::ConsensusResponsePB* resp,
                                rpc::RpcContext* context) OVERRIDE;
 
+  virtual void MultiRaftUpdateConsensus(const consensus::MultiRaftConsensusRequestPB* req,
+                                        consensus::MultiRaftConsensusResponsePB* resp,
+                                        rpc::RpcContext* context) OVERRIDE;
+
   virtual void RequestConsensusVote(const consensus::VoteRequestPB* req,
                                     consensus::VoteResponsePB* resp,
                                     rpc::RpcContext* context) OVERRIDE;
@@ -40,6 +40,7 @@
 #include "kudu/consensus/consensus_meta_manager.h"
 #include "kudu/consensus/log.h"
 #include "kudu/consensus/metadata.pb.h"
+#include "kudu/consensus/multi_raft_batcher.h"
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/consensus/opid_util.h"
 #include "kudu/consensus/quorum_util.h"
@@ -270,6 +271,9 @@ Status TSTabletManager::Init() {
                 .set_max_threads(max_open_threads)
                 .Build(&open_tablet_pool_));
 
+  multi_raft_manager_.reset(new consensus::MultiRaftManager(server_->messenger(),
+                                                            server_->metric_entity()));
+
   // Search for tablets in the metadata dir.
   vector<string> tablet_ids;
   RETURN_NOT_OK(fs_manager_->ListTabletIds(&tablet_ids));
@@ -986,7 +990,8 @@ void TSTabletManager::OpenTablet(const scoped_refptr<TabletReplica>& replica,
                        server_->messenger(),
                        server_->result_tracker(),
                        log,
-                       server_->tablet_prepare_pool());
+                       server_->tablet_prepare_pool(),
+                       multi_raft_manager_.get());
     if (!s.ok()) {
       LOG(ERROR) << LogPrefix(tablet_id) << "Tablet failed to start: "
                  << s.ToString();
@@ -1050,6 +1055,10 @@ void TSTabletManager::Shutdown() {
     replica->Shutdown();
   }
 
+  if (multi_raft_manager_) {
+    multi_raft_manager_->Shutdown();
+  }
+
   {
     std::lock_guard<RWMutex> l(lock_);
     // We don't expect anyone else to be modifying the map after we start the
@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -58,6 +59,7 @@ class ThreadPool;
 
 namespace consensus {
 class ConsensusMetadataManager;
+class MultiRaftManager;
 class OpId;
 class StartTabletCopyRequestPB;
 } // namespace consensus
@@ -361,6 +363,10 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   // Thread pool used to open the tablets async, whether bootstrap is required or not.
   gscoped_ptr<ThreadPool> open_tablet_pool_;
 
+  // Batches the Raft heartbeats sent by the replicas of this server by
+  // destination server.
+  std::unique_ptr<consensus::MultiRaftManager> multi_raft_manager_;
+
   FunctionGaugeDetacher metric_detacher_;
 
   DISALLOW_COPY_AND_ASSIGN(TSTabletManager);
@@ -585,6 +585,8 @@ string TabletServerPathHandlers::IteratorStatsToHtml(const Schema& projection,
        << "<th>Blocks read from disk</th>"
        << "<th>Bytes read from disk</th>"
        << "<th>Cells read from disk</th>"
+       << "<th>Cells decoded</th>"
+       << "<th>Cells returned</th>"
        << "</tr>\n";
   for (size_t idx = 0; idx < stats.size(); idx++) {
     // We use 'title' attributes so that if the user hovers over the value, they get a
@@ -593,8 +595,7 @@ string TabletServerPathHandlers::IteratorStatsToHtml(const Schema& projection,
                        "<td>$0</td>"
                        "<td title=\"$1\">$2</td>"
                        "<td title=\"$3\">$4</td>"
-                       "<td title=\"$5\">$6</td>"
-                       "</tr>\n",
+                       "<td title=\"$5\">$6</td>",
                        EscapeForHtmlToString(projection.column(idx).name()), // $0
                        HumanReadableInt::ToString(stats[idx].data_blocks_read_from_disk), // $1
                        stats[idx].data_blocks_read_from_disk, // $2
@@ -602,6 +603,13 @@ string TabletServerPathHandlers::IteratorStatsToHtml(const Schema& projection,
                        stats[idx].bytes_read_from_disk, // $4
                        HumanReadableInt::ToString(stats[idx].cells_read_from_disk), // $5
                        stats[idx].cells_read_from_disk); // $6
+    html << Substitute("<td title=\"$0\">$1</td>"
+                       "<td title=\"$2\">$3</td>"
+                       "</tr>\n",
+                       HumanReadableInt::ToString(stats[idx].cells_decoded), // $0
+                       stats[idx].cells_decoded, // $1
+                       HumanReadableInt::ToString(stats[idx].cells_returned), // $2
+                       stats[idx].cells_returned); // $3
   }
   html << "</table>\n";
   return html.str();
@@ -129,6 +129,21 @@ TEST(BlockingQueueTest, TestLogicalSize) {
   ASSERT_EQ(test_queue.Put("e"), QUEUE_FULL);
 }
 
+TEST(BlockingQueueTest, TestDrainAndHold) {
+  BlockingQueue<string, LengthLogicalSize> test_queue(4);
+  ASSERT_EQ(test_queue.Put("ab"), QUEUE_SUCCESS);
+  ASSERT_EQ(test_queue.Put("cd"), QUEUE_SUCCESS);
+  vector<string> out;
+  ASSERT_EQ(4, test_queue.DrainAndHoldTo(&out));
+  ASSERT_EQ(2, out.size());
+  ASSERT_TRUE(test_queue.empty());
+
+  // The drained elements still count against the queue's size.
+  ASSERT_EQ(test_queue.Put("e"), QUEUE_FULL);
+  test_queue.ReleaseHeldSize(4);
+  ASSERT_EQ(test_queue.Put("e"), QUEUE_SUCCESS);
+}
+
 TEST(BlockingQueueTest, TestNonPointerParamsMayBeNonEmptyOnDestruct) {
   BlockingQueue<int32_t> test_queue(1);
   ASSERT_EQ(test_queue.Put(123), QUEUE_SUCCESS);
@@ -137,6 +137,36 @@ class BlockingQueue {
     }
   }
 
+  // Moves all elements currently in the queue to 'out' without waiting, like
+  // BlockingDrainTo() with an expired deadline. Unlike that method, their
+  // logical size keeps counting against 'max_size' until the caller hands it
+  // back with ReleaseHeldSize(), so that producers are held off until the
+  // consumer is done with the elements.
+  //
+  // Returns the total logical size of the elements moved.
+  size_t DrainAndHoldTo(std::vector<T>* out) {
+    MutexLock l(lock_);
+    size_t held_size = 0;
+    out->reserve(out->size() + list_.size());
+    for (const T& elt : list_) {
+      out->push_back(elt);
+      held_size += LOGICAL_SIZE::logical_size(elt);
+    }
+    list_.clear();
+    return held_size;
+  }
+
+  // Returns 'held_size', as returned by DrainAndHoldTo(), to the queue.
+  void ReleaseHeldSize(size_t held_size) {
+    if (held_size == 0) {
+      return;
+    }
+    MutexLock l(lock_);
+    DCHECK_GE(size_, held_size);
+    size_ -= held_size;
+    not_full_.Signal();
+  }
+
   // Attempts to put the given value in the queue.
   // Returns:
   //   QUEUE_SUCCESS: if successfully inserted
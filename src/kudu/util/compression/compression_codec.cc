@@ -178,9 +178,12 @@ class Lz4Codec : public CompressionCodec {
   Status Uncompress(const Slice& compressed,
                     uint8_t *uncompressed,
                     size_t uncompressed_length) const OVERRIDE {
-    int n = LZ4_decompress_fast(reinterpret_cast<const char *>(compressed.data()),
-                                reinterpret_cast<char *>(uncompressed), uncompressed_length);
-    if (n != compressed.size()) {
+    // Unlike LZ4_decompress_fast(), this never reads past the end of
+    // 'compressed', which may have come off the network.
+    int n = LZ4_decompress_safe(reinterpret_cast<const char *>(compressed.data()),
+                                reinterpret_cast<char *>(uncompressed),
+                                compressed.size(), uncompressed_length);
+    if (n != uncompressed_length) {
       return Status::Corruption(
         StringPrintf("unable to uncompress the buffer. error near %d, buffer", -n),
                      KUDU_REDACT(compressed.ToDebugString(100)));
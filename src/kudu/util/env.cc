@@ -30,6 +30,9 @@ WritableFile::~WritableFile() {
 RWFile::~RWFile() {
 }
 
+SyncableFileSystem::~SyncableFileSystem() {
+}
+
 FileLock::~FileLock() {
 }
 
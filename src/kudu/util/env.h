@@ -32,6 +32,7 @@ class RandomAccessFile;
 class RWFile;
 class SequentialFile;
 class Slice;
+class SyncableFileSystem;
 class WritableFile;
 
 struct RandomAccessFileOptions;
@@ -172,6 +173,15 @@ class Env {
   // Synchronize the entry for a specific directory.
   virtual Status SyncDir(const std::string& dirname) = 0;
 
+  // Opens a handle on the filesystem containing 'path', through which all of
+  // its files can be synchronized at once.
+  //
+  // A single sync may be much cheaper than syncing many individual files on
+  // the same filesystem. Returns NotSupported if the platform has no way of
+  // doing so that reliably reports I/O errors (e.g. on Linux before 5.8).
+  virtual Status NewSyncableFileSystem(const std::string& path,
+                                       std::unique_ptr<SyncableFileSystem>* result) = 0;
+
   // Recursively delete the specified directory.
   // This should operate safely, not following any symlinks, etc.
   virtual Status DeleteRecursively(const std::string &dirname) = 0;
@@ -637,6 +647,27 @@ class RWFile {
   DISALLOW_COPY_AND_ASSIGN(RWFile);
 };
 
+// A handle on a filesystem, opened with Env::NewSyncableFileSystem().
+class SyncableFileSystem {
+ public:
+  SyncableFileSystem() { }
+  virtual ~SyncableFileSystem();
+
+  // Synchronize all files and metadata on the filesystem.
+  //
+  // Only errors hit while writing back data after the handle was opened are
+  // reported, so the handle must be opened before writing the files whose
+  // durability is to be ensured, and kept open for as long as they're
+  // synced this way.
+  virtual Status Sync() = 0;
+
+  // Returns the path provided when the handle was opened.
+  virtual const std::string& path() const = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SyncableFileSystem);
+};
+
 // Identifies a locked file.
 class FileLock {
  public:
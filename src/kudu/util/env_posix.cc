@@ -511,6 +511,25 @@ Status DoIsOnXfsFilesystem(const string& path, bool* result) {
   return Status::OK();
 }
 
+#if defined(__linux__)
+// Before Linux 5.8, syncfs() did not report errors hit while writing back the
+// filesystem's dirty pages, so data it claimed to have synced may have been
+// lost.
+bool SyncfsReportsWritebackErrors() {
+  static const bool kReportsErrors = []() {
+    struct utsname u;
+    PCHECK(uname(&u) == 0);
+    int major = 0;
+    int minor = 0;
+    if (sscanf(u.release, "%d.%d", &major, &minor) != 2) {
+      return false;
+    }
+    return major > 5 || (major == 5 && minor >= 8);
+  }();
+  return kReportsErrors;
+}
+#endif
+
 class PosixSequentialFile: public SequentialFile {
  private:
   std::string filename_;
@@ -1005,6 +1024,41 @@ class PosixFileLock : public FileLock {
   int fd_;
 };
 
+#if defined(__linux__)
+class PosixSyncableFileSystem : public SyncableFileSystem {
+ public:
+  PosixSyncableFileSystem(string path, int fd)
+      : path_(std::move(path)),
+        fd_(fd) {
+  }
+
+  ~PosixSyncableFileSystem() {
+    if (PREDICT_FALSE(::close(fd_) != 0)) {
+      PLOG(WARNING) << "Failed to close " << path_;
+    }
+  }
+
+  virtual Status Sync() OVERRIDE {
+    TRACE_EVENT1("io", "PosixSyncableFileSystem::Sync", "path", path_);
+    MAYBE_RETURN_EIO(path_, IOError(Env::kInjectedFailureStatusMsg, EIO));
+    ThreadRestrictions::AssertIOAllowed();
+    if (FLAGS_never_fsync) return Status::OK();
+    // syncfs() reports the writeback errors of the filesystem which were
+    // recorded since 'fd_' was opened or last synced.
+    if (syncfs(fd_) != 0) {
+      return IOError(path_, errno);
+    }
+    return Status::OK();
+  }
+
+  virtual const string& path() const OVERRIDE { return path_; }
+
+ private:
+  const string path_;
+  const int fd_;
+};
+#endif
+
 class PosixEnv : public Env {
  public:
   PosixEnv();
@@ -1196,6 +1250,27 @@ class PosixEnv : public Env {
     return Status::OK();
   }
 
+  virtual Status NewSyncableFileSystem(const std::string& path,
+                                       unique_ptr<SyncableFileSystem>* result) OVERRIDE {
+    TRACE_EVENT1("io", "PosixEnv::NewSyncableFileSystem", "path", path);
+    MAYBE_RETURN_EIO(path, IOError(Env::kInjectedFailureStatusMsg, EIO));
+    ThreadRestrictions::AssertIOAllowed();
+#if defined(__linux__)
+    if (!SyncfsReportsWritebackErrors()) {
+      return Status::NotSupported(
+          "syncfs() does not report writeback errors before Linux 5.8");
+    }
+    int fd;
+    if ((fd = open(path.c_str(), O_RDONLY)) == -1) {
+      return IOError(path, errno);
+    }
+    result->reset(new PosixSyncableFileSystem(path, fd));
+    return Status::OK();
+#else
+    return Status::NotSupported("syncfs() is not supported on this platform");
+#endif
+  }
+
   virtual Status DeleteRecursively(const std::string &name) OVERRIDE {
     return Walk(name, POST_ORDER, Bind(&PosixEnv::DeleteRecursivelyCb,
                                        Unretained(this)));
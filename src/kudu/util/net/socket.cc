@@ -196,6 +196,19 @@ Status Socket::SetTcpCork(bool enabled) {
   return Status::OK();
 }
 
+Status Socket::SetBusyPoll(int usec) {
+#if defined(__linux__) && defined(SO_BUSY_POLL)
+  if (setsockopt(fd_, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec)) == -1) {
+    int err = errno;
+    return Status::NetworkError(std::string("failed to set SO_BUSY_POLL: ") +
+                                ErrnoToString(err), Slice(), err);
+  }
+  return Status::OK();
+#else
+  return Status::NotSupported("SO_BUSY_POLL is not supported on this platform");
+#endif // defined(__linux__) && defined(SO_BUSY_POLL)
+}
+
 Status Socket::SetNonBlocking(bool enabled) {
   int curflags = ::fcntl(fd_, F_GETFL, 0);
   if (curflags == -1) {
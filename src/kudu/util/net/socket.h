@@ -73,6 +73,11 @@ class Socket {
   // Set or clear TCP_CORK
   Status SetTcpCork(bool enabled);
 
+  // Set SO_BUSY_POLL: the number of microseconds the kernel may busy-poll the
+  // device queue for incoming data when reading from or polling the socket.
+  // Returns NotSupported on platforms without the option.
+  Status SetBusyPoll(int usec);
+
   // Set or clear O_NONBLOCK
   Status SetNonBlocking(bool enabled);
   Status IsNonBlocking(bool* is_nonblock) const;